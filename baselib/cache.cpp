@@ -0,0 +1,272 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+
+#include <oh_utils.h>
+
+#include "cache.h"
+#include <sahpi_wrappers.h>
+
+
+static gint64 get_time()
+{
+#if GLIB_CHECK_VERSION (2, 28, 0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal tv;
+    g_get_current_time( &tv );
+    return (gint64)tv.tv_sec * G_USEC_PER_SEC + tv.tv_usec;
+#endif
+}
+
+
+/***************************************************************
+ * class cRptCache
+ **************************************************************/
+cRptCache::Resource::Resource()
+    : missing( false ),
+      rpte_valid( false ),
+      rdr_count_valid( false ),
+      rdr_count( 0 ),
+      rdr_checked( 0 )
+{
+    memset( &rpte, 0, sizeof(rpte) );
+}
+
+cRptCache::cRptCache( gint64 ttl )
+    : m_ttl( ttl ),
+      m_gen( 0 ),
+      m_rpt_count_valid( false ),
+      m_rpt_count( 0 ),
+      m_rpt_checked( 0 )
+{
+    m_lock = wrap_g_mutex_new_init();
+}
+
+cRptCache::~cRptCache()
+{
+    wrap_g_mutex_free_clear( m_lock );
+}
+
+uint32_t cRptCache::GetGeneration()
+{
+    g_mutex_lock( m_lock );
+    uint32_t gen = m_gen;
+    g_mutex_unlock( m_lock );
+
+    return gen;
+}
+
+bool cRptCache::IsRptCheckDue()
+{
+    g_mutex_lock( m_lock );
+    bool due = ( !m_rpt_count_valid ) || IsExpired( m_rpt_checked );
+    g_mutex_unlock( m_lock );
+
+    return due;
+}
+
+void cRptCache::SetRptUpdateCount( SaHpiUint32T count )
+{
+    g_mutex_lock( m_lock );
+    if ( m_rpt_count_valid && ( count != m_rpt_count ) ) {
+        // Resources were added, removed or changed:
+        // any of them can have a new RDR set now.
+        Clear();
+    }
+    m_rpt_count_valid = true;
+    m_rpt_count       = count;
+    m_rpt_checked     = get_time();
+    g_mutex_unlock( m_lock );
+}
+
+bool cRptCache::IsRdrCheckDue( SaHpiResourceIdT rid )
+{
+    g_mutex_lock( m_lock );
+    Resources::const_iterator iter = m_resources.find( rid );
+    bool due = true;
+    if ( iter != m_resources.end() ) {
+        const Resource& r = iter->second;
+        due = ( !r.missing ) &&
+              ( ( !r.rdr_count_valid ) || IsExpired( r.rdr_checked ) );
+    }
+    g_mutex_unlock( m_lock );
+
+    return due;
+}
+
+void cRptCache::SetRdrUpdateCount( SaHpiResourceIdT rid, SaHpiUint32T count )
+{
+    g_mutex_lock( m_lock );
+    Resource& r = m_resources[rid];
+    r.missing = false;
+    if ( r.rdr_count_valid && ( count != r.rdr_count ) ) {
+        r.rdrs.clear();
+        r.instruments.clear();
+        ++m_gen;
+    }
+    r.rdr_count_valid = true;
+    r.rdr_count       = count;
+    r.rdr_checked     = get_time();
+    g_mutex_unlock( m_lock );
+}
+
+bool cRptCache::GetRptEntry( SaHpiResourceIdT rid, SaHpiRptEntryT& rpte )
+{
+    g_mutex_lock( m_lock );
+    Resources::const_iterator iter = m_resources.find( rid );
+    bool found = ( iter != m_resources.end() ) && iter->second.rpte_valid;
+    if ( found ) {
+        memcpy( &rpte, &iter->second.rpte, sizeof(rpte) );
+    }
+    g_mutex_unlock( m_lock );
+
+    return found;
+}
+
+void cRptCache::AddRptEntry( uint32_t gen, const SaHpiRptEntryT& rpte )
+{
+    g_mutex_lock( m_lock );
+    if ( gen == m_gen ) {
+        Resource& r = m_resources[rpte.ResourceId];
+        r.missing = false;
+        memcpy( &r.rpte, &rpte, sizeof(rpte) );
+        r.rpte_valid = true;
+    }
+    g_mutex_unlock( m_lock );
+}
+
+bool cRptCache::GetRdr( SaHpiResourceIdT rid,
+                        SaHpiEntryIdT entry_id,
+                        SaHpiEntryIdT& next_entry_id,
+                        SaHpiRdrT& rdr )
+{
+    bool found = false;
+
+    g_mutex_lock( m_lock );
+    Resources::const_iterator iter = m_resources.find( rid );
+    if ( iter != m_resources.end() ) {
+        const Rdrs& rdrs = iter->second.rdrs;
+        Rdrs::const_iterator iter2 = rdrs.find( entry_id );
+        if ( iter2 != rdrs.end() ) {
+            next_entry_id = iter2->second.next_entry_id;
+            memcpy( &rdr, &iter2->second.rdr, sizeof(rdr) );
+            found = true;
+        }
+    }
+    g_mutex_unlock( m_lock );
+
+    return found;
+}
+
+void cRptCache::AddRdr( uint32_t gen,
+                        SaHpiResourceIdT rid,
+                        SaHpiEntryIdT entry_id,
+                        SaHpiEntryIdT next_entry_id,
+                        const SaHpiRdrT& rdr )
+{
+    g_mutex_lock( m_lock );
+    if ( gen == m_gen ) {
+        Resource& r = m_resources[rid];
+        RdrEntry& e = r.rdrs[entry_id];
+        e.next_entry_id = next_entry_id;
+        memcpy( &e.rdr, &rdr, sizeof(rdr) );
+        // A walk over RDRs also serves later lookups by instrument id
+        InstrumentKey key( rdr.RdrType, oh_get_instrument_id( &rdr ) );
+        memcpy( &r.instruments[key], &rdr, sizeof(rdr) );
+    }
+    g_mutex_unlock( m_lock );
+}
+
+bool cRptCache::GetRdrByInstrumentId( SaHpiResourceIdT rid,
+                                      SaHpiRdrTypeT type,
+                                      SaHpiInstrumentIdT instrument_id,
+                                      SaHpiRdrT& rdr )
+{
+    bool found = false;
+
+    g_mutex_lock( m_lock );
+    Resources::const_iterator iter = m_resources.find( rid );
+    if ( iter != m_resources.end() ) {
+        const Instruments& instruments = iter->second.instruments;
+        InstrumentKey key( type, instrument_id );
+        Instruments::const_iterator iter2 = instruments.find( key );
+        if ( iter2 != instruments.end() ) {
+            memcpy( &rdr, &iter2->second, sizeof(rdr) );
+            found = true;
+        }
+    }
+    g_mutex_unlock( m_lock );
+
+    return found;
+}
+
+void cRptCache::AddRdrByInstrumentId( uint32_t gen,
+                                      SaHpiResourceIdT rid,
+                                      const SaHpiRdrT& rdr )
+{
+    g_mutex_lock( m_lock );
+    if ( gen == m_gen ) {
+        Resource& r = m_resources[rid];
+        InstrumentKey key( rdr.RdrType, oh_get_instrument_id( &rdr ) );
+        memcpy( &r.instruments[key], &rdr, sizeof(rdr) );
+    }
+    g_mutex_unlock( m_lock );
+}
+
+bool cRptCache::IsMissing( SaHpiResourceIdT rid )
+{
+    g_mutex_lock( m_lock );
+    Resources::const_iterator iter = m_resources.find( rid );
+    bool missing = ( iter != m_resources.end() ) && iter->second.missing;
+    g_mutex_unlock( m_lock );
+
+    return missing;
+}
+
+void cRptCache::SetMissing( uint32_t gen, SaHpiResourceIdT rid )
+{
+    g_mutex_lock( m_lock );
+    if ( gen == m_gen ) {
+        Resource& r = m_resources[rid];
+        r.missing         = true;
+        r.rpte_valid      = false;
+        r.rdr_count_valid = false;
+        r.rdrs.clear();
+        r.instruments.clear();
+    }
+    g_mutex_unlock( m_lock );
+}
+
+void cRptCache::Invalidate( SaHpiResourceIdT rid )
+{
+    g_mutex_lock( m_lock );
+    if ( rid == SAHPI_UNSPECIFIED_RESOURCE_ID ) {
+        Clear();
+        m_rpt_count_valid = false;
+    } else {
+        m_resources.erase( rid );
+        ++m_gen;
+    }
+    g_mutex_unlock( m_lock );
+}
+
+void cRptCache::Clear()
+{
+    m_resources.clear();
+    ++m_gen;
+}
+
+bool cRptCache::IsExpired( gint64 checked ) const
+{
+    return ( get_time() - checked ) >= m_ttl;
+}
@@ -0,0 +1,129 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __BASELIB_CACHE_H
+#define __BASELIB_CACHE_H
+
+#include <stdint.h>
+
+#include <map>
+#include <utility>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+
+
+/***************************************************************
+ * class cRptCache
+ *
+ * Client side copy of RPT entries and RDRs of one session.
+ * Entries are kept as received from the daemon,
+ * i.e. without the domain entity root.
+ *
+ * The cache does not talk to the daemon itself.
+ * The session asks if a check is due, gets the update counter
+ * and reports it back. A changed counter drops stale entries.
+ *
+ * Data fetched by RPC is added only if nothing was invalidated
+ * since the caller took the generation number.
+ *
+ * A resource id the daemon does not know is remembered as missing
+ * until the RPT update counter changes or the resource is
+ * invalidated, so repeated lookups of it need no RPC.
+ **************************************************************/
+class cRptCache
+{
+public:
+
+    explicit cRptCache( gint64 ttl ); // usec
+    ~cRptCache();
+
+    uint32_t GetGeneration();
+
+    bool IsRptCheckDue();
+    void SetRptUpdateCount( SaHpiUint32T count );
+    bool IsRdrCheckDue( SaHpiResourceIdT rid );
+    void SetRdrUpdateCount( SaHpiResourceIdT rid, SaHpiUint32T count );
+
+    bool GetRptEntry( SaHpiResourceIdT rid, SaHpiRptEntryT& rpte );
+    void AddRptEntry( uint32_t gen, const SaHpiRptEntryT& rpte );
+
+    bool GetRdr( SaHpiResourceIdT rid,
+                 SaHpiEntryIdT entry_id,
+                 SaHpiEntryIdT& next_entry_id,
+                 SaHpiRdrT& rdr );
+    void AddRdr( uint32_t gen,
+                 SaHpiResourceIdT rid,
+                 SaHpiEntryIdT entry_id,
+                 SaHpiEntryIdT next_entry_id,
+                 const SaHpiRdrT& rdr );
+
+    bool GetRdrByInstrumentId( SaHpiResourceIdT rid,
+                               SaHpiRdrTypeT type,
+                               SaHpiInstrumentIdT instrument_id,
+                               SaHpiRdrT& rdr );
+    void AddRdrByInstrumentId( uint32_t gen,
+                               SaHpiResourceIdT rid,
+                               const SaHpiRdrT& rdr );
+
+    bool IsMissing( SaHpiResourceIdT rid );
+    void SetMissing( uint32_t gen, SaHpiResourceIdT rid );
+
+    // SAHPI_UNSPECIFIED_RESOURCE_ID invalidates everything
+    void Invalidate( SaHpiResourceIdT rid );
+
+private:
+
+    cRptCache( const cRptCache& );
+    cRptCache& operator =( cRptCache& );
+
+    struct RdrEntry
+    {
+        SaHpiEntryIdT next_entry_id;
+        SaHpiRdrT     rdr;
+    };
+
+    typedef std::pair<SaHpiRdrTypeT, SaHpiInstrumentIdT> InstrumentKey;
+    typedef std::map<SaHpiEntryIdT, RdrEntry> Rdrs;
+    typedef std::map<InstrumentKey, SaHpiRdrT> Instruments;
+
+    struct Resource
+    {
+        explicit Resource();
+
+        bool           missing;
+        bool           rpte_valid;
+        SaHpiRptEntryT rpte;
+        bool           rdr_count_valid;
+        SaHpiUint32T   rdr_count;
+        gint64         rdr_checked;
+        Rdrs           rdrs;
+        Instruments    instruments;
+    };
+
+    typedef std::map<SaHpiResourceIdT, Resource> Resources;
+
+    void Clear();
+    bool IsExpired( gint64 checked ) const;
+
+private: // data
+
+    const gint64 m_ttl;
+    GMutex *     m_lock;
+    uint32_t     m_gen;
+    bool         m_rpt_count_valid;
+    SaHpiUint32T m_rpt_count;
+    gint64       m_rpt_checked;
+    Resources    m_resources;
+};
+
+#endif /* __BASELIB_CACHE_H */
@@ -42,12 +42,19 @@ static GHashTable *ohc_domains = NULL;
 static SaHpiEntityPathT my_entity
     = { .Entry[0] = { .EntityType = SAHPI_ENT_UNSPECIFIED, .EntityLocation = 0 } };
 
+/* RPT/RDR cache validation interval, msec. 0 - cache is disabled */
+static unsigned int cache_ttl = 0;
+static int multiplex = 0;
+/* Min payload size for compressed messages, bytes. 0 - no compression */
+static unsigned int compress_threshold = 0;
+
 
 static int load_client_config(const char *filename);
 static void add_domain_conf(SaHpiDomainIdT did,
                             const char *host,
                             unsigned short port,
-                            const SaHpiEntityPathT *entity_root);
+                            const SaHpiEntityPathT *entity_root,
+                            const char *sockpath);
 static void extract_keys(gpointer key, gpointer val, gpointer user_data);
 static gint compare_keys(const gint *a, const gint *b);
 
@@ -60,6 +67,9 @@ void ohc_conf_init(void)
     // Create domain table
     if (!ohc_domains) { // Create domain table
         char * config_file;
+        const char *ttlstr;
+        const char *muxstr;
+        const char *compressstr;
         const struct ohc_domain_conf *default_conf;
 
         ohc_domains = g_hash_table_new_full(g_int_hash,
@@ -87,7 +97,7 @@ void ohc_conf_init(void)
         /* Check to see if a default domain exists, if not, add it */
         default_conf = ohc_get_domain_conf(OH_DEFAULT_DOMAIN_ID);
         if (default_conf == NULL) {
-            const char *host, *portstr;
+            const char *host, *portstr, *sockpath;
             unsigned short port;
             SaHpiEntityPathT entity_root;
 
@@ -102,9 +112,25 @@ void ohc_conf_init(void)
             } else {
                 port = atoi(portstr);
             }
+            sockpath = getenv("OPENHPI_DAEMON_SOCKET");
             oh_init_ep(&entity_root);
 
-            add_domain_conf(OH_DEFAULT_DOMAIN_ID, host, port, &entity_root);
+            add_domain_conf(OH_DEFAULT_DOMAIN_ID, host, port, &entity_root, sockpath);
+        }
+
+        ttlstr = getenv("OPENHPI_CLIENT_CACHE_TTL");
+        if (ttlstr != NULL) {
+            cache_ttl = atoi(ttlstr);
+        }
+
+        muxstr = getenv("OPENHPI_CLIENT_MULTIPLEX");
+        if (muxstr != NULL) {
+            multiplex = ( atoi(muxstr) != 0 ) ? 1 : 0;
+        }
+
+        compressstr = getenv("OPENHPI_CLIENT_COMPRESS");
+        if (compressstr != NULL) {
+            compress_threshold = atoi(compressstr);
         }
     }
 
@@ -124,6 +150,27 @@ const SaHpiEntityPathT * ohc_get_my_entity(void)
     return &my_entity;
 }
 
+unsigned int ohc_get_cache_ttl(void)
+{
+    // NB: Since cache_ttl is assigned on initialization
+    // we don't need to aquire lock
+    return cache_ttl;
+}
+
+int ohc_get_multiplex(void)
+{
+    // NB: Since multiplex is assigned on initialization
+    // we don't need to aquire lock
+    return multiplex;
+}
+
+unsigned int ohc_get_compress_threshold(void)
+{
+    // NB: Since compress_threshold is assigned on initialization
+    // we don't need to aquire lock
+    return compress_threshold;
+}
+
 const struct ohc_domain_conf * ohc_get_domain_conf(SaHpiDomainIdT did)
 {
     struct ohc_domain_conf *dc;
@@ -170,7 +217,7 @@ SaErrorT ohc_add_domain_conf(const char *host,
     }
 
     *did = prev_did + 1;
-    add_domain_conf(*did, host, port, entity_root);
+    add_domain_conf(*did, host, port, entity_root, NULL);
 
     ohc_unlock();
 
@@ -194,7 +241,7 @@ SaErrorT ohc_add_domain_conf_by_id(SaHpiDomainIdT did,
         return SA_ERR_HPI_DUPLICATE;
     }
     
-    add_domain_conf(did, host, port, entity_root);
+    add_domain_conf(did, host, port, entity_root, NULL);
     ohc_unlock();
     return SA_OK;
 }
@@ -270,6 +317,7 @@ enum {
         HPI_CLIENT_CONF_TOKEN_PORT,
         HPI_CLIENT_CONF_TOKEN_ROOT,
         HPI_CLIENT_CONF_TOKEN_MY_EP,
+        HPI_CLIENT_CONF_TOKEN_SOCKET,
 } hpiClientConfType;
 
 struct tokens {
@@ -303,6 +351,10 @@ static struct tokens ohc_conf_tokens[] = {
                 .name = "my_entity",
                 .token = HPI_CLIENT_CONF_TOKEN_MY_EP
         },
+        {
+                .name = "socket",
+                .token = HPI_CLIENT_CONF_TOKEN_SOCKET
+        },
 };
 
 /*******************************************************************************
@@ -362,7 +414,8 @@ static int get_next_good_token_in_domain_stanza(GScanner *oh_scanner) {
         while (next_token != G_TOKEN_RIGHT_CURLY &&
                next_token != HPI_CLIENT_CONF_TOKEN_HOST &&
                next_token != HPI_CLIENT_CONF_TOKEN_PORT &&
-               next_token != HPI_CLIENT_CONF_TOKEN_ROOT) {
+               next_token != HPI_CLIENT_CONF_TOKEN_ROOT &&
+               next_token != HPI_CLIENT_CONF_TOKEN_SOCKET) {
                 if (next_token == G_TOKEN_EOF) break;
                 next_token = g_scanner_get_next_token(oh_scanner);
         }
@@ -373,7 +426,8 @@ static int get_next_good_token_in_domain_stanza(GScanner *oh_scanner) {
 static void add_domain_conf(SaHpiDomainIdT did,
                             const char *host,
                             unsigned short port,
-                            const SaHpiEntityPathT * entity_root)
+                            const SaHpiEntityPathT * entity_root,
+                            const char *sockpath)
 {
     struct ohc_domain_conf *domain_conf;
 
@@ -382,6 +436,9 @@ static void add_domain_conf(SaHpiDomainIdT did,
     strncpy(domain_conf->host, host, SAHPI_MAX_TEXT_BUFFER_LENGTH);
     domain_conf->port = port;
     memcpy(&domain_conf->entity_root, entity_root, sizeof(SaHpiEntityPathT));
+    if (sockpath) {
+        strncpy(domain_conf->sockpath, sockpath, SAHPI_MAX_TEXT_BUFFER_LENGTH - 1);
+    }
     g_hash_table_insert(ohc_domains, &domain_conf->did, domain_conf);
 }
 
@@ -389,12 +446,14 @@ static int process_domain_token (GScanner *oh_scanner)
 {
         SaHpiDomainIdT did;
         char host[SAHPI_MAX_TEXT_BUFFER_LENGTH];
+        char sockpath[SAHPI_MAX_TEXT_BUFFER_LENGTH];
         unsigned int port;
         SaHpiEntityPathT entity_root;
 
         int next_token;
 
         host[0] = '\0';
+        sockpath[0] = '\0';
         port = OPENHPI_DEFAULT_DAEMON_PORT;
         oh_init_ep(&entity_root);
 
@@ -468,6 +527,19 @@ static int process_domain_token (GScanner *oh_scanner)
                                 CRIT("Processing entity_root: Invalid entity path");
                                 return -10;
                         }
+                } else if (next_token == HPI_CLIENT_CONF_TOKEN_SOCKET) {
+                        next_token = g_scanner_get_next_token(oh_scanner);
+                        if (next_token != G_TOKEN_EQUAL_SIGN) {
+                                CRIT("Processing socket: Expected equal sign");
+                                return -10;
+                        }
+                        next_token = g_scanner_get_next_token(oh_scanner);
+                        if (next_token != G_TOKEN_STRING) {
+                                CRIT("Processing socket: Expected a string");
+                                return -10;
+                        }
+                        strncpy(sockpath, oh_scanner->value.v_string, SAHPI_MAX_TEXT_BUFFER_LENGTH - 1);
+                        sockpath[SAHPI_MAX_TEXT_BUFFER_LENGTH - 1] = '\0';
                 } else {
                         CRIT("Processing domain: Should not get here!");
                         return -10;
@@ -478,12 +550,16 @@ static int process_domain_token (GScanner *oh_scanner)
         if (next_token == G_TOKEN_EOF) {
                 CRIT("Processing domain: Expected a right curly");
                 return -10;
-        } else if (host[0] == '\0') {
+        } else if ((host[0] == '\0') && (sockpath[0] == '\0')) {
                 CRIT("Processing domain: Did not find the host parameter");
                 return -10;
         }
 
-        add_domain_conf(did, host, port, &entity_root);
+        if (host[0] == '\0') {
+                strcpy(host, "localhost");
+        }
+
+        add_domain_conf(did, host, port, &entity_root, sockpath);
 
         return 0;
 }
@@ -34,11 +34,16 @@ struct ohc_domain_conf {
         char host[SAHPI_MAX_TEXT_BUFFER_LENGTH];
         unsigned short port;
         SaHpiEntityPathT entity_root;
+        /* unix domain socket, tried before host:port if not empty */
+        char sockpath[SAHPI_MAX_TEXT_BUFFER_LENGTH];
 };
 
 
 void ohc_conf_init(void);
 const SaHpiEntityPathT * ohc_get_my_entity(void);
+unsigned int ohc_get_cache_ttl(void);
+int ohc_get_multiplex(void);
+unsigned int ohc_get_compress_threshold(void);
 const struct ohc_domain_conf * ohc_get_domain_conf(SaHpiDomainIdT did);
 const struct ohc_domain_conf * ohc_get_next_domain_conf(SaHpiEntryIdT entry_id,
                                                         SaHpiEntryIdT *next_entry_id);
@@ -0,0 +1,301 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <oh_error.h>
+
+#include "connection.h"
+#include "lock.h"
+#include <sahpi_wrappers.h>
+
+
+/***************************************************************
+ * Connection to the domain daemon
+ **************************************************************/
+cClientStreamSock * ohc_connect( const struct ohc_domain_conf * dc )
+{
+    cClientStreamSock * sock = new cClientStreamSock;
+
+    // Local daemon is reached through unix domain socket if configured
+    bool local = false;
+#ifndef _WIN32
+    if ( dc->sockpath[0] != '\0' ) {
+        local = sock->CreateLocal( dc->sockpath );
+        if ( !local ) {
+            WARN("Session: cannot connect to %s, trying %s:%u.",
+                 dc->sockpath, dc->host, dc->port );
+        }
+    }
+#endif
+    bool rc = local || sock->Create( dc->host, dc->port );
+    if ( !rc ) {
+        delete sock;
+        CRIT("Session: cannot open connection to domain %u.", dc->did );
+        return 0;
+    }
+
+    // TODO configuration file, env vars?
+    if ( !local ) {
+        sock->EnableKeepAliveProbes( /* keepalive_time*/    1,
+                                     /* keepalive_intvl */  1,
+                                     /* keepalive_probes */ 3 );
+        sock->EnableCompression( ohc_get_compress_threshold() );
+    }
+
+    return sock;
+}
+
+
+/***************************************************************
+ * class cMuxConnection
+ **************************************************************/
+struct cMuxConnection::Waiter
+{
+    GCond *  cond;
+    bool     done;
+    bool     ok;
+    void *   data;
+    uint32_t data_len;
+    uint8_t  type;
+    uint32_t id;
+    int      byte_order;
+};
+
+cMuxConnection::cMuxConnection( SaHpiDomainIdT did )
+    : m_ref_cnt( 0 ),
+      m_did( did ),
+      m_sock( 0 ),
+      m_reader( 0 ),
+      m_epoch( 0 ),
+      m_next_tag( 0 )
+{
+    m_lock = wrap_g_mutex_new_init();
+}
+
+cMuxConnection::~cMuxConnection()
+{
+    g_mutex_lock( m_lock );
+    if ( m_sock ) {
+        m_sock->Shutdown();
+    }
+    g_mutex_unlock( m_lock );
+
+    // Reader deletes the socket on exit
+    if ( m_reader ) {
+        g_thread_join( m_reader );
+    }
+
+    wrap_g_mutex_free_clear( m_lock );
+}
+
+bool cMuxConnection::Connect( uint32_t& epoch )
+{
+    const struct ohc_domain_conf * dc = ohc_get_domain_conf( m_did );
+
+    g_mutex_lock( m_lock );
+    if ( !m_sock ) {
+        // Previous reader has released the socket and is about to exit
+        if ( m_reader ) {
+            g_thread_join( m_reader );
+            m_reader = 0;
+        }
+
+        cClientStreamSock * sock = dc ? ohc_connect( dc ) : 0;
+        if ( sock ) {
+            m_sock = sock;
+            ++m_epoch;
+            if ( m_epoch == 0 ) {
+                ++m_epoch;
+            }
+            m_reader = wrap_g_thread_create_new( "MuxReader",
+                                                 ReaderAdapter,
+                                                 this, TRUE, 0 );
+            if ( !m_reader ) {
+                CRIT( "Session: cannot start reader for domain %u.", m_did );
+                m_sock = 0;
+                delete sock;
+            }
+        }
+    }
+    bool rc = ( m_sock != 0 );
+    epoch = m_epoch;
+    g_mutex_unlock( m_lock );
+
+    return rc;
+}
+
+bool cMuxConnection::IsOpen( uint32_t epoch )
+{
+    g_mutex_lock( m_lock );
+    bool rc = ( m_sock != 0 ) && ( m_epoch == epoch );
+    g_mutex_unlock( m_lock );
+
+    return rc;
+}
+
+bool cMuxConnection::Call( uint32_t epoch,
+                           uint32_t id,
+                           void * data,
+                           uint32_t& data_len,
+                           uint8_t& rp_type,
+                           uint32_t& rp_id,
+                           int& rp_byte_order )
+{
+    Waiter w;
+    w.cond = wrap_g_cond_new_init();
+    w.done = false;
+    w.ok   = false;
+    w.data = data;
+
+    g_mutex_lock( m_lock );
+    bool rc = ( m_sock != 0 ) && ( ( epoch == 0 ) || ( epoch == m_epoch ) );
+    if ( rc ) {
+        uint16_t tag = m_next_tag++;
+        while ( m_waiters.find( tag ) != m_waiters.end() ) {
+            tag = m_next_tag++;
+        }
+        m_waiters[tag] = &w;
+        rc = m_sock->WriteMsg( eMhMsg, id, data, data_len, tag );
+        if ( rc ) {
+            while ( !w.done ) {
+                g_cond_wait( w.cond, m_lock );
+            }
+            rc = w.ok;
+        } else {
+            // Reader will notice the broken connection
+            m_waiters.erase( tag );
+        }
+    }
+    g_mutex_unlock( m_lock );
+
+    wrap_g_cond_free( w.cond );
+
+    if ( rc ) {
+        data_len      = w.data_len;
+        rp_type       = w.type;
+        rp_id         = w.id;
+        rp_byte_order = w.byte_order;
+    }
+
+    return rc;
+}
+
+gpointer cMuxConnection::ReaderAdapter( gpointer ptr )
+{
+    cMuxConnection * me = reinterpret_cast<cMuxConnection *>(ptr);
+    me->Reader();
+
+    return 0;
+}
+
+void cMuxConnection::Reader()
+{
+    g_mutex_lock( m_lock );
+    cClientStreamSock * sock = m_sock;
+    g_mutex_unlock( m_lock );
+
+    char data[dMaxPayloadLength];
+
+    while ( true ) {
+        uint8_t  type;
+        uint32_t id;
+        uint32_t data_len;
+        int      byte_order;
+        int      tag;
+
+        bool rc = sock->ReadMsg( type, id, data, data_len, byte_order, &tag );
+        if ( !rc ) {
+            break;
+        }
+        if ( tag < 0 ) {
+            CRIT( "Session: domain %u daemon does not support shared connections.",
+                  m_did );
+            break;
+        }
+
+        g_mutex_lock( m_lock );
+        Waiters::iterator iter = m_waiters.find( tag );
+        if ( iter != m_waiters.end() ) {
+            Waiter * w = iter->second;
+            m_waiters.erase( iter );
+            memcpy( w->data, data, data_len );
+            w->data_len   = data_len;
+            w->type       = type;
+            w->id         = id;
+            w->byte_order = byte_order;
+            w->ok         = true;
+            w->done       = true;
+            g_cond_signal( w->cond );
+        } else {
+            CRIT( "Session: unexpected reply %u from domain %u.", id, m_did );
+        }
+        g_mutex_unlock( m_lock );
+    }
+
+    g_mutex_lock( m_lock );
+    m_sock = 0;
+    FailWaiters();
+    g_mutex_unlock( m_lock );
+
+    delete sock;
+}
+
+void cMuxConnection::FailWaiters()
+{
+    Waiters::iterator iter = m_waiters.begin();
+    for ( ; iter != m_waiters.end(); ++iter ) {
+        Waiter * w = iter->second;
+        w->ok   = false;
+        w->done = true;
+        g_cond_signal( w->cond );
+    }
+    m_waiters.clear();
+}
+
+
+/***************************************************************
+ * Shared connection table
+ **************************************************************/
+static GHashTable * connections = 0;
+
+cMuxConnection * ohc_conn_get_ref( SaHpiDomainIdT did )
+{
+    ohc_lock();
+    if ( !connections ) {
+        connections = g_hash_table_new( g_direct_hash, g_direct_equal );
+    }
+    gpointer key = GUINT_TO_POINTER( did );
+    gpointer value = g_hash_table_lookup( connections, key );
+    cMuxConnection * conn = reinterpret_cast<cMuxConnection *>(value);
+    if ( !conn ) {
+        conn = new cMuxConnection( did );
+        g_hash_table_insert( connections, key, conn );
+    }
+    conn->Ref();
+    ohc_unlock();
+
+    return conn;
+}
+
+void ohc_conn_unref( cMuxConnection * conn )
+{
+    ohc_lock();
+    conn->Unref();
+    if ( conn->GetRefCnt() == 0 ) {
+        g_hash_table_remove( connections, GUINT_TO_POINTER( conn->GetDomainId() ) );
+        delete conn;
+    }
+    ohc_unlock();
+}
+
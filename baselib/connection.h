@@ -0,0 +1,124 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __BASELIB_CONNECTION_H
+#define __BASELIB_CONNECTION_H
+
+#include <stdint.h>
+
+#include <map>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+
+#include <strmsock.h>
+
+#include "conf.h"
+
+
+/***************************************************************
+ * Opens a new connection to the domain daemon
+ **************************************************************/
+cClientStreamSock * ohc_connect( const struct ohc_domain_conf * dc );
+
+
+/***************************************************************
+ * class cMuxConnection
+ *
+ * One connection to a domain shared by all sessions and threads.
+ * Every request gets a tag, a reader thread hands the replies
+ * over to the waiting callers.
+ *
+ * The connection is reopened on the next call after a failure.
+ * Each reopening starts a new epoch: the daemon drops sessions
+ * of a closed connection, so a session opened in an older epoch
+ * has to be opened again.
+ **************************************************************/
+class cMuxConnection
+{
+public:
+
+    explicit cMuxConnection( SaHpiDomainIdT did );
+    ~cMuxConnection();
+
+    void Ref()
+    {
+        ++m_ref_cnt;
+    }
+
+    void Unref()
+    {
+        --m_ref_cnt;
+    }
+
+    int GetRefCnt() const
+    {
+        return m_ref_cnt;
+    }
+
+    SaHpiDomainIdT GetDomainId() const
+    {
+        return m_did;
+    }
+
+    // Connects if necessary, gets current epoch
+    bool Connect( uint32_t& epoch );
+
+    // Is the connection of the given epoch still open?
+    bool IsOpen( uint32_t epoch );
+
+    // Epoch 0 - any epoch.
+    // Otherwise fails without sending if the connection
+    // was reopened since the given epoch.
+    // The reply replaces the request in data.
+    bool Call( uint32_t epoch,
+               uint32_t id,
+               void * data,
+               uint32_t& data_len,
+               uint8_t& rp_type,
+               uint32_t& rp_id,
+               int& rp_byte_order );
+
+private:
+
+    cMuxConnection( const cMuxConnection& );
+    cMuxConnection& operator =( cMuxConnection& );
+
+    struct Waiter;
+
+    static gpointer ReaderAdapter( gpointer ptr );
+    void Reader();
+    void FailWaiters();
+
+private: // data
+
+    typedef std::map<uint16_t, Waiter *> Waiters;
+
+    volatile int        m_ref_cnt;
+    SaHpiDomainIdT      m_did;
+    GMutex *            m_lock; // protects the fields below and socket writes
+    cClientStreamSock * m_sock;
+    GThread *           m_reader;
+    uint32_t            m_epoch;
+    uint16_t            m_next_tag;
+    Waiters             m_waiters;
+};
+
+
+/***************************************************************
+ * Shared connection table, one connection per domain
+ **************************************************************/
+cMuxConnection * ohc_conn_get_ref( SaHpiDomainIdT did );
+void ohc_conn_unref( cMuxConnection * conn );
+
+
+#endif /* __BASELIB_CONNECTION_H */
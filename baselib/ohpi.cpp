@@ -268,6 +268,23 @@ SaErrorT SAHPI_API oHpiGlobalParamSet (
 }
 
 
+/*----------------------------------------------------------------------------*/
+/* oHpiConfigReload                                                           */
+/*----------------------------------------------------------------------------*/
+
+SaErrorT SAHPI_API oHpiConfigReload (
+    SAHPI_IN    SaHpiSessionIdT sid)
+{
+    SaErrorT rv;
+
+    ClientRpcParams iparams;
+    ClientRpcParams oparams;
+    rv = ohc_sess_rpc(eFoHpiConfigReload, sid, iparams, oparams);
+
+    return rv;
+}
+
+
 /*----------------------------------------------------------------------------*/
 /* oHpiInjectEvent                                                            */
 /*----------------------------------------------------------------------------*/
@@ -291,6 +308,120 @@ SaErrorT SAHPI_API oHpiInjectEvent (
     return rv;
 }
 
+/*----------------------------------------------------------------------------*/
+/* oHpiMetricGet                                                              */
+/*----------------------------------------------------------------------------*/
+
+SaErrorT SAHPI_API oHpiMetricGet (
+    SAHPI_IN    SaHpiSessionIdT sid,
+    SAHPI_IN    SaHpiEntryIdT id,
+    SAHPI_OUT   SaHpiEntryIdT *next_id,
+    SAHPI_OUT   oHpiMetricT *metric)
+{
+    SaErrorT rv;
+
+    if (!next_id || !metric || id == SAHPI_LAST_ENTRY) {
+        return SA_ERR_HPI_INVALID_PARAMS;
+    }
+
+    ClientRpcParams iparams(&id);
+    ClientRpcParams oparams(next_id, metric);
+    rv = ohc_sess_rpc(eFoHpiMetricGet, sid, iparams, oparams);
+
+    return rv;
+}
+
+/*----------------------------------------------------------------------------*/
+/* oHpiSensorHistoryGet                                                       */
+/*----------------------------------------------------------------------------*/
+
+SaErrorT SAHPI_API oHpiSensorHistoryGet (
+    SAHPI_IN    SaHpiSessionIdT sid,
+    SAHPI_IN    SaHpiResourceIdT rid,
+    SAHPI_IN    SaHpiSensorNumT num,
+    SAHPI_IN    SaHpiTimeT start,
+    SAHPI_IN    SaHpiTimeT end,
+    SAHPI_INOUT SaHpiUint32T *num_samples,
+    SAHPI_OUT   oHpiSensorSampleT *samples)
+{
+    SaErrorT rv;
+    oHpiSensorHistoryT history;
+    SaHpiUint32T max;
+
+    if (!num_samples || !samples || *num_samples == 0) {
+        return SA_ERR_HPI_INVALID_PARAMS;
+    }
+    if (end != SAHPI_TIME_UNSPECIFIED && end < start) {
+        return SA_ERR_HPI_INVALID_PARAMS;
+    }
+
+    max = *num_samples;
+    if (max > OHPI_SENSOR_HISTORY_MAX_SAMPLES) {
+        max = OHPI_SENSOR_HISTORY_MAX_SAMPLES;
+    }
+
+    history.NumberOfSamples = 0;
+    history.Samples = 0;
+    ClientRpcParams iparams(&rid, &num, &start, &end, &max);
+    ClientRpcParams oparams(&history);
+    rv = ohc_sess_rpc(eFoHpiSensorHistoryGet, sid, iparams, oparams);
+
+    *num_samples = 0;
+    if (rv == SA_OK) {
+        if (history.NumberOfSamples > max) {
+            history.NumberOfSamples = max;
+        }
+        memcpy(samples, history.Samples,
+               history.NumberOfSamples * sizeof(oHpiSensorSampleT));
+        *num_samples = history.NumberOfSamples;
+    }
+    g_free(history.Samples);
+
+    return rv;
+}
+
+/*----------------------------------------------------------------------------*/
+/* oHpiSensorWatchAdd                                                         */
+/*----------------------------------------------------------------------------*/
+
+SaErrorT SAHPI_API oHpiSensorWatchAdd (
+    SAHPI_IN    SaHpiSessionIdT sid,
+    SAHPI_IN    SaHpiResourceIdT rid,
+    SAHPI_IN    SaHpiSensorNumT num,
+    SAHPI_IN    SaHpiUint32T interval,
+    SAHPI_IN    SaHpiFloat64T hysteresis)
+{
+    SaErrorT rv;
+
+    if (interval < OHPI_SENSOR_WATCH_MIN_INTERVAL || !(hysteresis >= 0)) {
+        return SA_ERR_HPI_INVALID_PARAMS;
+    }
+
+    ClientRpcParams iparams(&rid, &num, &interval, &hysteresis);
+    ClientRpcParams oparams;
+    rv = ohc_sess_rpc(eFoHpiSensorWatchAdd, sid, iparams, oparams);
+
+    return rv;
+}
+
+/*----------------------------------------------------------------------------*/
+/* oHpiSensorWatchRemove                                                      */
+/*----------------------------------------------------------------------------*/
+
+SaErrorT SAHPI_API oHpiSensorWatchRemove (
+    SAHPI_IN    SaHpiSessionIdT sid,
+    SAHPI_IN    SaHpiResourceIdT rid,
+    SAHPI_IN    SaHpiSensorNumT num)
+{
+    SaErrorT rv;
+
+    ClientRpcParams iparams(&rid, &num);
+    ClientRpcParams oparams;
+    rv = ohc_sess_rpc(eFoHpiSensorWatchRemove, sid, iparams, oparams);
+
+    return rv;
+}
+
 
 
 /*----------------------------------------------------------------------------*/
@@ -220,6 +220,7 @@ SaErrorT SAHPI_API saHpiDiscover(
     ClientRpcParams iparams;
     ClientRpcParams oparams;
     rv = ohc_sess_rpc(eFsaHpiDiscover, SessionId, iparams, oparams);
+    ohc_sess_invalidate_cache(SessionId, SAHPI_UNSPECIFIED_RESOURCE_ID);
 
     return rv;
 }
@@ -358,9 +359,7 @@ SaErrorT SAHPI_API saHpiRptEntryGetByResourceId(
         return SA_ERR_HPI_INVALID_PARAMS;
     }
 
-    ClientRpcParams iparams(&ResourceId);
-    ClientRpcParams oparams(RptEntry);
-    rv = ohc_sess_rpc(eFsaHpiRptEntryGetByResourceId, SessionId, iparams, oparams);
+    rv = ohc_sess_get_rpt_entry(SessionId, ResourceId, *RptEntry);
 
     if (rv == SA_OK)  {
         SaHpiEntityPathT entity_root;
@@ -395,6 +394,7 @@ SaErrorT SAHPI_API saHpiResourceSeveritySet(
     ClientRpcParams iparams(&ResourceId, &Severity);
     ClientRpcParams oparams;
     rv = ohc_sess_rpc(eFsaHpiResourceSeveritySet, SessionId, iparams, oparams);
+    ohc_sess_invalidate_cache(SessionId, ResourceId);
 
     return rv;
 }
@@ -418,6 +418,7 @@ SaErrorT SAHPI_API saHpiResourceTagSet(
     ClientRpcParams iparams(&ResourceId, ResourceTag);
     ClientRpcParams oparams;
     rv = ohc_sess_rpc(eFsaHpiResourceTagSet, SessionId, iparams, oparams);
+    ohc_sess_invalidate_cache(SessionId, ResourceId);
 
     return rv;
 }
@@ -597,6 +598,7 @@ SaErrorT SAHPI_API saHpiResourceFailedRemove(
     ClientRpcParams iparams(&ResourceId);
     ClientRpcParams oparams;
     rv = ohc_sess_rpc(eFsaHpiResourceFailedRemove, SessionId, iparams, oparams);
+    ohc_sess_invalidate_cache(SessionId, ResourceId);
 
     return rv;
 }
@@ -931,6 +933,13 @@ SaErrorT SAHPI_API saHpiEventGet(
         memcpy(EventQueueStatus, &status, sizeof(SaHpiEvtQueueStatusT));
     }
 
+    /* Resource events tell that cached RPT entry or RDRs are stale */
+    if ((rv == SA_OK) &&
+        ((Event->EventType == SAHPI_ET_RESOURCE) ||
+         (Event->EventType == SAHPI_ET_HOTSWAP))) {
+        ohc_sess_invalidate_cache(SessionId, Event->Source);
+    }
+
     if (rv == SA_OK)  {
         SaHpiEntityPathT entity_root;
         rv = ohc_sess_get_entity_root(SessionId, entity_root);
@@ -1147,9 +1156,7 @@ SaErrorT SAHPI_API saHpiRdrGet(
         return SA_ERR_HPI_INVALID_PARAMS;
     }
 
-    ClientRpcParams iparams(&ResourceId, &EntryId);
-    ClientRpcParams oparams(NextEntryId, Rdr);
-    rv = ohc_sess_rpc(eFsaHpiRdrGet, SessionId, iparams, oparams);
+    rv = ohc_sess_get_rdr(SessionId, ResourceId, EntryId, *NextEntryId, *Rdr);
 
     if (rv == SA_OK)  {
         SaHpiEntityPathT entity_root;
@@ -1180,9 +1187,8 @@ SaErrorT SAHPI_API saHpiRdrGetByInstrumentId(
         return SA_ERR_HPI_INVALID_PARAMS;
     }
 
-    ClientRpcParams iparams(&ResourceId, &RdrType, &InstrumentId);
-    ClientRpcParams oparams(Rdr);
-    rv = ohc_sess_rpc(eFsaHpiRdrGetByInstrumentId, SessionId, iparams, oparams);
+    rv = ohc_sess_get_rdr_by_instrument_id(SessionId, ResourceId,
+                                           RdrType, InstrumentId, *Rdr);
 
     if (rv == SA_OK)  {
         SaHpiEntityPathT entity_root;
@@ -3017,6 +3023,7 @@ SaErrorT SAHPI_API saHpiParmControl(
     ClientRpcParams iparams(&ResourceId, &Action);
     ClientRpcParams oparams;
     rv = ohc_sess_rpc(eFsaHpiParmControl, SessionId, iparams, oparams);
+    ohc_sess_invalidate_cache(SessionId, ResourceId);
 
     return rv;
 }
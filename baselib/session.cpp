@@ -26,7 +26,9 @@
 #include <marshal_hpi.h>
 #include <strmsock.h>
 
+#include "cache.h"
 #include "conf.h"
+#include "connection.h"
 #include "init.h"
 #include "lock.h"
 #include "session.h"
@@ -81,6 +83,17 @@ public:
                   ClientRpcParams& iparams,
                   ClientRpcParams& oparams );
 
+    SaErrorT GetRptEntry( SaHpiResourceIdT rid, SaHpiRptEntryT& rpte );
+    SaErrorT GetRdr( SaHpiResourceIdT rid,
+                     SaHpiEntryIdT entry_id,
+                     SaHpiEntryIdT& next_entry_id,
+                     SaHpiRdrT& rdr );
+    SaErrorT GetRdrByInstrumentId( SaHpiResourceIdT rid,
+                                   SaHpiRdrTypeT type,
+                                   SaHpiInstrumentIdT instrument_id,
+                                   SaHpiRdrT& rdr );
+    void InvalidateCache( SaHpiResourceIdT rid );
+
 private:
 
     cSession( const cSession& );
@@ -88,11 +101,17 @@ private:
 
     SaErrorT DoRpc( uint32_t id,
                     ClientRpcParams& iparams,
-                    ClientRpcParams& oparams );
+                    ClientRpcParams& oparams,
+                    uint32_t epoch = 0 );
+
+    SaErrorT Bind( SaHpiSessionIdT& remote_sid, uint32_t& epoch );
+    SaErrorT Reopen( uint32_t epoch );
 
     SaErrorT GetSock( cClientStreamSock * & sock );
     static void DeleteSock( gpointer ptr );
 
+    void ValidateCache( SaHpiResourceIdT rid, bool rdrs );
+
 private:
 
     static const size_t RPC_ATTEMPTS = 2;
@@ -103,6 +122,12 @@ private:
     SaHpiDomainIdT  m_did;
     SaHpiSessionIdT m_sid;
     SaHpiSessionIdT m_remote_sid;
+    cRptCache *     m_cache;
+    bool            m_subscribed;
+    // Shared connection mode
+    cMuxConnection * m_conn;
+    GMutex *        m_lock;  // serializes rebinding, protects m_subscribed
+    uint32_t        m_epoch; // connection epoch of m_remote_sid
 #if GLIB_CHECK_VERSION (2, 32, 0)
     GPrivate        m_sockets;
 #else
@@ -115,17 +140,33 @@ cSession::cSession()
     : m_ref_cnt( 0 ),
       m_did( SAHPI_UNSPECIFIED_DOMAIN_ID ),
       m_sid( 0 ),
-      m_remote_sid( 0 )
+      m_remote_sid( 0 ),
+      m_cache( 0 ),
+      m_subscribed( false ),
+      m_conn( 0 ),
+      m_epoch( 0 )
 {
+    m_lock = wrap_g_mutex_new_init();
+
     #if GLIB_CHECK_VERSION (2, 32, 0)
     m_sockets = G_PRIVATE_INIT (g_free);
     #else
     wrap_g_static_private_init( &m_sockets );
     #endif
+
+    unsigned int ttl = ohc_get_cache_ttl();
+    if ( ttl != 0 ) {
+        m_cache = new cRptCache( (gint64)ttl * 1000 );
+    }
 }
 
 cSession::~cSession()
 {
+    if ( m_conn ) {
+        ohc_conn_unref( m_conn );
+    }
+    delete m_cache;
+    wrap_g_mutex_free_clear( m_lock );
     wrap_g_static_private_free( &m_sockets );
 }
 
@@ -148,6 +189,17 @@ SaErrorT cSession::GetEntityRoot( SaHpiEntityPathT& entity_root ) const
 SaErrorT cSession::RpcOpen( SaHpiDomainIdT did )
 {
     m_did = did;
+
+    if ( ohc_get_multiplex() ) {
+        if ( !ohc_get_domain_conf( did ) ) {
+            return SA_ERR_HPI_INVALID_DOMAIN;
+        }
+        m_conn = ohc_conn_get_ref( did );
+        SaHpiSessionIdT remote_sid;
+        uint32_t epoch;
+        return Bind( remote_sid, epoch );
+    }
+
     SaHpiDomainIdT remote_did = SAHPI_UNSPECIFIED_DOMAIN_ID;
 
     ClientRpcParams iparams, oparams( &m_remote_sid );
@@ -157,22 +209,240 @@ SaErrorT cSession::RpcOpen( SaHpiDomainIdT did )
 
 SaErrorT cSession::RpcClose()
 {
+    if ( m_conn ) {
+        // The daemon has closed the session with the old connection
+        g_mutex_lock( m_lock );
+        bool open = m_conn->IsOpen( m_epoch );
+        g_mutex_unlock( m_lock );
+        if ( !open ) {
+            return SA_OK;
+        }
+    }
+
     ClientRpcParams iparams, oparams;
     iparams.SetFirst( &m_remote_sid );
-    return DoRpc( eFsaHpiSessionClose, iparams, oparams );
+    return DoRpc( eFsaHpiSessionClose, iparams, oparams, m_epoch );
 }
 
 SaErrorT cSession::Rpc( uint32_t id,
                         ClientRpcParams& iparams,
                         ClientRpcParams& oparams )
 {
-    iparams.SetFirst( &m_remote_sid );
-    return DoRpc( id, iparams, oparams );
+    SaErrorT rv;
+
+    if ( !m_conn ) {
+        iparams.SetFirst( &m_remote_sid );
+        rv = DoRpc( id, iparams, oparams );
+    } else {
+        SaHpiSessionIdT remote_sid;
+        uint32_t epoch;
+        for ( size_t attempt = 0; attempt < RPC_ATTEMPTS; ++attempt ) {
+            rv = Bind( remote_sid, epoch );
+            if ( rv != SA_OK ) {
+                return rv;
+            }
+            iparams.SetFirst( &remote_sid );
+            rv = DoRpc( id, iparams, oparams, epoch );
+            // Retry on the new connection if the old one was lost
+            if ( ( rv != SA_ERR_HPI_NO_RESPONSE ) || m_conn->IsOpen( epoch ) ) {
+                break;
+            }
+        }
+    }
+
+    if ( rv == SA_OK ) {
+        if ( id == eFsaHpiSubscribe ) {
+            g_mutex_lock( m_lock );
+            m_subscribed = true;
+            g_mutex_unlock( m_lock );
+        } else if ( id == eFsaHpiUnsubscribe ) {
+            g_mutex_lock( m_lock );
+            m_subscribed = false;
+            g_mutex_unlock( m_lock );
+        }
+    }
+
+    return rv;
+}
+
+SaErrorT cSession::Bind( SaHpiSessionIdT& remote_sid, uint32_t& epoch )
+{
+    SaErrorT rv = SA_OK;
+
+    g_mutex_lock( m_lock );
+    uint32_t current;
+    if ( !m_conn->Connect( current ) ) {
+        rv = SA_ERR_HPI_NO_RESPONSE;
+    } else if ( current != m_epoch ) {
+        rv = Reopen( current );
+    }
+    remote_sid = m_remote_sid;
+    epoch      = m_epoch;
+    g_mutex_unlock( m_lock );
+
+    return rv;
+}
+
+SaErrorT cSession::Reopen( uint32_t epoch )
+{
+    SaErrorT rv;
+    SaHpiDomainIdT remote_did = SAHPI_UNSPECIFIED_DOMAIN_ID;
+    SaHpiSessionIdT remote_sid;
+
+    ClientRpcParams iparams, oparams( &remote_sid );
+    iparams.SetFirst( &remote_did );
+    rv = DoRpc( eFsaHpiSessionOpen, iparams, oparams, epoch );
+    if ( rv != SA_OK ) {
+        return rv;
+    }
+
+    if ( m_subscribed ) {
+        ClientRpcParams iparams2, oparams2;
+        iparams2.SetFirst( &remote_sid );
+        rv = DoRpc( eFsaHpiSubscribe, iparams2, oparams2, epoch );
+        if ( rv != SA_OK ) {
+            ClientRpcParams iparams3, oparams3;
+            iparams3.SetFirst( &remote_sid );
+            DoRpc( eFsaHpiSessionClose, iparams3, oparams3, epoch );
+            return rv;
+        }
+    }
+
+    if ( m_epoch != 0 ) {
+        WARN( "Session: session %u is bound to new daemon session %u after reconnect.",
+              m_sid, remote_sid );
+    }
+    m_remote_sid = remote_sid;
+    m_epoch      = epoch;
+
+    return SA_OK;
+}
+
+SaErrorT cSession::GetRptEntry( SaHpiResourceIdT rid, SaHpiRptEntryT& rpte )
+{
+    uint32_t gen = 0;
+    if ( m_cache ) {
+        ValidateCache( rid, false );
+        if ( m_cache->IsMissing( rid ) ) {
+            return SA_ERR_HPI_INVALID_RESOURCE;
+        }
+        if ( m_cache->GetRptEntry( rid, rpte ) ) {
+            return SA_OK;
+        }
+        gen = m_cache->GetGeneration();
+    }
+
+    ClientRpcParams iparams( &rid );
+    ClientRpcParams oparams( &rpte );
+    SaErrorT rv = Rpc( eFsaHpiRptEntryGetByResourceId, iparams, oparams );
+    if ( m_cache ) {
+        if ( rv == SA_OK ) {
+            m_cache->AddRptEntry( gen, rpte );
+        } else if ( rv == SA_ERR_HPI_INVALID_RESOURCE ) {
+            m_cache->SetMissing( gen, rid );
+        }
+    }
+
+    return rv;
+}
+
+SaErrorT cSession::GetRdr( SaHpiResourceIdT rid,
+                           SaHpiEntryIdT entry_id,
+                           SaHpiEntryIdT& next_entry_id,
+                           SaHpiRdrT& rdr )
+{
+    uint32_t gen = 0;
+    if ( m_cache ) {
+        ValidateCache( rid, true );
+        if ( m_cache->IsMissing( rid ) ) {
+            return SA_ERR_HPI_INVALID_RESOURCE;
+        }
+        if ( m_cache->GetRdr( rid, entry_id, next_entry_id, rdr ) ) {
+            return SA_OK;
+        }
+        gen = m_cache->GetGeneration();
+    }
+
+    ClientRpcParams iparams( &rid, &entry_id );
+    ClientRpcParams oparams( &next_entry_id, &rdr );
+    SaErrorT rv = Rpc( eFsaHpiRdrGet, iparams, oparams );
+    if ( ( rv == SA_OK ) && m_cache ) {
+        m_cache->AddRdr( gen, rid, entry_id, next_entry_id, rdr );
+    }
+
+    return rv;
+}
+
+SaErrorT cSession::GetRdrByInstrumentId( SaHpiResourceIdT rid,
+                                         SaHpiRdrTypeT type,
+                                         SaHpiInstrumentIdT instrument_id,
+                                         SaHpiRdrT& rdr )
+{
+    uint32_t gen = 0;
+    if ( m_cache ) {
+        ValidateCache( rid, true );
+        if ( m_cache->IsMissing( rid ) ) {
+            return SA_ERR_HPI_INVALID_RESOURCE;
+        }
+        if ( m_cache->GetRdrByInstrumentId( rid, type, instrument_id, rdr ) ) {
+            return SA_OK;
+        }
+        gen = m_cache->GetGeneration();
+    }
+
+    ClientRpcParams iparams( &rid, &type, &instrument_id );
+    ClientRpcParams oparams( &rdr );
+    SaErrorT rv = Rpc( eFsaHpiRdrGetByInstrumentId, iparams, oparams );
+    if ( ( rv == SA_OK ) && m_cache ) {
+        m_cache->AddRdrByInstrumentId( gen, rid, rdr );
+    }
+
+    return rv;
+}
+
+void cSession::InvalidateCache( SaHpiResourceIdT rid )
+{
+    if ( m_cache ) {
+        m_cache->Invalidate( rid );
+    }
+}
+
+void cSession::ValidateCache( SaHpiResourceIdT rid, bool rdrs )
+{
+    // Update counters are checked at most once per TTL,
+    // calls in between are served without any RPC.
+    if ( m_cache->IsRptCheckDue() ) {
+        SaHpiDomainInfoT info;
+        ClientRpcParams iparams;
+        ClientRpcParams oparams( &info );
+        SaErrorT rv = Rpc( eFsaHpiDomainInfoGet, iparams, oparams );
+        if ( rv == SA_OK ) {
+            m_cache->SetRptUpdateCount( info.RptUpdateCount );
+        } else {
+            m_cache->Invalidate( SAHPI_UNSPECIFIED_RESOURCE_ID );
+        }
+    }
+    if ( rdrs && m_cache->IsRdrCheckDue( rid ) ) {
+        SaHpiUint32T count;
+        uint32_t gen = m_cache->GetGeneration();
+        ClientRpcParams iparams( &rid );
+        ClientRpcParams oparams( &count );
+        SaErrorT rv = Rpc( eFsaHpiRdrUpdateCountGet, iparams, oparams );
+        if ( rv == SA_OK ) {
+            m_cache->SetRdrUpdateCount( rid, count );
+        } else if ( rv == SA_ERR_HPI_INVALID_RESOURCE ) {
+            // Kept until the RPT changes, later lookups need no RPC
+            m_cache->SetMissing( gen, rid );
+        } else {
+            m_cache->Invalidate( rid );
+        }
+    }
 }
 
 SaErrorT cSession::DoRpc( uint32_t id,
                           ClientRpcParams& iparams,
-                          ClientRpcParams& oparams )
+                          ClientRpcParams& oparams,
+                          uint32_t epoch )
 {
     SaErrorT rv;
 
@@ -199,6 +469,22 @@ SaErrorT cSession::DoRpc( uint32_t id,
         if ( attempt > 0 ) {
             DBG( "Session: RPC request %u, Attempt %u\n", id, (unsigned int)attempt );
         }
+        if ( m_conn ) {
+            // Shared connection is reopened by the caller if necessary
+            uint32_t current;
+            if ( m_conn->Connect( current ) ) {
+                if ( ( epoch != 0 ) && ( epoch != current ) ) {
+                    break;
+                }
+                rc = m_conn->Call( current, id, data, data_len,
+                                   rp_type, rp_id, rp_byte_order );
+                if ( rc ) {
+                    break;
+                }
+            }
+            g_usleep( NEXT_RPC_ATTEMPT_TIMEOUT );
+            continue;
+        }
         cClientStreamSock * sock;
         rv = GetSock( sock );
         if ( rv != SA_OK ) {
@@ -252,20 +538,11 @@ SaErrorT cSession::GetSock( cClientStreamSock * & sock )
             return SA_ERR_HPI_INVALID_DOMAIN;
         }
 
-        sock = new cClientStreamSock;
-
-        bool rc = sock->Create( dc->host, dc->port );
-        if ( !rc ) {
-            delete sock;
-            CRIT("Session: cannot open connection to domain %u.", m_did );
+        sock = ohc_connect( dc );
+        if ( !sock ) {
             return SA_ERR_HPI_NO_RESPONSE;
         }
 
-        // TODO configuration file, env vars?
-        sock->EnableKeepAliveProbes( /* keepalive_time*/    1,
-                                     /* keepalive_intvl */  1,
-                                     /* keepalive_probes */ 3 );
-
         #if GLIB_CHECK_VERSION (2, 32, 0)
         wrap_g_static_private_set( &m_sockets, sock );
         #else
@@ -468,3 +745,61 @@ SaErrorT ohc_sess_get_entity_root( SaHpiSessionIdT sid, SaHpiEntityPathT& ep )
     return rv;
 }
 
+SaErrorT ohc_sess_get_rpt_entry( SaHpiSessionIdT sid,
+                                 SaHpiResourceIdT rid,
+                                 SaHpiRptEntryT& rpte )
+{
+    cSession * session = sessions_get_ref( sid );
+    if ( !session ) {
+        return SA_ERR_HPI_INVALID_SESSION;
+    }
+
+    SaErrorT rv = session->GetRptEntry( rid, rpte );
+    sessions_unref( session );
+
+    return rv;
+}
+
+SaErrorT ohc_sess_get_rdr( SaHpiSessionIdT sid,
+                           SaHpiResourceIdT rid,
+                           SaHpiEntryIdT entry_id,
+                           SaHpiEntryIdT& next_entry_id,
+                           SaHpiRdrT& rdr )
+{
+    cSession * session = sessions_get_ref( sid );
+    if ( !session ) {
+        return SA_ERR_HPI_INVALID_SESSION;
+    }
+
+    SaErrorT rv = session->GetRdr( rid, entry_id, next_entry_id, rdr );
+    sessions_unref( session );
+
+    return rv;
+}
+
+SaErrorT ohc_sess_get_rdr_by_instrument_id( SaHpiSessionIdT sid,
+                                            SaHpiResourceIdT rid,
+                                            SaHpiRdrTypeT type,
+                                            SaHpiInstrumentIdT instrument_id,
+                                            SaHpiRdrT& rdr )
+{
+    cSession * session = sessions_get_ref( sid );
+    if ( !session ) {
+        return SA_ERR_HPI_INVALID_SESSION;
+    }
+
+    SaErrorT rv = session->GetRdrByInstrumentId( rid, type, instrument_id, rdr );
+    sessions_unref( session );
+
+    return rv;
+}
+
+void ohc_sess_invalidate_cache( SaHpiSessionIdT sid, SaHpiResourceIdT rid )
+{
+    cSession * session = sessions_get_ref( sid );
+    if ( session ) {
+        session->InvalidateCache( rid );
+        sessions_unref( session );
+    }
+}
+
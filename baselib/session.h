@@ -38,5 +38,22 @@ SaErrorT ohc_sess_rpc( uint32_t id,
 SaErrorT ohc_sess_get_did( SaHpiSessionIdT sid, SaHpiDomainIdT& did );
 SaErrorT ohc_sess_get_entity_root( SaHpiSessionIdT sid, SaHpiEntityPathT& ep );
 
+/* RPT/RDR lookups, served from the session cache when it is enabled */
+SaErrorT ohc_sess_get_rpt_entry( SaHpiSessionIdT sid,
+                                 SaHpiResourceIdT rid,
+                                 SaHpiRptEntryT& rpte );
+SaErrorT ohc_sess_get_rdr( SaHpiSessionIdT sid,
+                           SaHpiResourceIdT rid,
+                           SaHpiEntryIdT entry_id,
+                           SaHpiEntryIdT& next_entry_id,
+                           SaHpiRdrT& rdr );
+SaErrorT ohc_sess_get_rdr_by_instrument_id( SaHpiSessionIdT sid,
+                                            SaHpiResourceIdT rid,
+                                            SaHpiRdrTypeT type,
+                                            SaHpiInstrumentIdT instrument_id,
+                                            SaHpiRdrT& rdr );
+/* SAHPI_UNSPECIFIED_RESOURCE_ID drops the whole cache */
+void ohc_sess_invalidate_cache( SaHpiSessionIdT sid, SaHpiResourceIdT rid );
+
 #endif /* __BASELIB_SESSION_H */
 
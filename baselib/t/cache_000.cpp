@@ -0,0 +1,146 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cache.h"
+
+#define TTL ( 60 * G_USEC_PER_SEC )
+
+static int failed = 0;
+
+#define CHECK( expr ) \
+    if ( !( expr ) ) { \
+        printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr ); \
+        failed = 1; \
+    }
+
+static void make_rpte( SaHpiResourceIdT rid, SaHpiRptEntryT& rpte )
+{
+    memset( &rpte, 0, sizeof(rpte) );
+    rpte.EntryId    = rid;
+    rpte.ResourceId = rid;
+    rpte.ResourceCapabilities = SAHPI_CAPABILITY_RESOURCE |
+                                SAHPI_CAPABILITY_RDR |
+                                SAHPI_CAPABILITY_SENSOR;
+}
+
+static void make_rdr( SaHpiEntryIdT id, SaHpiSensorNumT num, SaHpiRdrT& rdr )
+{
+    memset( &rdr, 0, sizeof(rdr) );
+    rdr.RecordId = id;
+    rdr.RdrType  = SAHPI_SENSOR_RDR;
+    rdr.RdrTypeUnion.SensorRec.Num = num;
+}
+
+/**
+ * Cache hits, invalidation by RPT and RDR update counters and
+ * remembered missing resources.
+ * Passes if every lookup finds exactly what is still valid,
+ * otherwise fails.
+ **/
+int main( int argc, char **argv )
+{
+    cRptCache cache( TTL );
+    SaHpiRptEntryT rpte, out_rpte;
+    SaHpiRdrT rdr, out_rdr;
+    SaHpiEntryIdT next;
+    uint32_t gen;
+
+    // nothing checked yet
+    CHECK( cache.IsRptCheckDue() );
+    CHECK( cache.IsRdrCheckDue( 1 ) );
+    cache.SetRptUpdateCount( 10 );
+    CHECK( !cache.IsRptCheckDue() );
+
+    // hit
+    make_rpte( 1, rpte );
+    gen = cache.GetGeneration();
+    cache.AddRptEntry( gen, rpte );
+    CHECK( cache.GetRptEntry( 1, out_rpte ) );
+    CHECK( out_rpte.ResourceId == 1 );
+    CHECK( !cache.GetRptEntry( 2, out_rpte ) );
+
+    // data fetched before an invalidation is not added
+    make_rpte( 2, rpte );
+    gen = cache.GetGeneration();
+    cache.Invalidate( 3 );
+    cache.AddRptEntry( gen, rpte );
+    CHECK( !cache.GetRptEntry( 2, out_rpte ) );
+
+    // RDRs are kept while the RDR update counter stays the same
+    cache.SetRdrUpdateCount( 1, 5 );
+    CHECK( !cache.IsRdrCheckDue( 1 ) );
+    make_rdr( 0, 7, rdr );
+    gen = cache.GetGeneration();
+    cache.AddRdr( gen, 1, SAHPI_FIRST_ENTRY, SAHPI_LAST_ENTRY, rdr );
+    CHECK( cache.GetRdr( 1, SAHPI_FIRST_ENTRY, next, out_rdr ) );
+    CHECK( next == SAHPI_LAST_ENTRY );
+    CHECK( cache.GetRdrByInstrumentId( 1, SAHPI_SENSOR_RDR, 7, out_rdr ) );
+    CHECK( !cache.GetRdrByInstrumentId( 1, SAHPI_SENSOR_RDR, 8, out_rdr ) );
+    cache.SetRdrUpdateCount( 1, 5 );
+    CHECK( cache.GetRdr( 1, SAHPI_FIRST_ENTRY, next, out_rdr ) );
+
+    // a new RDR update counter drops the RDRs but not the RPT entry
+    cache.SetRdrUpdateCount( 1, 6 );
+    CHECK( !cache.GetRdr( 1, SAHPI_FIRST_ENTRY, next, out_rdr ) );
+    CHECK( !cache.GetRdrByInstrumentId( 1, SAHPI_SENSOR_RDR, 7, out_rdr ) );
+    CHECK( cache.GetRptEntry( 1, out_rpte ) );
+
+    // an unchanged RPT update counter keeps everything
+    cache.SetRptUpdateCount( 10 );
+    CHECK( cache.GetRptEntry( 1, out_rpte ) );
+
+    // a new RPT update counter drops everything
+    cache.SetRptUpdateCount( 11 );
+    CHECK( !cache.GetRptEntry( 1, out_rpte ) );
+    CHECK( cache.IsRdrCheckDue( 1 ) );
+
+    // missing resources need no RDR update counter check...
+    gen = cache.GetGeneration();
+    cache.SetMissing( gen, 4 );
+    CHECK( cache.IsMissing( 4 ) );
+    CHECK( !cache.IsRdrCheckDue( 4 ) );
+    CHECK( !cache.IsMissing( 5 ) );
+
+    // ...unless they were marked with a stale generation...
+    gen = cache.GetGeneration();
+    cache.Invalidate( 6 );
+    cache.SetMissing( gen, 5 );
+    CHECK( !cache.IsMissing( 5 ) );
+
+    // ...and they are forgotten on invalidation or a new RPT
+    cache.Invalidate( 4 );
+    CHECK( !cache.IsMissing( 4 ) );
+    gen = cache.GetGeneration();
+    cache.SetMissing( gen, 4 );
+    CHECK( cache.IsMissing( 4 ) );
+    cache.SetRptUpdateCount( 11 );
+    CHECK( cache.IsMissing( 4 ) );
+    cache.SetRptUpdateCount( 12 );
+    CHECK( !cache.IsMissing( 4 ) );
+
+    // a resource that shows up again is not missing
+    gen = cache.GetGeneration();
+    cache.SetMissing( gen, 4 );
+    make_rpte( 4, rpte );
+    cache.AddRptEntry( gen, rpte );
+    CHECK( !cache.IsMissing( 4 ) );
+    CHECK( cache.GetRptEntry( 4, out_rpte ) );
+
+    // everything goes when the session asks for it
+    cache.Invalidate( SAHPI_UNSPECIFIED_RESOURCE_ID );
+    CHECK( !cache.GetRptEntry( 4, out_rpte ) );
+    CHECK( cache.IsRptCheckDue() );
+
+    return failed;
+}
@@ -41,6 +41,8 @@
     "         Find the right handler for a resource id              \n\n" \
     "Command retry <handler-id>                                     \n" \
     "         Retry loading of handler <handler-id>                 \n\n" \
+    "Command reload                                                 \n" \
+    "         Reload the daemon configuration file                  \n\n" \
     "Command create plugin <name> <params>                          \n" \
     "         Create handler with the specified parameters.         \n" \
     "         Pairs of strings in commandline like in openhpi.conf. \n" \
@@ -60,6 +62,7 @@ static SaErrorT exechandlerinfo(oHpiHandlerIdT);
 static SaErrorT exechandlergetnext(oHpiHandlerIdT);
 static SaErrorT exechandlerfind(SaHpiResourceIdT);
 static SaErrorT exechandlerretry(oHpiHandlerIdT);
+static SaErrorT exechandlerreload(void);
 static SaErrorT exechandlerlist(void);
 
 
@@ -90,6 +93,7 @@ main(int argc, char **argv)
       eHandlerGetNext, 
       eHandlerFind,
       eHandlerRetry,
+      eHandlerReload,
       eHandlerList} cmd=eUndefined;
        
    /* Print version strings */
@@ -154,6 +158,11 @@ main(int argc, char **argv)
          else printusage = TRUE;
       }
 
+      else if (strcmp(argv[i],"reload")==0) {
+         cmd=eHandlerReload;
+         if (++i<argc) printusage = TRUE;
+      }
+
       else if (strcmp(argv[i],"list")==0) {
          cmd=eHandlerList;
          if (++i<argc) printusage = TRUE;
@@ -212,6 +221,9 @@ main(int argc, char **argv)
                 case eHandlerRetry:
                                    rv = exechandlerretry ( handlerid );
                                    break;
+                case eHandlerReload:
+                                   rv = exechandlerreload ( );
+                                   break;
                 case eHandlerList:
                                    rv = exechandlerlist ( );
                                    break;
@@ -365,7 +377,10 @@ SaErrorT exechandlerinfo(oHpiHandlerIdT handlerid)
    printf("Root ");
    oh_print_ep (&(handlerinfo.entity_root),0);
 
-   printf("Failed attempts to load handler: %u\n",handlerinfo.load_failed);
+   if (handlerinfo.load_failed == OHPI_HANDLER_OPENING)
+      printf("Handler is still opening\n");
+   else
+      printf("Failed attempts to load handler: %u\n",handlerinfo.load_failed);
 
    printf("\nHandler configuration:\n");
    printf ("   plugin %s\n", (const char *)handlerinfo.plugin_name);
@@ -462,6 +477,26 @@ static SaErrorT exechandlerretry(oHpiHandlerIdT handlerid)
    return rv;
 }
 
+/********************************************/ 
+/* exechandlerreload                        */
+/********************************************/
+static SaErrorT exechandlerreload()
+{
+   SaErrorT rv = SA_OK;
+
+   if (copt.debug) DBG("Go and reload the configuration of domain %u",
+                      copt.domainid);
+
+   rv = oHpiConfigReload ( sessionid );
+
+   if (rv!=SA_OK) {
+      CRIT("oHpiConfigReload returned %s", oh_lookup_error(rv));
+      return rv;
+   }
+   printf("\nConfiguration successfully reloaded.\n");
+   return rv;
+}
+
 /********************************************/ 
 /* exechandlerlist                          */
 /********************************************/
@@ -52,6 +52,11 @@ typedef struct {
     SaHpiInt32T load_failed;
 } oHpiHandlerInfoT;
 
+/* oHpiHandlerInfoT load_failed values */
+#define OHPI_HANDLER_LOADED  0 /* Opened */
+#define OHPI_HANDLER_FAILED  1 /* Open failed or timed out */
+#define OHPI_HANDLER_OPENING 2 /* Still opening, daemon startup only */
+
 
 typedef struct {
     SaHpiDomainIdT   id;
@@ -104,6 +109,41 @@ typedef struct {
 } oHpiGlobalParamT;
 
 
+/* Histogram bucket i counts samples of at most 2^i microseconds */
+#define OHPI_METRIC_BUCKETS 24
+
+typedef enum {
+    OHPI_METRIC_COUNTER = 1,
+    OHPI_METRIC_GAUGE,
+    OHPI_METRIC_HISTOGRAM
+} oHpiMetricTypeT;
+
+typedef struct {
+    oHpiMetricTypeT Type;
+    SaHpiTextBufferT Name; /* Metric name, e.g. openhpid_rpc_duration_microseconds */
+    SaHpiTextBufferT Labels; /* Label set, e.g. rpc="saHpiEventGet", may be empty */
+    SaHpiUint64T Value; /* Counter or gauge value, number of histogram samples */
+    SaHpiUint64T Sum; /* Histogram only: sum of samples in microseconds */
+    SaHpiUint64T Buckets[OHPI_METRIC_BUCKETS]; /* Histogram only: cumulative */
+} oHpiMetricT;
+
+
+/* Most samples oHpiSensorHistoryGet() returns in one call */
+#define OHPI_SENSOR_HISTORY_MAX_SAMPLES 1024
+
+typedef struct {
+    SaHpiTimeT Timestamp; /* When the daemon read the sensor */
+    SaHpiEventStateT EventState;
+    SaHpiSensorReadingT Reading;
+} oHpiSensorSampleT;
+
+
+/* Shortest poll interval of a sensor watch in msec */
+#define OHPI_SENSOR_WATCH_MIN_INTERVAL 100
+/* Oem field of the sensor events posted for sensor watches */
+#define OHPI_SENSOR_WATCH_OEM 0x4F485357
+
+
 /***************************************************************************
 **
 ** Name: oHpiVersionGet()
@@ -184,6 +224,7 @@ SaErrorT SAHPI_API oHpiHandlerCreate (
 ** Return Value:
 **   SA_OK is returned on successful completion; otherwise, an error code is
 **      returned.
+**   SA_ERR_HPI_BUSY is returned when the handler is still opening.
 **   SA_ERR_HPI_ERROR is returned:
 **   * when the daemon failed to destroy the handler.
 **   * in other error cases.
@@ -228,6 +269,10 @@ SaErrorT SAHPI_API oHpiHandlerDestroy (
 **
 ** Remarks:
 **   This is Daemon level function.
+**   The daemon opens the handlers of its configuration file in parallel
+**   and serves calls while they are coming up. info->load_failed tells
+**   whether a handler is opened (OHPI_HANDLER_LOADED), still opening
+**   (OHPI_HANDLER_OPENING) or failed to open (OHPI_HANDLER_FAILED).
 **
 ***************************************************************************/
 SaErrorT SAHPI_API oHpiHandlerInfo (
@@ -337,6 +382,7 @@ SaErrorT SAHPI_API oHpiHandlerFind (
 **   SA_OK is returned if the handler was already successfully initialized.
 **   SA_ERR_HPI_NOT_PRESENT is returned when the targeted OpenHPI daemon
 **      has no handler with the specified id.
+**   SA_ERR_HPI_BUSY is returned when the handler is still opening.
 **
 ** Remarks:
 **   This is Daemon level function.
@@ -411,6 +457,40 @@ SaErrorT SAHPI_API oHpiGlobalParamSet (
      SAHPI_IN    SaHpiSessionIdT sid,
      SAHPI_IN    oHpiGlobalParamT *param );
 
+/***************************************************************************
+**
+** Name: oHpiConfigReload()
+**
+** Description:
+**   This function makes the targeted OpenHPI daemon read its configuration
+**   file again without a restart. It does the same as sending SIGHUP to
+**   the daemon, but returns once the reload is done.
+**
+** Parameters:
+**   sid - [in] Identifier for a session context previously obtained using
+**      saHpiSessionOpen().
+**
+** Return Value:
+**   SA_OK is returned on successful completion; otherwise, an error code is
+**      returned.
+**   SA_ERR_HPI_NOT_PRESENT is returned if the configuration file could not
+**      be read. The daemon keeps its configuration then.
+**
+** Remarks:
+**   This is Daemon level function.
+**   The global parameters of the file replace the current ones all at
+**   once. Parameters that are only read at daemon startup still need a
+**   restart.
+**   Handlers whose configuration did not change keep running with their
+**   resources. Handlers whose configuration changed or was removed are
+**   destroyed and their resources removed; new and changed configurations
+**   get new handlers, which open and discover in the background.
+**   Handlers created with oHpiHandlerCreate() are not touched.
+**
+***************************************************************************/
+SaErrorT SAHPI_API oHpiConfigReload (
+     SAHPI_IN    SaHpiSessionIdT sid );
+
 /***************************************************************************
 **
 ** Name: oHpiInjectEvent()
@@ -458,6 +538,173 @@ SaErrorT SAHPI_API oHpiInjectEvent (
      SAHPI_IN    SaHpiRptEntryT *rpte,
      SAHPI_IN    SaHpiRdrT *rdr);
 
+/***************************************************************************
+**
+** Name: oHpiMetricGet()
+**
+** Description:
+**   This function is used for reading the run-time metrics of the targeted
+**   OpenHPI daemon: RPC and plugin call latencies, discovery duration,
+**   event queue depths, event counts and the number of sessions.
+**
+** Parameters:
+**   sid - [in] Identifier for a session context previously obtained using
+**      saHpiSessionOpen().
+**   id - [in] Identifier of the metric to retrieve. Reserved id values:
+**   * SAHPI_FIRST_ENTRY     Get first metric.
+**   * SAHPI_LAST_ENTRY      Reserved as delimiter for end of list. Not a valid
+**      metric identifier.
+**   next_id - [out] Pointer to location to store the id of the next metric.
+**      SAHPI_LAST_ENTRY is returned after the last metric.
+**   metric - [out] Pointer to the structure to hold the returned metric.
+**
+** Return Value:
+**   SA_OK is returned on successful completion; otherwise, an error code is
+**      returned.
+**   SA_ERR_HPI_INVALID_PARAMS is returned if next_id or metric is passed
+**      in as NULL, or id is SAHPI_LAST_ENTRY.
+**   SA_ERR_HPI_NOT_PRESENT is returned when there is no metric with the
+**      specified id or after it.
+**
+** Remarks:
+**   This is Daemon level function.
+**   Histograms with no samples are skipped. Counters only grow while the
+**   daemon runs; rates are left to the consumer.
+**
+***************************************************************************/
+SaErrorT SAHPI_API oHpiMetricGet (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiEntryIdT id,
+     SAHPI_OUT   SaHpiEntryIdT *next_id,
+     SAHPI_OUT   oHpiMetricT *metric );
+
+/***************************************************************************
+**
+** Name: oHpiSensorHistoryGet()
+**
+** Description:
+**   This function is used for reading the history that the targeted OpenHPI
+**   daemon keeps of a sensor. The daemon reads the sensors every
+**   OPENHPI_HISTORY_INTERVAL milliseconds and keeps the last
+**   OPENHPI_HISTORY_SIZE readings of each.
+**
+** Parameters:
+**   sid - [in] Identifier for a session context previously obtained using
+**      saHpiSessionOpen().
+**   rid - [in] Resource id of the sensor.
+**   num - [in] Sensor number.
+**   start - [in] Time of the oldest sample to return.
+**   end - [in] Time of the newest sample to return. SAHPI_TIME_UNSPECIFIED
+**      stands for the newest sample there is.
+**   num_samples - [in/out] On input the number of entries samples can
+**      hold, at most OHPI_SENSOR_HISTORY_MAX_SAMPLES are returned. On output
+**      the number of samples returned.
+**   samples - [out] Samples taken between start and end, oldest first.
+**
+** Return Value:
+**   SA_OK is returned on successful completion; otherwise, an error code is
+**      returned.
+**   SA_ERR_HPI_INVALID_PARAMS is returned if num_samples or samples is
+**      passed in as NULL, *num_samples is 0 or end is before start.
+**   SA_ERR_HPI_NOT_PRESENT is returned if the daemon keeps no history of
+**      the sensor.
+**
+** Remarks:
+**   This is Daemon level function.
+**   If *num_samples comes back as large as it was passed in, there may be
+**   more samples in the time range. Call again with start set to one past
+**   the Timestamp of the last sample.
+**   Failed readings are not recorded.
+**
+***************************************************************************/
+SaErrorT SAHPI_API oHpiSensorHistoryGet (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num,
+     SAHPI_IN    SaHpiTimeT start,
+     SAHPI_IN    SaHpiTimeT end,
+     SAHPI_INOUT SaHpiUint32T *num_samples,
+     SAHPI_OUT   oHpiSensorSampleT *samples );
+
+/***************************************************************************
+**
+** Name: oHpiSensorWatchAdd()
+**
+** Description:
+**   This function is used for having the targeted OpenHPI daemon watch a
+**   sensor. The daemon polls the sensor every interval milliseconds and
+**   posts a sensor event when the reading or the event state changed.
+**   A sensor is polled once per interval however many sessions watch it.
+**
+** Parameters:
+**   sid - [in] Identifier for a session context previously obtained using
+**      saHpiSessionOpen().
+**   rid - [in] Resource id of the sensor.
+**   num - [in] Sensor number.
+**   interval - [in] Poll interval in milliseconds, at least
+**      OHPI_SENSOR_WATCH_MIN_INTERVAL.
+**   hysteresis - [in] How far a numeric reading has to move away from the
+**      reading of the last event for a new event. 0 means any change.
+**
+** Return Value:
+**   SA_OK is returned on successful completion; otherwise, an error code is
+**      returned.
+**   SA_ERR_HPI_INVALID_PARAMS is returned if interval is too short or
+**      hysteresis is negative.
+**   SA_ERR_HPI_INVALID_RESOURCE is returned if there is no such resource.
+**   SA_ERR_HPI_CAPABILITY is returned if the resource has no sensors.
+**   SA_ERR_HPI_NOT_PRESENT is returned if there is no such sensor.
+**
+** Remarks:
+**   This is Daemon level function.
+**   Calling it again for the same sensor changes interval and hysteresis.
+**   When several sessions watch a sensor, it is polled at the shortest
+**   interval and with the smallest hysteresis of them.
+**   The events are SAHPI_ET_SENSOR events of SAHPI_INFORMATIONAL severity
+**   and go to all sessions subscribed to the domain. EventState holds the
+**   current event states, the Oem field is OHPI_SENSOR_WATCH_OEM and the
+**   trigger reading is the new reading.
+**   The first poll only takes the reading to compare with.
+**   Watches end with the session.
+**
+***************************************************************************/
+SaErrorT SAHPI_API oHpiSensorWatchAdd (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num,
+     SAHPI_IN    SaHpiUint32T interval,
+     SAHPI_IN    SaHpiFloat64T hysteresis );
+
+/***************************************************************************
+**
+** Name: oHpiSensorWatchRemove()
+**
+** Description:
+**   This function is used for ending a watch set up with
+**   oHpiSensorWatchAdd().
+**
+** Parameters:
+**   sid - [in] Identifier for a session context previously obtained using
+**      saHpiSessionOpen().
+**   rid - [in] Resource id of the sensor.
+**   num - [in] Sensor number.
+**
+** Return Value:
+**   SA_OK is returned on successful completion; otherwise, an error code is
+**      returned.
+**   SA_ERR_HPI_NOT_PRESENT is returned if the session does not watch the
+**      sensor.
+**
+** Remarks:
+**   This is Daemon level function.
+**   The daemon keeps polling the sensor while other sessions watch it.
+**
+***************************************************************************/
+SaErrorT SAHPI_API oHpiSensorWatchRemove (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num );
+
 /***************************************************************************
 **
 ** Name: oHpiDomainAdd()
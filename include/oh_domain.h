@@ -85,6 +85,11 @@ struct oh_domain {
         struct oh_drt drt;
         /* Domain Event Log */
         oh_el *del;
+        /* Subscribed sessions (struct oh_session_subscribers).
+           Replaced as a whole by session code while holding the
+           domain lock. Event processing takes a reference under the
+           same lock and fans out after releasing it. */
+        gpointer subscribers;
 
         /* Synchronization - used internally by domain interfaces */
 #if GLIB_CHECK_VERSION (2, 32, 0)
@@ -95,6 +100,7 @@ struct oh_domain {
         GStaticRecMutex refcount_lock;
 #endif
         int refcount;
+        int lock_depth; /* Nesting of the domain lock, changed under it */
 };
 
 SaErrorT oh_create_domain(SaHpiDomainIdT id,
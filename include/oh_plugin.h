@@ -100,6 +100,14 @@ struct oh_handler {
         GStaticRecMutex refcount_lock;
 #endif
         int refcount;
+
+        /* Admission control for calls into the handler (dispatch.h) */
+        struct oh_abi_queue *dispatch;
+
+        /* Set while abi->open runs in the background, see
+         * oh_create_handler_async(). The opening thread holds lock. */
+        volatile int opening;
+        SaHpiUint64T open_deadline; /* oh_metrics_now() based, 0 is none */
 };
 extern struct oh_handlers oh_handlers;
 
@@ -117,9 +125,15 @@ int oh_unload_plugin(char *plugin_name);
 
 /* Handler (plugin instances) interface functions */
 struct oh_handler *oh_get_handler(unsigned int hid);
+struct oh_handler *oh_get_handler_timed(unsigned int hid, SaErrorT *error);
+struct oh_handler *oh_get_handler_try(unsigned int hid, SaErrorT *error);
 void oh_release_handler(struct oh_handler *handler);
 int oh_getnext_handler_id(unsigned int hid, unsigned int *next_hid);
 SaErrorT oh_create_handler(GHashTable *handler_config, unsigned int *hid);
+SaErrorT oh_create_handler_async(GHashTable *handler_config, unsigned int *hid);
+guint oh_wait_for_handlers(guint timeout);
+void oh_finit_handler_opens(void);
+SaHpiBoolT oh_handler_is_opening(unsigned int hid);
 int oh_destroy_handler(unsigned int hid);
 SaErrorT oh_get_handler_info(unsigned int hid, oHpiHandlerInfoT *info, GHashTable *conf_params);
 SaErrorT oh_discovery(void);
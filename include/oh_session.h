@@ -61,30 +61,72 @@ struct oh_session {
 
         SaHpiBoolT subscribed;
 
-        /* Initialized to false. Will be set to true*/
-        SaHpiEvtQueueStatusT eventq_status;
-
         /*
           Even if multiple sessions are opened for the same domain,
           each session could receive different events depending on what
           events the caller signs up for.
 
-          This is the session specific event queue
+          This is the session specific event queue: a ring of
+          eventq_size slots holding eventq_len events from eventq_head.
+          The ring grows up to OPENHPI_EVT_QUEUE_LIMIT slots; after that
+          OPENHPI_EVT_QUEUE_POLICY decides which event is dropped.
+          Everything below is protected by eventq_lock, and subscribed
+          is also changed under it so that waiters wake up precisely.
         */
-        GAsyncQueue *eventq;
+        GMutex *eventq_lock;
+        GCond *eventq_cond;
+        struct oh_event **eventq;
+        guint eventq_size;
+        guint eventq_head;
+        guint eventq_len;
+
+        /* Initialized to false. Will be set to true*/
+        SaHpiEvtQueueStatusT eventq_status;
+
+        /* Set when the session is closed, waiters return */
+        SaHpiBoolT eventq_closed;
+
+        /* Events dropped or coalesced due to queue overflow */
+        SaHpiUint64T eventq_dropped;
 
+        /*
+          The session table holds one reference, event waiters
+          hold one each while they wait on eventq_cond.
+        */
+        gint refcount;
 };
 
+/*
+ * Snapshot of the sessions subscribed to a domain's events.
+ * Never changed once published; holds a reference on every session
+ * in it. See oh_get_domain_subscribers().
+ */
+struct oh_session_subscribers {
+        gint refcount;
+        guint len;
+        struct oh_session *sessions[1];
+};
+
+struct oh_domain;
+
 SaHpiSessionIdT oh_create_session(SaHpiDomainIdT did);
 SaHpiDomainIdT oh_get_session_domain(SaHpiSessionIdT sid);
 GArray *oh_list_sessions(SaHpiDomainIdT did);
 SaErrorT oh_get_session_subscription(SaHpiSessionIdT sid, SaHpiBoolT *state);
 SaErrorT oh_set_session_subscription(SaHpiSessionIdT sid, SaHpiBoolT state);
 SaErrorT oh_queue_session_event(SaHpiSessionIdT sid, struct oh_event *event);
+struct oh_session_subscribers *oh_get_domain_subscribers(struct oh_domain *d);
+void oh_release_subscribers(struct oh_session_subscribers *subs);
+guint oh_queue_subscribers_event(struct oh_session_subscribers *subs,
+                                 struct oh_event *event);
 SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
                                   SaHpiTimeoutT timeout,
                                   struct oh_event *event,
                                   SaHpiEvtQueueStatusT *eventq_status);
+SaErrorT oh_get_session_queue_stats(SaHpiSessionIdT sid,
+                                    guint *len,
+                                    SaHpiUint64T *dropped);
+void oh_get_sessions_stats(guint *sessions, guint *queued, guint *max_queued);
 SaErrorT oh_destroy_session(SaHpiSessionIdT sid);
 
 #ifdef __cplusplus
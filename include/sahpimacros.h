@@ -64,17 +64,27 @@
 
 /*
  * OH_HANDLER_GET gets the hander for the rpt and resource id.  It
- * returns INVALID PARAMS if the handler isn't there
+ * returns INVALID PARAMS if the handler isn't there, and BUSY or
+ * TIMEOUT if the handler did not admit the call (dispatch.h).
+ * The domain is released before waiting for the handler, so callers
+ * must not use it (or its RPT entries and RDRs) afterwards.
  */
 #define OH_HANDLER_GET(d, rid, h) \
         { \
                 unsigned int *hid = NULL; \
+                unsigned int admit_hid; \
+                SaErrorT admit_error; \
                 hid = oh_get_resource_data(&(d->rpt), rid); \
                 if (!hid) { \
                         oh_release_domain(d); \
                         return SA_ERR_HPI_INVALID_RESOURCE; \
                 } \
-                h = oh_get_handler(*hid); \
+                admit_hid = *hid; \
+                oh_release_domain(d); \
+                h = oh_get_handler_timed(admit_hid, &admit_error); \
+                if (admit_error != SA_OK) { \
+                        return admit_error; \
+                } \
 		if (h && !h->hnd) { \
 			oh_release_handler(h); \
 			h = NULL; \
@@ -116,15 +126,18 @@
  * OH_CALL_ABI will check for a valid handler struct and existing plugin abi.
  * If a valid abi or handler is not found, it returns error. Once it passes
  * this validity check, it will call the plugin abi function with the passed
- * parameters. 
+ * parameters. The call time is recorded in the daemon metrics (metrics.h).
  */
 #define OH_CALL_ABI(handler, func, err, ret, params...) \
 	{ \
+		SaHpiUint64T oh_abi_start; \
 		if (!handler || !handler->abi->func) { \
                 	oh_release_handler(handler); \
                 	return err; \
         	} \
+		oh_abi_start = oh_metrics_now(); \
         	ret = handler->abi->func(handler->hnd, params); \
+		oh_metrics_abi(handler->id, oh_metrics_now() - oh_abi_start); \
         }
 
 #endif
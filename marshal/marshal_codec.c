@@ -0,0 +1,645 @@
+/*
+ * compiled marshaling/demarshaling for same byte order peers
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <oh_error.h>
+
+#include "marshal_codec.h"
+
+
+typedef enum
+{
+  eMcEnd,
+  eMcCopy,          // copy m_size bytes as is
+  eMcUnion,         // select sub-codec by modifier field
+  eMcVarArray,      // m_nelements field + pointer to elements
+  eMcUserDefined    // fall back to the interpreter
+} tMarshalCodecOp;
+
+typedef struct
+{
+  size_t         m_mod;
+  cMarshalCodec *m_codec;
+} cMarshalCodecUnionElement;
+
+typedef struct
+{
+  tMarshalCodecOp m_op;
+  size_t          m_param;  // index in the data array
+  size_t          m_offset; // data offset in the param
+  size_t          m_size;   // eMcCopy: number of bytes
+                            // eMcVarArray: element sizeof
+
+  // eMcUnion, eMcVarArray: modifier or number of elements field
+  size_t          m_int_offset;
+  tMarshalType    m_int_type;
+
+  // eMcUnion
+  size_t                     m_nelements;
+  cMarshalCodecUnionElement *m_elements;
+
+  // eMcVarArray
+  cMarshalCodec  *m_codec;
+  gboolean        m_flat;   // elements can be copied in one go
+
+  // eMcUserDefined
+  const cMarshalType *m_type;
+} cMarshalCodecOp;
+
+struct sMarshalCodec
+{
+  cMarshalCodecOp *m_ops; // terminated by eMcEnd
+};
+
+
+static size_t
+SimpleTypeSize( tMarshalType type )
+{
+  switch( type )
+     {
+       case eMtInt8:
+       case eMtUint8:
+	    return sizeof( tUint8 );
+       case eMtInt16:
+       case eMtUint16:
+	    return sizeof( tUint16 );
+       case eMtInt32:
+       case eMtUint32:
+	    return sizeof( tUint32 );
+       case eMtInt64:
+       case eMtUint64:
+	    return sizeof( tUint64 );
+       case eMtFloat32:
+	    return sizeof( tFloat32 );
+       case eMtFloat64:
+	    return sizeof( tFloat64 );
+       default:
+	    return 0;
+     }
+}
+
+
+static gboolean
+IsIntegerType( tMarshalType type )
+{
+  switch( type )
+     {
+       case eMtInt8:
+       case eMtUint8:
+       case eMtInt16:
+       case eMtUint16:
+       case eMtInt32:
+       case eMtUint32:
+       case eMtInt64:
+       case eMtUint64:
+	    return TRUE;
+       default:
+	    return FALSE;
+     }
+}
+
+
+static size_t
+GetIntegerValue( tMarshalType type, const unsigned char *data )
+{
+  union
+  {
+    tInt8   i8;
+    tUint8  ui8;
+    tInt16  i16;
+    tUint16 ui16;
+    tInt32  i32;
+    tUint32 ui32;
+    tInt64  i64;
+    tUint64 ui64;
+  } u;
+
+  memcpy( &u, data, SimpleTypeSize( type ) );
+
+  switch( type )
+     {
+       case eMtInt8:
+	    return (size_t)u.i8;
+       case eMtUint8:
+	    return (size_t)u.ui8;
+       case eMtInt16:
+	    return (size_t)u.i16;
+       case eMtUint16:
+	    return (size_t)u.ui16;
+       case eMtInt32:
+	    return (size_t)u.i32;
+       case eMtUint32:
+	    return (size_t)u.ui32;
+       case eMtInt64:
+	    return (size_t)u.i64;
+       case eMtUint64:
+	    return (size_t)u.ui64;
+       default:
+	    return SIZE_MAX;
+     }
+}
+
+
+static void
+AddOp( GArray *ops, const cMarshalCodecOp *op )
+{
+  g_array_append_vals( ops, op, 1 );
+}
+
+
+static void
+AddCopy( GArray *ops, size_t param, size_t offset, size_t size )
+{
+  // merge with the previous copy if the fields are adjacent in memory
+  if ( ops->len > 0 )
+     {
+       cMarshalCodecOp *last = &g_array_index( ops, cMarshalCodecOp, ops->len - 1 );
+       if (    ( last->m_op == eMcCopy )
+            && ( last->m_param == param )
+            && ( ( last->m_offset + last->m_size ) == offset ) )
+	  {
+	    last->m_size += size;
+	    return;
+	  }
+     }
+
+  cMarshalCodecOp op;
+  memset( &op, 0, sizeof( op ) );
+  op.m_op     = eMcCopy;
+  op.m_param  = param;
+  op.m_offset = offset;
+  op.m_size   = size;
+  AddOp( ops, &op );
+}
+
+
+static cMarshalCodec *
+CreateCodec( GArray *ops )
+{
+  cMarshalCodecOp end;
+  memset( &end, 0, sizeof( end ) );
+  end.m_op = eMcEnd;
+  AddOp( ops, &end );
+
+  cMarshalCodec *codec = g_new0( cMarshalCodec, 1 );
+  codec->m_ops = (cMarshalCodecOp *)g_array_free( ops, FALSE );
+
+  return codec;
+}
+
+
+static void
+FreeOps( GArray *ops )
+{
+  guint i;
+  for( i = 0; i < ops->len; i++ )
+     {
+       cMarshalCodecOp *op = &g_array_index( ops, cMarshalCodecOp, i );
+       if ( op->m_op == eMcUnion )
+	  {
+	    size_t j;
+	    for( j = 0; j < op->m_nelements; j++ )
+		 MarshalCodecFree( op->m_elements[j].m_codec );
+	    g_free( op->m_elements );
+	  }
+       else if ( op->m_op == eMcVarArray )
+	  {
+	    MarshalCodecFree( op->m_codec );
+	  }
+     }
+
+  g_array_free( ops, TRUE );
+}
+
+
+static gboolean CompileType( GArray *ops, const cMarshalType *type,
+			     size_t param, size_t offset );
+
+
+static gboolean
+CompileUnion( GArray *ops, const cMarshalType *type, size_t i, size_t param, size_t offset )
+{
+  const cMarshalType *elems = &type->u.m_struct.m_elements[0];
+  const cMarshalType *elem  = elems[i].u.m_struct_element.m_element;
+  const size_t mod_idx      = elem->u.m_union.m_mod_idx;
+
+  // same limitation as for Demarshal()
+  if ( mod_idx >= i )
+       return FALSE;
+
+  const cMarshalType *mod_type = elems[mod_idx].u.m_struct_element.m_element;
+  if ( !IsIntegerType( mod_type->m_type ) )
+       return FALSE;
+
+  const cMarshalType *uelems = &elem->u.m_union.m_elements[0];
+  size_t n;
+  for( n = 0; uelems[n].m_type == eMtUnionElement; n++ )
+       ;
+
+  cMarshalCodecOp op;
+  memset( &op, 0, sizeof( op ) );
+  op.m_op         = eMcUnion;
+  op.m_param      = param;
+  op.m_offset     = offset + elems[i].u.m_struct_element.m_offset;
+  op.m_int_offset = offset + elems[mod_idx].u.m_struct_element.m_offset;
+  op.m_int_type   = mod_type->m_type;
+  op.m_nelements  = n;
+  op.m_elements   = g_new0( cMarshalCodecUnionElement, n );
+
+  // add op first so that it is released on failure
+  AddOp( ops, &op );
+
+  size_t j;
+  for( j = 0; j < n; j++ )
+     {
+       op.m_elements[j].m_mod   = uelems[j].u.m_union_element.m_mod;
+       op.m_elements[j].m_codec = MarshalCodecCompile( uelems[j].u.m_union_element.m_element );
+       if ( !op.m_elements[j].m_codec )
+	    return FALSE;
+     }
+
+  return TRUE;
+}
+
+
+static gboolean
+CompileVarArray( GArray *ops, const cMarshalType *type, size_t i, size_t param, size_t offset )
+{
+  const cMarshalType *elems = &type->u.m_struct.m_elements[0];
+  const cMarshalType *elem  = elems[i].u.m_struct_element.m_element;
+  const size_t nelems_idx   = elem->u.m_var_array.m_nelements_idx;
+
+  // same limitation as for Demarshal()
+  if ( nelems_idx >= i )
+       return FALSE;
+
+  const cMarshalType *nelems_type = elems[nelems_idx].u.m_struct_element.m_element;
+  if ( !IsIntegerType( nelems_type->m_type ) )
+       return FALSE;
+
+  cMarshalCodec *codec = MarshalCodecCompile( elem->u.m_var_array.m_element );
+  if ( !codec )
+       return FALSE;
+
+  cMarshalCodecOp op;
+  memset( &op, 0, sizeof( op ) );
+  op.m_op         = eMcVarArray;
+  op.m_param      = param;
+  op.m_offset     = offset + elems[i].u.m_struct_element.m_offset;
+  op.m_size       = elem->u.m_var_array.m_element_sizeof;
+  op.m_int_offset = offset + elems[nelems_idx].u.m_struct_element.m_offset;
+  op.m_int_type   = nelems_type->m_type;
+  op.m_codec      = codec;
+
+  // an element without padding is a single copy of element size
+  const cMarshalCodecOp *eops = codec->m_ops;
+  op.m_flat =    ( eops[0].m_op == eMcCopy )
+              && ( eops[0].m_offset == 0 )
+              && ( eops[0].m_size == op.m_size )
+              && ( eops[1].m_op == eMcEnd );
+
+  AddOp( ops, &op );
+
+  return TRUE;
+}
+
+
+static gboolean
+CompileType( GArray *ops, const cMarshalType *type, size_t param, size_t offset )
+{
+  switch( type->m_type )
+     {
+       case eMtVoid:
+	    return TRUE;
+
+       case eMtInt8:
+       case eMtUint8:
+       case eMtInt16:
+       case eMtUint16:
+       case eMtInt32:
+       case eMtUint32:
+       case eMtInt64:
+       case eMtUint64:
+       case eMtFloat32:
+       case eMtFloat64:
+	    AddCopy( ops, param, offset, SimpleTypeSize( type->m_type ) );
+	    return TRUE;
+
+       case eMtArray:
+	    {
+	      const cMarshalType *elem = type->u.m_array.m_element;
+	      const size_t elem_sizeof = type->u.m_array.m_element_sizeof;
+
+	      size_t i;
+	      for( i = 0; i < type->u.m_array.m_nelements; i++ )
+		 {
+		   if ( !CompileType( ops, elem, param, offset + i * elem_sizeof ) )
+			return FALSE;
+		 }
+	    }
+	    return TRUE;
+
+       case eMtStruct:
+	    {
+	      const cMarshalType *elems = &type->u.m_struct.m_elements[0];
+
+	      size_t i;
+	      for( i = 0; elems[i].m_type == eMtStructElement; i++ )
+		 {
+		   const cMarshalType *elem = elems[i].u.m_struct_element.m_element;
+		   const size_t offset2     = offset + elems[i].u.m_struct_element.m_offset;
+		   gboolean rc;
+
+		   if ( elem->m_type == eMtUnion )
+			rc = CompileUnion( ops, type, i, param, offset );
+		   else if ( elem->m_type == eMtVarArray )
+			rc = CompileVarArray( ops, type, i, param, offset );
+		   else
+			rc = CompileType( ops, elem, param, offset2 );
+
+		   if ( !rc )
+			return FALSE;
+		 }
+	    }
+	    return TRUE;
+
+       case eMtUserDefined:
+	    {
+	      cMarshalCodecOp op;
+	      memset( &op, 0, sizeof( op ) );
+	      op.m_op     = eMcUserDefined;
+	      op.m_param  = param;
+	      op.m_offset = offset;
+	      op.m_type   = type;
+	      AddOp( ops, &op );
+	    }
+	    return TRUE;
+
+       default:
+	    return FALSE;
+     }
+}
+
+
+cMarshalCodec *
+MarshalCodecCompile( const cMarshalType *type )
+{
+  const cMarshalType *types[2];
+  types[0] = type;
+  types[1] = 0;
+
+  return MarshalCodecCompileArray( types );
+}
+
+
+cMarshalCodec *
+MarshalCodecCompileArray( const cMarshalType **types )
+{
+  GArray *ops = g_array_new( FALSE, TRUE, sizeof( cMarshalCodecOp ) );
+
+  size_t i;
+  for( i = 0; types[i]; i++ )
+     {
+       if ( !CompileType( ops, types[i], i, 0 ) )
+	  {
+	    DBG( "MarshalCodecCompile: %s cannot be compiled.", types[i]->m_name );
+	    FreeOps( ops );
+	    return 0;
+	  }
+     }
+
+  return CreateCodec( ops );
+}
+
+
+void
+MarshalCodecFree( cMarshalCodec *codec )
+{
+  if ( !codec )
+       return;
+
+  cMarshalCodecOp *op;
+  for( op = codec->m_ops; op->m_op != eMcEnd; op++ )
+     {
+       if ( op->m_op == eMcUnion )
+	  {
+	    size_t j;
+	    for( j = 0; j < op->m_nelements; j++ )
+		 MarshalCodecFree( op->m_elements[j].m_codec );
+	    g_free( op->m_elements );
+	  }
+       else if ( op->m_op == eMcVarArray )
+	  {
+	    MarshalCodecFree( op->m_codec );
+	  }
+     }
+
+  g_free( codec->m_ops );
+  g_free( codec );
+}
+
+
+static const cMarshalCodec *
+GetUnionCodec( const cMarshalCodecOp *op, size_t modifier )
+{
+  size_t j;
+  for( j = 0; j < op->m_nelements; j++ )
+     {
+       if ( op->m_elements[j].m_mod == modifier )
+	    return op->m_elements[j].m_codec;
+     }
+
+  return 0;
+}
+
+
+int
+MarshalCodec( const cMarshalCodec *codec, const void *data, void *buffer )
+{
+  const void *param[1];
+  param[0] = data;
+
+  return MarshalCodecArray( codec, param, buffer );
+}
+
+
+int
+MarshalCodecArray( const cMarshalCodec *codec, const void **data, void *b )
+{
+  unsigned char *buffer = b;
+  const cMarshalCodecOp *op;
+
+  for( op = codec->m_ops; op->m_op != eMcEnd; op++ )
+     {
+       const unsigned char *d = data[op->m_param];
+       int cc = 0;
+
+       switch( op->m_op )
+	  {
+	    case eMcCopy:
+		 memcpy( buffer, d + op->m_offset, op->m_size );
+		 cc = op->m_size;
+		 break;
+
+	    case eMcUnion:
+		 {
+		   const size_t mod = GetIntegerValue( op->m_int_type, d + op->m_int_offset );
+		   const cMarshalCodec *codec2 = GetUnionCodec( op, mod );
+		   if ( !codec2 )
+		      {
+			CRIT( "MarshalCodec: invalid mod value %u!", (unsigned int)mod );
+			return -EINVAL;
+		      }
+		   cc = MarshalCodec( codec2, d + op->m_offset, buffer );
+		 }
+		 break;
+
+	    case eMcVarArray:
+		 {
+		   const size_t nelems = GetIntegerValue( op->m_int_type, d + op->m_int_offset );
+		   // (d + offset) points to pointer to var array content
+		   const unsigned char *data2;
+		   memcpy( &data2, d + op->m_offset, sizeof( void * ) );
+
+		   if ( op->m_flat )
+		      {
+			if ( nelems > 0 )
+			     memcpy( buffer, data2, nelems * op->m_size );
+			cc = nelems * op->m_size;
+			break;
+		      }
+
+		   size_t i;
+		   for( i = 0; i < nelems; i++ )
+		      {
+			int cc2 = MarshalCodec( op->m_codec, data2, buffer + cc );
+			if ( cc2 < 0 )
+			     return cc2;
+
+			data2 += op->m_size;
+			cc    += cc2;
+		      }
+		 }
+		 break;
+
+	    case eMcUserDefined:
+		 cc = Marshal( op->m_type, d + op->m_offset, buffer );
+		 break;
+
+	    default:
+		 return -ENOSYS;
+	  }
+
+       if ( cc < 0 )
+	    return cc;
+
+       buffer += cc;
+     }
+
+  return buffer - (unsigned char *)b;
+}
+
+
+int
+DemarshalCodec( const cMarshalCodec *codec, void *data, const void *buffer )
+{
+  void *param[1];
+  param[0] = data;
+
+  return DemarshalCodecArray( codec, param, buffer );
+}
+
+
+int
+DemarshalCodecArray( const cMarshalCodec *codec, void **data, const void *b )
+{
+  const unsigned char *buffer = b;
+  const cMarshalCodecOp *op;
+
+  for( op = codec->m_ops; op->m_op != eMcEnd; op++ )
+     {
+       unsigned char *d = data[op->m_param];
+       int cc = 0;
+
+       switch( op->m_op )
+	  {
+	    case eMcCopy:
+		 memcpy( d + op->m_offset, buffer, op->m_size );
+		 cc = op->m_size;
+		 break;
+
+	    case eMcUnion:
+		 {
+		   // the modifier field has already been demarshaled
+		   const size_t mod = GetIntegerValue( op->m_int_type, d + op->m_int_offset );
+		   const cMarshalCodec *codec2 = GetUnionCodec( op, mod );
+		   if ( !codec2 )
+		      {
+			CRIT( "DemarshalCodec: invalid mod value %u!", (unsigned int)mod );
+			return -EINVAL;
+		      }
+		   cc = DemarshalCodec( codec2, d + op->m_offset, buffer );
+		 }
+		 break;
+
+	    case eMcVarArray:
+		 {
+		   const size_t nelems = GetIntegerValue( op->m_int_type, d + op->m_int_offset );
+
+		   // allocate storage for var array content
+		   unsigned char *data2 = g_new0( unsigned char, nelems * op->m_size );
+		   // (d + offset) points to pointer to var array content
+		   memcpy( d + op->m_offset, &data2, sizeof( void * ) );
+
+		   if ( op->m_flat )
+		      {
+			if ( nelems > 0 )
+			     memcpy( data2, buffer, nelems * op->m_size );
+			cc = nelems * op->m_size;
+			break;
+		      }
+
+		   size_t i;
+		   for( i = 0; i < nelems; i++ )
+		      {
+			int cc2 = DemarshalCodec( op->m_codec, data2, buffer + cc );
+			if ( cc2 < 0 )
+			     return cc2;
+
+			data2 += op->m_size;
+			cc    += cc2;
+		      }
+		 }
+		 break;
+
+	    case eMcUserDefined:
+		 cc = Demarshal( G_BYTE_ORDER, op->m_type, d + op->m_offset, buffer );
+		 break;
+
+	    default:
+		 return -ENOSYS;
+	  }
+
+       if ( cc < 0 )
+	    return cc;
+
+       buffer += cc;
+     }
+
+  return buffer - (const unsigned char *)b;
+}
@@ -0,0 +1,63 @@
+/*
+ * compiled marshaling/demarshaling for same byte order peers
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+#ifndef dMarshalCodec_h
+#define dMarshalCodec_h
+
+#include <stddef.h>
+
+#ifndef dMarshal_h
+#include "marshal.h"
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// NB
+//
+// A codec is a flat list of operations compiled once from
+// a marshal type tree. Adjacent fields that are contiguous
+// in memory are merged into a single copy operation.
+// Unions, var arrays and user defined types keep a small
+// sub-codec or fall back to the interpreter.
+//
+// The wire format produced is identical to Marshal().
+// Decoding with a codec is only valid when the peer
+// has the same byte order (no byte swapping is done).
+//
+
+struct sMarshalCodec;
+typedef struct sMarshalCodec cMarshalCodec;
+
+
+// compile codec for a single type or 0-terminated type list
+// returns 0 if the type tree cannot be compiled
+cMarshalCodec *MarshalCodecCompile( const cMarshalType *type );
+cMarshalCodec *MarshalCodecCompileArray( const cMarshalType **types );
+void MarshalCodecFree( cMarshalCodec *codec );
+
+// marshal data into buffer
+int MarshalCodec( const cMarshalCodec *codec, const void *data, void *buffer );
+int MarshalCodecArray( const cMarshalCodec *codec, const void **data, void *buffer );
+
+// demarshal buffer into data, buffer must be in host byte order
+int DemarshalCodec( const cMarshalCodec *codec, void *data, const void *buffer );
+int DemarshalCodecArray( const cMarshalCodec *codec, void **data, const void *buffer );
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
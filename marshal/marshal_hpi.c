@@ -22,6 +22,8 @@
 
 #include <stddef.h>
 
+#include <glib.h>
+
 #include <oh_error.h>
 
 #include "marshal_hpi.h"
@@ -2016,6 +2018,82 @@ static const cMarshalType *oHpiInjectEventOut[] =
 };
 
 
+static const cMarshalType *oHpiMetricGetIn[] =
+{
+  &SaHpiSessionIdType, // session id (SaHpiSessionIdT)
+  &SaHpiEntryIdType, // metric id
+  0
+};
+
+static const cMarshalType *oHpiMetricGetOut[] =
+{
+  &SaErrorType, // result (SaErrorT)
+  &SaHpiEntryIdType, // next metric id
+  &oHpiMetricType, // metric
+  0
+};
+
+static const cMarshalType *oHpiSensorHistoryGetIn[] =
+{
+  &SaHpiSessionIdType, // session id (SaHpiSessionIdT)
+  &SaHpiResourceIdType, // resource id (SaHpiResourceIdT)
+  &SaHpiSensorNumType, // sensor num (SaHpiSensorNumT)
+  &SaHpiTimeType, // start (SaHpiTimeT)
+  &SaHpiTimeType, // end (SaHpiTimeT)
+  &SaHpiUint32Type, // max number of samples
+  0
+};
+
+static const cMarshalType *oHpiSensorHistoryGetOut[] =
+{
+  &SaErrorType, // result (SaErrorT)
+  &oHpiSensorHistoryType, // samples
+  0
+};
+
+static const cMarshalType *oHpiSensorWatchAddIn[] =
+{
+  &SaHpiSessionIdType, // session id (SaHpiSessionIdT)
+  &SaHpiResourceIdType, // resource id (SaHpiResourceIdT)
+  &SaHpiSensorNumType, // sensor num (SaHpiSensorNumT)
+  &SaHpiUint32Type, // interval
+  &SaHpiFloat64Type, // hysteresis
+  0
+};
+
+static const cMarshalType *oHpiSensorWatchAddOut[] =
+{
+  &SaErrorType, // result (SaErrorT)
+  0
+};
+
+static const cMarshalType *oHpiSensorWatchRemoveIn[] =
+{
+  &SaHpiSessionIdType, // session id (SaHpiSessionIdT)
+  &SaHpiResourceIdType, // resource id (SaHpiResourceIdT)
+  &SaHpiSensorNumType, // sensor num (SaHpiSensorNumT)
+  0
+};
+
+static const cMarshalType *oHpiSensorWatchRemoveOut[] =
+{
+  &SaErrorType, // result (SaErrorT)
+  0
+};
+
+static const cMarshalType *oHpiConfigReloadIn[] =
+{
+  &SaHpiSessionIdType, // session id (SaHpiSessionIdT)
+  0
+};
+
+static const cMarshalType *oHpiConfigReloadOut[] =
+{
+  &SaErrorType, // result (SaErrorT)
+  0
+};
+
+
 static cHpiMarshal hpi_marshal[] =
 {
   dHpiMarshalEntry( saHpiSessionOpen ),
@@ -2149,6 +2227,12 @@ static cHpiMarshal hpi_marshal[] =
   dHpiMarshalEntry( saHpiFumiAutoRollbackDisableSet ),
   dHpiMarshalEntry( saHpiFumiActivateStart ),
   dHpiMarshalEntry( saHpiFumiCleanup ),
+
+  dHpiMarshalEntry( oHpiMetricGet ),
+  dHpiMarshalEntry( oHpiSensorHistoryGet ),
+  dHpiMarshalEntry( oHpiSensorWatchAdd ),
+  dHpiMarshalEntry( oHpiSensorWatchRemove ),
+  dHpiMarshalEntry( oHpiConfigReload ),
 };
 
 
@@ -2167,10 +2251,47 @@ HpiMarshalFind( int id )
 }
 
 
+/***********************************************************
+ * Gets compiled codec for request or reply params,
+ * compiles it on first use.
+ *
+ * returns codec or 0 if params cannot be compiled
+ * (the interpreter is used then)
+ ***********************************************************/
+static const cMarshalCodec *
+HpiMarshalCodec( cMarshalCodec **codec, const cMarshalType **types )
+{
+  cMarshalCodec *c = g_atomic_pointer_get( (gpointer *)codec );
+  if ( c ) {
+      return c;
+  }
+
+  c = MarshalCodecCompileArray( types );
+  if ( !c ) {
+      return 0;
+  }
+
+  // another thread may have compiled it in the meantime
+  if ( !g_atomic_pointer_compare_and_exchange( (gpointer *)codec, 0, c ) ) {
+      MarshalCodecFree( c );
+      c = g_atomic_pointer_get( (gpointer *)codec );
+  }
+
+  return c;
+}
+
+
 int
 HpiMarshalRequest( cHpiMarshal *m, void *buffer, const void **param )
 {
-    int cc = MarshalArray( m->m_request, param, buffer );
+    const cMarshalCodec *codec = HpiMarshalCodec( &m->m_request_codec, m->m_request );
+
+    int cc;
+    if ( codec ) {
+        cc = MarshalCodecArray( codec, param, buffer );
+    } else {
+        cc = MarshalArray( m->m_request, param, buffer );
+    }
     if ( cc < 0 ) {
         CRIT( "%s: HpiMarshalRequest: failure, cc = %d", m->m_name, cc );
     }
@@ -2259,7 +2380,17 @@ HpiMarshalRequest6( cHpiMarshal *m, void *buffer, const void *p1, const void *p2
 int
 HpiDemarshalRequest( int byte_order, cHpiMarshal *m, const void *buffer, void **params )
 {
-    int cc = DemarshalArray( byte_order, m->m_request, params, buffer );
+    const cMarshalCodec *codec = 0;
+    if ( byte_order == G_BYTE_ORDER ) {
+        codec = HpiMarshalCodec( &m->m_request_codec, m->m_request );
+    }
+
+    int cc;
+    if ( codec ) {
+        cc = DemarshalCodecArray( codec, params, buffer );
+    } else {
+        cc = DemarshalArray( byte_order, m->m_request, params, buffer );
+    }
     if ( cc < 0 ) {
         CRIT( "%s: HpiDemarshalRequest: failure, cc = %d", m->m_name, cc );
     }
@@ -2350,7 +2481,12 @@ HpiMarshalReply( cHpiMarshal *m, void *buffer, const void **params )
 
     int cc;
     if ( err == SA_OK ) {
-        cc = MarshalArray( m->m_reply, params, buffer );
+        const cMarshalCodec *codec = HpiMarshalCodec( &m->m_reply_codec, m->m_reply );
+        if ( codec ) {
+            cc = MarshalCodecArray( codec, params, buffer );
+        } else {
+            cc = MarshalArray( m->m_reply, params, buffer );
+        }
     } else {
         cc = Marshal( &SaErrorType, &err, buffer );
     }
@@ -2450,7 +2586,15 @@ HpiDemarshalReply( int byte_order, cHpiMarshal *m, const void *buffer, void **pa
     if ( cc > 0 ) {
         SaErrorT err = *(SaErrorT *)params[0];
         if ( err == SA_OK ) {
-            cc = DemarshalArray( byte_order, m->m_reply, params, buffer );
+            const cMarshalCodec *codec = 0;
+            if ( byte_order == G_BYTE_ORDER ) {
+                codec = HpiMarshalCodec( &m->m_reply_codec, m->m_reply );
+            }
+            if ( codec ) {
+                cc = DemarshalCodecArray( codec, params, buffer );
+            } else {
+                cc = DemarshalArray( byte_order, m->m_reply, params, buffer );
+            }
         }
     }
     if ( cc < 0 ) {
@@ -25,6 +25,10 @@
 #include "marshal_hpi_types.h"
 #endif
 
+#ifndef dMarshalCodec_h
+#include "marshal_codec.h"
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -166,6 +170,12 @@ typedef enum
   eFsaHpiFumiActivateStart,
   eFsaHpiFumiCleanup,
 
+  eFoHpiMetricGet,
+  eFoHpiSensorHistoryGet,
+  eFoHpiSensorWatchAdd,
+  eFoHpiSensorWatchRemove,
+  eFoHpiConfigReload,
+
 } tHpiFucntionId;
 
 
@@ -175,6 +185,8 @@ typedef struct
   const char          *m_name;
   const cMarshalType **m_request;
   const cMarshalType **m_reply; // the first param is the result
+  cMarshalCodec       *m_request_codec; // compiled on first use
+  cMarshalCodec       *m_reply_codec;   // compiled on first use
 } cHpiMarshal;
 
 
@@ -183,7 +195,9 @@ typedef struct
   eF ## name,                  \
   #name,                       \
   name ## In,                  \
-  name ## Out                  \
+  name ## Out,                 \
+  0,                           \
+  0                            \
 }
 
 
@@ -1145,3 +1145,43 @@ static cMarshalType oHpiGlobalParamTypeElements[] =
 
 cMarshalType oHpiGlobalParamType = dStruct( oHpiGlobalParamTypeElements );
 
+
+// metric
+static cMarshalType MetricBucketsArray = dArray( "MetricBucketsArray", OHPI_METRIC_BUCKETS, SaHpiUint64T, SaHpiUint64Type );
+
+static cMarshalType oHpiMetricTypeElements[] =
+{
+  dStructElement( oHpiMetricT, Type,    oHpiMetricTypeType ),
+  dStructElement( oHpiMetricT, Name,    SaHpiTextBufferType ),
+  dStructElement( oHpiMetricT, Labels,  SaHpiTextBufferType ),
+  dStructElement( oHpiMetricT, Value,   SaHpiUint64Type ),
+  dStructElement( oHpiMetricT, Sum,     SaHpiUint64Type ),
+  dStructElement( oHpiMetricT, Buckets, MetricBucketsArray ),
+  dStructElementEnd()
+};
+
+cMarshalType oHpiMetricType = dStruct( oHpiMetricTypeElements );
+
+
+// sensor history
+static cMarshalType oHpiSensorSampleTypeElements[] =
+{
+  dStructElement( oHpiSensorSampleT, Timestamp,  SaHpiTimeType ),
+  dStructElement( oHpiSensorSampleT, EventState, SaHpiEventStateType ),
+  dStructElement( oHpiSensorSampleT, Reading,    SaHpiSensorReadingType ),
+  dStructElementEnd()
+};
+
+cMarshalType oHpiSensorSampleType = dStruct( oHpiSensorSampleTypeElements );
+
+static cMarshalType SensorHistorySamplesArray = dVarArray( "SensorHistorySamplesArray", 0, oHpiSensorSampleT, oHpiSensorSampleType );
+
+static cMarshalType oHpiSensorHistoryTypeElements[] =
+{
+  dStructElement( oHpiSensorHistoryT, NumberOfSamples, SaHpiUint32Type ),
+  dStructElement( oHpiSensorHistoryT, Samples,         SensorHistorySamplesArray ),
+  dStructElementEnd()
+};
+
+cMarshalType oHpiSensorHistoryType = dStruct( oHpiSensorHistoryTypeElements );
+
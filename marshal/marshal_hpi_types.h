@@ -23,6 +23,7 @@
 
 
 #include <SaHpi.h>
+#include <oHpi.h>
 
 #ifndef dMarshal_h
 #include "marshal.h"
@@ -298,6 +299,14 @@ extern cMarshalType oHpiHandlerConfigType;
 extern cMarshalType oHpiHandlerInfoType;
 #define oHpiGlobalParamTypeType SaHpiUint32Type
 extern cMarshalType oHpiGlobalParamType;
+#define oHpiMetricTypeType SaHpiUint32Type
+extern cMarshalType oHpiMetricType;
+extern cMarshalType oHpiSensorSampleType;
+typedef struct {
+	SaHpiUint32T NumberOfSamples;
+	oHpiSensorSampleT *Samples;
+} oHpiSensorHistoryT;
+extern cMarshalType oHpiSensorHistoryType;
 
 #ifdef __cplusplus
 }
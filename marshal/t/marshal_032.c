@@ -0,0 +1,198 @@
+/*
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+#include <glib.h>
+#include "marshal.h"
+#include "marshal_codec.h"
+#include <string.h>
+
+
+typedef struct
+{
+  tUint8   m_u8;
+  tUint16  m_u16;
+} cTest2;
+
+cMarshalType Test2Elements[] =
+{
+  dStructElement( cTest2, m_u8 , Marshal_Uint8Type  ),
+  dStructElement( cTest2, m_u16, Marshal_Uint16Type ),
+  dStructElementEnd()
+};
+
+cMarshalType Test2Type = dStruct( Test2Elements );
+
+
+typedef union
+{
+  tUint32  m_u32;
+  tFloat64 m_f64;
+  cTest2   m_struct2;
+} cUnion;
+
+cMarshalType UnionElements[] =
+{
+  dUnionElement( 1, Marshal_Uint32Type  ),
+  dUnionElement( 2, Marshal_Float64Type ),
+  dUnionElement( 3, Test2Type ),
+  dUnionElementEnd()
+};
+
+cMarshalType UnionType = dUnion( 1, UnionElements );
+
+cMarshalType VarArrayType = dVarArray( "VarArray", 3, cTest2, Test2Type );
+
+cMarshalType ArrayType = dArray( "Array", 4, tUint16, Marshal_Uint16Type );
+
+
+typedef struct
+{
+  tUint8   m_pad1;
+  tUint8   m_mod;
+  cUnion   m_union;
+  tUint32  m_nelements;
+  cTest2  *m_var;
+  tUint16  m_array[4];
+  tUint8   m_pad2;
+} cTest1;
+
+cMarshalType Test1Elements[] =
+{
+  dStructElement( cTest1, m_pad1     , Marshal_Uint8Type  ),
+  dStructElement( cTest1, m_mod      , Marshal_Uint8Type  ),
+  dStructElement( cTest1, m_union    , UnionType          ),
+  dStructElement( cTest1, m_nelements, Marshal_Uint32Type ),
+  dStructElement( cTest1, m_var      , VarArrayType       ),
+  dStructElement( cTest1, m_array    , ArrayType          ),
+  dStructElement( cTest1, m_pad2     , Marshal_Uint8Type  ),
+  dStructElementEnd()
+};
+
+cMarshalType Test1Type = dStruct( Test1Elements );
+
+
+static int
+check( const cMarshalCodec *codec, cTest1 *value )
+{
+  unsigned char buffer1[256];
+  unsigned char buffer2[256];
+  cTest1        result;
+  unsigned int  i;
+
+  int s1 = Marshal( &Test1Type, value, buffer1 );
+  int s2 = MarshalCodec( codec, value, buffer2 );
+
+  if ( s1 <= 0 || s1 != s2 )
+       return 0;
+
+  // the compiled codec must produce identical wire data
+  if ( memcmp( buffer1, buffer2, s1 ) )
+       return 0;
+
+  memset( &result, 0, sizeof( result ) );
+  int s3 = DemarshalCodec( codec, &result, buffer2 );
+
+  if ( s3 != s1 )
+       return 0;
+
+  if ( value->m_pad1 != result.m_pad1 || value->m_mod != result.m_mod )
+       return 0;
+
+  switch( value->m_mod )
+     {
+       case 1:
+	    if ( value->m_union.m_u32 != result.m_union.m_u32 )
+		 return 0;
+	    break;
+       case 2:
+	    if ( value->m_union.m_f64 != result.m_union.m_f64 )
+		 return 0;
+	    break;
+       case 3:
+	    if (    value->m_union.m_struct2.m_u8 != result.m_union.m_struct2.m_u8
+		 || value->m_union.m_struct2.m_u16 != result.m_union.m_struct2.m_u16 )
+		 return 0;
+	    break;
+     }
+
+  if ( value->m_nelements != result.m_nelements )
+       return 0;
+
+  for( i = 0; i < value->m_nelements; i++ )
+     {
+       if (    value->m_var[i].m_u8 != result.m_var[i].m_u8
+	    || value->m_var[i].m_u16 != result.m_var[i].m_u16 )
+	    return 0;
+     }
+
+  g_free( result.m_var );
+
+  for( i = 0; i < 4; i++ )
+     {
+       if ( value->m_array[i] != result.m_array[i] )
+	    return 0;
+     }
+
+  if ( value->m_pad2 != result.m_pad2 )
+       return 0;
+
+  return 1;
+}
+
+
+int
+main( int argc, char *argv[] )
+{
+  cTest2 var[3] =
+  {
+    { .m_u8 = 0x11, .m_u16 = 0x1234 },
+    { .m_u8 = 0x22, .m_u16 = 0x5678 },
+    { .m_u8 = 0x33, .m_u16 = 0x9abc }
+  };
+
+  cTest1 value =
+  {
+    .m_pad1      = 0x42,
+    .m_mod       = 1,
+    .m_nelements = 3,
+    .m_var       = var,
+    .m_array     = { 0x0102, 0x0304, 0x0506, 0x0708 },
+    .m_pad2      = 0x43
+  };
+
+  cMarshalCodec *codec = MarshalCodecCompile( &Test1Type );
+  if ( !codec )
+       return 1;
+
+  value.m_union.m_u32 = 0xdeadbeef;
+  if ( !check( codec, &value ) )
+       return 1;
+
+  value.m_mod = 2;
+  value.m_union.m_f64 = -2.3480639908310873e-146;
+  if ( !check( codec, &value ) )
+       return 1;
+
+  value.m_mod = 3;
+  value.m_union.m_struct2.m_u8  = 0x17;
+  value.m_union.m_struct2.m_u16 = 0x6789;
+  value.m_nelements = 0;
+  if ( !check( codec, &value ) )
+       return 1;
+
+  // invalid modifier
+  unsigned char buffer[256];
+  value.m_mod = 4;
+  if ( MarshalCodec( codec, &value, buffer ) >= 0 )
+       return 1;
+
+  MarshalCodecFree( codec );
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+/*
+ * Compares throughput of the compiled codec against
+ * the marshal interpreter for some hot HPI types.
+ *
+ * Prints one JSON object per line.
+ *
+ * Usage: marshal_codec_bench [iterations]
+ */
+
+#include <glib.h>
+#include "marshal_hpi_types.h"
+#include "marshal_codec.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+static void
+bench( const char *name, const cMarshalType *type, const cMarshalCodec *codec,
+       void *value, unsigned int n )
+{
+  unsigned char buffer[4096];
+  unsigned char result[4096];
+  GTimer *timer = g_timer_new();
+  double t[4];
+  unsigned int i;
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       Marshal( type, value, buffer );
+  t[0] = g_timer_elapsed( timer, 0 );
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       MarshalCodec( codec, value, buffer );
+  t[1] = g_timer_elapsed( timer, 0 );
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       Demarshal( G_BYTE_ORDER, type, result, buffer );
+  t[2] = g_timer_elapsed( timer, 0 );
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       DemarshalCodec( codec, result, buffer );
+  t[3] = g_timer_elapsed( timer, 0 );
+
+  g_timer_destroy( timer );
+
+  printf( "{\"bench\":\"marshal_codec\",\"case\":\"%s\",\"op\":\"marshal\","
+	  "\"n\":%u,\"ns_per_op\":%.1f,\"codec_ns_per_op\":%.1f}\n",
+	  name, n, t[0] * 1e9 / n, t[1] * 1e9 / n );
+  printf( "{\"bench\":\"marshal_codec\",\"case\":\"%s\",\"op\":\"demarshal\","
+	  "\"n\":%u,\"ns_per_op\":%.1f,\"codec_ns_per_op\":%.1f}\n",
+	  name, n, t[2] * 1e9 / n, t[3] * 1e9 / n );
+}
+
+
+int
+main( int argc, char *argv[] )
+{
+  unsigned int n = 100000;
+  if ( argc > 1 )
+       n = strtoul( argv[1], 0, 0 );
+  if ( n == 0 )
+       return 1;
+
+  SaHpiRdrT rdr;
+  memset( &rdr, 0, sizeof( rdr ) );
+  rdr.RecordId = 1;
+  rdr.RdrType  = SAHPI_SENSOR_RDR;
+  rdr.Entity.Entry[0].EntityType     = SAHPI_ENT_SYSTEM_BOARD;
+  rdr.Entity.Entry[0].EntityLocation = 1;
+  rdr.Entity.Entry[1].EntityType     = SAHPI_ENT_ROOT;
+  rdr.IsFru = SAHPI_FALSE;
+  rdr.RdrTypeUnion.SensorRec.Num      = 1;
+  rdr.RdrTypeUnion.SensorRec.Type     = SAHPI_TEMPERATURE;
+  rdr.RdrTypeUnion.SensorRec.Category = SAHPI_EC_THRESHOLD;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.IsSupported = SAHPI_TRUE;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.ReadingType = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Flags = SAHPI_SRF_MIN | SAHPI_SRF_MAX;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Max.IsSupported = SAHPI_TRUE;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Max.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Max.Value.SensorFloat64 = 100.0;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Min.IsSupported = SAHPI_TRUE;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Min.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+  rdr.RdrTypeUnion.SensorRec.DataFormat.Range.Min.Value.SensorFloat64 = -20.0;
+  rdr.IdString.DataType   = SAHPI_TL_TYPE_TEXT;
+  rdr.IdString.Language   = SAHPI_LANG_ENGLISH;
+  rdr.IdString.DataLength = 11;
+  memcpy( rdr.IdString.Data, "Temperature", 11 );
+
+  SaHpiEventT event;
+  memset( &event, 0, sizeof( event ) );
+  event.Source    = 1;
+  event.EventType = SAHPI_ET_SENSOR;
+  event.Severity  = SAHPI_MAJOR;
+  event.EventDataUnion.SensorEvent.SensorNum  = 1;
+  event.EventDataUnion.SensorEvent.SensorType = SAHPI_TEMPERATURE;
+  event.EventDataUnion.SensorEvent.EventCategory = SAHPI_EC_THRESHOLD;
+  event.EventDataUnion.SensorEvent.Assertion  = SAHPI_TRUE;
+  event.EventDataUnion.SensorEvent.EventState = SAHPI_ES_UPPER_MAJOR;
+  event.EventDataUnion.SensorEvent.TriggerReading.IsSupported = SAHPI_TRUE;
+  event.EventDataUnion.SensorEvent.TriggerReading.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+  event.EventDataUnion.SensorEvent.TriggerReading.Value.SensorFloat64 = 85.0;
+
+  SaHpiRptEntryT rpte;
+  memset( &rpte, 0, sizeof( rpte ) );
+  rpte.EntryId    = 1;
+  rpte.ResourceId = 1;
+  rpte.ResourceEntity.Entry[0].EntityType = SAHPI_ENT_SYSTEM_BOARD;
+  rpte.ResourceEntity.Entry[1].EntityType = SAHPI_ENT_ROOT;
+  rpte.ResourceCapabilities = SAHPI_CAPABILITY_RESOURCE | SAHPI_CAPABILITY_RDR
+                              | SAHPI_CAPABILITY_SENSOR;
+  rpte.ResourceTag.DataType   = SAHPI_TL_TYPE_TEXT;
+  rpte.ResourceTag.Language   = SAHPI_LANG_ENGLISH;
+  rpte.ResourceTag.DataLength = 5;
+  memcpy( rpte.ResourceTag.Data, "Board", 5 );
+
+  cMarshalCodec *rdr_codec   = MarshalCodecCompile( &SaHpiRdrType );
+  cMarshalCodec *event_codec = MarshalCodecCompile( &SaHpiEventType );
+  cMarshalCodec *rpte_codec  = MarshalCodecCompile( &SaHpiRptEntryType );
+  if ( !rdr_codec || !event_codec || !rpte_codec )
+       return 1;
+
+  bench( "SaHpiRdrT",      &SaHpiRdrType,      rdr_codec,   &rdr,   n );
+  bench( "SaHpiEventT",    &SaHpiEventType,    event_codec, &event, n );
+  bench( "SaHpiRptEntryT", &SaHpiRptEntryType, rpte_codec,  &rpte,  n );
+
+  MarshalCodecFree( rdr_codec );
+  MarshalCodecFree( event_codec );
+  MarshalCodecFree( rpte_codec );
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+/*
+ * Times request and reply marshal/demarshal of every
+ * hpi_marshal[] entry, as done by the client library and
+ * the daemon. Parameters are zero filled.
+ *
+ * Prints one JSON object per line.
+ *
+ * Usage: marshal_hpi_bench [iterations]
+ */
+
+#include <glib.h>
+#include "marshal_hpi.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+#define dMaxParams     16
+#define dParamSize     16384
+#define dBufferSize    65536
+
+
+static void
+report( const char *name, const char *op, unsigned int n, double t, int size )
+{
+  printf( "{\"bench\":\"marshal\",\"case\":\"%s\",\"op\":\"%s\","
+	  "\"n\":%u,\"bytes\":%d,\"ns_per_op\":%.1f}\n",
+	  name, op, n, size, t * 1e9 / n );
+}
+
+
+static void
+free_params( void **param, int num )
+{
+  int i;
+
+  for( i = 0; i < num; i++ )
+       g_free( param[i] );
+}
+
+
+// zero filled parameters, 0 if the types cannot be marshaled
+static int
+alloc_params( const cMarshalType **types, void **param, void *buffer )
+{
+  int num = 0;
+
+  while( types[num] )
+     {
+       param[num] = g_malloc0( dParamSize );
+       num++;
+     }
+
+  if ( MarshalArray( types, (const void **)param, buffer ) < 0 )
+     {
+       free_params( param, num );
+       return -1;
+     }
+
+  return num;
+}
+
+
+static void
+bench( cHpiMarshal *hm, unsigned int n, unsigned char *buffer )
+{
+  void *param[dMaxParams];
+  GTimer *timer;
+  double t;
+  unsigned int i;
+  int num, size;
+
+  // request
+  num = alloc_params( hm->m_request, param, buffer );
+  if ( num < 0 )
+     {
+       printf( "{\"bench\":\"marshal\",\"case\":\"%s\",\"op\":\"request\",\"skipped\":true}\n",
+	       hm->m_name );
+       return;
+     }
+
+  timer = g_timer_new();
+
+  size = HpiMarshalRequest( hm, buffer, (const void **)param );
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       HpiMarshalRequest( hm, buffer, (const void **)param );
+  t = g_timer_elapsed( timer, 0 );
+  report( hm->m_name, "request_marshal", n, t, size );
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       HpiDemarshalRequest( G_BYTE_ORDER, hm, buffer, param );
+  t = g_timer_elapsed( timer, 0 );
+  report( hm->m_name, "request_demarshal", n, t, size );
+
+  free_params( param, num );
+
+  // reply
+  num = alloc_params( hm->m_reply, param, buffer );
+  if ( num < 0 )
+     {
+       printf( "{\"bench\":\"marshal\",\"case\":\"%s\",\"op\":\"reply\",\"skipped\":true}\n",
+	       hm->m_name );
+       g_timer_destroy( timer );
+       return;
+     }
+
+  size = HpiMarshalReply( hm, buffer, (const void **)param );
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       HpiMarshalReply( hm, buffer, (const void **)param );
+  t = g_timer_elapsed( timer, 0 );
+  report( hm->m_name, "reply_marshal", n, t, size );
+
+  g_timer_start( timer );
+  for( i = 0; i < n; i++ )
+       HpiDemarshalReply( G_BYTE_ORDER, hm, buffer, param );
+  t = g_timer_elapsed( timer, 0 );
+  report( hm->m_name, "reply_demarshal", n, t, size );
+
+  free_params( param, num );
+  g_timer_destroy( timer );
+}
+
+
+int
+main( int argc, char *argv[] )
+{
+  unsigned int n = 10000;
+  unsigned char *buffer;
+  cHpiMarshal *hm;
+  int id;
+
+  if ( argc > 1 )
+       n = strtoul( argv[1], 0, 0 );
+  if ( n == 0 )
+       return 1;
+
+  buffer = g_malloc( dBufferSize );
+
+  for( id = 1; ( hm = HpiMarshalFind( id ) ) != 0; id++ )
+       bench( hm, n, buffer );
+
+  g_free( buffer );
+
+  return 0;
+}
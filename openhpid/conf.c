@@ -21,6 +21,7 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
@@ -34,10 +35,12 @@
 #endif // _WIN32
  
 #include <config.h>
+#include <oh_domain.h>
 #include <oh_plugin.h>
 #include <oh_error.h>
 
 #include "conf.h"
+#include "event.h"
 #include "lock.h"
 #include "sahpi_wrappers.h"
 
@@ -59,10 +62,25 @@ static const char *known_globals[] = {
         "OPENHPI_UNCONFIGURED",
         "OPENHPI_AUTOINSERT_TIMEOUT",
         "OPENHPI_AUTOINSERT_TIMEOUT_READONLY",
+        "OPENHPI_EVT_QUEUE_POLICY",
+        "OPENHPI_METRICS_PORT",
+        "OPENHPI_ABI_CONCURRENCY",
+        "OPENHPI_ABI_QUEUE_DEPTH",
+        "OPENHPI_ABI_TIMEOUT",
+        "OPENHPI_EVT_WORKERS",
+        "OPENHPI_RPT_COMPACT",
+        "OPENHPI_HISTORY_INTERVAL",
+        "OPENHPI_HISTORY_SIZE",
+        "OPENHPI_HISTORY_SENSORS",
+        "OPENHPI_HISTORY_DELTA",
+        "OPENHPI_COMPRESS_THRESHOLD",
+        "OPENHPI_OPEN_TIMEOUT",
+        "OPENHPI_RPT_SAVE",
+        "OPENHPI_RPT_SAVE_INTERVAL",
         NULL
 };
 
-static struct {
+struct global_param_set {
         SaHpiSeverityT log_on_sev;
         SaHpiUint32T evt_queue_limit;
         SaHpiUint32T del_size_limit;
@@ -77,22 +95,64 @@ static struct {
         SaHpiBoolT unconfigured;
         SaHpiTimeoutT ai_timeout;
         SaHpiBoolT ai_timeout_readonly;
+        oh_evt_queue_policy evt_queue_policy;
+        SaHpiUint16T metrics_port;
+        SaHpiUint32T abi_concurrency;
+        SaHpiUint32T abi_queue_depth;
+        SaHpiUint32T abi_timeout;
+        SaHpiUint32T evt_workers;
+        SaHpiBoolT rpt_compact;
+        SaHpiUint32T history_interval;
+        SaHpiUint32T history_size;
+        char history_sensors[OH_PATH_PARAM_MAX_LENGTH];
+        SaHpiBoolT history_delta;
+        SaHpiUint32T compress_threshold;
+        SaHpiUint32T open_timeout;
+        SaHpiBoolT rpt_save;
+        SaHpiUint32T rpt_save_interval;
+        /* Not copied by a config reload, see apply_global_params() */
         unsigned char read_env;
         GStaticRecMutex lock;
-} global_params = { /* Defaults for global params are set here */
-        .log_on_sev = SAHPI_MINOR,
-        .evt_queue_limit = 10000,
-        .del_size_limit = 10000, /* 0 is unlimited size */
-        .del_save = SAHPI_FALSE,
-        .dat_size_limit = 0, /* Unlimited size */
-        .dat_user_limit = 0, /* Unlimited size */
-        .dat_save = SAHPI_FALSE,
-        .path = OH_PLUGIN_PATH,
-        .varpath = VARPATH,
-        .conf = OH_DEFAULT_CONF,
-        .unconfigured = SAHPI_FALSE,
-        .ai_timeout = 0,
-        .ai_timeout_readonly = SAHPI_TRUE,
+};
+
+/* Defaults for global params are set here */
+#define GLOBAL_PARAM_DEFAULTS \
+        .log_on_sev = SAHPI_MINOR,                             \
+        .evt_queue_limit = 10000,                              \
+        .del_size_limit = 10000, /* 0 is unlimited size */     \
+        .del_save = SAHPI_FALSE,                               \
+        .dat_size_limit = 0, /* Unlimited size */              \
+        .dat_user_limit = 0, /* Unlimited size */              \
+        .dat_save = SAHPI_FALSE,                               \
+        .path = OH_PLUGIN_PATH,                                \
+        .varpath = VARPATH,                                    \
+        .conf = OH_DEFAULT_CONF,                               \
+        .unconfigured = SAHPI_FALSE,                           \
+        .ai_timeout = 0,                                       \
+        .ai_timeout_readonly = SAHPI_TRUE,                     \
+        .evt_queue_policy = OH_EVT_QUEUE_DROP_NEWEST,          \
+        .metrics_port = 0, /* Disabled */                      \
+        .abi_concurrency = 0, /* Unlimited */                  \
+        .abi_queue_depth = 0, /* Unlimited */                  \
+        .abi_timeout = 0, /* Wait forever */                   \
+        .evt_workers = 1,                                      \
+        .rpt_compact = SAHPI_FALSE,                            \
+        .history_interval = 0, /* Disabled */                  \
+        .history_size = 360,                                   \
+        .history_sensors = "", /* All sensors with readings */ \
+        .history_delta = SAHPI_FALSE,                          \
+        .compress_threshold = 0, /* Disabled */                \
+        .open_timeout = 0, /* Wait forever */                  \
+        .rpt_save = SAHPI_FALSE,                               \
+        .rpt_save_interval = 60000
+
+/* Where a config reload starts from */
+static const struct global_param_set global_defaults = {
+        GLOBAL_PARAM_DEFAULTS
+};
+
+static struct global_param_set global_params = {
+        GLOBAL_PARAM_DEFAULTS,
         .read_env = 0,
         .lock = G_STATIC_REC_MUTEX_INIT
 };
@@ -103,6 +163,24 @@ static struct {
  */
 static GSList *handler_configs = NULL;
 
+/*
+ *  Global parameters of the config file being parsed. They are applied
+ *  together once the parse is done, so readers never see a mix of old
+ *  and new values after a config reload.
+ */
+struct global_update {
+        char *name;
+        char *value;
+};
+
+static GSList *global_updates = NULL;
+
+/*
+ *  Ids of the handlers created from config file stanzas, the ones a
+ *  config reload may destroy again.
+ */
+static GSList *config_hids = NULL;
+
 /*******************************************************************************
  *  In order to use the glib lexical parser we need to define token
  *  types which we want to switch on
@@ -177,91 +255,181 @@ static GScannerConfig oh_scanner_config =
                 TRUE                    /* store_int64 */,
         };
 
-static void process_global_param(const char *name, char *value)
+/* Sets a param of @params, the caller holds the global params lock */
+static void process_global_param(struct global_param_set *params,
+                                 const char *name, char *value)
 {
-        wrap_g_static_rec_mutex_lock((void *)&global_params.lock);
-
         if (!strcmp("OPENHPI_LOG_ON_SEV", name)) {
                 SaHpiTextBufferT buffer;
                 strncpy((char *)buffer.Data, value, SAHPI_MAX_TEXT_BUFFER_LENGTH);
-                oh_encode_severity(&buffer, &global_params.log_on_sev);
+                oh_encode_severity(&buffer, &params->log_on_sev);
         } else if (!strcmp("OPENHPI_EVT_QUEUE_LIMIT", name)) {
-                global_params.evt_queue_limit = atoi(value);
+                params->evt_queue_limit = atoi(value);
         } else if (!strcmp("OPENHPI_DEL_SIZE_LIMIT", name)) {
-                global_params.del_size_limit = atoi(value);
+                params->del_size_limit = atoi(value);
         } else if (!strcmp("OPENHPI_DEL_SAVE", name)) {
                 if (!strcmp("YES", value)) {
-                        global_params.del_save = SAHPI_TRUE;
+                        params->del_save = SAHPI_TRUE;
                 } else {
-                        global_params.del_save = SAHPI_FALSE;
+                        params->del_save = SAHPI_FALSE;
                 }
         } else if (!strcmp("OPENHPI_DAT_SIZE_LIMIT", name)) {
-                global_params.dat_size_limit = atoi(value);
+                params->dat_size_limit = atoi(value);
         } else if (!strcmp("OPENHPI_DAT_USER_LIMIT", name)) {
-                global_params.dat_user_limit = atoi(value);
+                params->dat_user_limit = atoi(value);
         } else if (!strcmp("OPENHPI_DAT_SAVE", name)) {
                 if (!strcmp("YES", value)) {
-                        global_params.dat_save = SAHPI_TRUE;
+                        params->dat_save = SAHPI_TRUE;
                 } else {
-                        global_params.dat_save = SAHPI_FALSE;
+                        params->dat_save = SAHPI_FALSE;
                 }
         } else if (!strcmp("OPENHPI_PATH", name)) {
-                memset(global_params.path, 0, OH_PATH_PARAM_MAX_LENGTH);
-                strncpy(global_params.path, value, OH_PATH_PARAM_MAX_LENGTH-1);
+                memset(params->path, 0, OH_PATH_PARAM_MAX_LENGTH);
+                strncpy(params->path, value, OH_PATH_PARAM_MAX_LENGTH-1);
         } else if (!strcmp("OPENHPI_VARPATH", name)) {
-                memset(global_params.varpath, 0, OH_PATH_PARAM_MAX_LENGTH);
-                strncpy(global_params.varpath, value, OH_PATH_PARAM_MAX_LENGTH-1);
+                memset(params->varpath, 0, OH_PATH_PARAM_MAX_LENGTH);
+                strncpy(params->varpath, value, OH_PATH_PARAM_MAX_LENGTH-1);
         } else if (!strcmp("OPENHPI_CONF", name)) {
-                memset(global_params.conf, 0, OH_PATH_PARAM_MAX_LENGTH);
-                strncpy(global_params.conf, value, OH_PATH_PARAM_MAX_LENGTH-1);
+                memset(params->conf, 0, OH_PATH_PARAM_MAX_LENGTH);
+                strncpy(params->conf, value, OH_PATH_PARAM_MAX_LENGTH-1);
         } else if (!strcmp("OPENHPI_UNCONFIGURED", name)) {
                 if (!strcmp("YES", value)) {
-                        global_params.unconfigured = SAHPI_TRUE;
+                        params->unconfigured = SAHPI_TRUE;
                 } else {
-                        global_params.unconfigured = SAHPI_FALSE;
+                        params->unconfigured = SAHPI_FALSE;
                 }
         } else if (!strcmp("OPENHPI_AUTOINSERT_TIMEOUT", name)) {
                 if (!strcmp(value, "BLOCK")) {
-                    global_params.ai_timeout = SAHPI_TIMEOUT_BLOCK;
+                    params->ai_timeout = SAHPI_TIMEOUT_BLOCK;
                 } else if (!strcmp(value, "IMMEDIATE")) {
-                    global_params.ai_timeout = SAHPI_TIMEOUT_IMMEDIATE;
+                    params->ai_timeout = SAHPI_TIMEOUT_IMMEDIATE;
                 } else {
-                    global_params.ai_timeout = strtoll(value, 0, 10);
-                    if (global_params.ai_timeout < 0) {
-                        global_params.ai_timeout = SAHPI_TIMEOUT_BLOCK;
+                    params->ai_timeout = strtoll(value, 0, 10);
+                    if (params->ai_timeout < 0) {
+                        params->ai_timeout = SAHPI_TIMEOUT_BLOCK;
                     }
                 }
         } else if (!strcmp("OPENHPI_AUTOINSERT_TIMEOUT_READONLY", name)) {
                 if (!strcmp("YES", value)) {
-                        global_params.ai_timeout_readonly = SAHPI_TRUE;
+                        params->ai_timeout_readonly = SAHPI_TRUE;
+                } else {
+                        params->ai_timeout_readonly = SAHPI_FALSE;
+                }
+        } else if (!strcmp("OPENHPI_EVT_QUEUE_POLICY", name)) {
+                if (!strcmp("DROP_NEWEST", value)) {
+                        params->evt_queue_policy = OH_EVT_QUEUE_DROP_NEWEST;
+                } else if (!strcmp("DROP_OLDEST", value)) {
+                        params->evt_queue_policy = OH_EVT_QUEUE_DROP_OLDEST;
+                } else if (!strcmp("COALESCE", value)) {
+                        params->evt_queue_policy = OH_EVT_QUEUE_COALESCE;
                 } else {
-                        global_params.ai_timeout_readonly = SAHPI_FALSE;
+                        CRIT("Invalid event queue policy %s.", value);
                 }
+        } else if (!strcmp("OPENHPI_METRICS_PORT", name)) {
+                params->metrics_port = atoi(value);
+        } else if (!strcmp("OPENHPI_ABI_CONCURRENCY", name)) {
+                params->abi_concurrency = atoi(value);
+        } else if (!strcmp("OPENHPI_ABI_QUEUE_DEPTH", name)) {
+                params->abi_queue_depth = atoi(value);
+        } else if (!strcmp("OPENHPI_ABI_TIMEOUT", name)) {
+                params->abi_timeout = atoi(value);
+        } else if (!strcmp("OPENHPI_EVT_WORKERS", name)) {
+                params->evt_workers = atoi(value);
+        } else if (!strcmp("OPENHPI_RPT_COMPACT", name)) {
+                if (!strcmp("YES", value)) {
+                        params->rpt_compact = SAHPI_TRUE;
+                } else {
+                        params->rpt_compact = SAHPI_FALSE;
+                }
+        } else if (!strcmp("OPENHPI_HISTORY_INTERVAL", name)) {
+                params->history_interval = atoi(value);
+        } else if (!strcmp("OPENHPI_HISTORY_SIZE", name)) {
+                params->history_size = atoi(value);
+        } else if (!strcmp("OPENHPI_HISTORY_SENSORS", name)) {
+                memset(params->history_sensors, 0, OH_PATH_PARAM_MAX_LENGTH);
+                strncpy(params->history_sensors, value, OH_PATH_PARAM_MAX_LENGTH-1);
+        } else if (!strcmp("OPENHPI_HISTORY_DELTA", name)) {
+                if (!strcmp("YES", value)) {
+                        params->history_delta = SAHPI_TRUE;
+                } else {
+                        params->history_delta = SAHPI_FALSE;
+                }
+        } else if (!strcmp("OPENHPI_COMPRESS_THRESHOLD", name)) {
+                params->compress_threshold = atoi(value);
+        } else if (!strcmp("OPENHPI_OPEN_TIMEOUT", name)) {
+                params->open_timeout = atoi(value);
+        } else if (!strcmp("OPENHPI_RPT_SAVE", name)) {
+                if (!strcmp("YES", value)) {
+                        params->rpt_save = SAHPI_TRUE;
+                } else {
+                        params->rpt_save = SAHPI_FALSE;
+                }
+        } else if (!strcmp("OPENHPI_RPT_SAVE_INTERVAL", name)) {
+                params->rpt_save_interval = atoi(value);
 	} else {
                 CRIT("Invalid global parameter %s in config file.", name);
         }
 
-        wrap_g_static_rec_mutex_unlock(&global_params.lock);
 }
 
-static void read_globals_from_env(int force)
+static void process_env_params(struct global_param_set *params)
 {
         char *tmp_env_str = NULL;
         int i;
 
-        if (!force && global_params.read_env) return;
-
-        wrap_g_static_rec_mutex_lock(&global_params.lock);
-
         for (i = 0; known_globals[i]; i++) {
                 if ((tmp_env_str = getenv(known_globals[i])) != NULL) {
-                        process_global_param(known_globals[i], tmp_env_str);
+                        process_global_param(params, known_globals[i],
+                                             tmp_env_str);
                         tmp_env_str = NULL;
                 }
         }
+}
+
+static void read_globals_from_env(int force)
+{
+        if (!force && global_params.read_env) return;
+
+        wrap_g_static_rec_mutex_lock(&global_params.lock);
+        process_env_params(&global_params);
+        global_params.read_env = 1;
+        wrap_g_static_rec_mutex_unlock(&global_params.lock);
+}
+
+/*
+ * Builds the global params from the defaults, the config file just
+ * parsed and the environment, then replaces all values at once. So a
+ * param removed from the config file goes back to its default.
+ */
+static void apply_global_params(void)
+{
+        struct global_param_set *params;
+        GSList *node;
+
+        params = g_new(struct global_param_set, 1);
+        memcpy(params, &global_defaults,
+               offsetof(struct global_param_set, read_env));
+
+        for (node = global_updates; node; node = node->next) {
+                struct global_update *u = (struct global_update *)node->data;
+                process_global_param(params, u->name, u->value);
+                g_free(u->name);
+                g_free(u->value);
+                g_free(u);
+        }
+        g_slist_free(global_updates);
+        global_updates = NULL;
 
+        /* The environment still overrides the config file */
+        process_env_params(params);
+
+        wrap_g_static_rec_mutex_lock(&global_params.lock);
+        memcpy(&global_params, params,
+               offsetof(struct global_param_set, read_env));
         global_params.read_env = 1;
         wrap_g_static_rec_mutex_unlock(&global_params.lock);
+
+        g_free(params);
 }
 
 /**
@@ -405,6 +573,7 @@ free_table:
 static int process_global_token(GScanner *scanner)
 {
         char *name = NULL, *value = NULL;
+        struct global_update *update;
         int current_token;
 
         data_access_lock();
@@ -449,9 +618,10 @@ static int process_global_token(GScanner *scanner)
                 goto free_and_quit;
         }
 
-        process_global_param(name, value);
-        g_free(name);
-        g_free(value);
+        update = g_new0(struct global_update, 1);
+        update->name = name;
+        update->value = value;
+        global_updates = g_slist_append(global_updates, update);
         data_access_unlock();
         return 0;
 
@@ -665,7 +835,7 @@ int oh_load_config (char *filename, struct oh_parsed_config *config)
                 }
         }
 
-        read_globals_from_env(1);
+        apply_global_params();
 
         if (fp)
                 fclose(fp);
@@ -694,6 +864,8 @@ int oh_load_config (char *filename, struct oh_parsed_config *config)
  *
  * This will process a parsed configuration by loading
  * the specified plugins and corresponding handlers.
+ * The handlers are opened in the background, see
+ * oh_create_handler_async().
  *
  * Returns: SA_OK on success, otherwise the call failed.
  **/
@@ -709,7 +881,7 @@ SaErrorT oh_process_config(struct oh_parsed_config *config)
 		unsigned int hid = 0;
 		SaErrorT error = SA_OK;
 
-		error = oh_create_handler(handler_config, &hid);
+		error = oh_create_handler_async(handler_config, &hid);
                 if (error == SA_OK) {
                         DBG("Loaded handler for plugin %s",
                             (char *)g_hash_table_lookup(handler_config, "plugin"));
@@ -717,14 +889,132 @@ SaErrorT oh_process_config(struct oh_parsed_config *config)
                 } else {
                         CRIT("Couldn't load handler for plugin %s.",
                             (char *)g_hash_table_lookup(handler_config, "plugin"));
-                        if (hid == 0) g_hash_table_destroy(handler_config);
                 }
+                if (hid != 0)
+                        config_hids = g_slist_append(config_hids,
+                                                     GUINT_TO_POINTER(hid));
+                /* The handler has a copy of its own */
+                g_hash_table_destroy(handler_config);
+                node->data = NULL;
                 config->handlers_defined++;
         }
 
         return SA_OK;
 }
 
+struct config_match {
+        GHashTable *config;
+        int differs;
+};
+
+static void compare_config_param(gpointer key, gpointer value, gpointer data)
+{
+        struct config_match *m = (struct config_match *)data;
+        const char *other;
+
+        if (m->differs) return;
+
+        other = (const char *)g_hash_table_lookup(m->config, key);
+        if (!other || strcmp(other, (const char *)value))
+                m->differs = 1;
+}
+
+static int same_config(GHashTable *a, GHashTable *b)
+{
+        struct config_match m = { b, 0 };
+
+        if (g_hash_table_size(a) != g_hash_table_size(b))
+                return 0;
+        g_hash_table_foreach(a, compare_config_param, &m);
+
+        return !m.differs;
+}
+
+/**
+ * oh_process_config_changes
+ * @config: pointer to a newly parsed configuration
+ *
+ * Brings the handlers created from the config file in line with a
+ * reparsed configuration. Handlers whose stanza is still there keep
+ * running with their resources. Handlers whose stanza changed or went
+ * away are destroyed and their resources removed. The stanzas left
+ * over are processed with oh_process_config(), so only their handlers
+ * open and discover. Handlers created with oHpiHandlerCreate() are not
+ * touched. A removed handler that is still opening is left for the next
+ * reload, destroying it would wait for its open.
+ *
+ * Returns: SA_OK on success, otherwise the call failed.
+ **/
+SaErrorT oh_process_config_changes(struct oh_parsed_config *config)
+{
+        GSList *node, *hnode, *stanza, *kept = NULL;
+        struct oh_handler *h;
+        struct oh_domain *d;
+        unsigned int hid;
+        int failed = 0;
+        int opening = 0;
+
+        if (!config) return SA_ERR_HPI_INVALID_PARAMS;
+
+        for (node = config_hids; node; node = node->next) {
+                hid = GPOINTER_TO_UINT(node->data);
+                stanza = NULL;
+
+                wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
+                hnode = g_hash_table_lookup(oh_handlers.table, &hid);
+                h = hnode ? (struct oh_handler *)(hnode->data) : NULL;
+                if (h) {
+                        for (stanza = config->handler_configs; stanza;
+                             stanza = stanza->next) {
+                                if (same_config(h->config,
+                                                (GHashTable *)stanza->data)) {
+                                        break;
+                                }
+                        }
+                        opening = h->opening;
+                        failed = !h->opening && !h->hnd;
+                }
+                wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
+
+                /* Destroyed with oHpiHandlerDestroy() meanwhile */
+                if (!h) continue;
+
+                if (stanza) {
+                        g_hash_table_destroy((GHashTable *)stanza->data);
+                        config->handler_configs =
+                                g_slist_delete_link(config->handler_configs,
+                                                    stanza);
+                        kept = g_slist_append(kept, node->data);
+                        config->handlers_defined++;
+                        if (!failed)
+                                config->handlers_loaded++;
+                        continue;
+                }
+
+                /* Its open thread holds the handler lock, don't wait */
+                if (opening) {
+                        CRIT("Handler #%u is no longer configured but still "
+                             "opening, destroying it on the next reload.", hid);
+                        kept = g_slist_append(kept, node->data);
+                        continue;
+                }
+
+                INFO("Handler #%u is no longer configured, destroying it.",
+                     hid);
+                if (oh_destroy_handler(hid))
+                        continue;
+                d = oh_get_domain(OH_DEFAULT_DOMAIN_ID);
+                if (d) {
+                        oh_remove_handler_resources(d, hid);
+                        oh_release_domain(d);
+                }
+        }
+        g_slist_free(config_hids);
+        config_hids = kept;
+
+        return oh_process_config(config);
+}
+
 void oh_clean_config(struct oh_parsed_config *config)
 {
         /* Free list of handler configuration blocks */
@@ -803,6 +1093,53 @@ int oh_get_global_param(struct oh_global_param *param)
                 case OPENHPI_AUTOINSERT_TIMEOUT_READONLY:
                         param->u.ai_timeout_readonly = global_params.ai_timeout_readonly;
                         break;
+                case OPENHPI_EVT_QUEUE_POLICY:
+                        param->u.evt_queue_policy = global_params.evt_queue_policy;
+                        break;
+                case OPENHPI_METRICS_PORT:
+                        param->u.metrics_port = global_params.metrics_port;
+                        break;
+                case OPENHPI_ABI_CONCURRENCY:
+                        param->u.abi_concurrency = global_params.abi_concurrency;
+                        break;
+                case OPENHPI_ABI_QUEUE_DEPTH:
+                        param->u.abi_queue_depth = global_params.abi_queue_depth;
+                        break;
+                case OPENHPI_ABI_TIMEOUT:
+                        param->u.abi_timeout = global_params.abi_timeout;
+                        break;
+                case OPENHPI_EVT_WORKERS:
+                        param->u.evt_workers = global_params.evt_workers;
+                        break;
+                case OPENHPI_RPT_COMPACT:
+                        param->u.rpt_compact = global_params.rpt_compact;
+                        break;
+                case OPENHPI_HISTORY_INTERVAL:
+                        param->u.history_interval = global_params.history_interval;
+                        break;
+                case OPENHPI_HISTORY_SIZE:
+                        param->u.history_size = global_params.history_size;
+                        break;
+                case OPENHPI_HISTORY_SENSORS:
+                        strncpy(param->u.history_sensors,
+                                global_params.history_sensors,
+                                OH_PATH_PARAM_MAX_LENGTH);
+                        break;
+                case OPENHPI_HISTORY_DELTA:
+                        param->u.history_delta = global_params.history_delta;
+                        break;
+                case OPENHPI_COMPRESS_THRESHOLD:
+                        param->u.compress_threshold = global_params.compress_threshold;
+                        break;
+                case OPENHPI_OPEN_TIMEOUT:
+                        param->u.open_timeout = global_params.open_timeout;
+                        break;
+                case OPENHPI_RPT_SAVE:
+                        param->u.rpt_save = global_params.rpt_save;
+                        break;
+                case OPENHPI_RPT_SAVE_INTERVAL:
+                        param->u.rpt_save_interval = global_params.rpt_save_interval;
+                        break;
                 default:
                         wrap_g_static_rec_mutex_unlock(&global_params.lock);
                         CRIT("Invalid global parameter %d!", param->type);
@@ -896,6 +1233,54 @@ int oh_set_global_param(const struct oh_global_param *param)
                 case OPENHPI_AUTOINSERT_TIMEOUT_READONLY:
                         global_params.ai_timeout_readonly = param->u.ai_timeout_readonly;
                         break;
+                case OPENHPI_EVT_QUEUE_POLICY:
+                        global_params.evt_queue_policy = param->u.evt_queue_policy;
+                        break;
+                case OPENHPI_METRICS_PORT:
+                        global_params.metrics_port = param->u.metrics_port;
+                        break;
+                case OPENHPI_ABI_CONCURRENCY:
+                        global_params.abi_concurrency = param->u.abi_concurrency;
+                        break;
+                case OPENHPI_ABI_QUEUE_DEPTH:
+                        global_params.abi_queue_depth = param->u.abi_queue_depth;
+                        break;
+                case OPENHPI_ABI_TIMEOUT:
+                        global_params.abi_timeout = param->u.abi_timeout;
+                        break;
+                case OPENHPI_EVT_WORKERS:
+                        global_params.evt_workers = param->u.evt_workers;
+                        break;
+                case OPENHPI_RPT_COMPACT:
+                        global_params.rpt_compact = param->u.rpt_compact;
+                        break;
+                case OPENHPI_HISTORY_INTERVAL:
+                        global_params.history_interval = param->u.history_interval;
+                        break;
+                case OPENHPI_HISTORY_SIZE:
+                        global_params.history_size = param->u.history_size;
+                        break;
+                case OPENHPI_HISTORY_SENSORS:
+                        memset(global_params.history_sensors, 0, OH_PATH_PARAM_MAX_LENGTH);
+                        strncpy(global_params.history_sensors,
+                                param->u.history_sensors,
+                                OH_PATH_PARAM_MAX_LENGTH-1);
+                        break;
+                case OPENHPI_HISTORY_DELTA:
+                        global_params.history_delta = param->u.history_delta;
+                        break;
+                case OPENHPI_COMPRESS_THRESHOLD:
+                        global_params.compress_threshold = param->u.compress_threshold;
+                        break;
+                case OPENHPI_OPEN_TIMEOUT:
+                        global_params.open_timeout = param->u.open_timeout;
+                        break;
+                case OPENHPI_RPT_SAVE:
+                        global_params.rpt_save = param->u.rpt_save;
+                        break;
+                case OPENHPI_RPT_SAVE_INTERVAL:
+                        global_params.rpt_save_interval = param->u.rpt_save_interval;
+                        break;
                 default:
                         wrap_g_static_rec_mutex_unlock(&global_params.lock);
                         CRIT("Invalid global parameter %d!", param->type);
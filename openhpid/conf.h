@@ -46,9 +46,31 @@ typedef enum {
         OPENHPI_CONF, 
 	OPENHPI_UNCONFIGURED,
         OPENHPI_AUTOINSERT_TIMEOUT,
-        OPENHPI_AUTOINSERT_TIMEOUT_READONLY
+        OPENHPI_AUTOINSERT_TIMEOUT_READONLY,
+        OPENHPI_EVT_QUEUE_POLICY,
+        OPENHPI_METRICS_PORT,
+        OPENHPI_ABI_CONCURRENCY,
+        OPENHPI_ABI_QUEUE_DEPTH,
+        OPENHPI_ABI_TIMEOUT,
+        OPENHPI_EVT_WORKERS,
+        OPENHPI_RPT_COMPACT,
+        OPENHPI_HISTORY_INTERVAL,
+        OPENHPI_HISTORY_SIZE,
+        OPENHPI_HISTORY_SENSORS,
+        OPENHPI_HISTORY_DELTA,
+        OPENHPI_COMPRESS_THRESHOLD,
+        OPENHPI_OPEN_TIMEOUT,
+        OPENHPI_RPT_SAVE,
+        OPENHPI_RPT_SAVE_INTERVAL
 } oh_global_param_type;
 
+/* What to do when a session's event queue is full */
+typedef enum {
+        OH_EVT_QUEUE_DROP_NEWEST = 0,
+        OH_EVT_QUEUE_DROP_OLDEST,
+        OH_EVT_QUEUE_COALESCE
+} oh_evt_queue_policy;
+
 typedef union {
         SaHpiEntityPathT on_ep;
         SaHpiSeverityT log_on_sev;
@@ -64,6 +86,21 @@ typedef union {
 	SaHpiBoolT unconfigured;
         SaHpiTimeoutT ai_timeout;
         SaHpiBoolT ai_timeout_readonly;
+        oh_evt_queue_policy evt_queue_policy;
+        SaHpiUint16T metrics_port;
+        SaHpiUint32T abi_concurrency;
+        SaHpiUint32T abi_queue_depth;
+        SaHpiUint32T abi_timeout; /* msec */
+        SaHpiUint32T evt_workers;
+        SaHpiBoolT rpt_compact;
+        SaHpiUint32T history_interval; /* msec */
+        SaHpiUint32T history_size;
+        char history_sensors[OH_MAX_TEXT_BUFFER_LENGTH];
+        SaHpiBoolT history_delta;
+        SaHpiUint32T compress_threshold; /* bytes */
+        SaHpiUint32T open_timeout; /* msec */
+        SaHpiBoolT rpt_save;
+        SaHpiUint32T rpt_save_interval; /* msec */
 } oh_global_param_union;
 
 struct oh_global_param {
@@ -74,6 +111,7 @@ struct oh_global_param {
 /* Plugin configuration information prototypes */
 int oh_load_config(char *filename, struct oh_parsed_config *config);
 SaErrorT oh_process_config(struct oh_parsed_config *config);
+SaErrorT oh_process_config_changes(struct oh_parsed_config *config);
 void oh_clean_config(struct oh_parsed_config *config);
 
 /* For handling global parameters */
@@ -0,0 +1,293 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <oh_error.h>
+
+#include "conf.h"
+#include "dispatch.h"
+#include <sahpi_wrappers.h>
+
+struct oh_abi_queue {
+        unsigned int hid;
+        GMutex *lock;
+        GCond *cond;
+        guint limit;      /* Calls holding a slot, 0 is unlimited */
+        guint max_queued; /* Callers waiting for a slot, 0 is unlimited */
+        guint timeout;    /* Max wait for a slot in msec, 0 is forever */
+        guint active;
+        guint queued;
+        SaHpiUint64T busy;
+        SaHpiUint64T timeouts;
+};
+
+/* How often a bounded call retries the handler lock, in usec */
+#define LOCK_POLL_USEC 1000
+
+/* hid -> queue, so metrics never have to lock a handler */
+static GHashTable *queues = NULL;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex queues_lock;
+#else
+static GStaticMutex queues_lock = G_STATIC_MUTEX_INIT;
+#endif
+
+/* Handler config values are strings, see copy_hashed_new_config() */
+static guint get_config_uint(GHashTable *config, const char *name, guint def)
+{
+        const char *value = NULL;
+        char *end = NULL;
+        unsigned long n;
+
+        if (config)
+                value = (const char *)g_hash_table_lookup(config, name);
+        if (!value)
+                return def;
+
+        n = strtoul(value, &end, 10);
+        if (end == value || *end != '\0') {
+                CRIT("Invalid value %s for handler parameter %s.", value, name);
+                return def;
+        }
+
+        return (guint)n;
+}
+
+/**
+ * oh_dispatch_create
+ * @hid: id of the handler
+ * @config: handler configuration
+ *
+ * Limits default to the OPENHPI_ABI_* global parameters and can be
+ * overridden with "abi_concurrency", "abi_queue_depth" and
+ * "abi_timeout" in the handler stanza.
+ *
+ * Returns: the new queue, registered for oh_dispatch_get_stats().
+ **/
+struct oh_abi_queue *oh_dispatch_create(unsigned int hid, GHashTable *config)
+{
+        struct oh_abi_queue *q = g_new0(struct oh_abi_queue, 1);
+        struct oh_global_param param;
+
+        q->hid = hid;
+        q->lock = wrap_g_mutex_new_init();
+        q->cond = wrap_g_cond_new_init();
+
+        oh_get_global_param2(OPENHPI_ABI_CONCURRENCY, &param);
+        q->limit = get_config_uint(config, "abi_concurrency",
+                                   param.u.abi_concurrency);
+        oh_get_global_param2(OPENHPI_ABI_QUEUE_DEPTH, &param);
+        q->max_queued = get_config_uint(config, "abi_queue_depth",
+                                        param.u.abi_queue_depth);
+        oh_get_global_param2(OPENHPI_ABI_TIMEOUT, &param);
+        q->timeout = get_config_uint(config, "abi_timeout",
+                                     param.u.abi_timeout);
+
+        wrap_g_static_mutex_lock(&queues_lock);
+        if (!queues)
+                queues = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_hash_table_insert(queues, GUINT_TO_POINTER(hid), q);
+        wrap_g_static_mutex_unlock(&queues_lock);
+
+        return q;
+}
+
+/**
+ * oh_dispatch_destroy
+ * @q: queue of a handler that is being deleted
+ *
+ * Nobody may hold or wait for a slot any more.
+ **/
+void oh_dispatch_destroy(struct oh_abi_queue *q)
+{
+        if (!q) return;
+
+        wrap_g_static_mutex_lock(&queues_lock);
+        g_hash_table_remove(queues, GUINT_TO_POINTER(q->hid));
+        wrap_g_static_mutex_unlock(&queues_lock);
+
+        wrap_g_cond_free(q->cond);
+        wrap_g_mutex_free_clear(q->lock);
+        g_free(q);
+}
+
+/* Waits for a slot, see oh_dispatch_enter() */
+static SaErrorT take_slot(struct oh_abi_queue *q, oh_dispatch_mode mode)
+{
+        SaHpiBoolT bounded = (mode != OH_DISPATCH_WAIT);
+#if GLIB_CHECK_VERSION (2, 32, 0)
+        gint64 gfinaltime = 0;
+#else
+        GTimeVal gfinaltime;
+#endif
+        SaErrorT rv = SA_OK;
+
+        wrap_g_mutex_lock(q->lock);
+        if (q->limit == 0 || q->active < q->limit) {
+                q->active++;
+                wrap_g_mutex_unlock(q->lock);
+                return SA_OK;
+        }
+
+        if (mode == OH_DISPATCH_TRY ||
+            (bounded && q->max_queued && q->queued >= q->max_queued)) {
+                q->busy++;
+                wrap_g_mutex_unlock(q->lock);
+                return SA_ERR_HPI_BUSY;
+        }
+
+        if (bounded && q->timeout) {
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                gfinaltime = g_get_monotonic_time() + (gint64)q->timeout * 1000;
+#else
+                g_get_current_time(&gfinaltime);
+                g_time_val_add(&gfinaltime, (glong)q->timeout * 1000);
+#endif
+        }
+
+        q->queued++;
+        while (q->active >= q->limit) {
+                if (!bounded || !q->timeout) {
+                        g_cond_wait(q->cond, q->lock);
+                } else if (!wrap_g_cond_timed_wait(q->cond, q->lock,
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                                                   gfinaltime)) {
+#else
+                                                   &gfinaltime)) {
+#endif
+                        if (q->active < q->limit)
+                                break;
+                        q->timeouts++;
+                        rv = SA_ERR_HPI_TIMEOUT;
+                        break;
+                }
+        }
+        q->queued--;
+        if (rv == SA_OK)
+                q->active++;
+        wrap_g_mutex_unlock(q->lock);
+
+        return rv;
+}
+
+/**
+ * oh_dispatch_enter
+ * @q: queue of the handler
+ * @lock: the handler lock
+ * @mode: OH_DISPATCH_BOUNDED to apply the queue depth and the timeout,
+ * OH_DISPATCH_TRY to give up unless both are free right away
+ *
+ * Takes a slot of the handler and then @lock, waiting for both if
+ * needed. Calls holding a slot still take turns on @lock, so with
+ * OH_DISPATCH_BOUNDED the timeout covers both waits together. The
+ * caller must not hold any domain lock, a handler may take a while.
+ *
+ * Returns: SA_OK if the caller holds a slot and @lock, SA_ERR_HPI_BUSY
+ * if the queue is full (or with OH_DISPATCH_TRY anything is taken) or
+ * SA_ERR_HPI_TIMEOUT if the slot or the lock did not become free in
+ * time.
+ **/
+SaErrorT oh_dispatch_enter(struct oh_abi_queue *q, void *lock,
+                           oh_dispatch_mode mode)
+{
+        gint64 deadline = 0;
+        SaErrorT rv;
+
+        if (!q) {
+                wrap_g_static_rec_mutex_lock(lock);
+                return SA_OK;
+        }
+
+        if (mode == OH_DISPATCH_BOUNDED && q->timeout)
+                deadline = g_get_monotonic_time() + (gint64)q->timeout * 1000;
+
+        rv = take_slot(q, mode);
+        if (rv != SA_OK)
+                return rv;
+
+        if (mode == OH_DISPATCH_TRY) {
+                if (wrap_g_static_rec_mutex_trylock(lock))
+                        return SA_OK;
+                wrap_g_mutex_lock(q->lock);
+                q->busy++;
+                wrap_g_mutex_unlock(q->lock);
+                oh_dispatch_leave(q);
+                return SA_ERR_HPI_BUSY;
+        }
+
+        if (!deadline) {
+                wrap_g_static_rec_mutex_lock(lock);
+                return SA_OK;
+        }
+
+        while (!wrap_g_static_rec_mutex_trylock(lock)) {
+                if (g_get_monotonic_time() >= deadline) {
+                        wrap_g_mutex_lock(q->lock);
+                        q->timeouts++;
+                        wrap_g_mutex_unlock(q->lock);
+                        oh_dispatch_leave(q);
+                        return SA_ERR_HPI_TIMEOUT;
+                }
+                g_usleep(LOCK_POLL_USEC);
+        }
+
+        return SA_OK;
+}
+
+/**
+ * oh_dispatch_leave
+ * @q: queue of the handler
+ *
+ * Gives back a slot taken with oh_dispatch_enter(). The caller still
+ * has to unlock the handler lock.
+ **/
+void oh_dispatch_leave(struct oh_abi_queue *q)
+{
+        if (!q) return;
+
+        wrap_g_mutex_lock(q->lock);
+        if (q->active > 0)
+                q->active--;
+        if (q->queued > 0)
+                g_cond_signal(q->cond);
+        wrap_g_mutex_unlock(q->lock);
+}
+
+/**
+ * oh_dispatch_get_stats
+ * @hid: id of the handler
+ * @stats: place for the current queue state and counters
+ *
+ * Returns: SA_OK, or SA_ERR_HPI_NOT_PRESENT if there is no such handler.
+ **/
+SaErrorT oh_dispatch_get_stats(unsigned int hid, struct oh_dispatch_stats *stats)
+{
+        struct oh_abi_queue *q = NULL;
+
+        if (!stats) return SA_ERR_HPI_INVALID_PARAMS;
+
+        wrap_g_static_mutex_lock(&queues_lock);
+        if (queues)
+                q = g_hash_table_lookup(queues, GUINT_TO_POINTER(hid));
+        if (q) {
+                wrap_g_mutex_lock(q->lock);
+                stats->active = q->active;
+                stats->queued = q->queued;
+                stats->busy = q->busy;
+                stats->timeouts = q->timeouts;
+                wrap_g_mutex_unlock(q->lock);
+        }
+        wrap_g_static_mutex_unlock(&queues_lock);
+
+        return q ? SA_OK : SA_ERR_HPI_NOT_PRESENT;
+}
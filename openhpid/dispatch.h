@@ -0,0 +1,61 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __OH_DISPATCH_H
+#define __OH_DISPATCH_H
+
+#include <glib.h>
+#include <SaHpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Admission control for calls into a handler.
+ *
+ * A call holds a slot of its handler and the handler lock from
+ * oh_get_handler() until oh_release_handler(). When all slots are
+ * taken, callers wait in the handler's queue. API callers give up with
+ * SA_ERR_HPI_BUSY if the queue is full and with SA_ERR_HPI_TIMEOUT if
+ * no slot and handler lock free up in time. Daemon internal callers
+ * (discovery, event processing) always wait.
+ */
+struct oh_abi_queue;
+
+/* How long a caller waits for its handler */
+typedef enum {
+        OH_DISPATCH_WAIT,     /* as long as it takes */
+        OH_DISPATCH_BOUNDED,  /* queue depth and timeout of the handler */
+        OH_DISPATCH_TRY       /* not at all, for background sampling */
+} oh_dispatch_mode;
+
+struct oh_dispatch_stats {
+        guint active;
+        guint queued;
+        SaHpiUint64T busy;
+        SaHpiUint64T timeouts;
+};
+
+struct oh_abi_queue *oh_dispatch_create(unsigned int hid, GHashTable *config);
+void oh_dispatch_destroy(struct oh_abi_queue *q);
+
+SaErrorT oh_dispatch_enter(struct oh_abi_queue *q, void *lock,
+                           oh_dispatch_mode mode);
+void oh_dispatch_leave(struct oh_abi_queue *q);
+
+SaErrorT oh_dispatch_get_stats(unsigned int hid, struct oh_dispatch_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OH_DISPATCH_H */
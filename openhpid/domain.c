@@ -22,6 +22,7 @@
 #include <oh_domain.h>
 #include <oh_error.h>
 #include <oh_plugin.h>
+#include <oh_session.h>
 #include <oh_utils.h>
 
 #include "alarm.h"
@@ -76,6 +77,7 @@ static void __delete_domain(struct oh_domain *d)
         oh_el_close(d->del);
         oh_close_alarmtable(d);
         __free_drt_list(d->drt.list);
+        oh_release_subscribers(d->subscribers);
         wrap_g_static_rec_mutex_free_clear(&d->lock);
         wrap_g_static_rec_mutex_free_clear(&d->refcount_lock);
         g_free(d);
@@ -120,6 +122,7 @@ static GList *__get_domain(SaHpiDomainIdT did)
         domains_unlock();
         /* Wait to get domain lock */
         wrap_g_static_rec_mutex_lock(&domain->lock);
+        domain->lock_depth++;
 
         return node;
 }
@@ -383,11 +386,17 @@ SaErrorT oh_create_domain(SaHpiDomainIdT id,
         domain->ai_timeout = ai_timeout;
 
         /* Initialize Resource Precense Table */
-        oh_init_rpt(&(domain->rpt));
+        oh_get_global_param2(OPENHPI_RPT_COMPACT, &param);
+        if (param.u.rpt_compact) {
+                oh_init_rpt_compact(&(domain->rpt));
+        } else {
+                oh_init_rpt(&(domain->rpt));
+        }
 
         /* Initialize domain reference table timestamp to a valid value */
         domain->drt.update_timestamp = SAHPI_TIME_UNSPECIFIED;
 
+        param.type = OPENHPI_DEL_SIZE_LIMIT;
         oh_get_global_param(&param); /* Get domain event log size limit */
         /* Initialize domain event log */
         domain->del = oh_el_create(param.u.del_size_limit);
@@ -593,10 +602,15 @@ SaErrorT oh_release_domain(struct oh_domain *domain)
          * If domain was scheduled for destruction before, and
          * no other threads are referring to it, then delete domain.
          */
-        if (domain->refcount < 0)
+        if (domain->refcount < 0) {
                 __delete_domain(domain);
-        else
+        } else {
+                /* RDRs handed out by a compact RPT are only valid while
+                   the domain is locked */
+                if (--domain->lock_depth == 0)
+                        oh_release_rdr_views(&domain->rpt);
                 wrap_g_static_rec_mutex_unlock(&domain->lock);
+        }
 
         return SA_OK;
 }
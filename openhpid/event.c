@@ -31,15 +31,41 @@
 #include <oh_plugin.h>
 #include <oh_session.h>
 #include <oh_utils.h>
+#include <sahpi_wrappers.h>
 
 #include "alarm.h"
 #include "conf.h"
 #include "event.h"
+#include "metrics.h"
+#include "snapshot.h"
 
 
 extern volatile int signal_stop;
 oh_evt_queue * oh_process_q = 0;
 
+/*
+ * Processing workers. Events of one resource always go to the same
+ * worker, so they are processed in the order the plugin sent them.
+ * With a single worker oh_process_q is processed directly.
+ * The RPT, DEL and alarm updates of all workers are serialized on the
+ * domain lock, only queueing to the sessions runs in parallel.
+ */
+static guint evt_workers = 0;
+static oh_evt_queue **evt_worker_q = NULL;
+
+/*
+ * Ready markers. A handler posts one after the events of its first
+ * discovery, see oh_post_ready_event(). Every worker gets a copy, and
+ * once all of them got to it the handler's earlier events are in the
+ * RPT. hid -> number of workers that got to it.
+ */
+static GHashTable *ready_seen = NULL;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex ready_lock;
+#else
+static GStaticMutex ready_lock = G_STATIC_MUTEX_INIT;
+#endif
+
 /*
  *  The following is required to set up the thread state for
  *  the use of event async queues.  This is true even if we aren't
@@ -60,6 +86,14 @@ int oh_event_init()
 
 int oh_event_finit(void)
 {
+        guint i;
+
+        for (i = 0; i < evt_workers; i++)
+                g_async_queue_unref(evt_worker_q[i]);
+        g_free(evt_worker_q);
+        evt_worker_q = NULL;
+        evt_workers = 0;
+
         if (oh_process_q) {
                 g_async_queue_unref(oh_process_q);
                 DBG("Processing queue is disposed.");
@@ -137,6 +171,130 @@ void oh_post_quit_event(void)
         }
 }
 
+static const char ready_signature[] = "OpenHPI handler ready";
+
+static struct oh_event * make_ready_event(unsigned int hid)
+{
+        struct oh_event * e     = oh_new_event();
+        SaHpiEventT * he        = &e->event;
+        SaHpiHpiSwEventT * swe  = &he->EventDataUnion.HpiSwEvent;
+        SaHpiTextBufferT * data = &swe->EventData;
+
+        e->hid                        = hid;
+        he->Source                    = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        he->EventType                 = SAHPI_ET_HPI_SW;
+        oh_gettimeofday(&he->Timestamp);
+        he->Severity                  = SAHPI_INFORMATIONAL;
+        swe->MId                      = SAHPI_MANUFACTURER_ID_UNSPECIFIED;
+        swe->Type                     = SAHPI_HPIE_OTHER;
+        data->DataType                = SAHPI_TL_TYPE_BINARY;
+        data->Language                = SAHPI_LANG_UNDEF;
+        data->DataLength              = sizeof(ready_signature);
+        memcpy(&data->Data[0], ready_signature, sizeof(ready_signature));
+        e->resource.ResourceId        = SAHPI_UNSPECIFIED_RESOURCE_ID;
+
+        return e;
+}
+
+static int is_ready_event(struct oh_event * e)
+{
+        const SaHpiTextBufferT * data;
+
+        if (e->event.EventType != SAHPI_ET_HPI_SW ||
+            e->event.Source != SAHPI_UNSPECIFIED_RESOURCE_ID ||
+            e->resource.ResourceCapabilities != 0 ||
+            e->event.EventDataUnion.HpiSwEvent.MId != 0) {
+                return 0;
+        }
+
+        data = &e->event.EventDataUnion.HpiSwEvent.EventData;
+        return data->DataLength == sizeof(ready_signature) &&
+               memcmp(&data->Data[0], ready_signature,
+                      sizeof(ready_signature)) == 0;
+}
+
+/**
+ * oh_post_ready_event
+ * @hid: id of a handler that is done with its first discovery
+ *
+ * Queues a marker behind the events the handler has sent so far. Once
+ * it has been processed, oh_snapshot_reconcile() is called for the
+ * handler.
+ **/
+void oh_post_ready_event(unsigned int hid)
+{
+        if (oh_process_q) {
+            oh_evt_queue_push(oh_process_q, make_ready_event(hid));
+        }
+}
+
+/**
+ * oh_remove_handler_resources
+ * @d: domain, locked by the caller
+ * @hid: id of a destroyed handler
+ *
+ * Queues a resource removed event for each resource of the handler
+ * that is still in the RPT of the domain.
+ **/
+void oh_remove_handler_resources(struct oh_domain *d, unsigned int hid)
+{
+        SaHpiRptEntryT *rpte;
+        SaHpiResourceIdT rid;
+        GSList *events = 0, *iter;
+
+        rid = SAHPI_FIRST_ENTRY;
+        while ((rpte = oh_get_resource_next(&(d->rpt), rid)) != 0) {
+            const void * data;
+            data = oh_get_resource_data(&(d->rpt), rpte->ResourceId);
+            if (data) {
+                const unsigned int rhid = *(const unsigned int*)(data);
+                if (rhid == hid) {
+                    struct oh_event * e = g_new0(struct oh_event, 1);
+                    e->hid = hid;
+                    e->resource = *rpte;
+                    e->rdrs = 0;
+                    e->rdrs_to_remove = 0;
+                    e->event.Source = rpte->ResourceId;
+                    e->event.EventType = SAHPI_ET_RESOURCE;
+                    oh_gettimeofday(&e->event.Timestamp);
+                    e->event.Severity = SAHPI_MAJOR;
+                    e->event.EventDataUnion.ResourceEvent.ResourceEventType
+                        = SAHPI_RESE_RESOURCE_REMOVED;
+                    events = g_slist_prepend(events, e);
+                }
+            }
+            rid = rpte->ResourceId;
+        }
+
+        iter = events;
+        while (iter) {
+            oh_evt_queue_push(oh_process_q, iter->data);
+            iter = g_slist_next(iter);
+        }
+        g_slist_free(events);
+}
+
+static void process_ready_event(struct oh_event * e)
+{
+        guint seen, need = evt_workers ? evt_workers : 1;
+        gpointer key = GUINT_TO_POINTER(e->hid);
+
+        wrap_g_static_mutex_lock(&ready_lock);
+        if (!ready_seen)
+                ready_seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+        seen = GPOINTER_TO_UINT(g_hash_table_lookup(ready_seen, key)) + 1;
+        if (seen < need) {
+                g_hash_table_insert(ready_seen, key, GUINT_TO_POINTER(seen));
+        } else {
+                g_hash_table_remove(ready_seen, key);
+        }
+        wrap_g_static_mutex_unlock(&ready_lock);
+
+        if (seen >= need) {
+                oh_snapshot_reconcile(e->hid);
+        }
+}
+
 int oh_detect_quit_event(struct oh_event * e)
 {
         if (!e) {
@@ -151,6 +309,7 @@ int oh_detect_quit_event(struct oh_event * e)
 
         struct oh_event * qe = make_quit_event();
         qe->event.Timestamp = e->event.Timestamp;
+        qe->pooled = e->pooled;
         int cc = memcmp( e, qe, sizeof(struct oh_event) );
         oh_event_free(qe, FALSE);
         if ( cc != 0 ) {
@@ -176,7 +335,9 @@ static SaErrorT harvest_events_for_handler(struct oh_handler *h)
 	if (!h->hnd || !h->abi->get_event) return SA_OK;
 
         do {
+                SaHpiUint64T start = oh_metrics_now();
                 error = h->abi->get_event(h->hnd);
+                oh_metrics_abi(h->id, oh_metrics_now() - start);
                 if (error < 1) {
                         DBG("Handler is out of Events");
                 }
@@ -201,6 +362,11 @@ SaErrorT oh_harvest_events()
                    break;
                 }
 
+                if (oh_handler_is_opening(hid)) {
+                        oh_getnext_handler_id(hid, &next_hid);
+                        continue;
+                }
+
                 h = oh_get_handler(hid);
                 if (!h) {
                         CRIT("No such handler %d", hid);
@@ -261,11 +427,13 @@ static int oh_add_event_to_del(struct oh_domain *d, struct oh_event *e)
         return error;
 }
 
+/*
+ * The process_*_event() functions run with the domain locked and
+ * return 1 if the event is to be queued to the sessions. That is done
+ * after the domain is unlocked, see process_event().
+ */
 static int process_hpi_event(struct oh_domain *d, struct oh_event *e)
 {
-        int i;
-        GArray *sessions = NULL;
-        SaHpiSessionIdT sid;
         SaHpiEventT *event = NULL;
         SaHpiRptEntryT *resource = NULL;
         SaHpiRdrT *rdr = NULL;
@@ -284,42 +452,7 @@ static int process_hpi_event(struct oh_domain *d, struct oh_event *e)
         oh_add_event_to_del(d, e);
         DBG("Added event to EL");
 
-        /*
-         * Here is the SESSION MULTIPLEXING code
-         */
-        sessions = oh_list_sessions(d->id);
-        if (!sessions) {
-                CRIT("Error: Got an empty session list on domain id %u", d->id);
-                return -2;
-        }
-        DBG("Got session list for domain %u", d->id);
-
-        /* Drop events if there are no sessions open to receive them.
-         */
-        if (sessions->len < 1) {
-                g_array_free(sessions, TRUE);
-                DBG("No sessions open for event's domain %u. "
-                    "Dropping hpi_event", d->id);
-                return 0;
-        }
-
-        /* multiplex event to the appropriate sessions */
-        for (i = 0; i < sessions->len; i++) {
-                SaHpiBoolT is_subscribed = SAHPI_FALSE;
-#if defined(__sparc) || defined(__sparc__)
-                sid = ((SaHpiSessionIdT *)((void *)(sessions->data)))[i];
-#else
-                sid = g_array_index(sessions, SaHpiSessionIdT, i);
-#endif
-                oh_get_session_subscription(sid, &is_subscribed);
-                if (is_subscribed) {
-                        oh_queue_session_event(sid, e);
-                }
-        }
-        g_array_free(sessions, TRUE);
-        DBG("done multiplexing event into sessions");
-
-        return 0;
+        return 1;
 }
 
 static int process_resource_event(struct oh_domain *d, struct oh_event *e)
@@ -336,6 +469,11 @@ static int process_resource_event(struct oh_domain *d, struct oh_event *e)
             return -1;
         }
 
+        /* Nothing new about a resource restored from the snapshot */
+        if (oh_snapshot_confirm(d, e)) {
+            return 0;
+        }
+
         rpt = &(d->rpt);
         exists = oh_get_resource_by_id(rpt, e->resource.ResourceId);
 
@@ -399,7 +537,7 @@ static int process_resource_event(struct oh_domain *d, struct oh_event *e)
         }
 
         if ( process ) {
-            process_hpi_event(d, e);
+            return process_hpi_event(d, e);
         }
 
         return 0;
@@ -417,6 +555,10 @@ static int process_hs_event(struct oh_domain *d, struct oh_event *e)
             return -1;
         }
 
+        if (oh_snapshot_confirm(d, e)) {
+            return 0;
+        }
+
         rpt = &(d->rpt);
         exists = oh_get_resource_by_id(rpt, e->resource.ResourceId);
         hse = &e->event.EventDataUnion.HotSwapEvent;
@@ -436,7 +578,7 @@ static int process_hs_event(struct oh_domain *d, struct oh_event *e)
         }
 
         if (hse->HotSwapState != hse->PreviousHotSwapState) {
-            process_hpi_event(d, e);
+            return process_hpi_event(d, e);
         }
 
         return 0;
@@ -446,7 +588,9 @@ static int process_event(SaHpiDomainIdT did,
                          struct oh_event *e)
 {
         struct oh_domain *d = NULL;
+        struct oh_session_subscribers *subs = NULL;
         RPTable *rpt = NULL;
+        int deliver = 0;
 
         if (!e) {
 		CRIT("Got NULL event");
@@ -480,7 +624,7 @@ static int process_event(SaHpiDomainIdT did,
                         CRIT("Invalid event. Resource in resource added event "
                             "has FRU capability. Dropping.");
                 } else {
-                        process_resource_event(d, e);
+                        deliver = process_resource_event(d, e);
                 }
                 break;
         case SAHPI_ET_HOTSWAP:
@@ -503,7 +647,7 @@ static int process_event(SaHpiDomainIdT did,
                         CRIT("Invalid event. Resource in hotswap event "
                                 "has no FRU capability. Dropping.");
                 } else {
-                        process_hs_event(d, e);
+                        deliver = process_hs_event(d, e);
                 }
                 break;
         case SAHPI_ET_SENSOR:
@@ -516,24 +660,45 @@ static int process_event(SaHpiDomainIdT did,
         case SAHPI_ET_DIMI:
         case SAHPI_ET_DIMI_UPDATE:
         case SAHPI_ET_FUMI:
-                process_hpi_event(d, e);
+                deliver = process_hpi_event(d, e);
                 break;
         default:
 		CRIT("Don't know what to do for event type  %d", e->event.EventType);
         }
         oh_detect_event_alarm(d, e);
+        if (deliver > 0) subs = oh_get_domain_subscribers(d);
         oh_release_domain(d);
 
+        /*
+         * Here is the SESSION MULTIPLEXING code
+         */
+        if (deliver > 0) {
+                if (oh_queue_subscribers_event(subs, e) == 0) {
+                        /* Drop events if there are no sessions to receive them. */
+                        DBG("No sessions subscribed to event's domain %u. "
+                            "Dropping hpi_event", did);
+                } else {
+                        DBG("done multiplexing event into sessions");
+                }
+                oh_release_subscribers(subs);
+        }
+
         return 0;
 }
 
-SaErrorT oh_process_events()
+static SaErrorT process_queue(oh_evt_queue *q)
 {
         int cc;
         struct oh_event *e;
 
-        while ((e = g_async_queue_pop(oh_process_q)) != NULL) {
+        while ((e = g_async_queue_pop(q)) != NULL) {
+                if (is_ready_event(e)) {
+                        process_ready_event(e);
+                        oh_event_free(e, FALSE);
+                        continue;
+                }
                 process_event(OH_DEFAULT_DOMAIN_ID, e);
+                oh_metrics_event_processed();
                 cc = oh_detect_quit_event(e);
                 oh_event_free(e, FALSE);
                 if (cc == 0) {
@@ -544,3 +709,95 @@ SaErrorT oh_process_events()
         return SA_OK;
 }
 
+SaErrorT oh_process_events()
+{
+        struct oh_event *e;
+        guint i;
+
+        if (!evt_workers) {
+                return process_queue(oh_process_q);
+        }
+
+        /* Hand events over to the workers by resource */
+        while ((e = g_async_queue_pop(oh_process_q)) != NULL) {
+                if (oh_detect_quit_event(e) == 0) {
+                        for (i = 0; i < evt_workers; i++) {
+                                oh_evt_queue_push(evt_worker_q[i],
+                                                  make_quit_event());
+                        }
+                        oh_event_free(e, FALSE);
+                        break;
+                }
+                if (is_ready_event(e)) {
+                        for (i = 0; i < evt_workers; i++) {
+                                oh_evt_queue_push(evt_worker_q[i],
+                                                  make_ready_event(e->hid));
+                        }
+                        oh_event_free(e, FALSE);
+                        continue;
+                }
+                oh_evt_queue_push(evt_worker_q[e->event.Source % evt_workers], e);
+        }
+
+        return SA_OK;
+}
+
+/**
+ * oh_event_workers
+ *
+ * Sets up the worker queues from OPENHPI_EVT_WORKERS on the first call,
+ * so it has to be called after the configuration is loaded and before
+ * the event threads start.
+ *
+ * Returns: number of worker threads to run oh_process_worker_events(),
+ * 0 if oh_process_events() processes the events itself.
+ **/
+guint oh_event_workers(void)
+{
+        struct oh_global_param param;
+        guint i;
+
+        if (!evt_worker_q) {
+                oh_get_global_param2(OPENHPI_EVT_WORKERS, &param);
+                if (param.u.evt_workers > 1) {
+                        evt_workers = param.u.evt_workers;
+                        evt_worker_q = g_new0(oh_evt_queue *, evt_workers);
+                        for (i = 0; i < evt_workers; i++)
+                                evt_worker_q[i] = g_async_queue_new();
+                        DBG("Set up %u event processing workers.", evt_workers);
+                }
+        }
+
+        return evt_workers;
+}
+
+SaErrorT oh_process_worker_events(guint worker)
+{
+        if (worker >= evt_workers) {
+                return SA_ERR_HPI_INVALID_PARAMS;
+        }
+
+        return process_queue(evt_worker_q[worker]);
+}
+
+/**
+ * oh_event_queue_length
+ *
+ * Returns: number of events waiting to be processed.
+ **/
+guint oh_event_queue_length(void)
+{
+        gint len, total = 0;
+        guint i;
+
+        if (oh_process_q) {
+                len = g_async_queue_length(oh_process_q);
+                if (len > 0) total += len;
+        }
+        for (i = 0; i < evt_workers; i++) {
+                len = g_async_queue_length(evt_worker_q[i]);
+                if (len > 0) total += len;
+        }
+
+        return total;
+}
@@ -20,6 +20,7 @@
 #ifndef __OH_EVENT_H
 #define __OH_EVENT_H
 
+#include <oh_domain.h>
 #include <oh_utils.h>
 
 #ifdef __cplusplus
@@ -33,8 +34,13 @@ int oh_event_init(void);
 int oh_event_finit(void);
 void oh_post_quit_event(void);
 int oh_detect_quit_event(struct oh_event * e);
+void oh_post_ready_event(unsigned int hid);
+void oh_remove_handler_resources(struct oh_domain *d, unsigned int hid);
 SaErrorT oh_harvest_events(void);
 SaErrorT oh_process_events(void);
+guint oh_event_workers(void);
+SaErrorT oh_process_worker_events(guint worker);
+guint oh_event_queue_length(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,702 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+
+#include <oh_domain.h>
+#include <oh_error.h>
+#include <oh_plugin.h>
+#include <oh_utils.h>
+#include <sahpi_wrappers.h>
+
+#include "conf.h"
+#include "history.h"
+#include "metrics.h"
+
+/* Samples per block of a delta encoded history */
+#define OH_HISTORY_BLOCK_SAMPLES 64
+/* Longest delta encoded sample: flags, time, event state, reading */
+#define OH_HISTORY_MAX_DELTA (1 + 10 + 3 + sizeof(SaHpiSensorReadingUnionT))
+
+/* Flags in front of each delta encoded sample */
+#define OH_HISTORY_STATE 0x01 /* Event state follows */
+#define OH_HISTORY_SAME  0x02 /* Reading did not change, no value follows */
+
+struct oh_history_key {
+        SaHpiResourceIdT rid;
+        SaHpiSensorNumT num;
+};
+
+/*
+ * A block starts with a sample stored as is, the others are stored as
+ * the difference to the sample before them. All samples of a block
+ * have the same reading type.
+ */
+struct oh_history_block {
+        oHpiSensorSampleT first;
+        guint count;    /* Samples including the first */
+        guint len;      /* Bytes of deltas */
+        guint size;     /* Bytes allocated */
+        guchar *data;
+};
+
+struct oh_sensor_history {
+        struct oh_history_key key;
+        guint round;    /* Last sampling round that saw the sensor */
+        guint count;    /* Samples stored */
+        /* Plain: ring of samples */
+        oHpiSensorSampleT *samples;
+        guint head;     /* Slot for the next sample */
+        /* Delta encoded: ring of blocks, the newest one is being filled */
+        struct oh_history_block *blocks;
+        guint nblocks;
+        guint first;    /* Oldest block */
+        guint used;
+        oHpiSensorSampleT last;  /* Newest sample */
+        SaHpiInt64T last_delta;  /* Time between the newest two samples */
+};
+
+struct oh_history_target {
+        struct oh_history_key key;
+        unsigned int hid;
+};
+
+static struct {
+        int configured;
+        guint size;
+        SaHpiBoolT delta;
+        SaHpiBoolT all_types;
+        guchar types[256 / 8]; /* Bit per SaHpiSensorTypeT */
+        guint round;
+        GHashTable *table;
+} history;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex history_lock;
+#else
+static GStaticMutex history_lock = G_STATIC_MUTEX_INIT;
+#endif
+
+static guint history_key_hash(gconstpointer key)
+{
+        const struct oh_history_key *k = key;
+
+        return (k->rid * 257) ^ k->num;
+}
+
+static gboolean history_key_equal(gconstpointer a, gconstpointer b)
+{
+        const struct oh_history_key *ka = a, *kb = b;
+
+        return ka->rid == kb->rid && ka->num == kb->num;
+}
+
+static void free_history(gpointer data)
+{
+        struct oh_sensor_history *h = data;
+        guint i;
+
+        if (h->blocks) {
+                for (i = 0; i < h->nblocks; i++)
+                        g_free(h->blocks[i].data);
+                g_free(h->blocks);
+        }
+        g_free(h->samples);
+        g_free(h);
+}
+
+/* OPENHPI_HISTORY_SENSORS is a comma separated list of sensor types */
+static void parse_types(const char *list)
+{
+        SaHpiTextBufferT buffer;
+        SaHpiSensorTypeT type;
+        gchar **names;
+        guint i;
+
+        memset(history.types, 0, sizeof(history.types));
+        history.all_types = SAHPI_TRUE;
+        if (!list || list[0] == '\0')
+                return;
+
+        names = g_strsplit(list, ",", 0);
+        for (i = 0; names[i]; i++) {
+                g_strstrip(names[i]);
+                if (names[i][0] == '\0')
+                        continue;
+                oh_init_textbuffer(&buffer);
+                oh_append_textbuffer(&buffer, names[i]);
+                if (oh_encode_sensortype(&buffer, &type) != SA_OK) {
+                        CRIT("Invalid sensor type %s in OPENHPI_HISTORY_SENSORS.",
+                             names[i]);
+                        continue;
+                }
+                history.types[type / 8] |= 1 << (type % 8);
+                history.all_types = SAHPI_FALSE;
+        }
+        g_strfreev(names);
+}
+
+/* Call with history_lock held */
+static void configure(void)
+{
+        struct oh_global_param param;
+
+        if (history.configured)
+                return;
+
+        oh_get_global_param2(OPENHPI_HISTORY_SIZE, &param);
+        history.size = param.u.history_size ? param.u.history_size : 1;
+        oh_get_global_param2(OPENHPI_HISTORY_DELTA, &param);
+        history.delta = param.u.history_delta;
+        oh_get_global_param2(OPENHPI_HISTORY_SENSORS, &param);
+        parse_types(param.u.history_sensors);
+
+        history.table = g_hash_table_new_full(history_key_hash,
+                                              history_key_equal,
+                                              NULL, free_history);
+        history.configured = 1;
+}
+
+static int wants_type(SaHpiSensorTypeT type)
+{
+        if (history.all_types)
+                return 1;
+
+        return (history.types[(type & 0xff) / 8] >> (type % 8)) & 1;
+}
+
+/* Clears what the plugin may have left in the unused part of the value */
+static void normalize_reading(SaHpiSensorReadingT *reading)
+{
+        SaHpiSensorReadingUnionT value = reading->Value;
+
+        memset(&reading->Value, 0, sizeof(reading->Value));
+        if (reading->IsSupported == SAHPI_FALSE) {
+                reading->Type = 0;
+                return;
+        }
+
+        switch (reading->Type) {
+        case SAHPI_SENSOR_READING_TYPE_INT64:
+                reading->Value.SensorInt64 = value.SensorInt64;
+                break;
+        case SAHPI_SENSOR_READING_TYPE_UINT64:
+                reading->Value.SensorUint64 = value.SensorUint64;
+                break;
+        case SAHPI_SENSOR_READING_TYPE_FLOAT64:
+                reading->Value.SensorFloat64 = value.SensorFloat64;
+                break;
+        default:
+                reading->Value = value;
+                break;
+        }
+}
+
+/*
+ * Delta encoding
+ *
+ * Time goes in as the change of the sampling period, which is close to
+ * zero while the daemon keeps pace. Integers go in as the difference to
+ * the previous value, floats as the bits that changed. All of them are
+ * written as LEB128 varints, signed ones zigzag encoded first.
+ */
+static guint put_varint(guchar *p, SaHpiUint64T v)
+{
+        guint n = 0;
+
+        while (v >= 0x80) {
+                p[n++] = (guchar)(v | 0x80);
+                v >>= 7;
+        }
+        p[n++] = (guchar)v;
+
+        return n;
+}
+
+static guint get_varint(const guchar *p, SaHpiUint64T *v)
+{
+        guint n = 0, shift = 0;
+
+        *v = 0;
+        do {
+                *v |= (SaHpiUint64T)(p[n] & 0x7f) << shift;
+                shift += 7;
+        } while (p[n++] & 0x80);
+
+        return n;
+}
+
+static SaHpiUint64T zigzag(SaHpiInt64T v)
+{
+        return ((SaHpiUint64T)v << 1) ^ (SaHpiUint64T)(v >> 63);
+}
+
+static SaHpiInt64T unzigzag(SaHpiUint64T v)
+{
+        return (SaHpiInt64T)(v >> 1) ^ -(SaHpiInt64T)(v & 1);
+}
+
+static SaHpiUint64T value_bits(const SaHpiSensorReadingT *reading)
+{
+        SaHpiUint64T bits;
+
+        memcpy(&bits, &reading->Value, sizeof(bits));
+
+        return bits;
+}
+
+static guint encode_sample(guchar *p,
+                           const oHpiSensorSampleT *prev,
+                           SaHpiInt64T prev_delta,
+                           const oHpiSensorSampleT *s)
+{
+        SaHpiInt64T delta = s->Timestamp - prev->Timestamp;
+        SaHpiUint64T x;
+        guchar flags = 0;
+        guint n = 1, tz;
+
+        if (s->EventState != prev->EventState)
+                flags |= OH_HISTORY_STATE;
+        if (memcmp(&s->Reading.Value, &prev->Reading.Value,
+                   sizeof(SaHpiSensorReadingUnionT)) == 0)
+                flags |= OH_HISTORY_SAME;
+        p[0] = flags;
+
+        n += put_varint(p + n, zigzag(delta - prev_delta));
+        if (flags & OH_HISTORY_STATE)
+                n += put_varint(p + n, s->EventState);
+        if (flags & OH_HISTORY_SAME)
+                return n;
+
+        switch (s->Reading.Type) {
+        case SAHPI_SENSOR_READING_TYPE_INT64:
+        case SAHPI_SENSOR_READING_TYPE_UINT64:
+                x = value_bits(&s->Reading) - value_bits(&prev->Reading);
+                n += put_varint(p + n, zigzag((SaHpiInt64T)x));
+                break;
+        case SAHPI_SENSOR_READING_TYPE_FLOAT64:
+                /* Not the same, so at least one bit changed */
+                x = value_bits(&s->Reading) ^ value_bits(&prev->Reading);
+                for (tz = 0; !(x & 1); tz++)
+                        x >>= 1;
+                p[n++] = (guchar)tz;
+                n += put_varint(p + n, x);
+                break;
+        default:
+                memcpy(p + n, &s->Reading.Value, sizeof(SaHpiSensorReadingUnionT));
+                n += sizeof(SaHpiSensorReadingUnionT);
+                break;
+        }
+
+        return n;
+}
+
+static guint decode_sample(const guchar *p,
+                           const oHpiSensorSampleT *prev,
+                           SaHpiInt64T *prev_delta,
+                           oHpiSensorSampleT *s)
+{
+        guchar flags = p[0];
+        SaHpiUint64T v, bits;
+        guint n = 1, tz;
+
+        *s = *prev;
+        n += get_varint(p + n, &v);
+        *prev_delta += unzigzag(v);
+        s->Timestamp = prev->Timestamp + *prev_delta;
+        if (flags & OH_HISTORY_STATE) {
+                n += get_varint(p + n, &v);
+                s->EventState = (SaHpiEventStateT)v;
+        }
+        if (flags & OH_HISTORY_SAME)
+                return n;
+
+        bits = value_bits(&prev->Reading);
+        switch (s->Reading.Type) {
+        case SAHPI_SENSOR_READING_TYPE_INT64:
+        case SAHPI_SENSOR_READING_TYPE_UINT64:
+                n += get_varint(p + n, &v);
+                bits += (SaHpiUint64T)unzigzag(v);
+                memcpy(&s->Reading.Value, &bits, sizeof(bits));
+                break;
+        case SAHPI_SENSOR_READING_TYPE_FLOAT64:
+                tz = p[n++];
+                n += get_varint(p + n, &v);
+                bits ^= v << tz;
+                memcpy(&s->Reading.Value, &bits, sizeof(bits));
+                break;
+        default:
+                memcpy(&s->Reading.Value, p + n, sizeof(SaHpiSensorReadingUnionT));
+                n += sizeof(SaHpiSensorReadingUnionT);
+                break;
+        }
+
+        return n;
+}
+
+static struct oh_sensor_history *new_history(const struct oh_history_key *key)
+{
+        struct oh_sensor_history *h = g_new0(struct oh_sensor_history, 1);
+
+        h->key = *key;
+        if (history.delta) {
+                /* Keep history.size samples even right after
+                   the oldest block was dropped */
+                h->nblocks = (history.size + OH_HISTORY_BLOCK_SAMPLES - 2) /
+                             OH_HISTORY_BLOCK_SAMPLES + 2;
+                h->blocks = g_new0(struct oh_history_block, h->nblocks);
+        } else {
+                h->samples = g_new0(oHpiSensorSampleT, history.size);
+        }
+
+        return h;
+}
+
+static void seal_block(struct oh_history_block *b)
+{
+        if (b->len < b->size) {
+                b->data = g_realloc(b->data, b->len);
+                b->size = b->len;
+        }
+}
+
+static void append_delta(struct oh_sensor_history *h,
+                         const oHpiSensorSampleT *s)
+{
+        struct oh_history_block *b = NULL;
+
+        if (h->used)
+                b = &h->blocks[(h->first + h->used - 1) % h->nblocks];
+
+        if (!b || b->count >= OH_HISTORY_BLOCK_SAMPLES ||
+            b->first.Reading.IsSupported != s->Reading.IsSupported ||
+            b->first.Reading.Type != s->Reading.Type) {
+                if (b)
+                        seal_block(b);
+                if (h->used == h->nblocks) {
+                        b = &h->blocks[h->first];
+                        h->count -= b->count;
+                        g_free(b->data);
+                        h->first = (h->first + 1) % h->nblocks;
+                        h->used--;
+                }
+                b = &h->blocks[(h->first + h->used) % h->nblocks];
+                memset(b, 0, sizeof(*b));
+                b->first = *s;
+                b->count = 1;
+                h->used++;
+                h->last_delta = 0;
+        } else {
+                if (b->size - b->len < OH_HISTORY_MAX_DELTA) {
+                        b->size = b->size ? b->size * 2 : 64;
+                        b->data = g_realloc(b->data, b->size);
+                }
+                b->len += encode_sample(b->data + b->len,
+                                        &h->last, h->last_delta, s);
+                h->last_delta = s->Timestamp - h->last.Timestamp;
+                b->count++;
+        }
+
+        h->last = *s;
+        h->count++;
+}
+
+static void append_sample(struct oh_sensor_history *h,
+                          const oHpiSensorSampleT *s)
+{
+        if (h->blocks) {
+                append_delta(h, s);
+                return;
+        }
+
+        h->samples[h->head] = *s;
+        h->head = (h->head + 1) % history.size;
+        if (h->count < history.size)
+                h->count++;
+}
+
+struct history_query {
+        SaHpiTimeT start;
+        SaHpiTimeT end;
+        guint skip;     /* Samples beyond history.size to pass over */
+        guint max;
+        guint n;
+        oHpiSensorSampleT *samples;
+};
+
+/* Returns 0 when the caller's buffer is full */
+static int query_sample(struct history_query *q, const oHpiSensorSampleT *s)
+{
+        if (q->skip) {
+                q->skip--;
+                return 1;
+        }
+        if (s->Timestamp < q->start)
+                return 1;
+        if (q->end != SAHPI_TIME_UNSPECIFIED && s->Timestamp > q->end)
+                return 1;
+
+        q->samples[q->n++] = *s;
+
+        return q->n < q->max;
+}
+
+static void query_history(const struct oh_sensor_history *h,
+                          struct history_query *q)
+{
+        const struct oh_history_block *b;
+        oHpiSensorSampleT prev, s;
+        SaHpiInt64T delta;
+        guint i, j, off;
+
+        if (!h->blocks) {
+                for (i = 0; i < h->count; i++) {
+                        j = (h->head + history.size - h->count + i) % history.size;
+                        if (!query_sample(q, &h->samples[j]))
+                                return;
+                }
+                return;
+        }
+
+        q->skip = h->count > history.size ? h->count - history.size : 0;
+        for (i = 0; i < h->used; i++) {
+                b = &h->blocks[(h->first + i) % h->nblocks];
+                if (q->skip >= b->count) {
+                        q->skip -= b->count;
+                        continue;
+                }
+                prev = b->first;
+                delta = 0;
+                if (!query_sample(q, &prev))
+                        return;
+                for (j = 1, off = 0; j < b->count; j++) {
+                        off += decode_sample(b->data + off, &prev, &delta, &s);
+                        if (!query_sample(q, &s))
+                                return;
+                        prev = s;
+                }
+        }
+}
+
+static gboolean history_gone(gpointer key, gpointer value, gpointer data)
+{
+        struct oh_sensor_history *h = value;
+
+        return h->round != GPOINTER_TO_UINT(data);
+}
+
+static GArray *get_targets(void)
+{
+        struct oh_domain *d;
+        struct oh_history_target t;
+        SaHpiRptEntryT *rpte;
+        SaHpiRdrT *rdr;
+        unsigned int *hid;
+        GArray *targets;
+
+        d = oh_get_domain(OH_DEFAULT_DOMAIN_ID);
+        if (!d)
+                return NULL;
+
+        targets = g_array_new(FALSE, FALSE, sizeof(struct oh_history_target));
+        for (rpte = oh_get_resource_next(&d->rpt, SAHPI_FIRST_ENTRY);
+             rpte;
+             rpte = oh_get_resource_next(&d->rpt, rpte->ResourceId)) {
+                if (!(rpte->ResourceCapabilities & SAHPI_CAPABILITY_SENSOR))
+                        continue;
+                hid = oh_get_resource_data(&d->rpt, rpte->ResourceId);
+                if (!hid)
+                        continue;
+                for (rdr = oh_get_rdr_by_type_first(&d->rpt, rpte->ResourceId,
+                                                    SAHPI_SENSOR_RDR);
+                     rdr;
+                     rdr = oh_get_rdr_by_type_next(&d->rpt, rpte->ResourceId,
+                                                   SAHPI_SENSOR_RDR,
+                                                   rdr->RdrTypeUnion.SensorRec.Num)) {
+                        const SaHpiSensorRecT *rec = &rdr->RdrTypeUnion.SensorRec;
+
+                        if (!rec->DataFormat.IsSupported ||
+                            !wants_type(rec->Type))
+                                continue;
+                        t.key.rid = rpte->ResourceId;
+                        t.key.num = rec->Num;
+                        t.hid = *hid;
+                        g_array_append_val(targets, t);
+                }
+        }
+        oh_release_domain(d);
+
+        return targets;
+}
+
+static SaErrorT read_sensor(const struct oh_history_target *t,
+                            oHpiSensorSampleT *s)
+{
+        struct oh_handler *h;
+        SaHpiUint64T start;
+        SaErrorT error, rv = SA_ERR_HPI_INVALID_CMD;
+
+        /* Users come first: give up if the handler is busy */
+        h = oh_get_handler_try(t->hid, &error);
+        if (!h)
+                return error != SA_OK ? error : SA_ERR_HPI_INVALID_RESOURCE;
+
+        memset(s, 0, sizeof(*s));
+        if (h->hnd && h->abi->get_sensor_reading) {
+                start = oh_metrics_now();
+                rv = h->abi->get_sensor_reading(h->hnd, t->key.rid, t->key.num,
+                                                &s->Reading, &s->EventState);
+                oh_metrics_abi(h->id, oh_metrics_now() - start);
+        }
+        oh_release_handler(h);
+
+        if (rv == SA_OK) {
+                oh_gettimeofday(&s->Timestamp);
+                normalize_reading(&s->Reading);
+        }
+
+        return rv;
+}
+
+/**
+ * oh_history_interval
+ *
+ * Returns: OPENHPI_HISTORY_INTERVAL in msec, 0 if there is no sensor
+ * history.
+ **/
+guint oh_history_interval(void)
+{
+        struct oh_global_param param;
+
+        oh_get_global_param2(OPENHPI_HISTORY_INTERVAL, &param);
+
+        return param.u.history_interval;
+}
+
+/**
+ * oh_history_sample
+ *
+ * Does one sampling round: reads all sensors of the default domain
+ * that have readings and match OPENHPI_HISTORY_SENSORS and appends the
+ * readings to their histories. Sensors are read without the domain
+ * lock, so clients are not held up by slow handlers.
+ **/
+void oh_history_sample(void)
+{
+        struct oh_sensor_history *h;
+        struct oh_history_target *t;
+        oHpiSensorSampleT s;
+        GArray *targets;
+        SaErrorT rv;
+        guint round, i;
+
+        wrap_g_static_mutex_lock(&history_lock);
+        configure();
+        round = ++history.round;
+        wrap_g_static_mutex_unlock(&history_lock);
+
+        targets = get_targets();
+        if (!targets)
+                return;
+
+        for (i = 0; i < targets->len; i++) {
+                t = &g_array_index(targets, struct oh_history_target, i);
+                rv = read_sensor(t, &s);
+
+                wrap_g_static_mutex_lock(&history_lock);
+                h = g_hash_table_lookup(history.table, &t->key);
+                if (!h && rv == SA_OK) {
+                        h = new_history(&t->key);
+                        g_hash_table_insert(history.table, &h->key, h);
+                }
+                if (h) {
+                        h->round = round;
+                        if (rv == SA_OK)
+                                append_sample(h, &s);
+                }
+                wrap_g_static_mutex_unlock(&history_lock);
+        }
+        g_array_free(targets, TRUE);
+
+        wrap_g_static_mutex_lock(&history_lock);
+        g_hash_table_foreach_remove(history.table, history_gone,
+                                    GUINT_TO_POINTER(round));
+        wrap_g_static_mutex_unlock(&history_lock);
+}
+
+/**
+ * oh_history_flush
+ *
+ * Drops all histories. The next oh_history_sample() reads the
+ * configuration again.
+ **/
+void oh_history_flush(void)
+{
+        wrap_g_static_mutex_lock(&history_lock);
+        if (history.table)
+                g_hash_table_destroy(history.table);
+        memset(&history, 0, sizeof(history));
+        wrap_g_static_mutex_unlock(&history_lock);
+}
+
+/**
+ * oh_history_get
+ * @did: domain of the session
+ * @rid: resource id of the sensor
+ * @num: sensor number
+ * @start: time of the oldest sample wanted
+ * @end: time of the newest sample wanted, SAHPI_TIME_UNSPECIFIED for all
+ * @num_samples: room in @samples on input, samples returned on output
+ * @samples: place for the samples, oldest first
+ *
+ * Returns: SA_OK, or SA_ERR_HPI_NOT_PRESENT if there is no history of
+ * the sensor.
+ **/
+SaErrorT oh_history_get(SaHpiDomainIdT did,
+                        SaHpiResourceIdT rid,
+                        SaHpiSensorNumT num,
+                        SaHpiTimeT start,
+                        SaHpiTimeT end,
+                        SaHpiUint32T *num_samples,
+                        oHpiSensorSampleT *samples)
+{
+        struct oh_sensor_history *h = NULL;
+        struct oh_history_key key;
+        struct history_query q;
+
+        if (!num_samples || !samples || *num_samples == 0)
+                return SA_ERR_HPI_INVALID_PARAMS;
+
+        /* Only the default domain is sampled */
+        if (did != OH_DEFAULT_DOMAIN_ID)
+                return SA_ERR_HPI_NOT_PRESENT;
+
+        key.rid = rid;
+        key.num = num;
+        memset(&q, 0, sizeof(q));
+        q.start = start;
+        q.end = end;
+        q.max = *num_samples;
+        q.samples = samples;
+
+        wrap_g_static_mutex_lock(&history_lock);
+        if (history.table)
+                h = g_hash_table_lookup(history.table, &key);
+        if (h)
+                query_history(h, &q);
+        wrap_g_static_mutex_unlock(&history_lock);
+
+        if (!h)
+                return SA_ERR_HPI_NOT_PRESENT;
+
+        *num_samples = q.n;
+
+        return SA_OK;
+}
@@ -0,0 +1,48 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __OH_HISTORY_H
+#define __OH_HISTORY_H
+
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sensor history.
+ *
+ * The sampling thread reads the sensors of the default domain every
+ * OPENHPI_HISTORY_INTERVAL msec into one ring buffer per sensor, so
+ * clients share one stream of readings instead of polling each on
+ * their own. Rings of sensors that went away are dropped on the next
+ * round.
+ */
+guint oh_history_interval(void);
+void oh_history_sample(void);
+void oh_history_flush(void);
+
+SaErrorT oh_history_get(SaHpiDomainIdT did,
+                        SaHpiResourceIdT rid,
+                        SaHpiSensorNumT num,
+                        SaHpiTimeT start,
+                        SaHpiTimeT end,
+                        SaHpiUint32T *num_samples,
+                        oHpiSensorSampleT *samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OH_HISTORY_H */
@@ -38,9 +38,41 @@
 #include "event.h"
 #include "init.h"
 #include "lock.h"
+#include "snapshot.h"
 #include "threaded.h"
 #include "sahpi_wrappers.h"
 
+/* How long oh_init() waits for handlers to open, msec */
+static const guint OH_HANDLER_STARTUP_WAIT = 1000;
+
+/* Set while the handlers are up, config reloads are done only then */
+static int running = 0;
+
+static int load_config(struct oh_parsed_config *config)
+{
+        struct oh_global_param param;
+        int rval;
+
+        /* Set openhpi configuration file location */
+        oh_get_global_param2(OPENHPI_CONF, &param);
+#ifdef _WIN32
+        char config_file[MAX_PATH];
+        DWORD cc = ExpandEnvironmentStrings(param.u.conf, config_file, MAX_PATH);
+        if ((cc != 0) && (cc < MAX_PATH)) {
+            INFO("Loading config file %s.", config_file);
+            rval = oh_load_config(config_file, config);
+        } else {
+            CRIT("Failed to expand config file path: %s", param.u.conf);
+            rval = SA_ERR_HPI_ERROR;
+        }
+#else
+        INFO("Loading config file %s.", param.u.conf);
+        rval = oh_load_config(param.u.conf, config);
+#endif /* _WIN32 */
+
+        return rval;
+}
+
 /**
  * oh_init
  *
@@ -52,6 +84,7 @@ int oh_init(void)
         struct oh_global_param param;
         struct oh_parsed_config config = { NULL, 0, 0 };
         SaErrorT rval;
+        guint pending;
 
         if (g_thread_supported() == FALSE) {
             wrap_g_thread_init(0);
@@ -74,22 +107,7 @@ int oh_init(void)
 		return SA_ERR_HPI_OUT_OF_MEMORY; /* Most likely */
 	}
 #endif
-        /* Set openhpi configuration file location */
-        oh_get_global_param2(OPENHPI_CONF, &param);
-#ifdef _WIN32
-        char config_file[MAX_PATH];
-        DWORD cc = ExpandEnvironmentStrings(param.u.conf, config_file, MAX_PATH);
-        if ((cc != 0) && (cc < MAX_PATH)) {
-            INFO("Loading config file %s.", config_file);
-            rval = oh_load_config(config_file, &config);
-        } else {
-            CRIT("Failed to expand config file path: %s", param.u.conf);
-            rval = SA_ERR_HPI_ERROR;
-        }
-#else
-        INFO("Loading config file %s.", param.u.conf);
-        rval = oh_load_config(param.u.conf, &config);
-#endif /* _WIN32 */
+        rval = load_config(&config);
         /* Don't error out if there is no conf file */
         if (rval < 0 && rval != -4) {
                 CRIT("Can not load config.");
@@ -171,10 +189,14 @@ int oh_init(void)
                    return SA_ERR_HPI_ERROR;
         }
 
+        /* Serve the last known resources until the handlers report */
+        oh_snapshot_load();
+
         /* Start discovery and event threads */
 	oh_threaded_start();
 
         initialized = 1;
+        running = 1;
         data_access_unlock();
 	INFO("OpenHPI has been initialized.");
 
@@ -187,10 +209,14 @@ int oh_init(void)
         }
 
         /*
-         * HACK: wait a second before returning
-         * to give the threads time to populate the RPT
+         * Give the handlers a moment to open and populate the RPT.
+         * Slow ones keep opening in the background while the
+         * daemon is serving clients.
          */
-        g_usleep(G_USEC_PER_SEC);
+        pending = oh_wait_for_handlers(OH_HANDLER_STARTUP_WAIT);
+        if (pending) {
+                INFO("%u handler(s) still opening.", pending);
+        }
 
         /* Do not use SA_OK here in case it is ever changed to something
          * besides zero, The runtime stuff depends on zero being returned here
@@ -199,6 +225,49 @@ int oh_init(void)
         return 0;
 }
 
+/**
+ * oh_reload_config
+ *
+ * Reads the configuration file again while the daemon keeps running.
+ * The global parameters are rebuilt from their defaults, the file and
+ * the environment and replace the current ones at once, so values set
+ * with oHpiGlobalParamSet() since are reset. The ones only read at
+ * startup still need a restart to take effect.
+ * Only handlers whose stanza was added, changed or removed are
+ * destroyed or created, see oh_process_config_changes(), so the other
+ * handlers keep their discovered resources.
+ *
+ * Returns: SA_OK on success, SA_ERR_HPI_NOT_PRESENT if the file could
+ * not be read. Nothing is changed then.
+ **/
+SaErrorT oh_reload_config(void)
+{
+        struct oh_parsed_config config = { NULL, 0, 0 };
+        int rval;
+
+        data_access_lock();
+        if (!running) {
+                data_access_unlock();
+                return SA_ERR_HPI_INVALID_REQUEST;
+        }
+
+        rval = load_config(&config);
+        if (rval < 0) {
+                CRIT("Can not reload config.");
+                data_access_unlock();
+                return SA_ERR_HPI_NOT_PRESENT;
+        }
+
+        oh_process_config_changes(&config);
+        oh_clean_config(&config);
+        data_access_unlock();
+
+        INFO("Config reloaded, %u of %u handler(s) loaded.",
+             config.handlers_loaded, config.handlers_defined);
+
+        return SA_OK;
+}
+
 /**
  * oh_finit
  *
@@ -206,12 +275,23 @@ int oh_init(void)
  **/
 int oh_finit(void)
 {
+        /* No config reloads from here on */
+        data_access_lock();
+        running = 0;
+        data_access_unlock();
+
+        oh_finit_handler_opens();
+
         data_access_lock();
         oh_close_handlers();
         data_access_unlock();
 
         oh_threaded_stop();
 
+        oh_uid_map_flush();
+        oh_snapshot_save();
+        oh_snapshot_finit();
+
         oh_destroy_domain(OH_DEFAULT_DOMAIN_ID);
         g_hash_table_destroy(oh_sessions.table);
         g_hash_table_destroy(oh_domains.table);
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 int oh_init(void);
+SaErrorT oh_reload_config(void);
 int oh_finit(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,454 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <oh_error.h>
+#include <oh_session.h>
+#include <oh_utils.h>
+
+#include "dispatch.h"
+#include "event.h"
+#include "metrics.h"
+#include <sahpi_wrappers.h>
+
+struct oh_histogram {
+        SaHpiUint64T count;
+        SaHpiUint64T sum;
+        SaHpiUint64T buckets[OHPI_METRIC_BUCKETS]; /* Not cumulative */
+};
+
+/*
+ * Counters of one thread. Only the owning thread writes them, so
+ * recording needs neither locks nor atomic operations. Readers add
+ * up all shards and may see a value that is a little stale (or torn
+ * on 32 bit hosts), which is fine for monitoring.
+ * Shards of finished threads are handed to new threads, so totals
+ * never go back and memory is bounded by the number of live threads.
+ */
+struct oh_metrics_shard {
+        struct oh_metrics_shard *next;
+        gint in_use;
+        SaHpiUint64T events_processed;
+        SaHpiUint64T events_dropped;
+        struct oh_histogram discovery;
+        struct oh_histogram abi[OH_METRICS_MAX_HANDLERS];
+        struct oh_histogram rpc[OH_METRICS_MAX_RPC];
+};
+
+/* Only ever prepended to, with compare-and-exchange */
+static struct oh_metrics_shard *shards = NULL;
+
+static const char *rpc_names[OH_METRICS_MAX_RPC];
+static gint connections = 0;
+
+static void release_shard(gpointer data)
+{
+        struct oh_metrics_shard *shard = data;
+
+        g_atomic_int_set(&shard->in_use, 0);
+}
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GPrivate shard_key = G_PRIVATE_INIT(release_shard);
+#else
+static GStaticPrivate shard_key = G_STATIC_PRIVATE_INIT;
+#endif
+
+static struct oh_metrics_shard *get_shard(void)
+{
+        struct oh_metrics_shard *shard = NULL;
+
+        shard = wrap_g_static_private_get(&shard_key);
+        if (shard)
+                return shard;
+
+        for (shard = g_atomic_pointer_get((gpointer *)&shards);
+             shard; shard = shard->next) {
+                if (g_atomic_int_compare_and_exchange(&shard->in_use, 0, 1))
+                        break;
+        }
+        if (!shard) {
+                shard = g_new0(struct oh_metrics_shard, 1);
+                shard->in_use = 1;
+                do {
+                        shard->next = g_atomic_pointer_get((gpointer *)&shards);
+                } while (!g_atomic_pointer_compare_and_exchange((gpointer *)&shards,
+                                                                shard->next,
+                                                                shard));
+        }
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+        wrap_g_static_private_set(&shard_key, shard);
+#else
+        wrap_g_static_private_set(&shard_key, shard, release_shard);
+#endif
+
+        return shard;
+}
+
+static void observe(struct oh_histogram *h, SaHpiUint64T usec)
+{
+        guint i;
+
+        if (usec <= 1) {
+                i = 0;
+        } else if ((usec - 1) >> 32) {
+                i = OHPI_METRIC_BUCKETS;
+        } else {
+                i = g_bit_storage((gulong)(usec - 1));
+        }
+
+        h->count++;
+        h->sum += usec;
+        if (i < OHPI_METRIC_BUCKETS)
+                h->buckets[i]++;
+}
+
+/**
+ * oh_metrics_now
+ *
+ * Returns: monotonic time in microseconds, for measuring durations.
+ **/
+SaHpiUint64T oh_metrics_now(void)
+{
+#if GLIB_CHECK_VERSION (2, 28, 0)
+        return (SaHpiUint64T)g_get_monotonic_time();
+#else
+        GTimeVal tv;
+
+        g_get_current_time(&tv);
+        return (SaHpiUint64T)tv.tv_sec * G_USEC_PER_SEC + tv.tv_usec;
+#endif
+}
+
+void oh_metrics_rpc(unsigned int rpc_id, const char *name, SaHpiUint64T usec)
+{
+        if (rpc_id >= OH_METRICS_MAX_RPC)
+                return;
+        if (name && !rpc_names[rpc_id])
+                rpc_names[rpc_id] = name;
+        observe(&get_shard()->rpc[rpc_id], usec);
+}
+
+void oh_metrics_abi(unsigned int hid, SaHpiUint64T usec)
+{
+        if (hid >= OH_METRICS_MAX_HANDLERS)
+                return;
+        observe(&get_shard()->abi[hid], usec);
+}
+
+void oh_metrics_discovery(SaHpiUint64T usec)
+{
+        observe(&get_shard()->discovery, usec);
+}
+
+void oh_metrics_event_processed(void)
+{
+        get_shard()->events_processed++;
+}
+
+void oh_metrics_event_dropped(void)
+{
+        get_shard()->events_dropped++;
+}
+
+void oh_metrics_connection(gint delta)
+{
+        g_atomic_int_add(&connections, delta);
+}
+
+/*
+ * Metric ids. Ids are stable, so a client can walk them with
+ * oHpiMetricGet() while the daemon keeps recording.
+ */
+enum {
+        METRIC_SESSIONS = 0,
+        METRIC_CONNECTIONS,
+        METRIC_PROCESS_QUEUE,
+        METRIC_SESSION_QUEUE,
+        METRIC_SESSION_QUEUE_MAX,
+        METRIC_EVENTS_PROCESSED,
+        METRIC_EVENTS_DROPPED,
+        METRIC_DISCOVERY,
+        METRIC_RPC_FIRST,
+        METRIC_ABI_FIRST = METRIC_RPC_FIRST + OH_METRICS_MAX_RPC,
+        METRIC_ABI_ACTIVE_FIRST = METRIC_ABI_FIRST + OH_METRICS_MAX_HANDLERS,
+        METRIC_ABI_QUEUED_FIRST = METRIC_ABI_ACTIVE_FIRST + OH_METRICS_MAX_HANDLERS,
+        METRIC_ABI_BUSY_FIRST = METRIC_ABI_QUEUED_FIRST + OH_METRICS_MAX_HANDLERS,
+        METRIC_ABI_TIMEOUT_FIRST = METRIC_ABI_BUSY_FIRST + OH_METRICS_MAX_HANDLERS,
+        METRIC_END = METRIC_ABI_TIMEOUT_FIRST + OH_METRICS_MAX_HANDLERS
+};
+
+/* Admission control metrics exist while the handler does */
+static guint dispatch_hid(guint id)
+{
+        return (id - METRIC_ABI_ACTIVE_FIRST) % OH_METRICS_MAX_HANDLERS;
+}
+
+static struct oh_histogram *shard_histogram(struct oh_metrics_shard *shard,
+                                            guint id)
+{
+        if (id == METRIC_DISCOVERY) {
+                return &shard->discovery;
+        } else if (id >= METRIC_RPC_FIRST && id < METRIC_ABI_FIRST) {
+                return &shard->rpc[id - METRIC_RPC_FIRST];
+        } else if (id >= METRIC_ABI_FIRST && id < METRIC_ABI_ACTIVE_FIRST) {
+                return &shard->abi[id - METRIC_ABI_FIRST];
+        }
+        return NULL;
+}
+
+static SaHpiBoolT metric_present(guint id)
+{
+        struct oh_metrics_shard *shard = NULL;
+        struct oh_histogram *h = NULL;
+
+        if (id < METRIC_DISCOVERY)
+                return SAHPI_TRUE;
+        if (id >= METRIC_ABI_ACTIVE_FIRST) {
+                struct oh_dispatch_stats stats;
+                return oh_dispatch_get_stats(dispatch_hid(id), &stats) == SA_OK ?
+                       SAHPI_TRUE : SAHPI_FALSE;
+        }
+
+        for (shard = g_atomic_pointer_get((gpointer *)&shards);
+             shard; shard = shard->next) {
+                h = shard_histogram(shard, id);
+                if (h && h->count)
+                        return SAHPI_TRUE;
+        }
+        return SAHPI_FALSE;
+}
+
+static void set_text(SaHpiTextBufferT *buffer, const char *text)
+{
+        oh_init_textbuffer(buffer);
+        oh_append_textbuffer(buffer, text);
+}
+
+static void fill_metric(guint id, oHpiMetricT *metric)
+{
+        struct oh_metrics_shard *shard = NULL;
+        struct oh_histogram *h = NULL;
+        struct oh_dispatch_stats stats;
+        guint sessions = 0, queued = 0, max_queued = 0;
+        char labels[SAHPI_MAX_TEXT_BUFFER_LENGTH];
+        guint i;
+
+        memset(metric, 0, sizeof(*metric));
+        labels[0] = '\0';
+
+        switch (id) {
+        case METRIC_SESSIONS:
+        case METRIC_SESSION_QUEUE:
+        case METRIC_SESSION_QUEUE_MAX:
+                oh_get_sessions_stats(&sessions, &queued, &max_queued);
+                metric->Type = OHPI_METRIC_GAUGE;
+                if (id == METRIC_SESSIONS) {
+                        set_text(&metric->Name, "openhpid_sessions");
+                        metric->Value = sessions;
+                } else if (id == METRIC_SESSION_QUEUE) {
+                        set_text(&metric->Name, "openhpid_session_events_queued");
+                        metric->Value = queued;
+                } else {
+                        set_text(&metric->Name, "openhpid_session_events_queued_max");
+                        metric->Value = max_queued;
+                }
+                break;
+        case METRIC_CONNECTIONS:
+                metric->Type = OHPI_METRIC_GAUGE;
+                set_text(&metric->Name, "openhpid_connections");
+                metric->Value = g_atomic_int_get(&connections);
+                break;
+        case METRIC_PROCESS_QUEUE:
+                metric->Type = OHPI_METRIC_GAUGE;
+                set_text(&metric->Name, "openhpid_event_process_queue_length");
+                metric->Value = oh_event_queue_length();
+                break;
+        case METRIC_EVENTS_PROCESSED:
+        case METRIC_EVENTS_DROPPED:
+                metric->Type = OHPI_METRIC_COUNTER;
+                set_text(&metric->Name, id == METRIC_EVENTS_PROCESSED ?
+                                        "openhpid_events_processed_total" :
+                                        "openhpid_events_dropped_total");
+                for (shard = g_atomic_pointer_get((gpointer *)&shards);
+                     shard; shard = shard->next) {
+                        metric->Value += id == METRIC_EVENTS_PROCESSED ?
+                                         shard->events_processed :
+                                         shard->events_dropped;
+                }
+                break;
+        default:
+                if (id >= METRIC_ABI_ACTIVE_FIRST) {
+                        memset(&stats, 0, sizeof(stats));
+                        oh_dispatch_get_stats(dispatch_hid(id), &stats);
+                        if (id < METRIC_ABI_QUEUED_FIRST) {
+                                metric->Type = OHPI_METRIC_GAUGE;
+                                set_text(&metric->Name, "openhpid_abi_active");
+                                metric->Value = stats.active;
+                        } else if (id < METRIC_ABI_BUSY_FIRST) {
+                                metric->Type = OHPI_METRIC_GAUGE;
+                                set_text(&metric->Name, "openhpid_abi_queued");
+                                metric->Value = stats.queued;
+                        } else {
+                                metric->Type = OHPI_METRIC_COUNTER;
+                                set_text(&metric->Name, "openhpid_abi_rejected_total");
+                                metric->Value = id < METRIC_ABI_TIMEOUT_FIRST ?
+                                                stats.busy : stats.timeouts;
+                        }
+                        if (id < METRIC_ABI_BUSY_FIRST) {
+                                snprintf(labels, sizeof(labels), "handler=\"%u\"",
+                                         dispatch_hid(id));
+                        } else {
+                                snprintf(labels, sizeof(labels),
+                                         "handler=\"%u\",reason=\"%s\"",
+                                         dispatch_hid(id),
+                                         id < METRIC_ABI_TIMEOUT_FIRST ?
+                                         "busy" : "timeout");
+                        }
+                        break;
+                }
+                metric->Type = OHPI_METRIC_HISTOGRAM;
+                if (id == METRIC_DISCOVERY) {
+                        set_text(&metric->Name,
+                                 "openhpid_discovery_duration_microseconds");
+                } else if (id < METRIC_ABI_FIRST) {
+                        const char *name = rpc_names[id - METRIC_RPC_FIRST];
+                        set_text(&metric->Name,
+                                 "openhpid_rpc_duration_microseconds");
+                        if (name) {
+                                snprintf(labels, sizeof(labels),
+                                         "rpc=\"%s\"", name);
+                        } else {
+                                snprintf(labels, sizeof(labels),
+                                         "rpc=\"%u\"", id - METRIC_RPC_FIRST);
+                        }
+                } else {
+                        set_text(&metric->Name,
+                                 "openhpid_abi_duration_microseconds");
+                        snprintf(labels, sizeof(labels),
+                                 "handler=\"%u\"", id - METRIC_ABI_FIRST);
+                }
+                for (shard = g_atomic_pointer_get((gpointer *)&shards);
+                     shard; shard = shard->next) {
+                        h = shard_histogram(shard, id);
+                        metric->Value += h->count;
+                        metric->Sum += h->sum;
+                        for (i = 0; i < OHPI_METRIC_BUCKETS; i++)
+                                metric->Buckets[i] += h->buckets[i];
+                }
+                for (i = 1; i < OHPI_METRIC_BUCKETS; i++)
+                        metric->Buckets[i] += metric->Buckets[i - 1];
+                break;
+        }
+
+        set_text(&metric->Labels, labels);
+}
+
+/**
+ * oh_metrics_get
+ * @id: metric id or SAHPI_FIRST_ENTRY
+ * @next_id: id of the next metric, SAHPI_LAST_ENTRY after the last one
+ * @metric: the metric with id @id, or the next one if @id has no samples
+ *
+ * Returns: SA_OK, or SA_ERR_HPI_NOT_PRESENT if there are no more metrics.
+ **/
+SaErrorT oh_metrics_get(SaHpiEntryIdT id,
+                        SaHpiEntryIdT *next_id,
+                        oHpiMetricT *metric)
+{
+        guint i;
+
+        if (!next_id || !metric || id == SAHPI_LAST_ENTRY)
+                return SA_ERR_HPI_INVALID_PARAMS;
+
+        for (i = id; i < METRIC_END && !metric_present(i); i++)
+                ;
+        if (i >= METRIC_END)
+                return SA_ERR_HPI_NOT_PRESENT;
+
+        fill_metric(i, metric);
+
+        for (id = i + 1; id < METRIC_END && !metric_present(id); id++)
+                ;
+        *next_id = (id < METRIC_END) ? id : SAHPI_LAST_ENTRY;
+
+        return SA_OK;
+}
+
+static void append_sample(GString *text, const oHpiMetricT *m,
+                          const char *suffix, const char *le,
+                          SaHpiUint64T value)
+{
+        int labels = m->Labels.DataLength > 0;
+
+        g_string_append_printf(text, "%.*s%s", m->Name.DataLength,
+                               (const char *)m->Name.Data, suffix);
+        if (labels || le) {
+                g_string_append_printf(text, "{%.*s%s",
+                                       m->Labels.DataLength,
+                                       (const char *)m->Labels.Data,
+                                       (labels && le) ? "," : "");
+                if (le)
+                        g_string_append_printf(text, "le=\"%s\"", le);
+                g_string_append_c(text, '}');
+        }
+        g_string_append_printf(text, " %llu\n", (unsigned long long)value);
+}
+
+/**
+ * oh_metrics_text
+ *
+ * Returns: all metrics in the Prometheus text exposition format.
+ * The caller frees the string with g_free().
+ **/
+gchar *oh_metrics_text(void)
+{
+        static const char *types[] = { "untyped", "counter", "gauge", "histogram" };
+        GString *text = g_string_new(NULL);
+        SaHpiTextBufferT family;
+        SaHpiEntryIdT id = SAHPI_FIRST_ENTRY, next_id;
+        oHpiMetricT m;
+        char le[32];
+        guint i;
+
+        oh_init_textbuffer(&family);
+
+        while (id != SAHPI_LAST_ENTRY &&
+               oh_metrics_get(id, &next_id, &m) == SA_OK) {
+                if (family.DataLength != m.Name.DataLength ||
+                    memcmp(family.Data, m.Name.Data, m.Name.DataLength)) {
+                        family = m.Name;
+                        g_string_append_printf(text, "# TYPE %.*s %s\n",
+                                               m.Name.DataLength,
+                                               (const char *)m.Name.Data,
+                                               types[m.Type <= OHPI_METRIC_HISTOGRAM ?
+                                                     m.Type : 0]);
+                }
+                if (m.Type != OHPI_METRIC_HISTOGRAM) {
+                        append_sample(text, &m, "", NULL, m.Value);
+                } else {
+                        for (i = 0; i < OHPI_METRIC_BUCKETS; i++) {
+                                snprintf(le, sizeof(le), "%lu", 1UL << i);
+                                append_sample(text, &m, "_bucket", le,
+                                              m.Buckets[i]);
+                        }
+                        append_sample(text, &m, "_bucket", "+Inf", m.Value);
+                        append_sample(text, &m, "_sum", NULL, m.Sum);
+                        append_sample(text, &m, "_count", NULL, m.Value);
+                }
+                id = next_id;
+        }
+
+        return g_string_free(text, FALSE);
+}
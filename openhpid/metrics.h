@@ -0,0 +1,48 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __OH_METRICS_H
+#define __OH_METRICS_H
+
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* RPC ids and handler ids beyond these are not tracked */
+#define OH_METRICS_MAX_RPC      256
+#define OH_METRICS_MAX_HANDLERS 64
+
+/*
+ * Recording functions are cheap and lock free: every thread
+ * writes to its own set of counters, readers add them up.
+ */
+SaHpiUint64T oh_metrics_now(void);
+void oh_metrics_rpc(unsigned int rpc_id, const char *name, SaHpiUint64T usec);
+void oh_metrics_abi(unsigned int hid, SaHpiUint64T usec);
+void oh_metrics_discovery(SaHpiUint64T usec);
+void oh_metrics_event_processed(void);
+void oh_metrics_event_dropped(void);
+void oh_metrics_connection(gint delta);
+
+SaErrorT oh_metrics_get(SaHpiEntryIdT id,
+                        SaHpiEntryIdT *next_id,
+                        oHpiMetricT *metric);
+gchar *oh_metrics_text(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OH_METRICS_H */
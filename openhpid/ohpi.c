@@ -34,6 +34,9 @@
 #include "event.h"
 #include "init.h"
 #include "lock.h"
+#include "history.h"
+#include "metrics.h"
+#include "watch.h"
 
 
 /**
@@ -101,6 +104,11 @@ SaErrorT SAHPI_API oHpiHandlerDestroy (
                 
         OH_CHECK_INIT_STATE(sid);
         OH_GET_DID(sid, did);
+
+        /* Not waiting for the open with the domain locked */
+        if (oh_handler_is_opening(id))
+                return SA_ERR_HPI_BUSY;
+
         OH_GET_DOMAIN(did, d); /* Lock domain */
                 
         if (oh_init()) error = SA_ERR_HPI_INTERNAL_ERROR;
@@ -110,40 +118,7 @@ SaErrorT SAHPI_API oHpiHandlerDestroy (
 
         if (error == SA_OK) {
             // Remove all handler remaing resources from the Domain RPT
-            SaHpiRptEntryT *rpte;
-            SaHpiResourceIdT rid;
-            GSList *events = 0;
-
-            rid = SAHPI_FIRST_ENTRY;
-            while ((rpte = oh_get_resource_next(&(d->rpt), rid)) != 0) {
-                const void * data;
-                data = oh_get_resource_data(&(d->rpt), rpte->ResourceId);
-                if (data) {
-                    const unsigned int hid = *(const unsigned int*)(data);
-                    if (hid == id) {
-                        struct oh_event * e = g_new0(struct oh_event, 1);
-                        e->hid = id;
-                        e->resource = *rpte;
-                        e->rdrs = 0;
-                        e->rdrs_to_remove = 0;
-                        e->event.Source = rpte->ResourceId;
-                        e->event.EventType = SAHPI_ET_RESOURCE;
-                        oh_gettimeofday(&e->event.Timestamp);
-                        e->event.Severity = SAHPI_MAJOR;
-                        e->event.EventDataUnion.ResourceEvent.ResourceEventType
-                            = SAHPI_RESE_RESOURCE_REMOVED;
-                        events = g_slist_prepend(events, e);
-                    }
-                }
-                rid = rpte->ResourceId;
-            }
-
-            GSList *iter = events;
-            while (iter) {
-                oh_evt_queue_push(oh_process_q, iter->data);
-                iter = g_slist_next(iter);
-            }
-            g_slist_free(events);
+            oh_remove_handler_resources(d, id);
         }
    
         oh_release_domain(d); /* Unlock domain */
@@ -274,6 +249,11 @@ SaErrorT SAHPI_API oHpiHandlerRetry (
 
         OH_CHECK_INIT_STATE(sid);
         OH_GET_DID(sid, did);
+
+        /* Not waiting for the open with the domain locked */
+        if (oh_handler_is_opening(id))
+                return SA_ERR_HPI_BUSY;
+
         OH_GET_DOMAIN(did, d); /* Lock domain */
 
         if (oh_init()) {
@@ -287,6 +267,13 @@ SaErrorT SAHPI_API oHpiHandlerRetry (
                 return SA_ERR_HPI_NOT_PRESENT;
         }
 
+	if (h->opening) {
+                // opening thread did not get to it yet
+ 		oh_release_handler(h);
+                oh_release_domain(d); /* Unlock domain */
+		return SA_ERR_HPI_BUSY;
+	}
+
 	if (h->hnd != NULL) {
                 // handler already running
  		oh_release_handler(h);
@@ -385,6 +372,20 @@ SaErrorT SAHPI_API oHpiGlobalParamSet (
         return SA_OK;
 }
 
+/**
+ * oHpiConfigReload
+ **/
+SaErrorT SAHPI_API oHpiConfigReload (
+     SAHPI_IN    SaHpiSessionIdT sid )
+{
+        if (sid == 0)
+                return SA_ERR_HPI_INVALID_SESSION;
+
+        OH_CHECK_INIT_STATE(sid);
+
+        return oh_reload_config();
+}
+
 /**
  * oHpiInjectEvent
  **/
@@ -445,6 +446,98 @@ SaErrorT SAHPI_API oHpiInjectEvent (
         return error;
 }
 
+/**
+ * oHpiMetricGet
+ **/
+SaErrorT SAHPI_API oHpiMetricGet (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiEntryIdT id,
+     SAHPI_OUT   SaHpiEntryIdT *next_id,
+     SAHPI_OUT   oHpiMetricT *metric )
+{
+        SaHpiDomainIdT did;
+
+        if (sid == 0)
+                return SA_ERR_HPI_INVALID_SESSION;
+        if (!next_id || !metric)
+                return SA_ERR_HPI_INVALID_PARAMS;
+
+        OH_CHECK_INIT_STATE(sid);
+        OH_GET_DID(sid, did);
+
+        /* Metrics are daemon wide, no domain lock needed */
+        return oh_metrics_get(id, next_id, metric);
+}
+
+/**
+ * oHpiSensorHistoryGet
+ **/
+SaErrorT SAHPI_API oHpiSensorHistoryGet (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num,
+     SAHPI_IN    SaHpiTimeT start,
+     SAHPI_IN    SaHpiTimeT end,
+     SAHPI_INOUT SaHpiUint32T *num_samples,
+     SAHPI_OUT   oHpiSensorSampleT *samples )
+{
+        SaHpiDomainIdT did;
+
+        if (sid == 0)
+                return SA_ERR_HPI_INVALID_SESSION;
+        if (!num_samples || !samples || *num_samples == 0)
+                return SA_ERR_HPI_INVALID_PARAMS;
+        if (end != SAHPI_TIME_UNSPECIFIED && end < start)
+                return SA_ERR_HPI_INVALID_PARAMS;
+
+        OH_CHECK_INIT_STATE(sid);
+        OH_GET_DID(sid, did);
+
+        /* The history has its own lock, no domain lock needed */
+        return oh_history_get(did, rid, num, start, end,
+                              num_samples, samples);
+}
+
+/**
+ * oHpiSensorWatchAdd
+ **/
+SaErrorT SAHPI_API oHpiSensorWatchAdd (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num,
+     SAHPI_IN    SaHpiUint32T interval,
+     SAHPI_IN    SaHpiFloat64T hysteresis )
+{
+        SaHpiDomainIdT did;
+
+        if (sid == 0)
+                return SA_ERR_HPI_INVALID_SESSION;
+
+        OH_CHECK_INIT_STATE(sid);
+        OH_GET_DID(sid, did);
+
+        return oh_watch_add(did, sid, rid, num, interval, hysteresis);
+}
+
+/**
+ * oHpiSensorWatchRemove
+ **/
+SaErrorT SAHPI_API oHpiSensorWatchRemove (
+     SAHPI_IN    SaHpiSessionIdT sid,
+     SAHPI_IN    SaHpiResourceIdT rid,
+     SAHPI_IN    SaHpiSensorNumT num )
+{
+        SaHpiDomainIdT did;
+
+        if (sid == 0)
+                return SA_ERR_HPI_INVALID_SESSION;
+
+        OH_CHECK_INIT_STATE(sid);
+        OH_GET_DID(sid, did);
+
+        return oh_watch_remove(did, sid, rid, num);
+}
+
 /**
  * oHpiDomainAdd
  * Currently only available in client library, but not in daemon
@@ -39,6 +39,7 @@
 #include <oh_error.h>
 #include <strmsock.h>
 
+#include "conf.h"
 #include "event.h"
 #include "init.h"
 #include "server.h"
@@ -54,6 +55,7 @@ static gboolean verbose_flag    = FALSE;
 static gchar    *bindaddr       = NULL;
 static gint     port            = OPENHPI_DEFAULT_DAEMON_PORT;
 static gchar    *portstr        = NULL;
+static gchar    *sockpath       = NULL;
 static gchar    *optpidfile     = NULL;
 static gint     sock_timeout    = 0;  // unlimited -- TODO: unlimited or 30 minutes default? was unsigned int
 static gint     max_threads     = -1; // unlimited
@@ -81,6 +83,10 @@ static GOptionEntry daemon_options[] =
                                     "                            No bind address is used by default.",              "bind_address" },
   { "port",      'p', 0, G_OPTION_ARG_STRING,   &portstr,       "Overrides the default listening port (4743) of\n"
                                     "                            the daemon. The option is optional.",              "port" },
+  { "socket",    'u', 0, G_OPTION_ARG_FILENAME, &sockpath,      "Unix domain socket for local clients.\n"
+                                    "                            Also socket path can be specified with\n"
+                                    "                            OPENHPI_DAEMON_SOCKET environment variable.\n"
+                                    "                            No local socket is used by default.",               "socket_path" },
 
   { "pidfile",   'f', 0, G_OPTION_ARG_FILENAME, &optpidfile,    "Overrides the default path/name for the daemon.\n"
                                     "                            pid file. The option is optional.",                "pidfile" },
@@ -132,6 +138,10 @@ void display_help(void)
     printf("                            No bind address is used by default.\n");
     printf("  -p, --port=port           Overrides the default listening port (4743) of\n");
     printf("                            the daemon. The option is optional.\n");
+    printf("  -u, --socket=socket_path  Unix domain socket for local clients.\n");
+    printf("                            Also socket path can be specified with\n");
+    printf("                            OPENHPI_DAEMON_SOCKET environment variable.\n");
+    printf("                            No local socket is used by default.\n");
     printf("  -f, --pidfile=pidfile     Overrides the default path/name for the daemon.\n");
     printf("                            pid file. The option is optional.\n");
     printf("  -s, --timeout=seconds     Overrides the default socket read timeout of 30\n");
@@ -325,6 +335,12 @@ static void sig_handler( int signum )
     oh_signal_service();
 }
 
+static void sighup_handler( int signum )
+{
+    // Handles SIGHUP
+    oh_request_config_reload();
+}
+
 
 /*--------------------------------------------------------------------*/
 /* Function: main                                                     */
@@ -369,6 +385,11 @@ int main(int argc, char *argv[])
     if (portstr) {
         port = atoi(portstr);
     }
+    if (sockpath) {
+        setenv("OPENHPI_DAEMON_SOCKET", sockpath, 1);
+    } else {
+        sockpath = getenv("OPENHPI_DAEMON_SOCKET");
+    }
 
 #ifdef HAVE_ENCRYPT
     if (g_decrypt) {
@@ -416,6 +437,10 @@ int main(int argc, char *argv[])
         CRIT("Cannot set SIGINT handler. Exiting.");
         exit(1);
     }
+    if (signal(SIGHUP, sighup_handler) == SIG_ERR) {
+        CRIT("Cannot set SIGHUP handler. Exiting.");
+        exit(1);
+    }
 
     if (!runasforeground) {
         if (!daemonize(pidfile)) {
@@ -432,6 +457,9 @@ int main(int argc, char *argv[])
         INFO("OPENHPI_DAEMON_BIND_ADDRESS = %s.", bindaddr);
     }
     INFO("OPENHPI_DAEMON_PORT = %u.", port);
+    if (sockpath) {
+        INFO("OPENHPI_DAEMON_SOCKET = %s.", sockpath);
+    }
     INFO("Enabled IP versions:%s%s.",
          (ipvflags & FlagIPv4) ? " IPv4" : "",
          (ipvflags & FlagIPv6) ? " IPv6" : "");
@@ -443,7 +471,16 @@ int main(int argc, char *argv[])
         return 8;
     }
 
-    bool rc = oh_server_run(ipvflags, bindaddr, port, sock_timeout, max_threads);
+    // Metrics are only served on the loopback interface
+    struct oh_global_param metrics_port;
+    metrics_port.type = OPENHPI_METRICS_PORT;
+    if ((oh_get_global_param(&metrics_port) == 0) &&
+        (metrics_port.u.metrics_port != 0)) {
+        INFO("OPENHPI_METRICS_PORT = %u.", metrics_port.u.metrics_port);
+        oh_metrics_server_start("localhost", metrics_port.u.metrics_port);
+    }
+
+    bool rc = oh_server_run(ipvflags, bindaddr, port, sockpath, sock_timeout, max_threads);
     if (!rc) {
         return 9;
     }
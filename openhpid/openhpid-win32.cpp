@@ -26,6 +26,7 @@
 #include <oh_error.h>
 #include <strmsock.h>
 
+#include "conf.h"
 #include "init.h"
 #include "server.h"
 
@@ -240,7 +241,16 @@ int main(int argc, char *argv[])
         return 8;
     }
 
-    bool rc = oh_server_run(ipvflags, bindaddr, port, sock_timeout, max_threads);
+    // Metrics are only served on the loopback interface
+    struct oh_global_param metrics_port;
+    metrics_port.type = OPENHPI_METRICS_PORT;
+    if ((oh_get_global_param(&metrics_port) == 0) &&
+        (metrics_port.u.metrics_port != 0)) {
+        INFO("OPENHPI_METRICS_PORT = %u.", metrics_port.u.metrics_port);
+        oh_metrics_server_start("localhost", metrics_port.u.metrics_port);
+    }
+
+    bool rc = oh_server_run(ipvflags, bindaddr, port, 0, sock_timeout, max_threads);
     if (!rc) {
         return 9;
     }
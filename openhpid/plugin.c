@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
@@ -35,6 +36,8 @@
 #include "conf.h"
 #include "event.h"
 #include "lock.h"
+#include "dispatch.h"
+#include "metrics.h"
 #include "sahpi_wrappers.h"
 
 extern volatile int signal_stop;
@@ -58,6 +61,18 @@ struct oh_handlers oh_handlers = {
 #endif
 };
 
+/*
+ * Handlers opened in the background, see oh_create_handler_async().
+ */
+static GThreadPool *open_pool = NULL;
+static GMutex *open_lock = NULL;
+static GCond *open_cond = NULL;
+static guint open_pending = 0;
+/* Open threads inside abi->open, these are not waited for at shutdown */
+static guint open_calls = 0;
+/* Set at shutdown, a late open is closed again right away */
+static int open_stopping = 0;
+
 /**
  * oh_close_handlers
  *
@@ -385,22 +400,20 @@ static void __delete_handler(struct oh_handler *h)
 
         /* Free the oh_handler members first, then the handler. */
         g_hash_table_destroy(h->config);
+        oh_dispatch_destroy(h->dispatch);
 
         wrap_g_static_rec_mutex_free_clear(&h->lock);
         wrap_g_static_rec_mutex_free_clear(&h->refcount_lock);
         g_free(h);
 }
 
-/**
- * oh_get_handler
- * @hid: id of handler being requested
- *
- * Returns: NULL if handler was not found.
- **/
-struct oh_handler *oh_get_handler(unsigned int hid)
+static struct oh_handler *__get_handler(unsigned int hid,
+                                        oh_dispatch_mode mode,
+                                        SaErrorT *error)
 {
         GSList *node = NULL;
         struct oh_handler *handler = NULL;
+        SaErrorT rv;
 
         wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
         node = g_hash_table_lookup(oh_handlers.table, &hid);
@@ -412,11 +425,80 @@ struct oh_handler *oh_get_handler(unsigned int hid)
         }
         __inc_handler_refcount(handler);
         wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
-        wrap_g_static_rec_mutex_lock(&handler->lock);
+
+        /* Do not queue up behind an open that may take minutes */
+        if (mode != OH_DISPATCH_WAIT && handler->opening) {
+                __dec_handler_refcount(handler);
+                if (handler->refcount < 0)
+                        __delete_handler(handler);
+                if (error) *error = SA_ERR_HPI_BUSY;
+                return NULL;
+        }
+
+        /* Wait for a slot, then for the handler lock */
+        rv = oh_dispatch_enter(handler->dispatch, &handler->lock, mode);
+        if (rv != SA_OK) {
+                __dec_handler_refcount(handler);
+                if (handler->refcount < 0)
+                        __delete_handler(handler);
+                if (error) *error = rv;
+                return NULL;
+        }
 
         return handler;
 }
 
+/**
+ * oh_get_handler
+ * @hid: id of handler being requested
+ *
+ * Waits as long as it takes for the handler to be free.
+ *
+ * Returns: NULL if handler was not found.
+ **/
+struct oh_handler *oh_get_handler(unsigned int hid)
+{
+        return __get_handler(hid, OH_DISPATCH_WAIT, NULL);
+}
+
+/**
+ * oh_get_handler_timed
+ * @hid: id of handler being requested
+ * @error: set to SA_ERR_HPI_BUSY or SA_ERR_HPI_TIMEOUT if the handler
+ * did not admit the call, left SA_OK otherwise.
+ *
+ * Like oh_get_handler(), but applies the queue depth and timeout
+ * configured for the handler and does not wait for a handler that is
+ * still opening (SA_ERR_HPI_BUSY). Used for HPI API calls.
+ *
+ * Returns: NULL if handler was not found or did not admit the call.
+ **/
+struct oh_handler *oh_get_handler_timed(unsigned int hid, SaErrorT *error)
+{
+        if (error) *error = SA_OK;
+
+        return __get_handler(hid, OH_DISPATCH_BOUNDED, error);
+}
+
+/**
+ * oh_get_handler_try
+ * @hid: id of handler being requested
+ * @error: set to SA_ERR_HPI_BUSY if the handler is in use, left SA_OK
+ * otherwise.
+ *
+ * Like oh_get_handler_timed(), but never waits, whatever the queue is
+ * configured to. Used for background sampling, which must not compete
+ * with HPI API calls for a slow handler.
+ *
+ * Returns: NULL if handler was not found or is in use.
+ **/
+struct oh_handler *oh_get_handler_try(unsigned int hid, SaErrorT *error)
+{
+        if (error) *error = SA_OK;
+
+        return __get_handler(hid, OH_DISPATCH_TRY, error);
+}
+
 /**
  * oh_release_handler
  * @handler: a handler, previously obtained (i.e. locked) with
@@ -431,6 +513,7 @@ void oh_release_handler(struct oh_handler *handler)
                 return;
         }
 
+        oh_dispatch_leave(handler->dispatch);
         __dec_handler_refcount(handler);
         if (handler->refcount < 0)
                 __delete_handler(handler);
@@ -543,6 +626,7 @@ static struct oh_handler *new_handler(GHashTable *handler_config)
         handler->refcount = 0;
         wrap_g_static_rec_mutex_init(&handler->lock);
         wrap_g_static_rec_mutex_init(&handler->refcount_lock);
+        handler->dispatch = oh_dispatch_create(handler->id, handler->config);
 
         return handler;
 cleanexit:
@@ -550,6 +634,146 @@ cleanexit:
         return NULL;
 }
 
+// TODO reimplement to get timeout value from domain
+static void set_autoinsert_timeout(struct oh_handler *handler)
+{
+        // set auto-extract timeout
+        if (handler->abi->set_autoinsert_timeout) {
+                struct oh_global_param param;
+                SaErrorT rv;
+                oh_get_global_param2(OPENHPI_AUTOINSERT_TIMEOUT, &param);
+                SaHpiTimeoutT ai_timeout = param.u.ai_timeout;
+                oh_get_global_param2(OPENHPI_AUTOINSERT_TIMEOUT_READONLY, &param);
+                DBG("auto-insert timeout readonly=%d, auto-insert timeout to set=%" PRId64,
+                       param.u.ai_timeout_readonly, (int64_t)ai_timeout);
+                if (!param.u.ai_timeout_readonly && ai_timeout) {
+                        rv = handler->abi->set_autoinsert_timeout(handler->hnd, ai_timeout);
+                        if (rv != SA_OK) {
+                                CRIT("Cannot propagate auto-insert timeout to handler.");
+                        }
+                 }
+        }
+}
+
+/* Handler config values are strings, see copy_hashed_new_config() */
+static guint get_open_timeout(GHashTable *config)
+{
+        struct oh_global_param param;
+        const char *value;
+        char *end = NULL;
+        unsigned long n;
+
+        value = (const char *)g_hash_table_lookup(config, "open_timeout");
+        if (value) {
+                n = strtoul(value, &end, 10);
+                if (end != value && *end == '\0')
+                        return (guint)n;
+                CRIT("Invalid value %s for handler parameter open_timeout.",
+                     value);
+        }
+
+        oh_get_global_param2(OPENHPI_OPEN_TIMEOUT, &param);
+
+        return param.u.open_timeout;
+}
+
+static int open_timed_out(const struct oh_handler *h)
+{
+        return h->open_deadline && oh_metrics_now() > h->open_deadline;
+}
+
+/* Runs in open_pool, holds a reference to the handler */
+static void open_handler_func(gpointer data, gpointer user_data)
+{
+        struct oh_handler *h = (struct oh_handler *)data;
+        unsigned int hid = h->id;
+        GSList *node;
+        void *hnd = NULL;
+        void *late = NULL;
+        SaHpiUint64T start;
+        int registered;
+        int stopping;
+
+        wrap_g_static_rec_mutex_lock(&h->lock);
+
+        /* Not if the handler was destroyed while waiting in the pool */
+        wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
+        node = g_hash_table_lookup(oh_handlers.table, &h->id);
+        registered = node && node->data == h;
+        wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
+
+        if (registered) {
+                wrap_g_mutex_lock(open_lock);
+                open_calls++;
+                g_cond_broadcast(open_cond);
+                wrap_g_mutex_unlock(open_lock);
+
+                start = oh_metrics_now();
+                hnd = h->abi->open(h->config, h->id, oh_process_q);
+
+                wrap_g_mutex_lock(open_lock);
+                open_calls--;
+                wrap_g_mutex_unlock(open_lock);
+
+                if (!hnd) {
+                        CRIT("A handler #%d on the %s plugin could not be opened.",
+                             h->id, h->plugin_name);
+                } else if (open_timed_out(h)) {
+                        CRIT("A handler #%d on the %s plugin opened after its "
+                             "open_timeout, closing it.", h->id, h->plugin_name);
+                        if (h->abi->close)
+                                h->abi->close(hnd);
+                        hnd = NULL;
+                } else {
+                        INFO("Handler #%d on the %s plugin opened in %" PRIu64
+                             " msec.", h->id, h->plugin_name,
+                             (uint64_t)((oh_metrics_now() - start) / 1000));
+                }
+        }
+
+        /* The daemon did not wait for this open to shut down */
+        wrap_g_mutex_lock(open_lock);
+        stopping = open_stopping;
+        if (stopping && hnd) {
+                late = hnd;
+                hnd = NULL;
+        }
+        h->hnd = hnd;
+        wrap_g_mutex_unlock(open_lock);
+        if (late) {
+                CRIT("A handler #%d on the %s plugin opened during shutdown, "
+                     "closing it.", h->id, h->plugin_name);
+                if (h->abi->close)
+                        h->abi->close(late);
+        }
+
+        if (hnd) {
+                set_autoinsert_timeout(h);
+                /* No need to wait for the next round of the discovery thread */
+                if (h->abi->discover_resources) {
+                        start = oh_metrics_now();
+                        h->abi->discover_resources(h->hnd);
+                        oh_metrics_abi(h->id, oh_metrics_now() - start);
+                }
+        }
+        h->opening = 0;
+
+        __dec_handler_refcount(h);
+        if (h->refcount < 0)
+                __delete_handler(h);
+        else
+                wrap_g_static_rec_mutex_unlock(&h->lock);
+
+        /* Restored resources the discovery did not bring back are gone */
+        if (!stopping)
+                oh_post_ready_event(hid);
+
+        wrap_g_mutex_lock(open_lock);
+        open_pending--;
+        g_cond_broadcast(open_cond);
+        wrap_g_mutex_unlock(open_lock);
+}
+
 /**
  * oh_create_handler
  * @handler_config: Hash table containing the configuration for a handler
@@ -591,34 +815,202 @@ SaErrorT oh_create_handler (GHashTable *handler_config, unsigned int *hid)
 		return SA_ERR_HPI_INTERNAL_ERROR;
         }
 
-        // TODO reimplement to get timeout value from domain
-        // set auto-extract timeout
-        if (handler->abi->set_autoinsert_timeout) {
-                struct oh_global_param param;
-                SaErrorT rv;
-                oh_get_global_param2(OPENHPI_AUTOINSERT_TIMEOUT, &param);
-                SaHpiTimeoutT ai_timeout = param.u.ai_timeout;
-                oh_get_global_param2(OPENHPI_AUTOINSERT_TIMEOUT_READONLY, &param);
-                DBG("auto-insert timeout readonly=%d, auto-insert timeout to set=%" PRId64,
-                       param.u.ai_timeout_readonly, (int64_t)ai_timeout);
-                if (!param.u.ai_timeout_readonly && ai_timeout) {
-                        rv = handler->abi->set_autoinsert_timeout(handler->hnd, ai_timeout);
-                        if (rv != SA_OK) {
-                                CRIT("Cannot propagate auto-insert timeout to handler.");
-                        }
-                 }
+        set_autoinsert_timeout(handler);
+
+        wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
+
+        return SA_OK;
+}
+
+/**
+ * oh_create_handler_async
+ * @handler_config: Hash table containing the configuration for a handler
+ * read from the configuration file.
+ * @hid: pointer where hid of newly created handler will be stored.
+ *
+ * Like oh_create_handler(), but abi->open and a first discovery run in a
+ * thread of their own, so slow handlers (e.g. logging in to a remote
+ * management module) neither hold up each other nor the daemon. Until
+ * the open returned the handler holds its lock, is skipped by the
+ * discovery and event threads and oh_get_handler_info() reports it as
+ * OHPI_HANDLER_OPENING. After "open_timeout" msec from the handler
+ * stanza (default OPENHPI_OPEN_TIMEOUT) it is reported as failed and a
+ * late open is closed again.
+ *
+ * Called from oh_process_config(), at startup from oh_init() and on a
+ * reload from oh_process_config_changes(). Both hold the data access
+ * lock, which also serializes the setup of the open pool below.
+ *
+ * Returns: SA_OK if the handler was created and its open was queued.
+ **/
+SaErrorT oh_create_handler_async(GHashTable *handler_config, unsigned int *hid)
+{
+        struct oh_handler *handler = NULL;
+        guint timeout;
+
+        if (!handler_config || !hid) {
+                CRIT("ERROR creating handler. Invalid parameters.");
+                return SA_ERR_HPI_INVALID_PARAMS;
+        }
+
+        *hid = 0;
+
+        if (!open_pool) {
+                open_lock = wrap_g_mutex_new_init();
+                open_cond = wrap_g_cond_new_init();
+                /* One thread per handler, all of them open at once */
+                open_pool = g_thread_pool_new(open_handler_func, NULL,
+                                              -1, FALSE, NULL);
         }
 
+        handler = new_handler(handler_config);
+        if (!handler) return SA_ERR_HPI_ERROR;
+
+        *hid = handler->id;
+        timeout = get_open_timeout(handler->config);
+        if (timeout)
+                handler->open_deadline = oh_metrics_now() +
+                                         (SaHpiUint64T)timeout * 1000;
+        handler->opening = 1;
+        /* Reference of the opening thread */
+        __inc_handler_refcount(handler);
+
+        wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
+        oh_handlers.list = g_slist_append(oh_handlers.list, handler);
+        g_hash_table_insert(oh_handlers.table,
+                            &(handler->id),
+                            g_slist_last(oh_handlers.list));
         wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
 
+        wrap_g_mutex_lock(open_lock);
+        open_pending++;
+        wrap_g_mutex_unlock(open_lock);
+        g_thread_pool_push(open_pool, handler, NULL);
+
         return SA_OK;
 }
 
+/**
+ * oh_wait_for_handlers
+ * @timeout: max wait in msec, 0 is forever
+ *
+ * Waits until the handlers created with oh_create_handler_async() are
+ * done opening.
+ *
+ * Returns: number of handlers still opening.
+ **/
+guint oh_wait_for_handlers(guint timeout)
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+        gint64 gfinaltime = 0;
+#else
+        GTimeVal gfinaltime;
+#endif
+        guint pending;
+
+        if (!open_pool) return 0;
+
+        if (timeout) {
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                gfinaltime = g_get_monotonic_time() + (gint64)timeout * 1000;
+#else
+                g_get_current_time(&gfinaltime);
+                g_time_val_add(&gfinaltime, (glong)timeout * 1000);
+#endif
+        }
+
+        wrap_g_mutex_lock(open_lock);
+        while (open_pending) {
+                if (!timeout) {
+                        g_cond_wait(open_cond, open_lock);
+                } else if (!wrap_g_cond_timed_wait(open_cond, open_lock,
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                                                   gfinaltime)) {
+#else
+                                                   &gfinaltime)) {
+#endif
+                        break;
+                }
+        }
+        pending = open_pending;
+        wrap_g_mutex_unlock(open_lock);
+
+        return pending;
+}
+
+/**
+ * oh_finit_handler_opens
+ *
+ * Waits for the background opens that are past abi->open and frees the
+ * open threads. Handlers still in abi->open are not waited for, a hung
+ * open must not hold up the shutdown. Their threads are left behind and
+ * close the handler again if the open returns.
+ **/
+void oh_finit_handler_opens(void)
+{
+        guint hung;
+
+        if (!open_pool) return;
+
+        wrap_g_mutex_lock(open_lock);
+        open_stopping = 1;
+        while (open_pending > open_calls)
+                g_cond_wait(open_cond, open_lock);
+        hung = open_pending;
+        wrap_g_mutex_unlock(open_lock);
+
+        if (hung) {
+                CRIT("%u handler(s) still opening, not waiting for them.",
+                     hung);
+                /* open_lock and open_cond stay for the left behind threads */
+                g_thread_pool_free(open_pool, FALSE, FALSE);
+                open_pool = NULL;
+                return;
+        }
+
+        g_thread_pool_free(open_pool, FALSE, TRUE);
+        open_pool = NULL;
+        wrap_g_cond_free(open_cond);
+        wrap_g_mutex_free_clear(open_lock);
+        open_cond = NULL;
+        open_lock = NULL;
+        open_pending = 0;
+        open_stopping = 0;
+}
+
+/**
+ * oh_handler_is_opening
+ * @hid: id of the handler
+ *
+ * Does not wait for the handler lock, for threads that go through all
+ * handlers and should not queue up behind a slow open.
+ *
+ * Returns: SAHPI_TRUE if the handler is still opening.
+ **/
+SaHpiBoolT oh_handler_is_opening(unsigned int hid)
+{
+        struct oh_handler *h;
+        GSList *node;
+        SaHpiBoolT opening = SAHPI_FALSE;
+
+        wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
+        node = g_hash_table_lookup(oh_handlers.table, &hid);
+        h = node ? (struct oh_handler *)(node->data) : NULL;
+        if (h && h->opening)
+                opening = SAHPI_TRUE;
+        wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
+
+        return opening;
+}
+
 /**
  * oh_destroy_handler
  * @hid: Id of handler to destroy
  *
- * Returns: 0 on Success.
+ * A handler that is still opening is not destroyed, its open thread
+ * holds the handler lock until abi->open returns.
+ *
+ * Returns: 0 on Success, -1 if the handler is not found or still opening.
  **/
 int oh_destroy_handler(unsigned int hid)
 {
@@ -629,6 +1021,11 @@ int oh_destroy_handler(unsigned int hid)
                 return -1;
         }
 
+        if (oh_handler_is_opening(hid)) {
+                CRIT("ERROR - Handler %d is still opening.", hid);
+                return -1;
+        }
+
         handler = oh_get_handler(hid);
         if (!handler) {
                 CRIT("ERROR - Handler %d not found.", hid);
@@ -692,7 +1089,13 @@ SaErrorT oh_get_handler_info(unsigned int hid, oHpiHandlerInfoT *info, GHashTabl
                 oh_encode_entitypath(entity_root_str, &info->entity_root);
         }
 
-        info->load_failed = (!h->hnd) ? 1 : 0;
+        if (h->opening) {
+                info->load_failed = open_timed_out(h) ?
+                                    OHPI_HANDLER_FAILED : OHPI_HANDLER_OPENING;
+        } else {
+                info->load_failed = (!h->hnd) ?
+                                    OHPI_HANDLER_FAILED : OHPI_HANDLER_LOADED;
+        }
 
         // copy h->config to the output hash table
         g_hash_table_foreach(h->config,copy_hashed_config_info,conf_params);
@@ -718,6 +1121,7 @@ SaErrorT oh_discovery(void)
         unsigned int hid = 0, next_hid;
         struct oh_handler *h = NULL;
         SaErrorT error = SA_ERR_HPI_ERROR;
+        SaHpiUint64T start = oh_metrics_now();
 
         oh_getnext_handler_id(hid, &next_hid);
         while (next_hid) {
@@ -728,6 +1132,12 @@ SaErrorT oh_discovery(void)
                    break;
                 }
 
+                /* Discovered by its opening thread */
+                if (oh_handler_is_opening(hid)) {
+                        oh_getnext_handler_id(hid, &next_hid);
+                        continue;
+                }
+
                 SaErrorT cur_error;
 
                 h = oh_get_handler(hid);
@@ -737,7 +1147,9 @@ SaErrorT oh_discovery(void)
                 }
 
 		if (h->abi->discover_resources && h->hnd) {
+                        SaHpiUint64T hstart = oh_metrics_now();
                         cur_error = h->abi->discover_resources(h->hnd);
+                        oh_metrics_abi(h->id, oh_metrics_now() - hstart);
                         if (cur_error == SA_OK && error) {
                                 error = cur_error;
                         }
@@ -746,6 +1158,11 @@ SaErrorT oh_discovery(void)
                 oh_getnext_handler_id(hid, &next_hid);
         }
 
+        /* Save resource ids assigned during this pass in one batch */
+        oh_uid_map_flush();
+
+        oh_metrics_discovery(oh_metrics_now() - start);
+
         return error;
 }
 
@@ -40,6 +40,7 @@
 #include "event.h"
 #include "hotswap.h"
 #include "init.h"
+#include "metrics.h"
 #include "threaded.h"
 
 
@@ -322,7 +323,6 @@ SaErrorT SAHPI_API saHpiResourceSeveritySet(
         OH_GET_DID(SessionId, did);
         OH_GET_DOMAIN(did, d); /* Lock domain */
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_resource_severity, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, Severity);
@@ -368,7 +368,6 @@ SaErrorT SAHPI_API saHpiResourceTagSet(
         OH_GET_DID(SessionId, did);
         OH_GET_DOMAIN(did, d); /* Lock domain */
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_resource_tag, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, ResourceTag);
@@ -480,11 +479,9 @@ SaErrorT SAHPI_API saHpiGetChildEntityPath (
 {
         struct oh_domain *d = NULL;
         SaHpiDomainIdT did;
-        oh_entitypath_pattern epp;
         SaHpiRptEntryT *rpte = NULL;
-        SaHpiBoolT found_match = SAHPI_FALSE;
+        SaHpiRptEntryT *nrpte = NULL;
         SaErrorT error;
-        int i, j;
         
         if (InstanceId == NULL || *InstanceId == SAHPI_LAST_ENTRY ||
             RptUpdateCount == NULL) {
@@ -510,47 +507,14 @@ SaErrorT SAHPI_API saHpiGetChildEntityPath (
             rpte = NULL;
         }
         
-        /* Create an entity path pattern from the parent entity path
-         * that looks like the following: <ParentEntityPath>{.,.}
-         * This will match direct childs of ParentEntityPath.
-         **/
-        memset(&epp, 0, sizeof(oh_entitypath_pattern));
-        epp.epattern[0].etp.is_dot = 1;
-        epp.epattern[0].elp.is_dot = 1;
-        for(i = 0, j = 1; i < SAHPI_MAX_ENTITY_PATH; i++) {
-                epp.epattern[j].etp.type =
-                        ParentEntityPath.Entry[i].EntityType;
-                epp.epattern[j].elp.location =
-                        ParentEntityPath.Entry[i].EntityLocation;
-                j++;
-        }
-        
-        /* Find a matching child */
-        for (rpte = oh_get_resource_by_id(&d->rpt, *InstanceId);
-             rpte;
-             rpte = oh_get_resource_next(&d->rpt, rpte->ResourceId)) {
-                if (oh_match_entitypath_pattern(&epp, &rpte->ResourceEntity)) {
-                        found_match = SAHPI_TRUE;
-                        break;
-                }
-                if (*InstanceId != SAHPI_FIRST_ENTRY) break;
-        }
-                
-        if (found_match) { /* Found matching InstanceId */
+        /* Direct childs of ParentEntityPath come from the entity path trie */
+        rpte = oh_get_resource_child(&d->rpt, &ParentEntityPath, *InstanceId);
+        if (rpte) { /* Found matching InstanceId */
                 /* Now look next matching InstanceId */
-                SaHpiRptEntryT *nrpte = NULL;
-                found_match = SAHPI_FALSE;
-                for (nrpte = oh_get_resource_next(&d->rpt, rpte->ResourceId);
-                     nrpte;
-                     nrpte = oh_get_resource_next(&d->rpt, nrpte->ResourceId)) {
-                        if (oh_match_entitypath_pattern(&epp,
-                                        &nrpte->ResourceEntity)) {
-                                found_match = SAHPI_TRUE;
-                                break;
-                        }
-                }
+                nrpte = oh_get_resource_child_next(&d->rpt, &ParentEntityPath,
+                                                   rpte->ResourceId);
                 *InstanceId = SAHPI_LAST_ENTRY;
-                if (found_match) {
+                if (nrpte) {
                         *InstanceId = nrpte->ResourceId;
                 }                
                 *ChildEntityPath = rpte->ResourceEntity;
@@ -600,7 +564,6 @@ SaErrorT SAHPI_API saHpiResourceFailedRemove (
         
         saved_res = *rpte;
         OH_HANDLER_GET(d, ResourceId, h);        
-        oh_release_domain(d);
 
         if (h && h->abi->resource_failed_remove) {
                 OH_CALL_ABI(h, resource_failed_remove, SA_ERR_HPI_INTERNAL_ERROR, error,
@@ -683,7 +646,6 @@ SaErrorT SAHPI_API saHpiEventLogInfoGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_el_info, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, Info);
@@ -727,7 +689,6 @@ SaErrorT SAHPI_API saHpiEventLogCapabilitiesGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_el_caps, SA_ERR_HPI_INTERNAL_ERROR, error,
                     ResourceId, EventLogCapabilities);
@@ -788,7 +749,6 @@ SaErrorT SAHPI_API saHpiEventLogEntryGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_el_entry, SA_ERR_HPI_INVALID_CMD, rv, 
                     ResourceId, EntryId, PrevEntryId, NextEntryId,
@@ -883,7 +843,6 @@ SaErrorT SAHPI_API saHpiEventLogEntryAdd (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, add_el_entry, SA_ERR_HPI_INVALID_CMD, rv, ResourceId, EvtEntry);
         oh_release_handler(h);
@@ -942,7 +901,6 @@ SaErrorT SAHPI_API saHpiEventLogClear (
 
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, clear_el, SA_ERR_HPI_INVALID_CMD, rv, ResourceId);
         oh_release_handler(h);
@@ -1030,7 +988,6 @@ SaErrorT SAHPI_API saHpiEventLogTimeSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_el_time, SA_ERR_HPI_INVALID_CMD, rv, ResourceId, Time);
         oh_release_handler(h);
@@ -1114,7 +1071,6 @@ SaErrorT SAHPI_API saHpiEventLogStateSet (
 
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_el_state, SA_ERR_HPI_INVALID_CMD, rv, ResourceId, Enable);
         oh_release_handler(h);
@@ -1171,7 +1127,6 @@ SaErrorT SAHPI_API saHpiEventLogOverflowReset (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, reset_el_overflow, SA_ERR_HPI_INVALID_CMD, rv, ResourceId);
         oh_release_handler(h);
@@ -1784,7 +1739,6 @@ SaErrorT SAHPI_API saHpiSensorReadingGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_sensor_reading, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, Reading, EventState);
@@ -1850,7 +1804,6 @@ SaErrorT SAHPI_API saHpiSensorThresholdsGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_sensor_thresholds, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, SensorThresholds);
@@ -1930,7 +1883,6 @@ SaErrorT SAHPI_API saHpiSensorThresholdsSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_sensor_thresholds, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, &tmp);
@@ -2019,7 +1971,6 @@ SaErrorT SAHPI_API saHpiSensorEnableGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_sensor_enable, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, SensorEnabled);
@@ -2065,7 +2016,6 @@ SaErrorT SAHPI_API saHpiSensorEnableSet (
                 return SA_ERR_HPI_READ_ONLY;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_sensor_enable, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, SensorEnabled);
@@ -2114,7 +2064,6 @@ SaErrorT SAHPI_API saHpiSensorEventEnableGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_sensor_event_enables, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, SensorEventsEnabled);
@@ -2163,7 +2112,6 @@ SaErrorT SAHPI_API saHpiSensorEventEnableSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_sensor_event_enables, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, SensorEventsEnabled);
@@ -2211,7 +2159,6 @@ SaErrorT SAHPI_API saHpiSensorEventMasksGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_sensor_event_masks, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, AssertEventMask, DeassertEventMask);
@@ -2283,7 +2230,6 @@ SaErrorT SAHPI_API saHpiSensorEventMasksSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_sensor_event_masks, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, SensorNum, Action, AssertEventMask, DeassertEventMask);
@@ -2394,7 +2340,6 @@ SaErrorT SAHPI_API saHpiControlGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_control_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, CtrlNum, CtrlMode, CtrlState);
@@ -2418,6 +2363,7 @@ SaErrorT SAHPI_API saHpiControlSet (
         struct oh_domain *d = NULL;
         SaHpiCtrlModeT cur_mode;
         SaHpiCtrlStateT cur_state;
+        SaHpiBoolT check_digital;
 
         if (!oh_lookup_ctrlmode(CtrlMode) ||
             (CtrlMode != SAHPI_CTRL_MODE_AUTO && !CtrlState)) {
@@ -2457,11 +2403,13 @@ SaErrorT SAHPI_API saHpiControlSet (
                 oh_release_domain(d);
                 return rv;
         }
+        /* rdr may be a view that is gone with the domain lock */
+        check_digital = (!rdr->RdrTypeUnion.CtrlRec.WriteOnly &&
+                         rdr->RdrTypeUnion.CtrlRec.Type ==
+                         SAHPI_CTRL_TYPE_DIGITAL) ? SAHPI_TRUE : SAHPI_FALSE;
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 	
-	if (!rdr->RdrTypeUnion.CtrlRec.WriteOnly &&
-	    rdr->RdrTypeUnion.CtrlRec.Type == SAHPI_CTRL_TYPE_DIGITAL) {
+	if (check_digital) {
 	    
 		OH_CALL_ABI(h, get_control_state, SA_ERR_HPI_INVALID_CMD, rv,
         	    	    ResourceId, CtrlNum, &cur_mode, &cur_state);
@@ -2526,7 +2474,6 @@ SaErrorT SAHPI_API saHpiIdrInfoGet(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_idr_info, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, IdrInfo);
@@ -2579,7 +2526,6 @@ SaErrorT SAHPI_API saHpiIdrAreaHeaderGet(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_idr_area_header, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, AreaType, AreaId, NextAreaId, Header);
@@ -2626,7 +2572,6 @@ SaErrorT SAHPI_API saHpiIdrAreaAdd(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, add_idr_area, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, AreaType, AreaId);
@@ -2677,7 +2622,6 @@ SaErrorT SAHPI_API saHpiIdrAreaAddById(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
         
         /* Check if IDR is read-only */
         OH_CALL_ABI(h, get_idr_info, SA_ERR_HPI_INTERNAL_ERROR, error,
@@ -2741,7 +2685,6 @@ SaErrorT SAHPI_API saHpiIdrAreaDelete(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, del_idr_area, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, AreaId);
@@ -2792,7 +2735,6 @@ SaErrorT SAHPI_API saHpiIdrFieldGet(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_idr_field, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, AreaId, FieldType, FieldId, NextFieldId, Field);
@@ -2841,7 +2783,6 @@ SaErrorT SAHPI_API saHpiIdrFieldAdd(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, add_idr_field, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, Field);
@@ -2897,7 +2838,6 @@ SaErrorT SAHPI_API saHpiIdrFieldAddById(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
         
         /* Check if AreaId specified in Field exists */
         OH_CALL_ABI(h, get_idr_area_header, SA_ERR_HPI_INTERNAL_ERROR, error,
@@ -2967,7 +2907,6 @@ SaErrorT SAHPI_API saHpiIdrFieldSet(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_idr_field, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, Field);
@@ -3011,7 +2950,6 @@ SaErrorT SAHPI_API saHpiIdrFieldDelete(
                 return SA_ERR_HPI_NOT_PRESENT;
         }
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, del_idr_field, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, IdrId, AreaId, FieldId);
@@ -3053,7 +2991,6 @@ SaErrorT SAHPI_API saHpiWatchdogTimerGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_watchdog_info, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, WatchdogNum, Watchdog);
@@ -3096,7 +3033,6 @@ SaErrorT SAHPI_API saHpiWatchdogTimerSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_watchdog_info, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, WatchdogNum, Watchdog);
@@ -3127,7 +3063,6 @@ SaErrorT SAHPI_API saHpiWatchdogTimerReset (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, reset_watchdog, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, WatchdogNum);
@@ -3183,7 +3118,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorGetNext(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_next_announce, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, Severity, UnacknowledgedOnly,
@@ -3233,7 +3167,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorGet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_announce, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, EntryId, Announcement);
@@ -3281,7 +3214,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorAcknowledge(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, ack_announce, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, EntryId, Severity);
@@ -3347,7 +3279,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorAdd(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, add_announce, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, Announcement);
@@ -3409,7 +3340,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorDelete(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, del_announce, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, EntryId, Severity);
@@ -3454,7 +3384,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorModeGet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_annunc_mode, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, Mode);
@@ -3507,7 +3436,6 @@ SaErrorT SAHPI_API saHpiAnnunciatorModeSet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, set_annunc_mode, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, AnnunciatorNum, Mode);
@@ -3561,7 +3489,6 @@ SaErrorT SAHPI_API saHpiDimiInfoGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
         
         OH_CALL_ABI(h, get_dimi_info, SA_ERR_HPI_INVALID_CMD, error,
         	    ResourceId, DimiNum, DimiInfo);
@@ -3608,7 +3535,6 @@ SaErrorT SAHPI_API saHpiDimiTestInfoGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
         
         OH_CALL_ABI(h, get_dimi_test, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum, DimiTest);
@@ -3655,7 +3581,6 @@ SaErrorT SAHPI_API saHpiDimiTestReadinessGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_dimi_test_ready, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum, DimiReady);
@@ -3704,7 +3629,6 @@ SaErrorT SAHPI_API saHpiDimiTestStart (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_dimi_test, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum, NumberOfParams, ParamsList);
@@ -3748,7 +3672,6 @@ SaErrorT SAHPI_API saHpiDimiTestCancel (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, cancel_dimi_test, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum);
@@ -3797,7 +3720,6 @@ SaErrorT SAHPI_API saHpiDimiTestStatusGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_dimi_test_status, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum, PercentCompleted, RunStatus);
@@ -3845,7 +3767,6 @@ SaErrorT SAHPI_API saHpiDimiTestResultsGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_dimi_test_results, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, DimiNum, TestNum, TestResults);
@@ -3898,7 +3819,6 @@ SaErrorT SAHPI_API saHpiFumiSpecInfoGet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_spec, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, SpecInfo);
@@ -3945,7 +3865,6 @@ SaErrorT SAHPI_API saHpiFumiServiceImpactGet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_service_impact, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, ServiceImpact);
@@ -3996,7 +3915,6 @@ SaErrorT SAHPI_API saHpiFumiSourceSet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, set_fumi_source, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, SourceUri);
@@ -4040,7 +3958,6 @@ SaErrorT SAHPI_API saHpiFumiSourceInfoValidateStart (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, validate_fumi_source, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum);
@@ -4088,7 +4005,6 @@ SaErrorT SAHPI_API saHpiFumiSourceInfoGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_source, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, SourceInfo);
@@ -4143,7 +4059,6 @@ SaErrorT SAHPI_API saHpiFumiSourceComponentInfoGet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_source_component, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, ComponentEntryId,
@@ -4192,7 +4107,6 @@ SaErrorT SAHPI_API saHpiFumiTargetInfoGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_target, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, BankInfo);
@@ -4247,7 +4161,6 @@ SaErrorT SAHPI_API saHpiFumiTargetComponentInfoGet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_target_component, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, ComponentEntryId,
@@ -4295,7 +4208,6 @@ SaErrorT SAHPI_API saHpiFumiLogicalTargetInfoGet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_logical_target, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankInfo);
@@ -4349,7 +4261,6 @@ SaErrorT SAHPI_API saHpiFumiLogicalTargetComponentInfoGet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_logical_target_component, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, ComponentEntryId,
@@ -4396,7 +4307,6 @@ SaErrorT SAHPI_API saHpiFumiBackupStart(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_backup, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum);
@@ -4444,7 +4354,6 @@ SaErrorT SAHPI_API saHpiFumiBankBootOrderSet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, set_fumi_bank_order, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, Position);
@@ -4496,7 +4405,6 @@ SaErrorT SAHPI_API saHpiFumiBankCopyStart(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_bank_copy, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, SourceBankNum, TargetBankNum);
@@ -4552,7 +4460,6 @@ SaErrorT SAHPI_API saHpiFumiInstallStart (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_install, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum);
@@ -4600,7 +4507,6 @@ SaErrorT SAHPI_API saHpiFumiUpgradeStatusGet (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_status, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum, UpgradeStatus);
@@ -4659,7 +4565,6 @@ SaErrorT SAHPI_API saHpiFumiTargetVerifyStart (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_verify, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum);
@@ -4717,7 +4622,6 @@ SaErrorT SAHPI_API saHpiFumiTargetVerifyMainStart(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_verify_main, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum);
@@ -4761,7 +4665,6 @@ SaErrorT SAHPI_API saHpiFumiUpgradeCancel (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, cancel_fumi_upgrade, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum);
@@ -4811,7 +4714,6 @@ SaErrorT SAHPI_API saHpiFumiAutoRollbackDisableGet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, get_fumi_autorollback_disable, SA_ERR_HPI_INVALID_CMD,
                     error, ResourceId, FumiNum, Disable);
@@ -4861,7 +4763,6 @@ SaErrorT SAHPI_API saHpiFumiAutoRollbackDisableSet(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, set_fumi_autorollback_disable, SA_ERR_HPI_INVALID_CMD,
                     error, ResourceId, FumiNum, Disable);
@@ -4907,7 +4808,6 @@ SaErrorT SAHPI_API saHpiFumiRollbackStart (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_rollback, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum);
@@ -4950,7 +4850,6 @@ SaErrorT SAHPI_API saHpiFumiActivate (
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, activate_fumi, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum);
@@ -4994,7 +4893,6 @@ SaErrorT SAHPI_API saHpiFumiActivateStart(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, start_fumi_activate, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, Logical);
@@ -5038,7 +4936,6 @@ SaErrorT SAHPI_API saHpiFumiCleanup(
         }
         
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d);
 
         OH_CALL_ABI(h, cleanup_fumi, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, FumiNum, BankNum);
@@ -5092,9 +4989,8 @@ SaErrorT SAHPI_API saHpiHotSwapPolicyCancel (
                 return SA_ERR_HPI_INVALID_REQUEST;
         }
 
-        OH_HANDLER_GET(d, ResourceId, h);
         timeout = d->ai_timeout;
-        oh_release_domain(d); /* Unlock domain */
+        OH_HANDLER_GET(d, ResourceId, h);
 
         OH_CALL_ABI(h, hotswap_policy_cancel, SA_OK, error,
                     ResourceId, timeout);
@@ -5140,7 +5036,6 @@ SaErrorT SAHPI_API saHpiResourceActiveSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_hotswap_state, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, SAHPI_HS_STATE_ACTIVE);
@@ -5187,7 +5082,6 @@ SaErrorT SAHPI_API saHpiResourceInactiveSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_hotswap_state, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, SAHPI_HS_STATE_INACTIVE);
@@ -5334,7 +5228,6 @@ SaErrorT SAHPI_API saHpiAutoExtractTimeoutGet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock Domain */
 
         OH_CALL_ABI(h, get_autoextract_timeout, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, Timeout);
@@ -5374,7 +5267,6 @@ SaErrorT SAHPI_API saHpiAutoExtractTimeoutSet(
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock Domain */
 
         OH_CALL_ABI(h, set_autoextract_timeout, SA_ERR_HPI_INVALID_CMD, error,
                     ResourceId, Timeout);
@@ -5409,7 +5301,6 @@ SaErrorT SAHPI_API saHpiHotSwapStateGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_hotswap_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, State);
@@ -5463,7 +5354,6 @@ SaErrorT SAHPI_API saHpiHotSwapActionRequest (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, request_hotswap_action, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, Action);
@@ -5507,7 +5397,6 @@ SaErrorT SAHPI_API saHpiHotSwapIndicatorStateGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_indicator_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, State);
@@ -5551,7 +5440,6 @@ SaErrorT SAHPI_API saHpiHotSwapIndicatorStateSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_indicator_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, State);
@@ -5592,7 +5480,6 @@ SaErrorT SAHPI_API saHpiParmControl (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, control_parm, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, Action);
@@ -5633,7 +5520,6 @@ SaErrorT SAHPI_API saHpiResourceLoadIdGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
         
         OH_CALL_ABI(h, load_id_get, SA_ERR_HPI_INTERNAL_ERROR, error,
                     ResourceId, LoadId);
@@ -5669,7 +5555,6 @@ SaErrorT SAHPI_API saHpiResourceLoadIdSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
         
         OH_CALL_ABI(h, load_id_set, SA_ERR_HPI_INTERNAL_ERROR, error,
                     ResourceId, LoadId);
@@ -5711,7 +5596,6 @@ SaErrorT SAHPI_API saHpiResourceResetStateGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_reset_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, ResetAction);
@@ -5746,7 +5630,6 @@ SaErrorT SAHPI_API saHpiResourceResetStateSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_reset_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, ResetAction);
@@ -5787,7 +5670,6 @@ SaErrorT SAHPI_API saHpiResourcePowerStateGet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, get_power_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, State);
@@ -5822,7 +5704,6 @@ SaErrorT SAHPI_API saHpiResourcePowerStateSet (
         }
 
         OH_HANDLER_GET(d, ResourceId, h);
-        oh_release_domain(d); /* Unlock domain */
 
         OH_CALL_ABI(h, set_power_state, SA_ERR_HPI_INVALID_CMD, rv,
                     ResourceId, State);
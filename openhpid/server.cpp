@@ -22,6 +22,12 @@
 
 #include <string.h>
 
+#ifndef _WIN32
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+#endif
+
 #include <glib.h>
 
 #include <SaHpi.h>
@@ -34,12 +40,21 @@
 #include <strmsock.h>
 #include <sahpi_wrappers.h>
 
+#include "conf.h"
+#include "metrics.h"
+
 
 /*--------------------------------------------------------------------*/
 /* Forward Declarations                                               */
 /*--------------------------------------------------------------------*/
 
 static void service_thread(gpointer sock_ptr, gpointer /* user_data */);
+static void tagged_request_thread(gpointer rq_ptr, gpointer /* user_data */);
+static gpointer metrics_thread(gpointer ssock_ptr);
+static void accept_connections(cServerStreamSock * ssock, bool local);
+#ifndef _WIN32
+static gpointer local_accept_thread(gpointer ssock_ptr);
+#endif
 static SaErrorT process_msg(cHpiMarshal * hm,
                             int rq_byte_order,
                             char * data,
@@ -59,6 +74,47 @@ static volatile bool stop = false;
 
 static GList * sockets = 0; 
 
+/* Connection thread pool, shared by all listening sockets */
+static GThreadPool * pool = 0;
+
+/* Threads serving tagged requests of multiplexed connections */
+static GThreadPool * rq_pool = 0;
+
+/* Threads serving tagged saHpiEventGet() requests, they may block for */
+/* long and so are not bounded by max_threads                          */
+static GThreadPool * evt_pool = 0;
+
+/* Min payload size for compressed replies to TCP clients, 0 is off */
+static uint32_t compress_threshold = 0;
+
+/*--------------------------------------------------------------------*/
+/* Multiplexed connection                                             */
+/*                                                                    */
+/* Requests with a tag are served in parallel by rq_pool, so one      */
+/* connection can carry any number of sessions. saHpiEventGet()       */
+/* requests go to the unbounded evt_pool instead, so blocked event    */
+/* waiters can never take all rq_pool threads and hold up the other   */
+/* requests.                                                          */
+/*--------------------------------------------------------------------*/
+struct MuxConn
+{
+    cStreamSock * sock;
+    GMutex *      lock;     // protects the fields below and socket writes
+    GCond *       cond;
+    unsigned int  pending;  // requests being served
+    GList *       sids;     // sessions opened through the connection
+};
+
+struct TaggedRequest
+{
+    MuxConn * conn;
+    uint32_t  id;
+    int       tag;
+    int       byte_order;
+    uint32_t  data_len;
+    char      data[1];  // data_len bytes of the request follow
+};
+
 /*--------------------------------------------------------------------*/
 /* Socket List                                                        */
 /*--------------------------------------------------------------------*/
@@ -139,6 +195,69 @@ static void LogIp( const cStreamSock * sock )
 }
 
 
+#ifndef _WIN32
+/*--------------------------------------------------------------------*/
+/* Function to check local connection peer                            */
+/*--------------------------------------------------------------------*/
+// SO_PEERCRED only reports the primary group of the peer,
+// supplementary groups come from the group database
+static bool IsGroupMember( uid_t uid, gid_t gid )
+{
+    long size = sysconf( _SC_GETPW_R_SIZE_MAX );
+    if ( size <= 0 ) {
+        size = 16384;
+    }
+    gchar * buf = g_new( gchar, size );
+    struct passwd pwd, * result = 0;
+    int cc = getpwuid_r( uid, &pwd, buf, size, &result );
+    if ( ( cc != 0 ) || ( result == 0 ) ) {
+        g_free( buf );
+        return false;
+    }
+
+    bool member = ( pwd.pw_gid == gid );
+    if ( !member ) {
+        int ngroups = 0;
+        getgrouplist( pwd.pw_name, pwd.pw_gid, 0, &ngroups );
+        gid_t * groups = g_new( gid_t, ngroups + 1 );
+        if ( getgrouplist( pwd.pw_name, pwd.pw_gid, groups, &ngroups ) >= 0 ) {
+            for ( int i = 0; ( i < ngroups ) && !member; ++i ) {
+                member = ( groups[i] == gid );
+            }
+        }
+        g_free( groups );
+    }
+    g_free( buf );
+
+    return member;
+}
+
+static bool CheckLocalPeer( const cStreamSock * sock )
+{
+    uid_t uid;
+    gid_t gid;
+    pid_t pid;
+    bool rc = sock->GetPeerCredentials( uid, gid, pid );
+    if ( !rc ) {
+        WARN( "Cannot determine local connection credentials!" );
+        return false;
+    }
+
+    // root, the daemon user and members of the daemon group are allowed
+    if ( ( uid != 0 ) && ( uid != geteuid() ) && ( gid != getegid() ) &&
+         !IsGroupMember( uid, getegid() ) ) {
+        WARN( "Denied local connection from pid %d uid %d gid %d",
+              (int)pid, (int)uid, (int)gid );
+        return false;
+    }
+
+    INFO( "Got local connection from pid %d uid %d", (int)pid, (int)uid );
+
+    return true;
+}
+#endif /* _WIN32 */
+
+
 /*--------------------------------------------------------------------*/
 /* HPI Server Interface                                               */
 /*--------------------------------------------------------------------*/
@@ -146,6 +265,7 @@ static void LogIp( const cStreamSock * sock )
 bool oh_server_run( int ipvflags,
                     const char * bindaddr,
                     uint16_t port,
+                    const char * sockpath,
                     unsigned int sock_timeout,
                     int max_threads )
 {
@@ -157,10 +277,84 @@ bool oh_server_run( int ipvflags,
     }
     add_socket_to_list( ssock );
 
-    // create the thread pool
-    GThreadPool *pool;
+    struct oh_global_param param;
+    oh_get_global_param2(OPENHPI_COMPRESS_THRESHOLD, &param);
+    compress_threshold = param.u.compress_threshold;
+    if (compress_threshold) {
+        INFO("Compressing payloads from %u bytes.", compress_threshold);
+    }
+
+    // create the thread pools
     pool = g_thread_pool_new(service_thread, 0, max_threads, FALSE, 0);
+    rq_pool = g_thread_pool_new(tagged_request_thread, 0, max_threads, FALSE, 0);
+    evt_pool = g_thread_pool_new(tagged_request_thread, 0, -1, FALSE, 0);
+
+    // local clients get their own listening socket and accept thread
+    GThread * local_thread = 0;
+    cServerStreamSock * lsock = 0;
+#ifndef _WIN32
+    if (sockpath) {
+        lsock = new cServerStreamSock;
+        if (!lsock->CreateLocal(sockpath)) {
+            CRIT("Error creating local server socket %s.", sockpath);
+            delete lsock;
+            lsock = 0;
+        } else {
+            add_socket_to_list( lsock );
+            local_thread = wrap_g_thread_create_new("LocalServer",
+                                                    local_accept_thread,
+                                                    lsock, TRUE, 0);
+            if (!local_thread) {
+                CRIT("Error creating local server thread.");
+                remove_socket_from_list( lsock );
+                delete lsock;
+                lsock = 0;
+                unlink(sockpath);
+            }
+        }
+    }
+#endif
+
+    accept_connections(ssock, false);
+
+    remove_socket_from_list( ssock );
+    delete ssock;
+    DBG("Server socket closed.");
+
+    if (local_thread) {
+        g_thread_join(local_thread);
+        remove_socket_from_list( lsock );
+        delete lsock;
+#ifndef _WIN32
+        unlink(sockpath);
+#endif
+        DBG("Local server socket closed.");
+    }
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+    pool = 0;
+    DBG("All connection threads are terminated.");
 
+    g_thread_pool_free(rq_pool, FALSE, TRUE);
+    rq_pool = 0;
+    g_thread_pool_free(evt_pool, FALSE, TRUE);
+    evt_pool = 0;
+
+    return true;
+}
+
+#ifndef _WIN32
+static gpointer local_accept_thread(gpointer ssock_ptr)
+{
+    cServerStreamSock * ssock = reinterpret_cast<cServerStreamSock *>(ssock_ptr);
+    accept_connections(ssock, true);
+
+    return 0;
+}
+#endif
+
+static void accept_connections(cServerStreamSock * ssock, bool local)
+{
     cStreamSock::eWaitCc wc;
     // wait for a connection and then service the connection
     while (!stop) {
@@ -186,29 +380,180 @@ bool oh_server_run( int ipvflags,
         }
 
         if (stop) {
+            delete sock;
             break;
         }
 
-        LogIp( sock );
+        if (local) {
+#ifndef _WIN32
+            if (!CheckLocalPeer( sock )) {
+                delete sock;
+                continue;
+            }
+#endif
+        } else {
+            LogIp( sock );
+            sock->EnableCompression( compress_threshold );
+        }
         add_socket_to_list( sock );
         DBG("### Spawning thread to handle connection. ###");
         g_thread_pool_push(pool, (gpointer)sock, 0);
     }
+}
 
-    remove_socket_from_list( ssock );
-    delete ssock;
-    DBG("Server socket closed.");
+void oh_server_request_stop(void)
+{
+    stop = true;
+    close_sockets_in_list();
+}
 
-    g_thread_pool_free(pool, FALSE, TRUE);
-    DBG("All connection threads are terminated.");
+bool oh_metrics_server_start( const char * bindaddr, uint16_t port )
+{
+    cServerStreamSock * ssock = new cServerStreamSock;
+    if (!ssock->Create(FlagIPv4 | FlagIPv6, bindaddr, port)) {
+        CRIT("Error creating metrics server socket.");
+        delete ssock;
+        return false;
+    }
+    add_socket_to_list( ssock );
+
+    GThread * thread = wrap_g_thread_create_new("MetricsServer",
+                                                metrics_thread,
+                                                ssock, FALSE, 0);
+    if (!thread) {
+        CRIT("Error creating metrics server thread.");
+        remove_socket_from_list( ssock );
+        delete ssock;
+        return false;
+    }
 
     return true;
 }
 
-void oh_server_request_stop(void)
+
+/*--------------------------------------------------------------------*/
+/* Multiplexed connection functions                                   */
+/*--------------------------------------------------------------------*/
+
+static MuxConn * mux_conn_new(cStreamSock * sock)
 {
-    stop = true;
-    close_sockets_in_list();
+    MuxConn * conn = g_new0(MuxConn, 1);
+    conn->sock = sock;
+    conn->lock = wrap_g_mutex_new_init();
+    conn->cond = wrap_g_cond_new_init();
+
+    return conn;
+}
+
+static void mux_conn_push(MuxConn * conn,
+                          uint32_t id,
+                          int tag,
+                          int byte_order,
+                          const char * data,
+                          uint32_t data_len)
+{
+    // Only the request is kept, it is served in a full payload buffer
+    TaggedRequest * rq = (TaggedRequest *)g_malloc(sizeof(TaggedRequest) + data_len);
+    rq->conn       = conn;
+    rq->id         = id;
+    rq->tag        = tag;
+    rq->byte_order = byte_order;
+    rq->data_len   = data_len;
+    memcpy(rq->data, data, data_len);
+
+    g_mutex_lock(conn->lock);
+    ++conn->pending;
+    g_mutex_unlock(conn->lock);
+
+    if (id == eFsaHpiEventGet) {
+        g_thread_pool_push(evt_pool, rq, 0);
+    } else {
+        g_thread_pool_push(rq_pool, rq, 0);
+    }
+}
+
+static void mux_conn_close_sessions(MuxConn * conn)
+{
+    g_mutex_lock(conn->lock);
+    GList * sids = conn->sids;
+    conn->sids = 0;
+    g_mutex_unlock(conn->lock);
+
+    for (GList * iter = sids; iter != 0; iter = g_list_next(iter)) {
+        saHpiSessionClose((SaHpiSessionIdT)GPOINTER_TO_UINT(iter->data));
+    }
+    g_list_free(sids);
+}
+
+static void mux_conn_free(MuxConn * conn)
+{
+    // Closing sessions first wakes up requests blocked in saHpiEventGet()
+    mux_conn_close_sessions(conn);
+
+    g_mutex_lock(conn->lock);
+    while (conn->pending != 0) {
+        g_cond_wait(conn->cond, conn->lock);
+    }
+    g_mutex_unlock(conn->lock);
+
+    // Sessions opened by requests that were still in flight
+    mux_conn_close_sessions(conn);
+
+    wrap_g_cond_free(conn->cond);
+    wrap_g_mutex_free_clear(conn->lock);
+    g_free(conn);
+}
+
+static void tagged_request_thread(gpointer rq_ptr, gpointer /* user_data */)
+{
+    TaggedRequest * rq = reinterpret_cast<TaggedRequest *>(rq_ptr);
+    MuxConn * conn = rq->conn;
+
+    // The reply is marshalled in place and may be larger than the request
+    char     data[dMaxPayloadLength];
+    uint32_t data_len = rq->data_len;
+    memcpy(data, rq->data, data_len);
+
+    cHpiMarshal *hm = HpiMarshalFind(rq->id);
+    SaErrorT process_rv;
+    SaHpiSessionIdT changed_sid = 0;
+    if ( hm ) {
+        SaHpiUint64T start = oh_metrics_now();
+        process_rv = process_msg(hm, rq->byte_order, data, data_len, changed_sid);
+        oh_metrics_rpc(rq->id, hm->m_name, oh_metrics_now() - start);
+    } else {
+        process_rv = SA_ERR_HPI_UNSUPPORTED_API;
+    }
+
+    bool reply = true;
+    if (process_rv != SA_OK) {
+        int cc = HpiMarshalReply0(hm, data, &process_rv);
+        if (cc < 0) {
+            CRIT("Marshal failed, cc = %d", cc);
+            reply = false;
+        } else {
+            data_len = (uint32_t)cc;
+        }
+    }
+
+    g_mutex_lock(conn->lock);
+    if ((process_rv == SA_OK) && (changed_sid != 0)) {
+        gpointer sid_ptr = GUINT_TO_POINTER(changed_sid);
+        if (rq->id == eFsaHpiSessionOpen) {
+            conn->sids = g_list_prepend(conn->sids, sid_ptr);
+        } else if (rq->id == eFsaHpiSessionClose) {
+            conn->sids = g_list_remove(conn->sids, sid_ptr);
+        }
+    }
+    if (reply && !stop) {
+        // Write failure is detected by the reading thread
+        conn->sock->WriteMsg(eMhMsg, rq->id, data, data_len, rq->tag);
+    }
+    --conn->pending;
+    g_cond_signal(conn->cond);
+    g_mutex_unlock(conn->lock);
+
+    g_free(rq);
 }
 
 
@@ -232,6 +577,10 @@ static void service_thread(gpointer sock_ptr, gpointer /* user_data */)
 
     DBG("### service_thread, thrdid [%p] ###", (void *)thrdid);
 
+    oh_metrics_connection(1);
+
+    MuxConn * conn = 0;
+
     while (!stop) {
         bool     rc;
         char     data[dMaxPayloadLength];
@@ -239,11 +588,19 @@ static void service_thread(gpointer sock_ptr, gpointer /* user_data */)
         uint8_t  type;
         uint32_t id;
         int      rq_byte_order;
+        int      tag;
 
-        rc = sock->ReadMsg(type, id, data, data_len, rq_byte_order);
+        rc = sock->ReadMsg(type, id, data, data_len, rq_byte_order, &tag);
         if (stop) {
             break;
         }
+        if (rc && (tag >= 0) && (type == eMhMsg)) {
+            if (!conn) {
+                conn = mux_conn_new(sock);
+            }
+            mux_conn_push(conn, id, tag, rq_byte_order, data, data_len);
+            continue;
+        }
         if (!rc) {
             // The following error message need not be there as the
             // ReadMsg captures the error when it returns false and
@@ -258,7 +615,9 @@ static void service_thread(gpointer sock_ptr, gpointer /* user_data */)
             SaErrorT process_rv;
             SaHpiSessionIdT changed_sid = 0;
             if ( hm ) {
+                SaHpiUint64T start = oh_metrics_now();
                 process_rv = process_msg(hm, rq_byte_order, data, data_len, changed_sid);
+                oh_metrics_rpc(id, hm->m_name, oh_metrics_now() - start);
             } else {
                 process_rv = SA_ERR_HPI_UNSUPPORTED_API;
             }
@@ -293,16 +652,101 @@ static void service_thread(gpointer sock_ptr, gpointer /* user_data */)
     if (my_sid != 0) {
         saHpiSessionClose(my_sid);
     }
+    if (conn) {
+        mux_conn_free(conn);
+    }
 
     remove_socket_from_list( sock );
     delete sock; // cleanup thread instance data
 
+    oh_metrics_connection(-1);
+
     DBG("%p Connection closed.", thrdid);
     return; // do NOT use g_thread_exit here!
     // TODO why? what is wrong with g_thread_exit? (2011-06-07)
 }
 
 
+/*--------------------------------------------------------------------*/
+/* Function: metrics_thread                                           */
+/*--------------------------------------------------------------------*/
+
+// Scrapes are served one at a time, so a stalled peer may
+// hold up the others for this long per read or write
+#define METRICS_IO_TIMEOUT 500 // ms
+
+static void serve_metrics(cStreamSock * sock)
+{
+    char request[1024];
+    size_t len = sizeof(request) - 1;
+
+    if ( !sock->SetTimeouts( METRICS_IO_TIMEOUT ) ) {
+        return;
+    }
+
+    // One short read is enough for the request line of a scrape
+    if ( !sock->ReadRaw( request, len ) ) {
+        return;
+    }
+    request[len] = '\0';
+
+    if ( strncmp( request, "GET ", 4 ) != 0 ) {
+        static const char reply[] =
+            "HTTP/1.0 405 Method Not Allowed\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n";
+        sock->WriteRaw( reply, sizeof(reply) - 1 );
+        return;
+    }
+
+    gchar * body = oh_metrics_text();
+    gchar * header = g_strdup_printf(
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %lu\r\n"
+        "Connection: close\r\n\r\n",
+        (unsigned long)strlen( body ) );
+    if ( sock->WriteRaw( header, strlen( header ) ) ) {
+        sock->WriteRaw( body, strlen( body ) );
+    }
+    g_free( header );
+    g_free( body );
+}
+
+static gpointer metrics_thread(gpointer ssock_ptr)
+{
+    cServerStreamSock * ssock = (cServerStreamSock *)ssock_ptr;
+    cStreamSock::eWaitCc wc;
+
+    while (!stop) {
+        wc = ssock->Wait();
+        if ( wc == cStreamSock::eWaitError ) {
+            if (stop) {
+                break;
+            }
+            g_usleep( 1000000 ); // in case the problem is persistent
+            continue;
+        }
+        if ( wc == cStreamSock::eWaitTimeout ) {
+            continue;
+        }
+
+        cStreamSock * sock = ssock->Accept();
+        if ( !sock ) {
+            continue;
+        }
+        serve_metrics( sock );
+        delete sock;
+    }
+
+    remove_socket_from_list( ssock );
+    delete ssock;
+    DBG("Metrics server socket closed.");
+
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------------*/
 /* RPC Call Processing                                                        */
 /*----------------------------------------------------------------------------*/
@@ -2104,6 +2548,93 @@ static SaErrorT process_msg(cHpiMarshal * hm,
         }
         break;
 
+        case eFoHpiMetricGet: {
+            SaHpiEntryIdT eid;
+            SaHpiEntryIdT next_eid;
+            oHpiMetricT   metric;
+
+            RpcParams iparams(&sid, &eid);
+            DEMARSHAL_RQ(rq_byte_order, hm, data, iparams);
+
+            rv = oHpiMetricGet(sid, eid, &next_eid, &metric);
+
+            RpcParams oparams(&rv, &next_eid, &metric);
+            MARSHAL_RP(hm, data, data_len, oparams);
+        }
+        break;
+
+        case eFoHpiSensorHistoryGet: {
+            SaHpiResourceIdT   rid;
+            SaHpiSensorNumT    num;
+            SaHpiTimeT         start;
+            SaHpiTimeT         end;
+            SaHpiUint32T       max;
+            oHpiSensorHistoryT history;
+
+            RpcParams iparams(&sid, &rid, &num, &start, &end, &max);
+            DEMARSHAL_RQ(rq_byte_order, hm, data, iparams);
+
+            if (max > OHPI_SENSOR_HISTORY_MAX_SAMPLES) {
+                max = OHPI_SENSOR_HISTORY_MAX_SAMPLES;
+            }
+            history.NumberOfSamples = max;
+            history.Samples = g_new0(oHpiSensorSampleT, max ? max : 1);
+
+            rv = oHpiSensorHistoryGet(sid, rid, num, start, end,
+                                      &history.NumberOfSamples,
+                                      history.Samples);
+            if (rv != SA_OK) {
+                history.NumberOfSamples = 0;
+            }
+
+            RpcParams oparams(&rv, &history);
+            MARSHAL_RP(hm, data, data_len, oparams);
+            // cleanup
+            g_free(history.Samples);
+        }
+        break;
+
+        case eFoHpiSensorWatchAdd: {
+            SaHpiResourceIdT rid;
+            SaHpiSensorNumT  num;
+            SaHpiUint32T     interval;
+            SaHpiFloat64T    hysteresis;
+
+            RpcParams iparams(&sid, &rid, &num, &interval, &hysteresis);
+            DEMARSHAL_RQ(rq_byte_order, hm, data, iparams);
+
+            rv = oHpiSensorWatchAdd(sid, rid, num, interval, hysteresis);
+
+            RpcParams oparams(&rv);
+            MARSHAL_RP(hm, data, data_len, oparams);
+        }
+        break;
+
+        case eFoHpiSensorWatchRemove: {
+            SaHpiResourceIdT rid;
+            SaHpiSensorNumT  num;
+
+            RpcParams iparams(&sid, &rid, &num);
+            DEMARSHAL_RQ(rq_byte_order, hm, data, iparams);
+
+            rv = oHpiSensorWatchRemove(sid, rid, num);
+
+            RpcParams oparams(&rv);
+            MARSHAL_RP(hm, data, data_len, oparams);
+        }
+        break;
+
+        case eFoHpiConfigReload: {
+            RpcParams iparams(&sid);
+            DEMARSHAL_RQ(rq_byte_order, hm, data, iparams);
+
+            rv = oHpiConfigReload(sid);
+
+            RpcParams oparams(&rv);
+            MARSHAL_RP(hm, data, data_len, oparams);
+        }
+        break;
+
         default:
             DBG("%p Function not found", thrdid);
             return SA_ERR_HPI_UNSUPPORTED_API; 
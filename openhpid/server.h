@@ -22,14 +22,19 @@
 #include <strmsock.h>
 
 
+/* sockpath - unix domain socket for local clients, NULL if not used */
 bool oh_server_run( int ipvflags,
                     const char * bindaddr,
                     uint16_t port,
+                    const char * sockpath,
                     unsigned int sock_timeout,
                     int max_threads );
 
 void oh_server_request_stop( void );
 
+/* Serves oh_metrics_text() over HTTP until oh_server_request_stop() */
+bool oh_metrics_server_start( const char * bindaddr, uint16_t port );
+
 
 #endif /* __OH_SERVER_H */
 
@@ -26,6 +26,8 @@
 #include "conf.h"
 #include "event.h"
 #include "lock.h"
+#include "metrics.h"
+#include "watch.h"
 #include <sahpi_wrappers.h>
 
 struct oh_session_table oh_sessions = {
@@ -36,6 +38,262 @@ struct oh_session_table oh_sessions = {
 };
 
 
+static void unref_session(struct oh_session *session);
+
+static void unref_subscribers(struct oh_session_subscribers *subs)
+{
+        guint i;
+
+        if (!subs || !g_atomic_int_dec_and_test(&subs->refcount))
+                return;
+
+        for (i = 0; i < subs->len; i++)
+                unref_session(subs->sessions[i]);
+        g_free(subs);
+}
+
+/*
+ * Rebuilds the subscriber snapshot of domain @did. Called after
+ * a session of the domain subscribed, unsubscribed or was closed.
+ *
+ * Event processing takes a reference on the snapshot under the domain
+ * lock and walks it after releasing the lock. Publishing the new one
+ * under the domain lock means no reference to the old one can be taken
+ * afterwards; the old one is freed when its last walk drops its
+ * reference. Lock order is domain, then session table, as in
+ * oh_create_session().
+ */
+static void update_subscribers(SaHpiDomainIdT did)
+{
+        struct oh_domain *domain = NULL;
+        struct oh_session_subscribers *subs = NULL, *old = NULL;
+        GSList *node = NULL;
+        guint n = 0;
+
+        domain = oh_get_domain(did);
+        if (!domain)
+                return;
+
+        wrap_g_static_rec_mutex_lock(&oh_sessions.lock); /* Locked session table */
+        for (node = oh_sessions.list; node; node = node->next) {
+                struct oh_session *s = node->data;
+                if (s->did == domain->id && s->subscribed) n++;
+        }
+        if (n > 0) {
+                subs = g_malloc(sizeof(*subs) +
+                                (n - 1) * sizeof(subs->sessions[0]));
+                subs->len = 0;
+                subs->refcount = 1;
+                for (node = oh_sessions.list; node; node = node->next) {
+                        struct oh_session *s = node->data;
+                        if (s->did == domain->id && s->subscribed) {
+                                g_atomic_int_inc(&s->refcount);
+                                subs->sessions[subs->len++] = s;
+                        }
+                }
+        }
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
+
+        old = g_atomic_pointer_get(&domain->subscribers);
+        g_atomic_pointer_set(&domain->subscribers, subs);
+        oh_release_domain(domain);
+
+        unref_subscribers(old);
+}
+
+/* First allocation of a session's event ring, doubled as needed */
+#define EVENTQ_INITIAL_SIZE 64
+
+static void get_eventq_params(guint *limit, oh_evt_queue_policy *policy)
+{
+        struct oh_global_param param;
+
+        param.type = OPENHPI_EVT_QUEUE_LIMIT;
+        *limit = oh_get_global_param(&param) ? 0 : param.u.evt_queue_limit;
+
+        param.type = OPENHPI_EVT_QUEUE_POLICY;
+        *policy = oh_get_global_param(&param) ? OH_EVT_QUEUE_DROP_NEWEST :
+                                                param.u.evt_queue_policy;
+}
+
+/* Called with eventq_lock held or with the last reference */
+static void flush_session_events(struct oh_session *session)
+{
+        while (session->eventq_len > 0) {
+                oh_event_free(session->eventq[session->eventq_head], FALSE);
+                session->eventq_head =
+                        (session->eventq_head + 1) % session->eventq_size;
+                session->eventq_len--;
+        }
+        session->eventq_head = 0;
+}
+
+static void unref_session(struct oh_session *session)
+{
+        if (!g_atomic_int_dec_and_test(&session->refcount))
+                return;
+
+        flush_session_events(session);
+        g_free(session->eventq);
+        wrap_g_cond_free(session->eventq_cond);
+        wrap_g_mutex_free_clear(session->eventq_lock);
+        g_free(session);
+}
+
+/*
+ * Doubles the event ring, but not beyond @limit (0 is unlimited).
+ * Called with eventq_lock held.
+ */
+static SaHpiBoolT grow_session_eventq(struct oh_session *session, guint limit)
+{
+        struct oh_event **ring = NULL;
+        guint size, i;
+
+        if (limit > 0 && session->eventq_size >= limit)
+                return SAHPI_FALSE;
+
+        size = session->eventq_size ? session->eventq_size * 2 :
+                                      EVENTQ_INITIAL_SIZE;
+        if (limit > 0 && size > limit)
+                size = limit;
+
+        ring = g_new(struct oh_event *, size);
+        for (i = 0; i < session->eventq_len; i++) {
+                ring[i] = session->eventq[(session->eventq_head + i) %
+                                          session->eventq_size];
+        }
+        g_free(session->eventq);
+        session->eventq = ring;
+        session->eventq_size = size;
+        session->eventq_head = 0;
+
+        return SAHPI_TRUE;
+}
+
+/*
+ * Tells whether @b reports the state of the same resource (and sensor)
+ * as @a, so that @b can stand in for @a when coalescing.
+ */
+static SaHpiBoolT same_event_state(const SaHpiEventT *a, const SaHpiEventT *b)
+{
+        if (a->Source != b->Source || a->EventType != b->EventType)
+                return SAHPI_FALSE;
+
+        switch (a->EventType) {
+        case SAHPI_ET_SENSOR:
+                return a->EventDataUnion.SensorEvent.SensorNum ==
+                       b->EventDataUnion.SensorEvent.SensorNum;
+        case SAHPI_ET_SENSOR_ENABLE_CHANGE:
+                return a->EventDataUnion.SensorEnableChangeEvent.SensorNum ==
+                       b->EventDataUnion.SensorEnableChangeEvent.SensorNum;
+        case SAHPI_ET_HOTSWAP:
+        case SAHPI_ET_RESOURCE:
+                return SAHPI_TRUE;
+        default:
+                return SAHPI_FALSE;
+        }
+}
+
+/*
+ * Queues a copy of @event to @session. When the queue is full,
+ * @policy picks the event to drop, the overflow is flagged for
+ * the next saHpiEventGet() and the session's drop counter goes up.
+ *
+ * Returns: SA_OK if the event was queued, SA_ERR_HPI_OUT_OF_SPACE
+ * if it was dropped, SA_ERR_HPI_INVALID_REQUEST if the session is
+ * not subscribed or is closed.
+ */
+static SaErrorT push_session_event(struct oh_session *session,
+                                   struct oh_event *event,
+                                   guint limit,
+                                   oh_evt_queue_policy policy)
+{
+        struct oh_event *qevent = NULL, *dropped = NULL;
+        SaHpiBoolT overflow = SAHPI_FALSE;
+        SaHpiUint64T ndropped = 0;
+        guint i, j, slot, len = 0;
+        SaErrorT rv = SA_OK;
+
+        qevent = oh_dup_event(event);
+        if (!qevent)
+                return SA_ERR_HPI_OUT_OF_MEMORY;
+
+        wrap_g_mutex_lock(session->eventq_lock);
+        if (!session->subscribed || session->eventq_closed) {
+                wrap_g_mutex_unlock(session->eventq_lock);
+                oh_event_free(qevent, FALSE);
+                return SA_ERR_HPI_INVALID_REQUEST;
+        }
+
+        if (limit == 0 || session->eventq_len < limit) {
+                if (session->eventq_len == session->eventq_size)
+                        grow_session_eventq(session, limit);
+        } else {
+                overflow = (session->eventq_status == 0);
+                session->eventq_status = SAHPI_EVT_QUEUE_OVERFLOW;
+                session->eventq_dropped++;
+                ndropped = session->eventq_dropped;
+                len = session->eventq_len;
+
+                if (policy == OH_EVT_QUEUE_COALESCE) {
+                        /*
+                         * Newest first, hot sensors are found quickly.
+                         * The stale event is taken out and the later
+                         * ones move up, so @event still goes to the
+                         * tail and the queue stays in FIFO order.
+                         */
+                        for (i = session->eventq_len; i > 0; i--) {
+                                slot = (session->eventq_head + i - 1) %
+                                       session->eventq_size;
+                                if (!same_event_state(&session->eventq[slot]->event,
+                                                      &event->event))
+                                        continue;
+                                dropped = session->eventq[slot];
+                                for (j = i; j < session->eventq_len; j++) {
+                                        session->eventq[slot] =
+                                                session->eventq[(slot + 1) %
+                                                        session->eventq_size];
+                                        slot = (slot + 1) %
+                                               session->eventq_size;
+                                }
+                                session->eventq_len--;
+                                break;
+                        }
+                }
+                if (!dropped && policy != OH_EVT_QUEUE_DROP_NEWEST) {
+                        dropped = session->eventq[session->eventq_head];
+                        session->eventq_head = (session->eventq_head + 1) %
+                                               session->eventq_size;
+                        session->eventq_len--;
+                } else if (!dropped) {
+                        dropped = qevent;
+                        qevent = NULL;
+                        rv = SA_ERR_HPI_OUT_OF_SPACE;
+                }
+        }
+
+        if (qevent) {
+                slot = (session->eventq_head + session->eventq_len) %
+                       session->eventq_size;
+                session->eventq[slot] = qevent;
+                session->eventq_len++;
+                g_cond_signal(session->eventq_cond);
+        }
+        wrap_g_mutex_unlock(session->eventq_lock);
+
+        oh_event_free(dropped, FALSE);
+        if (dropped) {
+                oh_metrics_event_dropped();
+        }
+        if (overflow) {
+                CRIT("Session %d's queue is out of space; "
+                    "# of events is %u; Max is %u; %llu events dropped",
+                    session->id, len, limit, (unsigned long long)ndropped);
+        }
+
+        return rv;
+}
+
 /**
  * oh_create_session
  * @did:
@@ -58,13 +316,14 @@ SaHpiSessionIdT oh_create_session(SaHpiDomainIdT did)
                 return 0;
 
         session->did = did;
-        session->eventq = g_async_queue_new();
+        session->eventq_lock = wrap_g_mutex_new_init();
+        session->eventq_cond = wrap_g_cond_new_init();
         session->subscribed = SAHPI_FALSE;
+        session->refcount = 1;
 
         domain = oh_get_domain(did);
         if (!domain) {
-                g_async_queue_unref(session->eventq);
-                g_free(session);
+                unref_session(session);
                 return 0;
         }
         wrap_g_static_rec_mutex_lock(&oh_sessions.lock); /* Locked session table */
@@ -190,7 +449,7 @@ SaErrorT oh_get_session_subscription(SaHpiSessionIdT sid,
 SaErrorT oh_set_session_subscription(SaHpiSessionIdT sid, SaHpiBoolT state)
 {
         struct oh_session *session = NULL;
-        struct oh_event e;
+        SaHpiDomainIdT did;
 
         if (sid < 1)
                 return SA_ERR_HPI_INVALID_PARAMS;
@@ -201,18 +460,21 @@ SaErrorT oh_set_session_subscription(SaHpiSessionIdT sid, SaHpiBoolT state)
                wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
                 return SA_ERR_HPI_INVALID_SESSION;
         }
-        session->subscribed = state;
 
-        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
-        /* Flush session's event queue
+        /* Flush session's event queue and wake up its waiters
          */
+        wrap_g_mutex_lock(session->eventq_lock);
+        session->subscribed = state;
         if (state == SAHPI_FALSE) {
-                while (oh_dequeue_session_event(sid,
-                                                SAHPI_TIMEOUT_IMMEDIATE,
-                                                &e, NULL) == SA_OK) {
-			oh_event_free(&e, TRUE);
-		}
+                flush_session_events(session);
+                g_cond_broadcast(session->eventq_cond);
         }
+        wrap_g_mutex_unlock(session->eventq_lock);
+        did = session->did;
+
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
+        update_subscribers(did);
+
         return SA_OK;
 }
 
@@ -229,49 +491,88 @@ SaErrorT oh_queue_session_event(SaHpiSessionIdT sid,
                                 struct oh_event * event)
 {
         struct oh_session *session = NULL;
-        struct oh_event *qevent = NULL;
-        struct oh_global_param param = {.type = OPENHPI_EVT_QUEUE_LIMIT };
-        SaHpiBoolT nolimit = SAHPI_FALSE;
+        oh_evt_queue_policy policy;
+        guint limit;
+        SaErrorT rv;
 
         if (sid < 1 || !event)
                 return SA_ERR_HPI_INVALID_PARAMS;
 
-        qevent = oh_dup_event(event);
-        if (!qevent)
-                return SA_ERR_HPI_OUT_OF_MEMORY;
-
-        if (oh_get_global_param(&param)) {
-                nolimit = SAHPI_TRUE;
-        }
+        get_eventq_params(&limit, &policy);
 
         wrap_g_static_rec_mutex_lock(&oh_sessions.lock); /* Locked session table */
         session = g_hash_table_lookup(oh_sessions.table, &sid);
         if (!session) {
                 wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
-                oh_event_free(qevent, FALSE);
                 return SA_ERR_HPI_INVALID_SESSION;
         }
+        rv = push_session_event(session, event, limit, policy);
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
 
-        if (nolimit == SAHPI_FALSE) {
-                SaHpiSessionIdT tmp_sid;
-                tmp_sid = session->id;
-                gint qlength = g_async_queue_length(session->eventq);
-                if (qlength > 0 && qlength >= param.u.evt_queue_limit) {
-                        /* Don't proceed with event push if queue is overflowed */
-                        session->eventq_status = SAHPI_EVT_QUEUE_OVERFLOW;
-                        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
-                        oh_event_free(qevent, FALSE);
-                        CRIT("Session %d's queue is out of space; "
-                            "# of events is %d; Max is %d",
-                            tmp_sid, qlength, param.u.evt_queue_limit);
-                        return SA_ERR_HPI_OUT_OF_SPACE;
-                }
-        }
+        return rv;
+}
 
-        g_async_queue_push(session->eventq, qevent);
-        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
+/**
+ * oh_get_domain_subscribers
+ * @d: domain, locked by the caller
+ *
+ * Returns: a reference to the snapshot of the sessions subscribed to
+ * domain @d, or NULL if there are none. The snapshot and its sessions
+ * stay valid after the domain is unlocked until the reference is given
+ * back with oh_release_subscribers().
+ **/
+struct oh_session_subscribers *oh_get_domain_subscribers(struct oh_domain *d)
+{
+        struct oh_session_subscribers *subs = NULL;
 
-        return SA_OK;
+        if (!d)
+                return NULL;
+
+        subs = g_atomic_pointer_get(&d->subscribers);
+        if (subs)
+                g_atomic_int_inc(&subs->refcount);
+
+        return subs;
+}
+
+/**
+ * oh_release_subscribers
+ * @subs: snapshot obtained with oh_get_domain_subscribers()
+ **/
+void oh_release_subscribers(struct oh_session_subscribers *subs)
+{
+        unref_subscribers(subs);
+}
+
+/**
+ * oh_queue_subscribers_event
+ * @subs: snapshot obtained with oh_get_domain_subscribers()
+ * @event: event to queue
+ *
+ * Queues a copy of @event to every session in @subs. Needs neither
+ * the domain lock nor the session table lock, so event processing
+ * workers fan out in parallel.
+ *
+ * Returns: number of sessions the event was queued to.
+ **/
+guint oh_queue_subscribers_event(struct oh_session_subscribers *subs,
+                                 struct oh_event *event)
+{
+        oh_evt_queue_policy policy;
+        guint i, limit, n = 0;
+
+        if (!subs || !event)
+                return 0;
+
+        get_eventq_params(&limit, &policy);
+
+        for (i = 0; i < subs->len; i++) {
+                if (push_session_event(subs->sessions[i], event,
+                                       limit, policy) == SA_OK)
+                        n++;
+        }
+
+        return n;
 }
 
 /**
@@ -279,7 +580,8 @@ SaErrorT oh_queue_session_event(SaHpiSessionIdT sid,
  * @sid:
  * @event:
  *
- *
+ * Waits on the session's event queue until an event arrives, the
+ * timeout expires, or the session is unsubscribed or closed.
  *
  * Returns:
  **/
@@ -290,9 +592,12 @@ SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
 {
         struct oh_session *session = NULL;
         struct oh_event *devent = NULL;
-        GAsyncQueue *eventq = NULL;
-        SaHpiBoolT subscribed;
-        SaErrorT invalid;
+        SaErrorT rv = SA_OK;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+        gint64 gfinaltime = 0;
+#else
+        GTimeVal gfinaltime;
+#endif
 
         if (sid < 1 || (event == NULL))
                 return SA_ERR_HPI_INVALID_PARAMS;
@@ -303,62 +608,59 @@ SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
                 wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
                 return SA_ERR_HPI_INVALID_SESSION;
         }
+        g_atomic_int_inc(&session->refcount);
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
 
-        if (eventq_status) {
-                *eventq_status = session->eventq_status;
+        if (timeout != SAHPI_TIMEOUT_IMMEDIATE &&
+            timeout != SAHPI_TIMEOUT_BLOCK) {
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                gfinaltime = g_get_monotonic_time() + timeout / 1000;
+#else
+                g_get_current_time(&gfinaltime);
+                g_time_val_add(&gfinaltime, (glong) (timeout / 1000));
+#endif
         }
-        session->eventq_status = 0;
-        eventq = session->eventq;
-        g_async_queue_ref(eventq);
-        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
 
-        if (timeout == SAHPI_TIMEOUT_IMMEDIATE) {
-                devent = g_async_queue_try_pop(eventq);
-        } else if (timeout == SAHPI_TIMEOUT_BLOCK) {
-                while (devent == NULL) {
-                        #if GLIB_CHECK_VERSION (2, 32, 0)
-                        guint64 gfinaltime;
-                        gfinaltime = (guint64) 5000000L;
-                        devent =
-                            wrap_g_async_queue_timed_pop(eventq, gfinaltime);
-                        #else
-                        GTimeVal gfinaltime;
-                        g_get_current_time(&gfinaltime);
-                        g_time_val_add(&gfinaltime, 5000000L);
-                        devent =
-                            wrap_g_async_queue_timed_pop(eventq, &gfinaltime);
-                        #endif
-                        /* compliance with spec page 63 */
-                        invalid =
-                            oh_get_session_subscription(sid, &subscribed);
-                        /* Is the session still open? or still subscribed? */
-                        if (invalid || !subscribed) {
-                                g_async_queue_unref(eventq);
-                                oh_event_free(devent, FALSE);
-                                return invalid ? SA_ERR_HPI_INVALID_SESSION
-                                    : SA_ERR_HPI_INVALID_REQUEST;
+        wrap_g_mutex_lock(session->eventq_lock);
+        if (timeout != SAHPI_TIMEOUT_IMMEDIATE) {
+                while (session->eventq_len == 0 &&
+                       session->subscribed && !session->eventq_closed) {
+                        if (timeout == SAHPI_TIMEOUT_BLOCK) {
+                                g_cond_wait(session->eventq_cond,
+                                            session->eventq_lock);
+                        } else if (!wrap_g_cond_timed_wait(session->eventq_cond,
+                                                           session->eventq_lock,
+#if GLIB_CHECK_VERSION (2, 32, 0)
+                                                           gfinaltime)) {
+#else
+                                                           &gfinaltime)) {
+#endif
+                                break;
                         }
                 }
-        } else {
-                #if GLIB_CHECK_VERSION (2, 32, 0)
-                guint64 gfinaltime;
-                gfinaltime = (guint64) (timeout / 1000);
-                devent = wrap_g_async_queue_timed_pop(eventq, gfinaltime);
-                #else
-                GTimeVal gfinaltime;
-                g_get_current_time(&gfinaltime);
-                g_time_val_add(&gfinaltime, (glong) (timeout / 1000));
-                devent = wrap_g_async_queue_timed_pop(eventq, &gfinaltime);
-                #endif
-                invalid = oh_get_session_subscription(sid, &subscribed);
-                if (invalid || !subscribed) {
-                        g_async_queue_unref(eventq);
-                        oh_event_free(devent, FALSE);
-                        return invalid ? SA_ERR_HPI_INVALID_SESSION :
-                            SA_ERR_HPI_INVALID_REQUEST;
+                /* compliance with spec page 63 */
+                if (session->eventq_closed) {
+                        rv = SA_ERR_HPI_INVALID_SESSION;
+                } else if (!session->subscribed) {
+                        rv = SA_ERR_HPI_INVALID_REQUEST;
                 }
         }
-        g_async_queue_unref(eventq);
+        if (rv == SA_OK && session->eventq_len > 0) {
+                devent = session->eventq[session->eventq_head];
+                session->eventq_head = (session->eventq_head + 1) %
+                                       session->eventq_size;
+                session->eventq_len--;
+        }
+        if (eventq_status) {
+                *eventq_status = session->eventq_status;
+        }
+        session->eventq_status = 0;
+        wrap_g_mutex_unlock(session->eventq_lock);
+        unref_session(session);
+
+        if (rv != SA_OK) {
+                return rv;
+        }
 
         if (devent) {
                 int cc;
@@ -369,7 +671,10 @@ SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
                         return SA_ERR_HPI_NO_RESPONSE;
                 }
                 memcpy(event, devent, sizeof(struct oh_event));
-                g_free(devent);
+                /* The RDRs now belong to @event */
+                devent->rdrs = NULL;
+                devent->rdrs_to_remove = NULL;
+                oh_event_free(devent, FALSE);
                 return SA_OK;
         } else {
                 memset(event, 0, sizeof(struct oh_event));
@@ -377,6 +682,66 @@ SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
         }
 }
 
+/**
+ * oh_get_session_queue_stats
+ * @sid: session id
+ * @len: number of events queued, may be NULL
+ * @dropped: number of events lost to queue overflow, may be NULL
+ *
+ * Returns: SA_OK, or SA_ERR_HPI_INVALID_SESSION if @sid is unknown.
+ **/
+SaErrorT oh_get_session_queue_stats(SaHpiSessionIdT sid,
+                                    guint *len,
+                                    SaHpiUint64T *dropped)
+{
+        struct oh_session *session = NULL;
+
+        if (sid < 1)
+                return SA_ERR_HPI_INVALID_SESSION;
+
+        wrap_g_static_rec_mutex_lock(&oh_sessions.lock); /* Locked session table */
+        session = g_hash_table_lookup(oh_sessions.table, &sid);
+        if (!session) {
+                wrap_g_static_rec_mutex_unlock(&oh_sessions.lock);
+                return SA_ERR_HPI_INVALID_SESSION;
+        }
+        wrap_g_mutex_lock(session->eventq_lock);
+        if (len) *len = session->eventq_len;
+        if (dropped) *dropped = session->eventq_dropped;
+        wrap_g_mutex_unlock(session->eventq_lock);
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
+
+        return SA_OK;
+}
+
+/**
+ * oh_get_sessions_stats
+ * @sessions: number of open sessions
+ * @queued: number of events queued in all sessions
+ * @max_queued: number of events in the fullest session queue
+ *
+ * Returns: nothing.
+ **/
+void oh_get_sessions_stats(guint *sessions, guint *queued, guint *max_queued)
+{
+        GSList *node = NULL;
+        guint len;
+
+        *sessions = *queued = *max_queued = 0;
+
+        wrap_g_static_rec_mutex_lock(&oh_sessions.lock); /* Locked session table */
+        for (node = oh_sessions.list; node; node = node->next) {
+                struct oh_session *s = node->data;
+                wrap_g_mutex_lock(s->eventq_lock);
+                len = s->eventq_len;
+                wrap_g_mutex_unlock(s->eventq_lock);
+                (*sessions)++;
+                *queued += len;
+                if (len > *max_queued) *max_queued = len;
+        }
+        wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
+}
+
 /**
  * oh_destroy_session
  * @sid:
@@ -388,8 +753,6 @@ SaErrorT oh_dequeue_session_event(SaHpiSessionIdT sid,
 SaErrorT oh_destroy_session(SaHpiSessionIdT sid)
 {
         struct oh_session *session = NULL;
-        gpointer event = NULL;
-        int i, len;
 
         if (sid < 1)
                 return SA_ERR_HPI_INVALID_PARAMS;
@@ -404,18 +767,19 @@ SaErrorT oh_destroy_session(SaHpiSessionIdT sid)
         g_hash_table_remove(oh_sessions.table, &(session->id));
         wrap_g_static_rec_mutex_unlock(&oh_sessions.lock); /* Unlocked session table */
 
-        /* Finalize session */
-        len = g_async_queue_length(session->eventq);
-        if (len > 0) {
-                for (i = 0; i < len; i++) {
-                        event = g_async_queue_try_pop(session->eventq);
-                        if (event)
-                                oh_event_free(event, FALSE);
-                        event = NULL;
-                }
-        }
-        g_async_queue_unref(session->eventq);
-        g_free(session);
+        oh_watch_remove_session(sid);
+
+        /* Snapshots still in use by event processing keep a reference */
+        if (session->subscribed)
+                update_subscribers(session->did);
+
+        /* Wake up waiters, the last one out frees the session */
+        wrap_g_mutex_lock(session->eventq_lock);
+        session->eventq_closed = SAHPI_TRUE;
+        flush_session_events(session);
+        g_cond_broadcast(session->eventq_cond);
+        wrap_g_mutex_unlock(session->eventq_lock);
+        unref_session(session);
 
         return SA_OK;
 }
@@ -0,0 +1,772 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <oHpi.h>
+#include <oh_domain.h>
+#include <oh_error.h>
+#include <oh_plugin.h>
+#include <oh_utils.h>
+#include <sahpi_wrappers.h>
+
+#include "conf.h"
+#include "event.h"
+#include "snapshot.h"
+
+#define OH_SNAPSHOT_MAGIC    0x4F485250 /* "OHRP" */
+#define OH_SNAPSHOT_VERSION  1
+#define OH_SNAPSHOT_KEY_MAX  256
+
+/*
+ * The snapshot file holds the header, header.handlers handler records
+ * and then, up to the end of the file, a resource record followed by
+ * its RDRs for each resource. Records are written as they are in
+ * memory, so a snapshot of another build is recognized by the sizes in
+ * the header and ignored.
+ */
+struct snapshot_header {
+        SaHpiUint32T magic;
+        SaHpiUint32T version;
+        SaHpiUint32T rpte_size;
+        SaHpiUint32T rdr_size;
+        SaHpiUint32T handlers;
+        SaHpiUint32T reserved;
+        SaHpiTimeT timestamp;
+};
+
+struct snapshot_handler {
+        SaHpiUint32T hid;
+        char key[OH_SNAPSHOT_KEY_MAX]; /* Plugin name and entity root */
+};
+
+struct snapshot_resource {
+        SaHpiUint32T hid;
+        SaHpiUint32T rdrs;
+        SaHpiRptEntryT entry;
+};
+
+/* A restored resource its handler did not report yet */
+struct restored {
+        SaHpiDomainIdT did;
+        unsigned int hid;
+};
+
+/* rid -> struct restored */
+static GHashTable *restored = NULL;
+static gint restored_count = 0;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex restored_lock;
+#else
+static GStaticMutex restored_lock = G_STATIC_MUTEX_INIT;
+#endif
+
+/* did -> RPT signature of the last save, see rpt_signature() */
+static GHashTable *saved = NULL;
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex save_lock;
+#else
+static GStaticMutex save_lock = G_STATIC_MUTEX_INIT;
+#endif
+
+static SaHpiBoolT snapshot_enabled(void)
+{
+        struct oh_global_param param;
+
+        oh_get_global_param2(OPENHPI_RPT_SAVE, &param);
+
+        return param.u.rpt_save;
+}
+
+static gchar *snapshot_file(SaHpiDomainIdT did)
+{
+        struct oh_global_param param;
+
+        oh_get_global_param2(OPENHPI_VARPATH, &param);
+
+        return g_strdup_printf("%s/rpt.%u", param.u.varpath, did);
+}
+
+/**
+ * oh_snapshot_interval
+ *
+ * Returns: msec between two snapshots, 0 if they are only saved on
+ * shutdown or OPENHPI_RPT_SAVE is off.
+ **/
+guint oh_snapshot_interval(void)
+{
+        struct oh_global_param param;
+
+        if (!snapshot_enabled())
+                return 0;
+
+        oh_get_global_param2(OPENHPI_RPT_SAVE_INTERVAL, &param);
+
+        return param.u.rpt_save_interval;
+}
+
+/* A handler owns the same resources after a restart if it has the same
+   id, plugin and entity root */
+static GArray *get_handlers(void)
+{
+        GArray *handlers;
+        struct snapshot_handler sh;
+        struct oh_handler *h;
+        const char *root;
+        GSList *node;
+
+        handlers = g_array_new(FALSE, TRUE, sizeof(struct snapshot_handler));
+
+        wrap_g_static_rec_mutex_lock(&oh_handlers.lock);
+        for (node = oh_handlers.list; node; node = node->next) {
+                h = (struct oh_handler *)node->data;
+                root = NULL;
+                if (h->config)
+                        root = (const char *)g_hash_table_lookup(h->config,
+                                                                 "entity_root");
+                memset(&sh, 0, sizeof(sh));
+                sh.hid = h->id;
+                snprintf(sh.key, OH_SNAPSHOT_KEY_MAX, "%s %s",
+                         h->plugin_name ? h->plugin_name : "",
+                         root ? root : "");
+                g_array_append_val(handlers, sh);
+        }
+        wrap_g_static_rec_mutex_unlock(&oh_handlers.lock);
+
+        return handlers;
+}
+
+static GArray *get_domain_ids(void)
+{
+        GArray *ids = g_array_new(FALSE, TRUE, sizeof(SaHpiDomainIdT));
+        GList *node;
+
+        wrap_g_static_rec_mutex_lock(&oh_domains.lock);
+        for (node = oh_domains.list; node; node = node->next) {
+                struct oh_domain *d = (struct oh_domain *)node->data;
+                g_array_append_val(ids, d->id);
+        }
+        wrap_g_static_rec_mutex_unlock(&oh_domains.lock);
+
+        return ids;
+}
+
+/*
+ * Changes whenever the RPT changes: the RPT update count goes up with
+ * every resource added, updated or removed, and the RDR update counts
+ * of the resources with every RDR change.
+ */
+static guint64 rpt_signature(RPTable *rpt)
+{
+        SaHpiRptEntryT *rpte;
+        SaHpiUint32T count;
+        guint64 sig = (guint64)rpt->update_count << 32;
+
+        for (rpte = oh_get_resource_by_id(rpt, SAHPI_FIRST_ENTRY);
+             rpte;
+             rpte = oh_get_resource_next(rpt, rpte->ResourceId)) {
+                if (oh_get_rdr_update_count(rpt, rpte->ResourceId,
+                                            &count) == SA_OK)
+                        sig += count;
+        }
+
+        return sig;
+}
+
+static int sync_file(FILE *fp)
+{
+        if (fflush(fp) != 0) {
+                return -1;
+        }
+#ifdef _WIN32
+        if (_commit(_fileno(fp)) != 0) {
+                return -1;
+        }
+#else
+        if (fsync(fileno(fp)) != 0) {
+                return -1;
+        }
+#endif
+        return 0;
+}
+
+static int write_resources(FILE *fp, struct oh_domain *d)
+{
+        struct snapshot_resource sr;
+        SaHpiRptEntryT *rpte;
+        SaHpiRdrT *rdr;
+        unsigned int *hidp;
+        GSList *rdrs, *node;
+        int err = 0;
+
+        for (rpte = oh_get_resource_by_id(&d->rpt, SAHPI_FIRST_ENTRY);
+             rpte && !err;
+             rpte = oh_get_resource_next(&d->rpt, rpte->ResourceId)) {
+                rdrs = NULL;
+                for (rdr = oh_get_rdr_by_id(&d->rpt, rpte->ResourceId,
+                                            SAHPI_FIRST_ENTRY);
+                     rdr;
+                     rdr = oh_get_rdr_next(&d->rpt, rpte->ResourceId,
+                                           rdr->RecordId)) {
+                        rdrs = g_slist_prepend(rdrs, rdr);
+                }
+                rdrs = g_slist_reverse(rdrs);
+
+                hidp = (unsigned int *)oh_get_resource_data(&d->rpt,
+                                                            rpte->ResourceId);
+                memset(&sr, 0, sizeof(sr));
+                sr.hid = hidp ? *hidp : 0;
+                sr.rdrs = g_slist_length(rdrs);
+                sr.entry = *rpte;
+                if (fwrite(&sr, sizeof(sr), 1, fp) != 1)
+                        err = 1;
+                for (node = rdrs; node && !err; node = node->next) {
+                        if (fwrite(node->data, sizeof(SaHpiRdrT), 1, fp) != 1)
+                                err = 1;
+                }
+                g_slist_free(rdrs);
+
+                /* Compact RDR copies are only referenced by us if we hold
+                   the only domain lock, so do not pile them all up */
+                if (d->lock_depth == 1)
+                        oh_release_rdr_views(&d->rpt);
+        }
+
+        return err;
+}
+
+/*
+ * Like the uid map, the snapshot is written to a temporary file that
+ * replaces the old one, so a crash never leaves half a snapshot behind.
+ * Called with save_lock held.
+ */
+static SaErrorT save_domain(SaHpiDomainIdT did, GArray *handlers)
+{
+        struct oh_domain *d;
+        struct snapshot_header hdr;
+        guint64 sig, *last;
+        gchar *file, *tmp_file;
+        FILE *fp;
+        int err = 0;
+
+        d = oh_get_domain(did);
+        if (!d)
+                return SA_ERR_HPI_NOT_PRESENT;
+
+        sig = rpt_signature(&d->rpt);
+        last = saved ? g_hash_table_lookup(saved, GUINT_TO_POINTER(did)) : NULL;
+        if (last && *last == sig) {
+                oh_release_domain(d);
+                return SA_OK;
+        }
+
+        file = snapshot_file(did);
+        tmp_file = g_strconcat(file, ".tmp", NULL);
+        fp = fopen(tmp_file, "wb");
+        if (!fp) {
+                oh_release_domain(d);
+                CRIT("RPT snapshot file '%s' could not be opened", tmp_file);
+                g_free(tmp_file);
+                g_free(file);
+                return SA_ERR_HPI_ERROR;
+        }
+
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic = OH_SNAPSHOT_MAGIC;
+        hdr.version = OH_SNAPSHOT_VERSION;
+        hdr.rpte_size = sizeof(SaHpiRptEntryT);
+        hdr.rdr_size = sizeof(SaHpiRdrT);
+        hdr.handlers = handlers->len;
+        oh_gettimeofday(&hdr.timestamp);
+
+        if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+            fwrite(handlers->data, sizeof(struct snapshot_handler),
+                   handlers->len, fp) != handlers->len) {
+                err = 1;
+        }
+        if (!err)
+                err = write_resources(fp, d);
+        oh_release_domain(d);
+
+        /* The disk is slow, do not hold the domain for it */
+        if (!err)
+                err = sync_file(fp);
+        if (fclose(fp) != 0)
+                err = 1;
+        if (!err) {
+#ifdef _WIN32
+                /* rename() does not replace an existing file on Windows */
+                remove(file);
+#endif
+                if (rename(tmp_file, file) != 0)
+                        err = 1;
+        }
+
+        if (err) {
+                CRIT("Couldn't write RPT snapshot file '%s'", file);
+                remove(tmp_file);
+        } else {
+                if (!saved)
+                        saved = g_hash_table_new_full(g_direct_hash,
+                                                      g_direct_equal,
+                                                      NULL, g_free);
+                last = g_new(guint64, 1);
+                *last = sig;
+                g_hash_table_insert(saved, GUINT_TO_POINTER(did), last);
+        }
+
+        g_free(tmp_file);
+        g_free(file);
+
+        return err ? SA_ERR_HPI_ERROR : SA_OK;
+}
+
+/**
+ * oh_snapshot_save
+ *
+ * Saves the RPT of each domain that changed since its last save.
+ * Does nothing unless OPENHPI_RPT_SAVE is on.
+ *
+ * Returns: SA_OK, or SA_ERR_HPI_ERROR if a snapshot could not be written.
+ **/
+SaErrorT oh_snapshot_save(void)
+{
+        GArray *handlers, *ids;
+        SaErrorT rv = SA_OK;
+        guint i;
+
+        if (!snapshot_enabled())
+                return SA_OK;
+
+        /* Resource ids are only restored if the uid map still has them */
+        oh_uid_map_flush();
+
+        handlers = get_handlers();
+        ids = get_domain_ids();
+
+        wrap_g_static_mutex_lock(&save_lock);
+        for (i = 0; i < ids->len; i++) {
+                if (save_domain(g_array_index(ids, SaHpiDomainIdT, i),
+                                handlers) != SA_OK)
+                        rv = SA_ERR_HPI_ERROR;
+        }
+        wrap_g_static_mutex_unlock(&save_lock);
+
+        g_array_free(ids, TRUE);
+        g_array_free(handlers, TRUE);
+
+        return rv;
+}
+
+static SaHpiBoolT same_handler(const struct snapshot_handler *sh,
+                               GArray *handlers)
+{
+        const struct snapshot_handler *cur;
+        guint i;
+
+        for (i = 0; i < handlers->len; i++) {
+                cur = &g_array_index(handlers, struct snapshot_handler, i);
+                if (cur->hid == sh->hid)
+                        return strncmp(cur->key, sh->key,
+                                       OH_SNAPSHOT_KEY_MAX) == 0;
+        }
+
+        return SAHPI_FALSE;
+}
+
+static void add_restored(SaHpiDomainIdT did, SaHpiResourceIdT rid,
+                         unsigned int hid)
+{
+        struct restored *r = g_new0(struct restored, 1);
+
+        r->did = did;
+        r->hid = hid;
+
+        wrap_g_static_mutex_lock(&restored_lock);
+        if (!restored)
+                restored = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                 NULL, g_free);
+        if (!g_hash_table_lookup(restored, GUINT_TO_POINTER(rid)))
+                g_atomic_int_inc(&restored_count);
+        g_hash_table_insert(restored, GUINT_TO_POINTER(rid), r);
+        wrap_g_static_mutex_unlock(&restored_lock);
+}
+
+static SaErrorT load_domain(SaHpiDomainIdT did, GArray *handlers)
+{
+        struct oh_domain *d;
+        struct snapshot_header hdr;
+        struct snapshot_handler sh;
+        struct snapshot_resource sr;
+        SaHpiRdrT rdr;
+        GHashTable *owners;
+        unsigned int *hidp;
+        gchar *file, *data = NULL;
+        gsize len = 0, pos, rdrpos;
+        guint i, n = 0, skipped = 0;
+
+        file = snapshot_file(did);
+        if (!g_file_get_contents(file, &data, &len, NULL)) {
+                DBG("No RPT snapshot '%s'", file);
+                g_free(file);
+                return SA_OK;
+        }
+
+        memset(&hdr, 0, sizeof(hdr));
+        if (len >= sizeof(hdr))
+                memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.magic != OH_SNAPSHOT_MAGIC ||
+            hdr.version != OH_SNAPSHOT_VERSION ||
+            hdr.rpte_size != sizeof(SaHpiRptEntryT) ||
+            hdr.rdr_size != sizeof(SaHpiRdrT) ||
+            (len - sizeof(hdr)) / sizeof(sh) < hdr.handlers) {
+                WARN("Ignoring RPT snapshot '%s' of another format", file);
+                g_free(data);
+                g_free(file);
+                return SA_ERR_HPI_INVALID_DATA;
+        }
+        pos = sizeof(hdr);
+
+        /* hid -> 1 for the handlers that are still the same */
+        owners = g_hash_table_new(g_direct_hash, g_direct_equal);
+        for (i = 0; i < hdr.handlers; i++, pos += sizeof(sh)) {
+                memcpy(&sh, data + pos, sizeof(sh));
+                sh.key[OH_SNAPSHOT_KEY_MAX - 1] = '\0';
+                if (same_handler(&sh, handlers))
+                        g_hash_table_insert(owners, GUINT_TO_POINTER(sh.hid),
+                                            GUINT_TO_POINTER(1));
+        }
+
+        d = oh_get_domain(did);
+        if (!d) {
+                g_hash_table_destroy(owners);
+                g_free(data);
+                g_free(file);
+                return SA_ERR_HPI_NOT_PRESENT;
+        }
+
+        while (len - pos >= sizeof(sr)) {
+                memcpy(&sr, data + pos, sizeof(sr));
+                pos += sizeof(sr);
+                if (sr.rdrs > (len - pos) / sizeof(SaHpiRdrT)) {
+                        WARN("Ignoring truncated resource in '%s'", file);
+                        break;
+                }
+                rdrpos = pos;
+                pos += (gsize)sr.rdrs * sizeof(SaHpiRdrT);
+
+                /* Another handler or resource id now, or already there */
+                if (!g_hash_table_lookup(owners, GUINT_TO_POINTER(sr.hid)) ||
+                    oh_uid_lookup(&sr.entry.ResourceEntity) != sr.entry.ResourceId ||
+                    oh_get_resource_by_id(&d->rpt, sr.entry.ResourceId)) {
+                        skipped++;
+                        continue;
+                }
+
+                hidp = g_new0(unsigned int, 1);
+                *hidp = sr.hid;
+                if (oh_add_resource(&d->rpt, &sr.entry, hidp,
+                                    FREE_RPT_DATA) != SA_OK) {
+                        g_free(hidp);
+                        skipped++;
+                        continue;
+                }
+                for (i = 0; i < sr.rdrs; i++) {
+                        memcpy(&rdr, data + rdrpos + i * sizeof(SaHpiRdrT),
+                               sizeof(SaHpiRdrT));
+                        oh_add_rdr(&d->rpt, sr.entry.ResourceId, &rdr, NULL, 0);
+                }
+                add_restored(did, sr.entry.ResourceId, sr.hid);
+                n++;
+        }
+        oh_release_domain(d);
+
+        INFO("Restored %u resources of domain %u from '%s'.", n, did, file);
+        if (skipped)
+                INFO("Skipped %u resources of changed handlers.", skipped);
+
+        g_hash_table_destroy(owners);
+        g_free(data);
+        g_free(file);
+
+        return SA_OK;
+}
+
+/**
+ * oh_snapshot_load
+ *
+ * Restores the RPT of each domain from its snapshot. Has to be called
+ * after the handlers are created and before the events are processed.
+ * Does nothing unless OPENHPI_RPT_SAVE is on.
+ *
+ * Returns: SA_OK, or an error if a snapshot could not be used.
+ **/
+SaErrorT oh_snapshot_load(void)
+{
+        GArray *handlers, *ids;
+        SaErrorT rv = SA_OK;
+        guint i;
+
+        if (!snapshot_enabled())
+                return SA_OK;
+
+        handlers = get_handlers();
+        ids = get_domain_ids();
+
+        for (i = 0; i < ids->len; i++) {
+                if (load_domain(g_array_index(ids, SaHpiDomainIdT, i),
+                                handlers) != SA_OK)
+                        rv = SA_ERR_HPI_ERROR;
+        }
+
+        g_array_free(ids, TRUE);
+        g_array_free(handlers, TRUE);
+
+        return rv;
+}
+
+/**
+ * oh_snapshot_finit
+ *
+ * Forgets the restored resources and the state of the last saves.
+ **/
+void oh_snapshot_finit(void)
+{
+        wrap_g_static_mutex_lock(&restored_lock);
+        if (restored)
+                g_hash_table_destroy(restored);
+        restored = NULL;
+        g_atomic_int_set(&restored_count, 0);
+        wrap_g_static_mutex_unlock(&restored_lock);
+
+        wrap_g_static_mutex_lock(&save_lock);
+        if (saved)
+                g_hash_table_destroy(saved);
+        saved = NULL;
+        wrap_g_static_mutex_unlock(&save_lock);
+}
+
+/* Events that carry the whole resource with its RDRs */
+static SaHpiBoolT carries_resource(struct oh_event *e)
+{
+        SaHpiResourceEventTypeT type;
+
+        if (e->event.EventType == SAHPI_ET_HOTSWAP) {
+                return e->event.EventDataUnion.HotSwapEvent.HotSwapState !=
+                       SAHPI_HS_STATE_NOT_PRESENT;
+        }
+
+        type = e->event.EventDataUnion.ResourceEvent.ResourceEventType;
+        return e->event.EventType == SAHPI_ET_RESOURCE &&
+               (type == SAHPI_RESE_RESOURCE_ADDED ||
+                type == SAHPI_RESE_RESOURCE_UPDATED);
+}
+
+/* Same comparison as rpt_diff(), the ids are set as oh_add_*() does */
+static SaHpiBoolT same_resource(RPTable *rpt, struct oh_event *e)
+{
+        SaHpiResourceIdT rid = e->resource.ResourceId;
+        SaHpiRptEntryT *rpte, entry;
+        SaHpiRdrT *rdr, tmp;
+        GSList *node;
+        guint n = 0;
+
+        rpte = oh_get_resource_by_id(rpt, rid);
+        if (!rpte || e->rdrs_to_remove)
+                return SAHPI_FALSE;
+
+        entry = e->resource;
+        entry.EntryId = entry.ResourceId;
+        if (memcmp(&entry, rpte, sizeof(SaHpiRptEntryT)))
+                return SAHPI_FALSE;
+
+        for (node = e->rdrs; node; node = node->next) {
+                tmp = *(SaHpiRdrT *)node->data;
+                tmp.RecordId = oh_get_rdr_uid(tmp.RdrType,
+                                              oh_get_instrument_id(&tmp));
+                rdr = oh_get_rdr_by_id(rpt, rid, tmp.RecordId);
+                if (!rdr || memcmp(rdr, &tmp, sizeof(SaHpiRdrT)))
+                        return SAHPI_FALSE;
+                n++;
+        }
+
+        for (rdr = oh_get_rdr_by_id(rpt, rid, SAHPI_FIRST_ENTRY);
+             rdr;
+             rdr = oh_get_rdr_next(rpt, rid, rdr->RecordId)) {
+                if (n-- == 0)
+                        return SAHPI_FALSE;
+        }
+
+        return n == 0;
+}
+
+/**
+ * oh_snapshot_confirm
+ * @d: domain the event is processed for, locked
+ * @e: resource or hotswap event
+ *
+ * The first event about a restored resource takes it off the restored
+ * list. If the event brings the resource with other data or from
+ * another handler, the restored copy is removed first, so the event
+ * is processed as for a new resource and an added resource event
+ * goes out as an updated one.
+ *
+ * Returns: 1 if the event is an added or updated resource event that
+ * is the same as the restored resource and is to be dropped, else 0.
+ **/
+int oh_snapshot_confirm(struct oh_domain *d, struct oh_event *e)
+{
+        struct restored *r = NULL;
+        gpointer key = GUINT_TO_POINTER(e->resource.ResourceId);
+        SaHpiBoolT same = SAHPI_FALSE;
+
+        if (g_atomic_int_get(&restored_count) == 0)
+                return 0;
+
+        wrap_g_static_mutex_lock(&restored_lock);
+        if (restored)
+                r = (struct restored *)g_hash_table_lookup(restored, key);
+        if (r && r->did == d->id) {
+                g_hash_table_steal(restored, key);
+                g_atomic_int_add(&restored_count, -1);
+        } else {
+                r = NULL;
+        }
+        wrap_g_static_mutex_unlock(&restored_lock);
+
+        if (!r)
+                return 0;
+
+        if (carries_resource(e)) {
+                same = r->hid == e->hid && same_resource(&d->rpt, e);
+                if (!same) {
+                        oh_remove_resource(&d->rpt, e->resource.ResourceId);
+                        if (e->event.EventType == SAHPI_ET_RESOURCE)
+                                e->event.EventDataUnion.ResourceEvent.ResourceEventType =
+                                        SAHPI_RESE_RESOURCE_UPDATED;
+                }
+        }
+        g_free(r);
+
+        /* Hotswap events are state changes of their own */
+        return same && e->event.EventType == SAHPI_ET_RESOURCE;
+}
+
+struct gone {
+        SaHpiDomainIdT did;
+        SaHpiResourceIdT rid;
+};
+
+struct reconcile_ctx {
+        unsigned int hid;
+        GArray *gone;
+};
+
+static gboolean collect_gone(gpointer key, gpointer value, gpointer data)
+{
+        struct restored *r = (struct restored *)value;
+        struct reconcile_ctx *ctx = (struct reconcile_ctx *)data;
+        struct gone g;
+
+        if (r->hid != ctx->hid)
+                return FALSE;
+
+        g.did = r->did;
+        g.rid = GPOINTER_TO_UINT(key);
+        g_array_append_val(ctx->gone, g);
+
+        return TRUE;
+}
+
+static struct oh_event *make_gone_event(unsigned int hid,
+                                        const SaHpiRptEntryT *rpte)
+{
+        struct oh_event *e = oh_new_event();
+        SaHpiHotSwapEventT *hse = &e->event.EventDataUnion.HotSwapEvent;
+
+        e->hid = hid;
+        e->resource = *rpte;
+        e->event.Source = rpte->ResourceId;
+        e->event.Severity = rpte->ResourceSeverity;
+        oh_gettimeofday(&e->event.Timestamp);
+
+        if (rpte->ResourceCapabilities & SAHPI_CAPABILITY_FRU) {
+                e->event.EventType = SAHPI_ET_HOTSWAP;
+                hse->HotSwapState = SAHPI_HS_STATE_NOT_PRESENT;
+                hse->PreviousHotSwapState = SAHPI_HS_STATE_ACTIVE;
+                hse->CauseOfStateChange = SAHPI_HS_CAUSE_UNKNOWN;
+        } else {
+                e->event.EventType = SAHPI_ET_RESOURCE;
+                e->event.EventDataUnion.ResourceEvent.ResourceEventType =
+                        SAHPI_RESE_RESOURCE_REMOVED;
+        }
+
+        return e;
+}
+
+/**
+ * oh_snapshot_reconcile
+ * @hid: id of a handler whose first discovery has been processed
+ *
+ * The handler's restored resources it did not report again are gone.
+ * Removal events are queued for them like the handler had sent them.
+ * Events are only processed for the default domain, restored resources
+ * of other domains are just removed.
+ **/
+void oh_snapshot_reconcile(unsigned int hid)
+{
+        struct reconcile_ctx ctx;
+        struct oh_domain *d;
+        struct oh_event *e;
+        SaHpiRptEntryT *rpte;
+        struct gone *g;
+        guint i;
+
+        if (g_atomic_int_get(&restored_count) == 0)
+                return;
+
+        ctx.hid = hid;
+        ctx.gone = g_array_new(FALSE, TRUE, sizeof(struct gone));
+
+        wrap_g_static_mutex_lock(&restored_lock);
+        if (restored)
+                g_hash_table_foreach_remove(restored, collect_gone, &ctx);
+        g_atomic_int_add(&restored_count, -(gint)ctx.gone->len);
+        wrap_g_static_mutex_unlock(&restored_lock);
+
+        if (ctx.gone->len)
+                INFO("Handler %u did not report %u restored resources, "
+                     "removing them.", hid, ctx.gone->len);
+
+        for (i = 0; i < ctx.gone->len; i++) {
+                g = &g_array_index(ctx.gone, struct gone, i);
+                d = oh_get_domain(g->did);
+                if (!d)
+                        continue;
+                e = NULL;
+                rpte = oh_get_resource_by_id(&d->rpt, g->rid);
+                if (rpte && g->did == OH_DEFAULT_DOMAIN_ID)
+                        e = make_gone_event(hid, rpte);
+                else if (rpte)
+                        oh_remove_resource(&d->rpt, g->rid);
+                oh_release_domain(d);
+                if (e)
+                        oh_evt_queue_push(oh_process_q, e);
+        }
+
+        g_array_free(ctx.gone, TRUE);
+}
@@ -0,0 +1,46 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __OH_SNAPSHOT_H
+#define __OH_SNAPSHOT_H
+
+#include <glib.h>
+#include <SaHpi.h>
+#include <oh_domain.h>
+#include <oh_utils.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * RPT snapshots.
+ *
+ * With OPENHPI_RPT_SAVE the resources and RDRs of each domain, and the
+ * handlers owning them, are saved to OPENHPI_VARPATH/rpt.<domain id>.
+ * At startup they are put back into the RPT, so clients see the last
+ * known resources while the handlers are still opening. Once a handler
+ * is done with its first discovery, its restored resources it did not
+ * report again are removed through the usual resource events.
+ */
+guint oh_snapshot_interval(void);
+SaErrorT oh_snapshot_save(void);
+SaErrorT oh_snapshot_load(void);
+void oh_snapshot_finit(void);
+
+int oh_snapshot_confirm(struct oh_domain *d, struct oh_event *e);
+void oh_snapshot_reconcile(unsigned int hid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OH_SNAPSHOT_H */
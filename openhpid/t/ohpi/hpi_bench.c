@@ -0,0 +1,266 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+/* "direct" when linked with the daemon library, "rpc" with libopenhpi */
+#ifndef BENCH_MODE
+#define BENCH_MODE "direct"
+#endif
+
+#define BENCH_EVENTS  1000
+#define BENCH_REPEAT  100
+#define MAX_SUBSCRIBERS 64
+
+static void report(const char *op, const char *param, guint size,
+                   guint n, gdouble t)
+{
+        printf("{\"bench\":\"hpi\",\"mode\":\"%s\",\"op\":\"%s\","
+               "\"%s\":%u,\"n\":%u,\"ns_per_op\":%.1f,\"ops_per_sec\":%.1f}\n",
+               BENCH_MODE, op, param, size, n,
+               n ? t * 1e9 / n : 0.0, t > 0 ? n / t : 0.0);
+}
+
+static void user_text(SaHpiTextBufferT *text)
+{
+        text->DataType = SAHPI_TL_TYPE_TEXT;
+        text->Language = SAHPI_LANG_ENGLISH;
+        text->DataLength = 5;
+        memcpy(text->Data, "bench", 5);
+}
+
+static void user_event(SaHpiEventT *event)
+{
+        memset(event, 0, sizeof(*event));
+        event->Source = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        event->EventType = SAHPI_ET_USER;
+        event->Timestamp = SAHPI_TIME_UNSPECIFIED;
+        event->Severity = SAHPI_INFORMATIONAL;
+        user_text(&event->EventDataUnion.UserEvent.UserEventData);
+}
+
+/* Request/reply round trip of a trivial call */
+static void bench_round_trip(SaHpiSessionIdT sid, GTimer *timer)
+{
+        SaHpiDomainInfoT info;
+        guint i, n = BENCH_REPEAT * 100;
+
+        g_timer_start(timer);
+        for (i = 0; i < n; i++) {
+                if (saHpiDomainInfoGet(sid, &info) != SA_OK) break;
+        }
+        report("domain_info_get", "size", 0, i, g_timer_elapsed(timer, NULL));
+}
+
+/* Full RPT and RDR walks, as clients do after discovery */
+static void bench_walk(SaHpiSessionIdT sid, GTimer *timer)
+{
+        SaHpiRptEntryT res;
+        SaHpiRdrT rdr;
+        SaHpiEntryIdT id, next, rid, rnext;
+        guint r, nres = 0, nrdr = 0;
+        gdouble t_res = 0, t_rdr = 0;
+
+        for (r = 0; r < BENCH_REPEAT; r++) {
+                nres = nrdr = 0;
+                g_timer_start(timer);
+                for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next) {
+                        if (saHpiRptEntryGet(sid, id, &next, &res) != SA_OK)
+                                break;
+                        nres++;
+                }
+                t_res += g_timer_elapsed(timer, NULL);
+
+                g_timer_start(timer);
+                for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next) {
+                        if (saHpiRptEntryGet(sid, id, &next, &res) != SA_OK)
+                                break;
+                        if (!(res.ResourceCapabilities & SAHPI_CAPABILITY_RDR))
+                                continue;
+                        for (rid = SAHPI_FIRST_ENTRY; rid != SAHPI_LAST_ENTRY; rid = rnext) {
+                                if (saHpiRdrGet(sid, res.ResourceId, rid,
+                                                &rnext, &rdr) != SA_OK)
+                                        break;
+                                nrdr++;
+                        }
+                }
+                t_rdr += g_timer_elapsed(timer, NULL);
+        }
+
+        report("rpt_walk", "resources", nres, nres * BENCH_REPEAT, t_res);
+        report("rdr_walk", "rdrs", nrdr, nrdr * BENCH_REPEAT, t_rdr);
+}
+
+static void drain(SaHpiSessionIdT sid)
+{
+        SaHpiEventT event;
+
+        while (saHpiEventGet(sid, SAHPI_TIMEOUT_IMMEDIATE, &event,
+                             NULL, NULL, NULL) == SA_OK)
+                ;
+}
+
+/* Time from the first saHpiEventAdd until every subscriber got every event */
+static void bench_fanout(SaHpiDomainIdT did, SaHpiSessionIdT sid,
+                         guint subs, GTimer *timer)
+{
+        SaHpiSessionIdT sids[MAX_SUBSCRIBERS];
+        SaHpiEventT event;
+        guint i, j, got;
+
+        for (i = 0; i < subs; i++) {
+                if (saHpiSessionOpen(did, &sids[i], NULL) != SA_OK ||
+                    saHpiSubscribe(sids[i]) != SA_OK) {
+                        printf("{\"bench\":\"hpi\",\"op\":\"event_fanout\",\"error\":\"session\"}\n");
+                        subs = i;
+                        goto out;
+                }
+                drain(sids[i]);
+        }
+
+        user_event(&event);
+
+        got = 0;
+        g_timer_start(timer);
+        for (j = 0; j < BENCH_EVENTS; j++) {
+                event.Timestamp = SAHPI_TIME_UNSPECIFIED;
+                if (saHpiEventAdd(sid, &event) != SA_OK) break;
+        }
+        for (i = 0; i < subs; i++) {
+                for (j = 0; j < BENCH_EVENTS; j++) {
+                        if (saHpiEventGet(sids[i], 5 * (SaHpiTimeoutT)1000000000,
+                                          &event, NULL, NULL, NULL) != SA_OK)
+                                break;
+                        if (event.EventType == SAHPI_ET_USER)
+                                got++;
+                        else
+                                j--;
+                }
+        }
+        report("event_fanout", "subscribers", subs, got, g_timer_elapsed(timer, NULL));
+
+out:
+        for (i = 0; i < subs; i++)
+                saHpiSessionClose(sids[i]);
+}
+
+/* Domain event log add, walk and clear */
+static void bench_del(SaHpiSessionIdT sid, guint size, GTimer *timer)
+{
+        SaHpiEventT event;
+        SaHpiEventLogEntryT entry;
+        SaHpiEventLogEntryIdT id, prev, next;
+        guint i, n;
+
+        saHpiEventLogClear(sid, SAHPI_UNSPECIFIED_RESOURCE_ID);
+        user_event(&event);
+
+        g_timer_start(timer);
+        for (i = 0; i < size; i++) {
+                event.Timestamp = SAHPI_TIME_UNSPECIFIED;
+                if (saHpiEventLogEntryAdd(sid, SAHPI_UNSPECIFIED_RESOURCE_ID,
+                                          &event) != SA_OK)
+                        break;
+        }
+        report("del_add", "size", size, i, g_timer_elapsed(timer, NULL));
+
+        n = 0;
+        g_timer_start(timer);
+        for (id = SAHPI_OLDEST_ENTRY; id != SAHPI_NO_MORE_ENTRIES; id = next) {
+                if (saHpiEventLogEntryGet(sid, SAHPI_UNSPECIFIED_RESOURCE_ID, id,
+                                          &prev, &next, &entry,
+                                          NULL, NULL) != SA_OK)
+                        break;
+                n++;
+        }
+        report("del_walk", "size", size, n, g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        saHpiEventLogClear(sid, SAHPI_UNSPECIFIED_RESOURCE_ID);
+        report("del_clear", "size", size, size, g_timer_elapsed(timer, NULL));
+}
+
+/* Domain alarm table add, walk and delete */
+static void bench_dat(SaHpiSessionIdT sid, guint size, GTimer *timer)
+{
+        SaHpiAlarmT alarm;
+        SaHpiAlarmIdT *ids = g_new0(SaHpiAlarmIdT, size);
+        guint i, added, n;
+
+        memset(&alarm, 0, sizeof(alarm));
+        alarm.Severity = SAHPI_MINOR;
+        alarm.AlarmCond.Type = SAHPI_STATUS_COND_TYPE_USER;
+        alarm.AlarmCond.ResourceId = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        user_text(&alarm.AlarmCond.Data);
+
+        g_timer_start(timer);
+        for (added = 0; added < size; added++) {
+                if (saHpiAlarmAdd(sid, &alarm) != SA_OK) break;
+                ids[added] = alarm.AlarmId;
+        }
+        report("dat_add", "size", size, added, g_timer_elapsed(timer, NULL));
+
+        n = 0;
+        alarm.AlarmId = SAHPI_FIRST_ENTRY;
+        g_timer_start(timer);
+        while (saHpiAlarmGetNext(sid, SAHPI_ALL_SEVERITIES, SAHPI_FALSE,
+                                 &alarm) == SA_OK)
+                n++;
+        report("dat_walk", "size", size, n, g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        for (i = 0; i < added; i++)
+                saHpiAlarmDelete(sid, ids[i], SAHPI_MINOR);
+        report("dat_delete", "size", size, added, g_timer_elapsed(timer, NULL));
+
+        g_free(ids);
+}
+
+/**
+ * main: Times HPI calls against the domain in OPENHPI_CONF (direct)
+ * or against a running openhpid (rpc). Prints one JSON object per line.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        GTimer *timer;
+        guint size, subs;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL) != SA_OK)
+                return 1;
+        if (saHpiDiscover(sid) != SA_OK)
+                return 1;
+
+        timer = g_timer_new();
+
+        bench_round_trip(sid, timer);
+        bench_walk(sid, timer);
+
+        for (subs = 1; subs <= MAX_SUBSCRIBERS; subs *= 4)
+                bench_fanout(SAHPI_UNSPECIFIED_DOMAIN_ID, sid, subs, timer);
+
+        for (size = 100; size <= 10000; size *= 10) {
+                bench_del(sid, size, timer);
+                bench_dat(sid, size, timer);
+        }
+
+        g_timer_destroy(timer);
+        saHpiSessionClose(sid);
+
+        return 0;
+}
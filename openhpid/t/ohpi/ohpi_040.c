@@ -0,0 +1,94 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define TIMEOUT (5 * (SaHpiTimeoutT)1000000000)
+
+static int get_user_event(SaHpiSessionIdT sid)
+{
+        SaHpiEventT event;
+
+        while (saHpiEventGet(sid, TIMEOUT, &event,
+                             NULL, NULL, NULL) == SA_OK) {
+                if (event.EventType == SAHPI_ET_USER)
+                        return 0;
+        }
+
+        return -1;
+}
+
+/**
+ * Fan out user events to subscribed sessions only, while sessions
+ * subscribe, unsubscribe and close.
+ * Pass if every subscribed session gets the event, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid, s1, s2, s3;
+        SaHpiEventT event;
+        SaHpiEventT got;
+
+        memset(&event, 0, sizeof(event));
+        event.Source = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        event.EventType = SAHPI_ET_USER;
+        event.Timestamp = SAHPI_TIME_UNSPECIFIED;
+        event.Severity = SAHPI_INFORMATIONAL;
+        event.EventDataUnion.UserEvent.UserEventData.DataType = SAHPI_TL_TYPE_TEXT;
+        event.EventDataUnion.UserEvent.UserEventData.Language = SAHPI_LANG_ENGLISH;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &s1, NULL))
+                return -1;
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &s2, NULL))
+                return -1;
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &s3, NULL))
+                return -1;
+
+        if (saHpiSubscribe(s1) || saHpiSubscribe(s2) || saHpiSubscribe(s3))
+                return -1;
+
+        if (saHpiEventAdd(sid, &event))
+                return -1;
+        if (get_user_event(s1) || get_user_event(s2) || get_user_event(s3))
+                return -1;
+
+        /* Unsubscribed and closed sessions drop out of the fan-out */
+        if (saHpiUnsubscribe(s2))
+                return -1;
+        if (saHpiSessionClose(s3))
+                return -1;
+
+        if (saHpiEventAdd(sid, &event))
+                return -1;
+        if (get_user_event(s1))
+                return -1;
+        if (saHpiEventGet(s2, SAHPI_TIMEOUT_IMMEDIATE, &got,
+                          NULL, NULL, NULL) != SA_ERR_HPI_INVALID_REQUEST)
+                return -1;
+
+        /* Subscribing again puts the session back */
+        if (saHpiSubscribe(s2))
+                return -1;
+        if (saHpiEventAdd(sid, &event))
+                return -1;
+        if (get_user_event(s1) || get_user_event(s2))
+                return -1;
+
+        saHpiSessionClose(s1);
+        saHpiSessionClose(s2);
+        saHpiSessionClose(sid);
+
+        return 0;
+}
@@ -0,0 +1,125 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+#include <sahpi_wrappers.h>
+
+#define QUEUE_LIMIT 4
+#define NEVENTS (QUEUE_LIMIT + 2)
+
+static SaHpiSessionIdT waiter_sid;
+
+static gpointer waiter(gpointer data)
+{
+        SaHpiEventT event;
+        SaErrorT *rv = data;
+
+        *rv = saHpiEventGet(waiter_sid, SAHPI_TIMEOUT_BLOCK, &event,
+                            NULL, NULL, NULL);
+
+        return NULL;
+}
+
+/**
+ * Overflow a session queue with the DROP_OLDEST policy, then unsubscribe
+ * a session blocked in saHpiEventGet().
+ * Pass if only the newest events are kept, overflow is reported and
+ * the blocked call returns right away, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid, s1;
+        SaHpiEventT event;
+        SaHpiEvtQueueStatusT status = 0, qstatus;
+        oHpiGlobalParamT param;
+        SaErrorT waiter_rv = SA_OK;
+        GThread *thread;
+        GTimer *timer;
+        int i, first = -1, last = -1;
+
+        setenv("OPENHPI_EVT_QUEUE_POLICY", "DROP_OLDEST", 1);
+
+        memset(&event, 0, sizeof(event));
+        event.Source = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        event.EventType = SAHPI_ET_USER;
+        event.Severity = SAHPI_INFORMATIONAL;
+        event.EventDataUnion.UserEvent.UserEventData.DataType = SAHPI_TL_TYPE_TEXT;
+        event.EventDataUnion.UserEvent.UserEventData.Language = SAHPI_LANG_ENGLISH;
+        event.EventDataUnion.UserEvent.UserEventData.DataLength = 1;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+        if (saHpiDiscover(sid))
+                return -1;
+
+        param.Type = OHPI_EVT_QUEUE_LIMIT;
+        param.u.EvtQueueLimit = QUEUE_LIMIT;
+        if (oHpiGlobalParamSet(sid, &param))
+                return -1;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &s1, NULL))
+                return -1;
+        if (saHpiSubscribe(s1))
+                return -1;
+
+        for (i = 0; i < NEVENTS; i++) {
+                event.Timestamp = SAHPI_TIME_UNSPECIFIED;
+                event.EventDataUnion.UserEvent.UserEventData.Data[0] = i;
+                if (saHpiEventAdd(sid, &event))
+                        return -1;
+        }
+
+        /* Event processing is asynchronous */
+        g_usleep(G_USEC_PER_SEC);
+
+        while (saHpiEventGet(s1, SAHPI_TIMEOUT_IMMEDIATE, &event,
+                             NULL, NULL, &qstatus) == SA_OK) {
+                status |= qstatus;
+                if (event.EventType != SAHPI_ET_USER)
+                        continue;
+                if (first < 0)
+                        first = event.EventDataUnion.UserEvent.UserEventData.Data[0];
+                last = event.EventDataUnion.UserEvent.UserEventData.Data[0];
+        }
+
+        if (!(status & SAHPI_EVT_QUEUE_OVERFLOW))
+                return -1;
+        if (first < NEVENTS - QUEUE_LIMIT || last != NEVENTS - 1)
+                return -1;
+
+        /* Unsubscribe wakes up a blocked saHpiEventGet() */
+        waiter_sid = s1;
+        thread = wrap_g_thread_create_new("ohpi_041", waiter, &waiter_rv,
+                                          TRUE, NULL);
+        if (!thread)
+                return -1;
+        g_usleep(G_USEC_PER_SEC / 10);
+
+        timer = g_timer_new();
+        if (saHpiUnsubscribe(s1))
+                return -1;
+        g_thread_join(thread);
+        if (g_timer_elapsed(timer, NULL) > 1.0)
+                return -1;
+        g_timer_destroy(timer);
+
+        if (waiter_rv != SA_ERR_HPI_INVALID_REQUEST)
+                return -1;
+
+        saHpiSessionClose(s1);
+        saHpiSessionClose(sid);
+
+        return 0;
+}
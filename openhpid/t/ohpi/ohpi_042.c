@@ -0,0 +1,70 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+static int name_is(const oHpiMetricT *metric, const char *name)
+{
+        return (metric->Name.DataLength == strlen(name)) &&
+               (memcmp(metric->Name.Data, name, strlen(name)) == 0);
+}
+
+/**
+ * Walk the daemon metrics after a discovery.
+ * Pass if the session gauge and the discovery histogram are reported
+ * and bad parameters are rejected, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        SaHpiEntryIdT id, next_id;
+        oHpiMetricT metric;
+        int sessions = 0, discovery = 0;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+        if (saHpiDiscover(sid))
+                return -1;
+
+        if (oHpiMetricGet(sid, SAHPI_FIRST_ENTRY, NULL, &metric) !=
+            SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+        if (oHpiMetricGet(sid, SAHPI_FIRST_ENTRY, &next_id, NULL) !=
+            SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (oHpiMetricGet(sid, id, &next_id, &metric))
+                        return -1;
+                if (name_is(&metric, "openhpid_sessions")) {
+                        if (metric.Type != OHPI_METRIC_GAUGE ||
+                            metric.Value < 1)
+                                return -1;
+                        sessions = 1;
+                } else if (name_is(&metric,
+                                   "openhpid_discovery_duration_microseconds")) {
+                        if (metric.Type != OHPI_METRIC_HISTOGRAM ||
+                            metric.Value < 1 ||
+                            metric.Buckets[OHPI_METRIC_BUCKETS - 1] > metric.Value)
+                                return -1;
+                        discovery = 1;
+                }
+        }
+
+        if (!sessions || !discovery)
+                return -1;
+
+        saHpiSessionClose(sid);
+
+        return 0;
+}
@@ -0,0 +1,135 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+static int find_sensor(SaHpiSessionIdT sid,
+                       SaHpiResourceIdT *rid, SaHpiSensorNumT *num,
+                       SaHpiSensorReadingTypeT *type)
+{
+        SaHpiEntryIdT id, next_id, rdr_id, next_rdr_id;
+        SaHpiRptEntryT rpte;
+        SaHpiRdrT rdr;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        return -1;
+                if (!(rpte.ResourceCapabilities & SAHPI_CAPABILITY_SENSOR))
+                        continue;
+                for (rdr_id = SAHPI_FIRST_ENTRY; rdr_id != SAHPI_LAST_ENTRY;
+                     rdr_id = next_rdr_id) {
+                        if (saHpiRdrGet(sid, rpte.ResourceId, rdr_id,
+                                        &next_rdr_id, &rdr))
+                                break;
+                        if (rdr.RdrType != SAHPI_SENSOR_RDR ||
+                            !rdr.RdrTypeUnion.SensorRec.DataFormat.IsSupported)
+                                continue;
+                        *rid = rpte.ResourceId;
+                        *num = rdr.RdrTypeUnion.SensorRec.Num;
+                        *type = rdr.RdrTypeUnion.SensorRec.DataFormat.ReadingType;
+                        return 0;
+                }
+        }
+
+        return -1;
+}
+
+/**
+ * Let the daemon keep a delta encoded history of the simulator's
+ * sensors and read the history of one of them.
+ * Pass if the samples are in order, have the sensor's reading type and
+ * time ranges and bad parameters are handled, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        GHashTable *config = g_hash_table_new(g_str_hash, g_str_equal);
+        oHpiHandlerIdT hid;
+        SaHpiResourceIdT rid;
+        SaHpiSensorNumT num;
+        SaHpiSensorReadingTypeT type;
+        oHpiSensorSampleT samples[64], last;
+        SaHpiUint32T n, i;
+
+        setenv("OPENHPI_CONF", "./noconfig", 1);
+        setenv("OPENHPI_HISTORY_INTERVAL", "100", 1);
+        setenv("OPENHPI_HISTORY_DELTA", "YES", 1);
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+
+        g_hash_table_insert(config, "plugin", "libsimulator");
+        g_hash_table_insert(config, "entity_root", "{SYSTEM_CHASSIS,1}");
+        g_hash_table_insert(config, "name", "test");
+        g_hash_table_insert(config, "addr", "0");
+        if (oHpiHandlerCreate(sid, config, &hid))
+                return -1;
+        if (saHpiDiscover(sid))
+                return -1;
+        if (find_sensor(sid, &rid, &num, &type))
+                return -1;
+
+        /* A few sampling rounds */
+        g_usleep(G_USEC_PER_SEC);
+
+        n = 64;
+        if (oHpiSensorHistoryGet(sid, rid, num, 0, SAHPI_TIME_UNSPECIFIED,
+                                 &n, samples))
+                return -1;
+        if (n < 2)
+                return -1;
+        for (i = 0; i < n; i++) {
+                if (!samples[i].Reading.IsSupported ||
+                    samples[i].Reading.Type != type)
+                        return -1;
+                if (i > 0 && samples[i].Timestamp <= samples[i - 1].Timestamp)
+                        return -1;
+        }
+
+        /* Only the samples in the range */
+        last = samples[n - 1];
+        n = 64;
+        if (oHpiSensorHistoryGet(sid, rid, num, last.Timestamp,
+                                 last.Timestamp, &n, samples))
+                return -1;
+        if (n != 1 || memcmp(&samples[0], &last, sizeof(last)))
+                return -1;
+
+        /* Only as many samples as asked for, the oldest first */
+        n = 1;
+        if (oHpiSensorHistoryGet(sid, rid, num, 0, SAHPI_TIME_UNSPECIFIED,
+                                 &n, samples))
+                return -1;
+        if (n != 1 || samples[0].Timestamp >= last.Timestamp)
+                return -1;
+
+        n = 64;
+        if (oHpiSensorHistoryGet(sid, rid, num, 2, 1, &n, samples) !=
+            SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+        n = 0;
+        if (oHpiSensorHistoryGet(sid, rid, num, 0, SAHPI_TIME_UNSPECIFIED,
+                                 &n, samples) != SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+        n = 64;
+        if (oHpiSensorHistoryGet(sid, rid, 0xFFFF, 0, SAHPI_TIME_UNSPECIFIED,
+                                 &n, samples) != SA_ERR_HPI_NOT_PRESENT)
+                return -1;
+
+        oHpiHandlerDestroy(sid, hid);
+        saHpiSessionClose(sid);
+
+        return 0;
+}
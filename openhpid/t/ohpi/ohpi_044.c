@@ -0,0 +1,125 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+static int find_sensor(SaHpiSessionIdT sid,
+                       SaHpiResourceIdT *rid, SaHpiSensorNumT *num)
+{
+        SaHpiEntryIdT id, next_id, rdr_id, next_rdr_id;
+        SaHpiRptEntryT rpte;
+        SaHpiRdrT rdr;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        return -1;
+                if (!(rpte.ResourceCapabilities & SAHPI_CAPABILITY_SENSOR))
+                        continue;
+                for (rdr_id = SAHPI_FIRST_ENTRY; rdr_id != SAHPI_LAST_ENTRY;
+                     rdr_id = next_rdr_id) {
+                        if (saHpiRdrGet(sid, rpte.ResourceId, rdr_id,
+                                        &next_rdr_id, &rdr))
+                                break;
+                        if (rdr.RdrType != SAHPI_SENSOR_RDR)
+                                continue;
+                        *rid = rpte.ResourceId;
+                        *num = rdr.RdrTypeUnion.SensorRec.Num;
+                        return 0;
+                }
+        }
+
+        return -1;
+}
+
+/**
+ * Watch a sensor of the simulator, change the watch, remove it and
+ * check that a sensor that does not change posts no watch events.
+ * Pass if the watch calls succeed and bad parameters are handled,
+ * otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        GHashTable *config = g_hash_table_new(g_str_hash, g_str_equal);
+        oHpiHandlerIdT hid;
+        SaHpiResourceIdT rid;
+        SaHpiSensorNumT num;
+        SaHpiEventT event;
+
+        setenv("OPENHPI_CONF", "./noconfig", 1);
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+
+        g_hash_table_insert(config, "plugin", "libsimulator");
+        g_hash_table_insert(config, "entity_root", "{SYSTEM_CHASSIS,1}");
+        g_hash_table_insert(config, "name", "test");
+        g_hash_table_insert(config, "addr", "0");
+        if (oHpiHandlerCreate(sid, config, &hid))
+                return -1;
+        if (saHpiDiscover(sid))
+                return -1;
+        if (find_sensor(sid, &rid, &num))
+                return -1;
+
+        if (oHpiSensorWatchAdd(sid, rid, num,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL - 1, 0) !=
+            SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+        if (oHpiSensorWatchAdd(sid, rid, num,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL, -1) !=
+            SA_ERR_HPI_INVALID_PARAMS)
+                return -1;
+        if (oHpiSensorWatchAdd(sid, rid, 0xFFFF,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL, 0) !=
+            SA_ERR_HPI_NOT_PRESENT)
+                return -1;
+        if (oHpiSensorWatchAdd(sid, 0xFFFFFFFE, num,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL, 0) !=
+            SA_ERR_HPI_INVALID_RESOURCE)
+                return -1;
+
+        if (saHpiSubscribe(sid))
+                return -1;
+        while (saHpiEventGet(sid, SAHPI_TIMEOUT_IMMEDIATE, &event,
+                             NULL, NULL, NULL) == SA_OK)
+                ;
+
+        if (oHpiSensorWatchAdd(sid, rid, num,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL, 0))
+                return -1;
+        /* Adding it again only changes the watch */
+        if (oHpiSensorWatchAdd(sid, rid, num,
+                               OHPI_SENSOR_WATCH_MIN_INTERVAL * 2, 0.5))
+                return -1;
+
+        /* A few polls of a sensor that does not change */
+        g_usleep(G_USEC_PER_SEC);
+        while (saHpiEventGet(sid, SAHPI_TIMEOUT_IMMEDIATE, &event,
+                             NULL, NULL, NULL) == SA_OK) {
+                if (event.EventType == SAHPI_ET_SENSOR &&
+                    event.EventDataUnion.SensorEvent.Oem == OHPI_SENSOR_WATCH_OEM)
+                        return -1;
+        }
+
+        if (oHpiSensorWatchRemove(sid, rid, num))
+                return -1;
+        if (oHpiSensorWatchRemove(sid, rid, num) != SA_ERR_HPI_NOT_PRESENT)
+                return -1;
+
+        oHpiHandlerDestroy(sid, hid);
+        saHpiSessionClose(sid);
+
+        return 0;
+}
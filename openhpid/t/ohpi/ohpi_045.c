@@ -0,0 +1,95 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define CONF "./ohpi_045.conf"
+#define HANDLERS 3
+
+static int write_conf(void)
+{
+        FILE *f = fopen(CONF, "w");
+        int i;
+
+        if (!f)
+                return -1;
+        for (i = 1; i <= HANDLERS; i++) {
+                fprintf(f, "handler libsimulator {\n");
+                fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,%d}\"\n", i);
+                fprintf(f, "        name = \"simulator%d\"\n", i);
+                fprintf(f, "        open_timeout = \"60000\"\n");
+                fprintf(f, "}\n");
+        }
+        fclose(f);
+
+        return chmod(CONF, S_IRUSR | S_IWUSR);
+}
+
+/**
+ * Start with several simulator handlers in the config file, which are
+ * opened in parallel, and wait for them to come up.
+ * Pass if every handler is reported as opening or loaded and all of
+ * them end up loaded with their resources in the RPT, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        GHashTable *config;
+        oHpiHandlerInfoT info;
+        oHpiHandlerIdT hid, next_hid;
+        SaHpiEntryIdT next_id;
+        SaHpiRptEntryT rpte;
+        int n, tries;
+
+        if (write_conf())
+                return -1;
+        setenv("OPENHPI_CONF", CONF, 1);
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+
+        n = 0;
+        for (hid = SAHPI_FIRST_ENTRY;
+             oHpiHandlerGetNext(sid, hid, &next_hid) == SA_OK;
+             hid = next_hid) {
+                for (tries = 0; tries < 100; tries++) {
+                        config = g_hash_table_new_full(g_str_hash,
+                                                       g_str_equal,
+                                                       g_free, g_free);
+                        if (oHpiHandlerInfo(sid, next_hid, &info, config))
+                                return -1;
+                        g_hash_table_destroy(config);
+                        if (info.load_failed != OHPI_HANDLER_OPENING)
+                                break;
+                        g_usleep(G_USEC_PER_SEC / 10);
+                }
+                if (info.load_failed != OHPI_HANDLER_LOADED)
+                        return -1;
+                n++;
+        }
+        if (n != HANDLERS)
+                return -1;
+
+        if (saHpiDiscover(sid))
+                return -1;
+        if (saHpiRptEntryGet(sid, SAHPI_FIRST_ENTRY, &next_id, &rpte))
+                return -1;
+
+        saHpiSessionClose(sid);
+        remove(CONF);
+
+        return 0;
+}
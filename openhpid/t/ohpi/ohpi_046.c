@@ -0,0 +1,133 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define CONF "./ohpi_046.conf"
+#define SNAPSHOT "./rpt.0"
+
+static int write_conf(void)
+{
+        FILE *f = fopen(CONF, "w");
+
+        if (!f)
+                return -1;
+        fprintf(f, "handler libsimulator {\n");
+        fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,1}\"\n");
+        fprintf(f, "        name = \"simulator\"\n");
+        fprintf(f, "}\n");
+        fclose(f);
+
+        return chmod(CONF, S_IRUSR | S_IWUSR);
+}
+
+static int count_resources(SaHpiSessionIdT sid)
+{
+        SaHpiEntryIdT id, next_id;
+        SaHpiRptEntryT rpte;
+        int n = 0;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        break;
+                n++;
+        }
+
+        return n;
+}
+
+/* Waits for the first handler to open and discovers */
+static int start(SaHpiSessionIdT *sid)
+{
+        GHashTable *config;
+        oHpiHandlerInfoT info;
+        int tries;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, sid, NULL))
+                return -1;
+        for (tries = 0; tries < 100; tries++) {
+                config = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, g_free);
+                if (oHpiHandlerInfo(*sid, 1, &info, config))
+                        return -1;
+                g_hash_table_destroy(config);
+                if (info.load_failed != OHPI_HANDLER_OPENING)
+                        break;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+        if (info.load_failed != OHPI_HANDLER_LOADED)
+                return -1;
+
+        return saHpiDiscover(*sid);
+}
+
+/**
+ * Run the daemon with RPT snapshots in a child process until the
+ * snapshot has the simulator's resources, then start it again.
+ * Pass if the resources are in the RPT right after the start and the
+ * same number of them is left once the handler has discovered,
+ * otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        pid_t pid;
+        int status, n;
+
+        if (write_conf())
+                return -1;
+        setenv("OPENHPI_CONF", CONF, 1);
+        setenv("OPENHPI_VARPATH", ".", 1);
+        setenv("OPENHPI_RPT_SAVE", "YES", 1);
+        setenv("OPENHPI_RPT_SAVE_INTERVAL", "100", 1);
+        remove(SNAPSHOT);
+
+        pid = fork();
+        if (pid < 0)
+                return -1;
+        if (pid == 0) {
+                if (start(&sid))
+                        _exit(0);
+                /* A few snapshots after the discovery */
+                g_usleep(G_USEC_PER_SEC / 2);
+                _exit(count_resources(sid));
+        }
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+                return -1;
+        n = WEXITSTATUS(status);
+        if (n == 0 || access(SNAPSHOT, R_OK))
+                return -1;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+        if (count_resources(sid) != n)
+                return -1;
+        saHpiSessionClose(sid);
+
+        if (start(&sid))
+                return -1;
+        g_usleep(G_USEC_PER_SEC / 2);
+        if (count_resources(sid) != n)
+                return -1;
+
+        saHpiSessionClose(sid);
+        remove(SNAPSHOT);
+        remove(CONF);
+
+        return 0;
+}
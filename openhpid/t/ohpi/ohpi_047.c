@@ -0,0 +1,195 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define CONF "./ohpi_047.conf"
+
+/* second is the chassis of the second handler, 0 for none */
+static int write_conf(int first, int second, int limit)
+{
+        FILE *f = fopen(CONF, "w");
+
+        if (!f)
+                return -1;
+        if (limit)
+                fprintf(f, "OPENHPI_EVT_QUEUE_LIMIT = %d\n", limit);
+        if (first) {
+                fprintf(f, "handler libsimulator {\n");
+                fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,1}\"\n");
+                fprintf(f, "        name = \"simulator1\"\n");
+                fprintf(f, "}\n");
+        }
+        if (second) {
+                fprintf(f, "handler libsimulator {\n");
+                fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,%d}\"\n",
+                        second);
+                fprintf(f, "        name = \"simulator2\"\n");
+                fprintf(f, "}\n");
+        }
+        fclose(f);
+
+        return chmod(CONF, S_IRUSR | S_IWUSR);
+}
+
+static int count_resources(SaHpiSessionIdT sid)
+{
+        SaHpiEntryIdT id, next_id;
+        SaHpiRptEntryT rpte;
+        int n = 0;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        break;
+                n++;
+        }
+
+        return n;
+}
+
+/* Returns the handler state or -1 if there is no such handler */
+static int handler_state(SaHpiSessionIdT sid, oHpiHandlerIdT hid)
+{
+        GHashTable *config;
+        oHpiHandlerInfoT info;
+        int tries;
+
+        for (tries = 0; tries < 100; tries++) {
+                config = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, g_free);
+                if (oHpiHandlerInfo(sid, hid, &info, config)) {
+                        g_hash_table_destroy(config);
+                        return -1;
+                }
+                g_hash_table_destroy(config);
+                if (info.load_failed != OHPI_HANDLER_OPENING)
+                        break;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+
+        return info.load_failed;
+}
+
+/* Waits for the events of a reload to show up in the RPT */
+static int wait_resources(SaHpiSessionIdT sid, int n)
+{
+        int tries;
+
+        for (tries = 0; tries < 50; tries++) {
+                saHpiDiscover(sid);
+                if (count_resources(sid) == n)
+                        return 0;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+
+        return -1;
+}
+
+/**
+ * Start with one simulator handler, then reload the config file with a
+ * second handler and a new OPENHPI_EVT_QUEUE_LIMIT, again with the
+ * first handler removed, again with the stanza of the second handler
+ * changed and last with OPENHPI_EVT_QUEUE_LIMIT removed.
+ * Pass if the unchanged handler is kept on each reload, the new one is
+ * created, the removed one is destroyed with its resources, the changed
+ * one is replaced by a new handler and the global parameter is in effect
+ * while configured and back to its default once removed, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        oHpiGlobalParamT param;
+        int n, limit;
+
+        if (write_conf(1, 0, 0))
+                return -1;
+        setenv("OPENHPI_CONF", CONF, 1);
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+        if (handler_state(sid, 1) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (saHpiDiscover(sid))
+                return -1;
+        n = count_resources(sid);
+        if (n == 0)
+                return -1;
+        param.Type = OHPI_EVT_QUEUE_LIMIT;
+        if (oHpiGlobalParamGet(sid, &param))
+                return -1;
+        limit = param.u.EvtQueueLimit;
+        if (limit == 1234)
+                return -1;
+
+        /* Added handler and global parameter */
+        if (write_conf(1, 2, 1234))
+                return -1;
+        if (oHpiConfigReload(sid))
+                return -1;
+        if (handler_state(sid, 1) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (handler_state(sid, 2) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (wait_resources(sid, 2 * n))
+                return -1;
+        param.Type = OHPI_EVT_QUEUE_LIMIT;
+        if (oHpiGlobalParamGet(sid, &param))
+                return -1;
+        if (param.u.EvtQueueLimit != 1234)
+                return -1;
+
+        /* Removed handler */
+        if (write_conf(0, 2, 1234))
+                return -1;
+        if (oHpiConfigReload(sid))
+                return -1;
+        if (handler_state(sid, 1) != -1)
+                return -1;
+        if (handler_state(sid, 2) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (wait_resources(sid, n))
+                return -1;
+
+        /* Changed handler */
+        if (write_conf(0, 3, 1234))
+                return -1;
+        if (oHpiConfigReload(sid))
+                return -1;
+        if (handler_state(sid, 2) != -1)
+                return -1;
+        if (handler_state(sid, 3) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (wait_resources(sid, n))
+                return -1;
+
+        /* Removed global parameter */
+        if (write_conf(0, 3, 0))
+                return -1;
+        if (oHpiConfigReload(sid))
+                return -1;
+        if (handler_state(sid, 3) != OHPI_HANDLER_LOADED)
+                return -1;
+        param.Type = OHPI_EVT_QUEUE_LIMIT;
+        if (oHpiGlobalParamGet(sid, &param))
+                return -1;
+        if (param.u.EvtQueueLimit != limit)
+                return -1;
+
+        saHpiSessionClose(sid);
+        remove(CONF);
+
+        return 0;
+}
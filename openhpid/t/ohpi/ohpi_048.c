@@ -0,0 +1,185 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <sahpi_wrappers.h>
+
+#define CONF        "./ohpi_048.conf"
+#define CLIENT_CONF "./ohpi_048_client.conf"
+#define PIDFILE     "./ohpi_048.pid"
+#define PORT        "4798"
+#define WAITERS     2
+
+static pid_t daemon_pid = -1;
+
+static int write_conf(const char *name, mode_t mode)
+{
+        FILE *f = fopen(name, "w");
+
+        if (!f)
+                return -1;
+        fprintf(f, "# no handlers\n");
+        fclose(f);
+
+        return chmod(name, mode);
+}
+
+static void stop_daemon(void)
+{
+        int status;
+
+        if (daemon_pid > 0) {
+                kill(daemon_pid, SIGTERM);
+                waitpid(daemon_pid, &status, 0);
+                daemon_pid = -1;
+        }
+}
+
+static void on_alarm(int sig)
+{
+        /* A request is stuck behind the blocked saHpiEventGet() calls */
+        if (daemon_pid > 0)
+                kill(daemon_pid, SIGKILL);
+        _exit(1);
+}
+
+static gpointer wait_event(gpointer data)
+{
+        SaHpiSessionIdT sid = *(SaHpiSessionIdT *)data;
+        SaHpiEventT event;
+        SaErrorT rv;
+
+        rv = saHpiEventGet(sid, SAHPI_TIMEOUT_BLOCK, &event,
+                           NULL, NULL, NULL);
+        if (rv != SA_OK || event.EventType != SAHPI_ET_USER)
+                return GINT_TO_POINTER(1);
+
+        return GINT_TO_POINTER(0);
+}
+
+static void user_event(SaHpiEventT *event)
+{
+        memset(event, 0, sizeof(*event));
+        event->Source = SAHPI_UNSPECIFIED_RESOURCE_ID;
+        event->EventType = SAHPI_ET_USER;
+        event->Timestamp = SAHPI_TIME_UNSPECIFIED;
+        event->Severity = SAHPI_INFORMATIONAL;
+        event->EventDataUnion.UserEvent.UserEventData.DataType =
+                SAHPI_TL_TYPE_TEXT;
+        event->EventDataUnion.UserEvent.UserEventData.Language =
+                SAHPI_LANG_ENGLISH;
+}
+
+static int run(void)
+{
+        SaHpiSessionIdT sid[WAITERS + 1];
+        GThread *waiter[WAITERS];
+        SaHpiDomainInfoT info;
+        SaHpiEventT event;
+        SaErrorT rv = SA_ERR_HPI_NO_RESPONSE;
+        int i, tries, failed = 0;
+
+        /* Wait for the daemon to come up */
+        for (tries = 0; tries < 50 && rv != SA_OK; tries++) {
+                rv = saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID,
+                                      &sid[0], NULL);
+                if (rv != SA_OK)
+                        g_usleep(G_USEC_PER_SEC / 10);
+        }
+        if (rv != SA_OK)
+                return -1;
+        for (i = 1; i <= WAITERS; i++) {
+                if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID,
+                                     &sid[i], NULL))
+                        return -1;
+        }
+
+        /* As many blocked saHpiEventGet() calls as the daemon has threads */
+        for (i = 0; i < WAITERS; i++) {
+                if (saHpiSubscribe(sid[i + 1]))
+                        return -1;
+                waiter[i] = wrap_g_thread_create_new("ohpi_048", wait_event,
+                                                     &sid[i + 1], TRUE, 0);
+                if (!waiter[i])
+                        return -1;
+        }
+        g_usleep(G_USEC_PER_SEC / 2);
+
+        /* Other requests on the same connection must still be served */
+        alarm(10);
+        if (saHpiDomainInfoGet(sid[0], &info))
+                return -1;
+        user_event(&event);
+        if (saHpiEventAdd(sid[0], &event))
+                return -1;
+        for (i = 0; i < WAITERS; i++) {
+                if (g_thread_join(waiter[i]))
+                        failed = -1;
+        }
+        alarm(0);
+
+        for (i = 0; i <= WAITERS; i++)
+                saHpiSessionClose(sid[i]);
+
+        return failed;
+}
+
+/**
+ * Run openhpid with two request threads and open three sessions over
+ * one multiplexed connection. Block saHpiEventGet() on two of them,
+ * then call saHpiDomainInfoGet() and saHpiEventAdd() on the third.
+ * Pass if the calls on the third session are served and the blocked
+ * saHpiEventGet() calls return the added event, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        const char *openhpid = getenv("OPENHPID");
+        int rv;
+
+        if (!openhpid)
+                openhpid = "../../openhpid";
+        if (write_conf(CONF, S_IRUSR | S_IWUSR))
+                return -1;
+        if (write_conf(CLIENT_CONF, S_IRUSR | S_IWUSR))
+                return -1;
+
+        daemon_pid = fork();
+        if (daemon_pid < 0)
+                return -1;
+        if (daemon_pid == 0) {
+                execl(openhpid, "openhpid", "-n", "-c", CONF, "-p", PORT,
+                      "-t", "2", "-f", PIDFILE, (char *)NULL);
+                _exit(127);
+        }
+
+        setenv("OPENHPICLIENT_CONF", CLIENT_CONF, 1);
+        setenv("OPENHPI_DAEMON_HOST", "localhost", 1);
+        setenv("OPENHPI_DAEMON_PORT", PORT, 1);
+        setenv("OPENHPI_CLIENT_MULTIPLEX", "1", 1);
+        signal(SIGALRM, on_alarm);
+
+        rv = run();
+
+        stop_daemon();
+        remove(CONF);
+        remove(CLIENT_CONF);
+
+        return rv;
+}
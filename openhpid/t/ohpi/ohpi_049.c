@@ -0,0 +1,148 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <sahpi_wrappers.h>
+#include <dispatch.h>
+
+#define TIMEOUT  "200"
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GRecMutex lock;
+#else
+static GStaticRecMutex lock = G_STATIC_REC_MUTEX_INIT;
+#endif
+
+struct caller {
+        struct oh_abi_queue *q;
+        oh_dispatch_mode mode;
+        SaErrorT rv;
+        gint64 waited;  /* msec */
+};
+
+static struct oh_abi_queue *new_queue(const char *concurrency)
+{
+        struct oh_abi_queue *q;
+        GHashTable *config;
+
+        config = g_hash_table_new(g_str_hash, g_str_equal);
+        g_hash_table_insert(config, "abi_concurrency",
+                            (gpointer)concurrency);
+        g_hash_table_insert(config, "abi_queue_depth", (gpointer)"1");
+        g_hash_table_insert(config, "abi_timeout", (gpointer)TIMEOUT);
+        q = oh_dispatch_create(1, config);
+        g_hash_table_destroy(config);
+
+        return q;
+}
+
+static gpointer call(gpointer data)
+{
+        struct caller *c = (struct caller *)data;
+        gint64 start = g_get_monotonic_time();
+
+        c->rv = oh_dispatch_enter(c->q, &lock, c->mode);
+        c->waited = (g_get_monotonic_time() - start) / 1000;
+        if (c->rv == SA_OK) {
+                oh_dispatch_leave(c->q);
+                wrap_g_static_rec_mutex_unlock(&lock);
+        }
+
+        return NULL;
+}
+
+static GThread *start_call(struct caller *c, struct oh_abi_queue *q,
+                           oh_dispatch_mode mode)
+{
+        c->q = q;
+        c->mode = mode;
+        c->rv = SA_ERR_HPI_UNKNOWN;
+        c->waited = 0;
+
+        return wrap_g_thread_create_new("ohpi_049", call, c, TRUE, 0);
+}
+
+/**
+ * Admission control of a handler with one slot, a queue of one and a
+ * timeout of 200 msec. While the slot is taken a second API call waits
+ * and times out, a third one is refused as the queue is full and a
+ * daemon internal call waits until the slot is given back. With two
+ * slots, a second API call gets a slot but times out on the handler
+ * lock and a sampling call gives up at once.
+ * Pass if all calls return as expected, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        struct oh_abi_queue *q;
+        struct oh_dispatch_stats stats;
+        struct caller c;
+        GThread *t;
+
+        wrap_g_static_rec_mutex_init(&lock);
+
+        /* One slot */
+        q = new_queue("1");
+        if (oh_dispatch_enter(q, &lock, OH_DISPATCH_BOUNDED) != SA_OK)
+                return -1;
+
+        t = start_call(&c, q, OH_DISPATCH_BOUNDED);
+        g_usleep(G_USEC_PER_SEC / 20);
+        if (oh_dispatch_get_stats(1, &stats) || stats.queued != 1)
+                return -1;
+        /* The queue is full */
+        if (oh_dispatch_enter(q, &lock, OH_DISPATCH_BOUNDED) !=
+            SA_ERR_HPI_BUSY)
+                return -1;
+        g_thread_join(t);
+        if (c.rv != SA_ERR_HPI_TIMEOUT || c.waited < 150)
+                return -1;
+
+        /* Daemon internal calls wait as long as it takes */
+        t = start_call(&c, q, OH_DISPATCH_WAIT);
+        g_usleep(G_USEC_PER_SEC / 2);
+        oh_dispatch_leave(q);
+        wrap_g_static_rec_mutex_unlock(&lock);
+        g_thread_join(t);
+        if (c.rv != SA_OK || c.waited < 400)
+                return -1;
+
+        if (oh_dispatch_get_stats(1, &stats))
+                return -1;
+        if (stats.active != 0 || stats.queued != 0 ||
+            stats.busy != 1 || stats.timeouts != 1)
+                return -1;
+        oh_dispatch_destroy(q);
+
+        /* Two slots, the handler lock is still taken in turns */
+        q = new_queue("2");
+        if (oh_dispatch_enter(q, &lock, OH_DISPATCH_BOUNDED) != SA_OK)
+                return -1;
+        t = start_call(&c, q, OH_DISPATCH_BOUNDED);
+        g_thread_join(t);
+        if (c.rv != SA_ERR_HPI_TIMEOUT || c.waited < 150)
+                return -1;
+        /* Background sampling does not wait at all */
+        t = start_call(&c, q, OH_DISPATCH_TRY);
+        g_thread_join(t);
+        if (c.rv != SA_ERR_HPI_BUSY || c.waited >= 150)
+                return -1;
+        if (oh_dispatch_get_stats(1, &stats))
+                return -1;
+        if (stats.active != 1 || stats.busy != 1 || stats.timeouts != 1)
+                return -1;
+        oh_dispatch_leave(q);
+        wrap_g_static_rec_mutex_unlock(&lock);
+        oh_dispatch_destroy(q);
+
+        return 0;
+}
@@ -0,0 +1,167 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define CONF "./ohpi_050.conf"
+
+static int write_conf(void)
+{
+        FILE *f = fopen(CONF, "w");
+
+        if (!f)
+                return -1;
+        fprintf(f, "OPENHPI_RPT_COMPACT = \"YES\"\n");
+        fprintf(f, "handler libsimulator {\n");
+        fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,1}\"\n");
+        fprintf(f, "        name = \"simulator\"\n");
+        fprintf(f, "}\n");
+        fclose(f);
+
+        return chmod(CONF, S_IRUSR | S_IWUSR);
+}
+
+/* Waits for the handler to open and discovers */
+static int start(SaHpiSessionIdT *sid)
+{
+        GHashTable *config;
+        oHpiHandlerInfoT info;
+        int tries;
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, sid, NULL))
+                return -1;
+        for (tries = 0; tries < 100; tries++) {
+                config = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, g_free);
+                if (oHpiHandlerInfo(*sid, 1, &info, config))
+                        return -1;
+                g_hash_table_destroy(config);
+                if (info.load_failed != OHPI_HANDLER_OPENING)
+                        break;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+        if (info.load_failed != OHPI_HANDLER_LOADED)
+                return -1;
+
+        return saHpiDiscover(*sid);
+}
+
+/* Finds a digital control that can be read */
+static int find_digital(SaHpiSessionIdT sid, SaHpiResourceIdT *rid,
+                        SaHpiCtrlNumT *num)
+{
+        SaHpiEntryIdT id, next_id, rdr_id, next_rdr_id;
+        SaHpiRptEntryT rpte;
+        SaHpiRdrT rdr;
+        SaHpiCtrlRecT *rec;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        break;
+                if (!(rpte.ResourceCapabilities & SAHPI_CAPABILITY_CONTROL))
+                        continue;
+                for (rdr_id = SAHPI_FIRST_ENTRY;
+                     rdr_id != SAHPI_LAST_ENTRY;
+                     rdr_id = next_rdr_id) {
+                        if (saHpiRdrGet(sid, rpte.ResourceId, rdr_id,
+                                        &next_rdr_id, &rdr))
+                                break;
+                        if (rdr.RdrType != SAHPI_CTRL_RDR)
+                                continue;
+                        rec = &rdr.RdrTypeUnion.CtrlRec;
+                        if (rec->Type != SAHPI_CTRL_TYPE_DIGITAL ||
+                            rec->WriteOnly)
+                                continue;
+                        *rid = rpte.ResourceId;
+                        *num = rec->Num;
+                        return 0;
+                }
+        }
+
+        return -1;
+}
+
+static int text_is(const SaHpiTextBufferT *buffer, const char *text)
+{
+        return buffer->DataLength == strlen(text) &&
+               !strncmp((const char *)buffer->Data, text, buffer->DataLength);
+}
+
+/* Number of plugin calls of handler 1 so far */
+static SaHpiUint64T abi_calls(SaHpiSessionIdT sid)
+{
+        SaHpiEntryIdT id, next_id;
+        oHpiMetricT metric;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (oHpiMetricGet(sid, id, &next_id, &metric))
+                        break;
+                if (text_is(&metric.Name,
+                            "openhpid_abi_duration_microseconds") &&
+                    text_is(&metric.Labels, "handler=\"1\""))
+                        return metric.Value;
+        }
+
+        return 0;
+}
+
+/**
+ * Run the daemon with compact RDR storage and set a readable digital
+ * control to its current mode and state. saHpiControlSet() reads the
+ * current state before setting a readable digital control, which it
+ * can only tell from the control record while the domain is locked:
+ * the RDR is a view then, freed with the domain lock.
+ * Pass if the set succeeds and took two plugin calls, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        SaHpiResourceIdT rid;
+        SaHpiCtrlNumT num;
+        SaHpiCtrlModeT mode;
+        SaHpiCtrlStateT state;
+        SaHpiUint64T calls;
+
+#ifdef M_PERTURB
+        /* A freed view reads as garbage rather than the old record */
+        mallopt(M_PERTURB, 0xa5);
+#endif
+        if (write_conf())
+                return -1;
+        setenv("OPENHPI_CONF", CONF, 1);
+
+        if (start(&sid))
+                return -1;
+        if (find_digital(sid, &rid, &num))
+                return -1;
+        if (saHpiControlGet(sid, rid, num, &mode, &state))
+                return -1;
+
+        calls = abi_calls(sid);
+        if (saHpiControlSet(sid, rid, num, mode, &state))
+                return -1;
+        if (abi_calls(sid) != calls + 2)
+                return -1;
+
+        saHpiSessionClose(sid);
+        remove(CONF);
+
+        return 0;
+}
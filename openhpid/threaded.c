@@ -18,7 +18,11 @@
 #include <oh_plugin.h>
 
 #include "event.h"
+#include "history.h"
+#include "init.h"
+#include "snapshot.h"
 #include "threaded.h"
+#include "watch.h"
 #include "sahpi_wrappers.h"
 
 
@@ -27,6 +31,7 @@ static const glong OH_EVTGET_THREAD_SLEEP_TIME    = 3 * G_USEC_PER_SEC;
 
 static volatile int started = FALSE;
 volatile int signal_stop    = FALSE;
+static volatile int reload_requested = FALSE;
 int signal_service_thread    = FALSE; /* Used by the plugins */
 
 GThread *discovery_thread = 0;
@@ -39,6 +44,21 @@ GMutex *evtget_lock    = 0;
 
 GThread *evtpop_thread = 0;
 
+static GThread **evtwork_threads = 0;
+static guint evtwork_count = 0;
+
+static GThread *history_thread = 0;
+static GMutex *history_lock    = 0;
+static GCond *history_cond     = 0;
+static glong history_interval  = 0; /* usec */
+
+static GThread *watch_thread = 0;
+
+static GThread *snapshot_thread = 0;
+static GMutex *snapshot_lock    = 0;
+static GCond *snapshot_cond     = 0;
+static glong snapshot_interval  = 0; /* usec */
+
 
 static gpointer discovery_func(gpointer data)
 {
@@ -95,6 +115,14 @@ static gpointer evtget_func(gpointer data)
                         CRIT("Error on harvest of events.");
                 }
 
+                /* Save resource ids assigned by plugins to new resources */
+                oh_uid_map_flush();
+
+                if (reload_requested && signal_stop == FALSE) {
+                        reload_requested = FALSE;
+                        oh_reload_config();
+                }
+
 		if(signal_stop == TRUE)
 			break;
 
@@ -137,6 +165,100 @@ static gpointer evtpop_func(gpointer data)
         return 0;
 }
 
+static gpointer evtwork_func(gpointer data)
+{
+        guint worker = GPOINTER_TO_UINT(data);
+        SaErrorT error = SA_OK;
+
+        DBG("Begin event processing in worker %u.", worker);
+        while(1) {
+                error = oh_process_worker_events(worker);
+                if (error == SA_OK) {
+                        // OpenHPI is about to quit
+                        break;
+                } else if (error == SA_ERR_HPI_INVALID_PARAMS) {
+                        CRIT("No event processing worker %u.", worker);
+                        break;
+                } else {
+                        CRIT("Error on processing of events.");
+                }
+        }
+        DBG("Done with event processing in worker %u.", worker);
+
+        return 0;
+}
+
+static gpointer history_func(gpointer data)
+{
+        DBG("Begin sensor history.");
+
+        g_mutex_lock(history_lock);
+        while (signal_stop == FALSE) {
+                oh_history_sample();
+
+		if(signal_stop == TRUE)
+			break;
+
+                #if GLIB_CHECK_VERSION (2, 32, 0)
+                gint64 time;
+                time = g_get_monotonic_time();
+                time = time + history_interval;
+                wrap_g_cond_timed_wait(history_cond, history_lock, time);
+                #else
+                GTimeVal time;
+                g_get_current_time(&time);
+                g_time_val_add(&time, history_interval);
+                wrap_g_cond_timed_wait(history_cond, history_lock, &time);
+                #endif
+        }
+        g_mutex_unlock(history_lock);
+
+        DBG("Done with sensor history.");
+
+        return 0;
+}
+
+static gpointer snapshot_func(gpointer data)
+{
+        DBG("Begin RPT snapshots.");
+
+        g_mutex_lock(snapshot_lock);
+        while (signal_stop == FALSE) {
+                #if GLIB_CHECK_VERSION (2, 32, 0)
+                gint64 time;
+                time = g_get_monotonic_time();
+                time = time + snapshot_interval;
+                wrap_g_cond_timed_wait(snapshot_cond, snapshot_lock, time);
+                #else
+                GTimeVal time;
+                g_get_current_time(&time);
+                g_time_val_add(&time, snapshot_interval);
+                wrap_g_cond_timed_wait(snapshot_cond, snapshot_lock, &time);
+                #endif
+
+		if(signal_stop == TRUE)
+			break;
+
+                oh_snapshot_save();
+        }
+        g_mutex_unlock(snapshot_lock);
+
+        DBG("Done with RPT snapshots.");
+
+        return 0;
+}
+
+static gpointer watch_func(gpointer data)
+{
+        DBG("Begin sensor watch.");
+
+        oh_watch_process();
+
+        DBG("Done with sensor watch.");
+
+        return 0;
+}
+
 
 int oh_threaded_start()
 {
@@ -162,14 +284,62 @@ int oh_threaded_start()
         evtget_thread = wrap_g_thread_create_new("EventGet",evtget_func, 
                                                              0, TRUE, 0);
 
+        /* Workers are set up before EventPop hands events over to them */
+        evtwork_count = oh_event_workers();
+        if (evtwork_count) {
+                guint i;
+                DBG("Starting %u event processing workers.", evtwork_count);
+                evtwork_threads = g_new0(GThread *, evtwork_count);
+                for (i = 0; i < evtwork_count; i++) {
+                        evtwork_threads[i] = wrap_g_thread_create_new("EventWork",
+                                                        evtwork_func,
+                                                        GUINT_TO_POINTER(i),
+                                                        TRUE, 0);
+                }
+        }
+
         evtpop_thread = wrap_g_thread_create_new("EventPop",evtpop_func, 
                                                              0, TRUE, 0);
 
+        history_interval = (glong)oh_history_interval() * 1000;
+        if (history_interval) {
+                DBG("Starting sensor history thread.");
+                history_cond = wrap_g_cond_new_init();
+                history_lock = wrap_g_mutex_new_init();
+                history_thread = wrap_g_thread_create_new("SensorHistory",
+                                                history_func, 0, TRUE, 0);
+        }
+
+        snapshot_interval = (glong)oh_snapshot_interval() * 1000;
+        if (snapshot_interval) {
+                DBG("Starting RPT snapshot thread.");
+                snapshot_cond = wrap_g_cond_new_init();
+                snapshot_lock = wrap_g_mutex_new_init();
+                snapshot_thread = wrap_g_thread_create_new("RptSnapshot",
+                                                snapshot_func, 0, TRUE, 0);
+        }
+
+        DBG("Starting sensor watch thread.");
+        oh_watch_init();
+        watch_thread = wrap_g_thread_create_new("SensorWatch",
+                                                watch_func, 0, TRUE, 0);
+
         started = TRUE;
 
         return 0;
 }
 
+/**
+ * oh_request_config_reload
+ *
+ * Safe to call from a signal handler. The event harvesting thread
+ * reloads the configuration on its next round, see oh_reload_config().
+ **/
+void oh_request_config_reload(void)
+{
+        reload_requested = TRUE;
+}
+
 void oh_signal_service(void)
 {
         /* Plugin may need to wait for a long time (ex: power cycle). This 
@@ -187,9 +357,50 @@ int oh_threaded_stop(void)
 
         signal_stop = TRUE;
 
+        oh_watch_stop();
+        g_thread_join(watch_thread);
+        watch_thread = 0;
+        oh_watch_finit();
+
+        if (history_thread) {
+                g_mutex_lock(history_lock);
+                g_cond_broadcast(history_cond);
+                g_mutex_unlock(history_lock);
+                g_thread_join(history_thread);
+                wrap_g_mutex_free_clear(history_lock);
+                wrap_g_cond_free(history_cond);
+                history_cond   = 0;
+                history_thread = 0;
+                history_lock   = 0;
+                oh_history_flush();
+        }
+
+        if (snapshot_thread) {
+                g_mutex_lock(snapshot_lock);
+                g_cond_broadcast(snapshot_cond);
+                g_mutex_unlock(snapshot_lock);
+                g_thread_join(snapshot_thread);
+                wrap_g_mutex_free_clear(snapshot_lock);
+                wrap_g_cond_free(snapshot_cond);
+                snapshot_cond   = 0;
+                snapshot_thread = 0;
+                snapshot_lock   = 0;
+        }
+
         g_thread_join(evtpop_thread);
         evtpop_thread = 0;
 
+        /* EventPop has passed the quit event on to every worker */
+        if (evtwork_count) {
+                guint i;
+                for (i = 0; i < evtwork_count; i++) {
+                        g_thread_join(evtwork_threads[i]);
+                }
+                g_free(evtwork_threads);
+                evtwork_threads = 0;
+                evtwork_count = 0;
+        }
+
         g_mutex_lock(evtget_lock);
         g_cond_broadcast(evtget_cond);
         g_mutex_unlock(evtget_lock);
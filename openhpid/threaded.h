@@ -23,6 +23,7 @@ extern "C" {
 
 int oh_threaded_start(void);
 void oh_signal_service(void);
+void oh_request_config_reload(void);
 int oh_threaded_stop(void);
 
 void oh_wake_discovery_thread(void);
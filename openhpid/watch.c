@@ -0,0 +1,589 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+
+#include <oHpi.h>
+#include <oh_domain.h>
+#include <oh_error.h>
+#include <oh_plugin.h>
+#include <oh_utils.h>
+#include <sahpi_wrappers.h>
+
+#include "event.h"
+#include "metrics.h"
+#include "watch.h"
+
+struct oh_watch_key {
+        SaHpiDomainIdT did;
+        SaHpiResourceIdT rid;
+        SaHpiSensorNumT num;
+};
+
+struct oh_watch_client {
+        SaHpiSessionIdT sid;
+        SaHpiUint32T interval;
+        SaHpiFloat64T hysteresis;
+};
+
+struct oh_sensor_watch {
+        struct oh_watch_key key;
+        GSList *clients;
+        SaHpiUint32T interval;    /* Shortest one of the clients, msec */
+        SaHpiFloat64T hysteresis; /* Smallest one of the clients */
+        SaHpiUint64T due;         /* oh_metrics_now() of the next poll */
+        SaHpiBoolT polled;        /* last and last_state are valid */
+        SaHpiSensorReadingT last; /* Reading of the last event */
+        SaHpiEventStateT last_state;
+};
+
+/* A due sensor, polled without holding any lock */
+struct oh_watch_target {
+        struct oh_watch_key key;
+        unsigned int hid;
+        SaHpiRptEntryT rpte;
+        SaHpiRdrT rdr;
+        SaHpiSensorReadingT reading;
+        SaHpiEventStateT state;
+};
+
+static struct {
+        GMutex *lock;
+        GCond *cond;
+        GHashTable *table;
+        int stop;
+} watch = { 0, 0, 0, 0 };
+
+static guint watch_key_hash(gconstpointer key)
+{
+        const struct oh_watch_key *k = key;
+
+        return (k->did * 65599) ^ (k->rid * 257) ^ k->num;
+}
+
+static gboolean watch_key_equal(gconstpointer a, gconstpointer b)
+{
+        const struct oh_watch_key *ka = a, *kb = b;
+
+        return ka->did == kb->did && ka->rid == kb->rid && ka->num == kb->num;
+}
+
+static void free_watch(gpointer data)
+{
+        struct oh_sensor_watch *w = data;
+        GSList *node;
+
+        for (node = w->clients; node; node = node->next)
+                g_free(node->data);
+        g_slist_free(w->clients);
+        g_free(w);
+}
+
+/* Call with watch.lock held. Returns 0 if no client is left. */
+static int update_watch(struct oh_sensor_watch *w)
+{
+        struct oh_watch_client *c;
+        GSList *node;
+
+        if (!w->clients)
+                return 0;
+
+        c = w->clients->data;
+        w->interval = c->interval;
+        w->hysteresis = c->hysteresis;
+        for (node = w->clients->next; node; node = node->next) {
+                c = node->data;
+                if (c->interval < w->interval)
+                        w->interval = c->interval;
+                if (c->hysteresis < w->hysteresis)
+                        w->hysteresis = c->hysteresis;
+        }
+
+        return 1;
+}
+
+static struct oh_watch_client *find_client(struct oh_sensor_watch *w,
+                                           SaHpiSessionIdT sid)
+{
+        struct oh_watch_client *c;
+        GSList *node;
+
+        for (node = w->clients; node; node = node->next) {
+                c = node->data;
+                if (c->sid == sid)
+                        return c;
+        }
+
+        return NULL;
+}
+
+static SaHpiFloat64T reading_value(const SaHpiSensorReadingT *reading)
+{
+        switch (reading->Type) {
+        case SAHPI_SENSOR_READING_TYPE_INT64:
+                return (SaHpiFloat64T)reading->Value.SensorInt64;
+        case SAHPI_SENSOR_READING_TYPE_UINT64:
+                return (SaHpiFloat64T)reading->Value.SensorUint64;
+        case SAHPI_SENSOR_READING_TYPE_FLOAT64:
+                return reading->Value.SensorFloat64;
+        default:
+                return 0;
+        }
+}
+
+/* Numbers have to move by the hysteresis, anything else just change */
+static int reading_changed(const struct oh_sensor_watch *w,
+                           const SaHpiSensorReadingT *reading)
+{
+        SaHpiFloat64T delta;
+
+        if (reading->IsSupported != w->last.IsSupported)
+                return 1;
+        if (!reading->IsSupported)
+                return 0;
+        if (reading->Type != w->last.Type)
+                return 1;
+
+        switch (reading->Type) {
+        case SAHPI_SENSOR_READING_TYPE_INT64:
+        case SAHPI_SENSOR_READING_TYPE_UINT64:
+        case SAHPI_SENSOR_READING_TYPE_FLOAT64:
+                delta = reading_value(reading) - reading_value(&w->last);
+                if (delta < 0)
+                        delta = -delta;
+                if (w->hysteresis == 0)
+                        return delta != 0;
+                return delta >= w->hysteresis;
+        default:
+                return memcmp(reading->Value.SensorBuffer,
+                              w->last.Value.SensorBuffer,
+                              SAHPI_SENSOR_BUFFER_LENGTH) != 0;
+        }
+}
+
+static struct oh_event *make_event(const struct oh_watch_target *t,
+                                   SaHpiEventStateT previous)
+{
+        struct oh_event *e = g_new0(struct oh_event, 1);
+        SaHpiSensorEventT *se = &e->event.EventDataUnion.SensorEvent;
+        const SaHpiSensorRecT *rec = &t->rdr.RdrTypeUnion.SensorRec;
+        SaHpiRdrT *rdr = g_new0(SaHpiRdrT, 1);
+
+        *rdr = t->rdr;
+        e->hid = t->hid;
+        e->resource = t->rpte;
+        e->rdrs = g_slist_append(NULL, rdr);
+
+        e->event.Source = t->key.rid;
+        e->event.EventType = SAHPI_ET_SENSOR;
+        e->event.Severity = SAHPI_INFORMATIONAL;
+        oh_gettimeofday(&e->event.Timestamp);
+
+        se->SensorNum = rec->Num;
+        se->SensorType = rec->Type;
+        se->EventCategory = rec->Category;
+        se->Assertion = SAHPI_TRUE;
+        se->EventState = t->state;
+        se->OptionalDataPresent = SAHPI_SOD_PREVIOUS_STATE | SAHPI_SOD_OEM;
+        se->PreviousState = previous;
+        se->Oem = OHPI_SENSOR_WATCH_OEM;
+        if (t->reading.IsSupported) {
+                se->OptionalDataPresent |= SAHPI_SOD_TRIGGER_READING;
+                se->TriggerReading = t->reading;
+        }
+
+        return e;
+}
+
+struct due_scan {
+        SaHpiUint64T now;
+        SaHpiUint64T next;
+        GArray *targets;
+};
+
+static void scan_watch(gpointer key, gpointer value, gpointer data)
+{
+        struct oh_sensor_watch *w = value;
+        struct due_scan *scan = data;
+        struct oh_watch_target t;
+
+        if (w->due <= scan->now) {
+                memset(&t, 0, sizeof(t));
+                t.key = w->key;
+                g_array_append_val(scan->targets, t);
+                /* Keep the pace, unless polling fell behind */
+                w->due += (SaHpiUint64T)w->interval * 1000;
+                if (w->due <= scan->now)
+                        w->due = scan->now + (SaHpiUint64T)w->interval * 1000;
+        }
+        if (scan->next == 0 || w->due < scan->next)
+                scan->next = w->due;
+}
+
+/* Call with watch.lock held */
+static GArray *due_targets(SaHpiUint64T now, SaHpiUint64T *next)
+{
+        struct due_scan scan;
+
+        scan.now = now;
+        scan.next = 0;
+        scan.targets = g_array_new(FALSE, TRUE, sizeof(struct oh_watch_target));
+        g_hash_table_foreach(watch.table, scan_watch, &scan);
+        *next = scan.next;
+
+        return scan.targets;
+}
+
+/* Returns SA_OK if the sensor could be read */
+static SaErrorT poll_target(struct oh_watch_target *t)
+{
+        struct oh_domain *d;
+        struct oh_handler *h;
+        SaHpiRptEntryT *rpte;
+        SaHpiRdrT *rdr;
+        unsigned int *hid;
+        SaHpiUint64T start;
+        SaErrorT error, rv = SA_ERR_HPI_INVALID_CMD;
+
+        d = oh_get_domain(t->key.did);
+        if (!d)
+                return SA_ERR_HPI_INVALID_DOMAIN;
+        rpte = oh_get_resource_by_id(&d->rpt, t->key.rid);
+        rdr = oh_get_rdr_by_type(&d->rpt, t->key.rid,
+                                 SAHPI_SENSOR_RDR, t->key.num);
+        hid = oh_get_resource_data(&d->rpt, t->key.rid);
+        if (!rpte || !rdr || !hid) {
+                /* Gone for now, maybe it comes back */
+                oh_release_domain(d);
+                return SA_ERR_HPI_NOT_PRESENT;
+        }
+        t->rpte = *rpte;
+        t->rdr = *rdr;
+        t->hid = *hid;
+        oh_release_domain(d);
+
+        /* Users come first: skip this round if the handler is busy */
+        h = oh_get_handler_try(t->hid, &error);
+        if (!h)
+                return error != SA_OK ? error : SA_ERR_HPI_INVALID_RESOURCE;
+        if (h->hnd && h->abi->get_sensor_reading) {
+                start = oh_metrics_now();
+                rv = h->abi->get_sensor_reading(h->hnd, t->key.rid, t->key.num,
+                                                &t->reading, &t->state);
+                oh_metrics_abi(h->id, oh_metrics_now() - start);
+        }
+        oh_release_handler(h);
+
+        return rv;
+}
+
+static void poll_targets(GArray *targets)
+{
+        struct oh_watch_target *t;
+        struct oh_sensor_watch *w;
+        struct oh_event *e;
+        GSList *events = NULL, *node;
+        SaHpiEventStateT previous;
+        guint i;
+
+        for (i = 0; i < targets->len; i++) {
+                t = &g_array_index(targets, struct oh_watch_target, i);
+                if (poll_target(t) != SA_OK)
+                        continue;
+
+                g_mutex_lock(watch.lock);
+                w = g_hash_table_lookup(watch.table, &t->key);
+                if (w && !w->polled) {
+                        /* First reading is the base to compare with */
+                        w->last = t->reading;
+                        w->last_state = t->state;
+                        w->polled = SAHPI_TRUE;
+                } else if (w && (t->state != w->last_state ||
+                                 reading_changed(w, &t->reading))) {
+                        previous = w->last_state;
+                        w->last = t->reading;
+                        w->last_state = t->state;
+                        events = g_slist_prepend(events,
+                                                 make_event(t, previous));
+                }
+                g_mutex_unlock(watch.lock);
+        }
+
+        /* Into the pipeline like any plugin event */
+        events = g_slist_reverse(events);
+        for (node = events; node; node = node->next) {
+                e = node->data;
+                oh_evt_queue_push(oh_process_q, e);
+        }
+        g_slist_free(events);
+}
+
+/**
+ * oh_watch_add
+ * @did: domain of the session
+ * @sid: session that wants the sensor watched
+ * @rid: resource id of the sensor
+ * @num: sensor number
+ * @interval: poll interval in msec
+ * @hysteresis: how far a numeric reading has to move from the reading
+ * of the last event for a new event, 0 for any change
+ *
+ * Adds the session to the watchers of the sensor, or changes its
+ * interval and hysteresis. The sensor is polled at the shortest
+ * interval and with the smallest hysteresis of its watchers.
+ *
+ * Returns: SA_OK on success, SA_ERR_HPI_INVALID_PARAMS for an interval
+ * below OHPI_SENSOR_WATCH_MIN_INTERVAL or a negative hysteresis,
+ * SA_ERR_HPI_NOT_PRESENT if there is no such sensor.
+ **/
+SaErrorT oh_watch_add(SaHpiDomainIdT did,
+                      SaHpiSessionIdT sid,
+                      SaHpiResourceIdT rid,
+                      SaHpiSensorNumT num,
+                      SaHpiUint32T interval,
+                      SaHpiFloat64T hysteresis)
+{
+        struct oh_sensor_watch *w;
+        struct oh_watch_client *c;
+        struct oh_watch_key key;
+        struct oh_domain *d;
+        SaHpiRptEntryT *rpte;
+
+        if (interval < OHPI_SENSOR_WATCH_MIN_INTERVAL || !(hysteresis >= 0))
+                return SA_ERR_HPI_INVALID_PARAMS;
+
+        d = oh_get_domain(did);
+        if (!d)
+                return SA_ERR_HPI_INVALID_DOMAIN;
+        rpte = oh_get_resource_by_id(&d->rpt, rid);
+        if (!rpte) {
+                oh_release_domain(d);
+                return SA_ERR_HPI_INVALID_RESOURCE;
+        }
+        if (!(rpte->ResourceCapabilities & SAHPI_CAPABILITY_SENSOR)) {
+                oh_release_domain(d);
+                return SA_ERR_HPI_CAPABILITY;
+        }
+        if (!oh_get_rdr_by_type(&d->rpt, rid, SAHPI_SENSOR_RDR, num)) {
+                oh_release_domain(d);
+                return SA_ERR_HPI_NOT_PRESENT;
+        }
+        oh_release_domain(d);
+
+        if (!watch.lock)
+                return SA_ERR_HPI_INVALID_REQUEST;
+
+        memset(&key, 0, sizeof(key));
+        key.did = did;
+        key.rid = rid;
+        key.num = num;
+
+        g_mutex_lock(watch.lock);
+        w = g_hash_table_lookup(watch.table, &key);
+        if (!w) {
+                w = g_new0(struct oh_sensor_watch, 1);
+                w->key = key;
+                w->due = oh_metrics_now();
+                g_hash_table_insert(watch.table, &w->key, w);
+        }
+        c = find_client(w, sid);
+        if (!c) {
+                c = g_new0(struct oh_watch_client, 1);
+                c->sid = sid;
+                w->clients = g_slist_append(w->clients, c);
+        }
+        c->interval = interval;
+        c->hysteresis = hysteresis;
+        update_watch(w);
+        /* The scheduler may sleep longer than the new interval */
+        g_cond_signal(watch.cond);
+        g_mutex_unlock(watch.lock);
+
+        return SA_OK;
+}
+
+/**
+ * oh_watch_remove
+ * @did: domain of the session
+ * @sid: session that watches the sensor
+ * @rid: resource id of the sensor
+ * @num: sensor number
+ *
+ * Returns: SA_OK on success, SA_ERR_HPI_NOT_PRESENT if the session
+ * does not watch the sensor.
+ **/
+SaErrorT oh_watch_remove(SaHpiDomainIdT did,
+                         SaHpiSessionIdT sid,
+                         SaHpiResourceIdT rid,
+                         SaHpiSensorNumT num)
+{
+        struct oh_sensor_watch *w;
+        struct oh_watch_client *c = NULL;
+        struct oh_watch_key key;
+        SaErrorT rv = SA_ERR_HPI_NOT_PRESENT;
+
+        if (!watch.lock)
+                return SA_ERR_HPI_NOT_PRESENT;
+
+        memset(&key, 0, sizeof(key));
+        key.did = did;
+        key.rid = rid;
+        key.num = num;
+
+        g_mutex_lock(watch.lock);
+        w = g_hash_table_lookup(watch.table, &key);
+        if (w)
+                c = find_client(w, sid);
+        if (c) {
+                w->clients = g_slist_remove(w->clients, c);
+                g_free(c);
+                if (!update_watch(w))
+                        g_hash_table_remove(watch.table, &key);
+                rv = SA_OK;
+        }
+        g_mutex_unlock(watch.lock);
+
+        return rv;
+}
+
+static gboolean remove_session(gpointer key, gpointer value, gpointer data)
+{
+        struct oh_sensor_watch *w = value;
+        struct oh_watch_client *c;
+
+        c = find_client(w, GPOINTER_TO_UINT(data));
+        if (c) {
+                w->clients = g_slist_remove(w->clients, c);
+                g_free(c);
+        }
+
+        return !update_watch(w);
+}
+
+/**
+ * oh_watch_remove_session
+ * @sid: session that is closed
+ *
+ * Drops all watches of the session.
+ **/
+void oh_watch_remove_session(SaHpiSessionIdT sid)
+{
+        if (!watch.lock)
+                return;
+
+        g_mutex_lock(watch.lock);
+        g_hash_table_foreach_remove(watch.table, remove_session,
+                                    GUINT_TO_POINTER(sid));
+        g_mutex_unlock(watch.lock);
+}
+
+/**
+ * oh_watch_init
+ *
+ * Sets up the watch table. Called before the scheduler thread starts.
+ **/
+void oh_watch_init(void)
+{
+        if (watch.lock)
+                return;
+
+        watch.table = g_hash_table_new_full(watch_key_hash, watch_key_equal,
+                                            NULL, free_watch);
+        watch.cond = wrap_g_cond_new_init();
+        watch.lock = wrap_g_mutex_new_init();
+        watch.stop = 0;
+}
+
+/**
+ * oh_watch_finit
+ *
+ * Drops all watches. Called after the scheduler thread is done.
+ **/
+void oh_watch_finit(void)
+{
+        if (!watch.lock)
+                return;
+
+        g_hash_table_destroy(watch.table);
+        wrap_g_cond_free(watch.cond);
+        wrap_g_mutex_free_clear(watch.lock);
+        memset(&watch, 0, sizeof(watch));
+}
+
+/**
+ * oh_watch_process
+ *
+ * The scheduler: polls the sensors that are due, posts events for the
+ * ones that changed and sleeps until the next one is due. One pass
+ * over the table per wakeup, so sensors with the same interval are
+ * polled in one batch.
+ *
+ * Returns: SA_OK once oh_watch_stop() was called.
+ **/
+SaErrorT oh_watch_process(void)
+{
+        SaHpiUint64T now, next, delay;
+        GArray *targets;
+
+        if (!watch.lock)
+                return SA_ERR_HPI_INVALID_REQUEST;
+
+        g_mutex_lock(watch.lock);
+        while (!watch.stop) {
+                now = oh_metrics_now();
+                targets = due_targets(now, &next);
+                if (targets->len) {
+                        g_mutex_unlock(watch.lock);
+                        poll_targets(targets);
+                        g_array_free(targets, TRUE);
+                        g_mutex_lock(watch.lock);
+                        continue;
+                }
+                g_array_free(targets, TRUE);
+
+                if (next == 0) {
+                        g_cond_wait(watch.cond, watch.lock);
+                        continue;
+                }
+
+                delay = next - now;
+                #if GLIB_CHECK_VERSION (2, 32, 0)
+                gint64 time;
+                time = g_get_monotonic_time();
+                time = time + delay;
+                wrap_g_cond_timed_wait(watch.cond, watch.lock, time);
+                #else
+                GTimeVal time;
+                g_get_current_time(&time);
+                g_time_val_add(&time, delay);
+                wrap_g_cond_timed_wait(watch.cond, watch.lock, &time);
+                #endif
+        }
+        g_mutex_unlock(watch.lock);
+
+        return SA_OK;
+}
+
+/**
+ * oh_watch_stop
+ *
+ * Makes oh_watch_process() return.
+ **/
+void oh_watch_stop(void)
+{
+        if (!watch.lock)
+                return;
+
+        g_mutex_lock(watch.lock);
+        watch.stop = 1;
+        g_cond_broadcast(watch.cond);
+        g_mutex_unlock(watch.lock);
+}
@@ -0,0 +1,51 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __OH_WATCH_H
+#define __OH_WATCH_H
+
+#include <glib.h>
+#include <SaHpi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sensor watches.
+ *
+ * Sessions register sensors of the default domain with a poll interval
+ * and a hysteresis. Each sensor is polled once per interval however
+ * many sessions watch it, and a sensor event goes into the event
+ * pipeline when its reading or event state changed.
+ */
+SaErrorT oh_watch_add(SaHpiDomainIdT did,
+                      SaHpiSessionIdT sid,
+                      SaHpiResourceIdT rid,
+                      SaHpiSensorNumT num,
+                      SaHpiUint32T interval,
+                      SaHpiFloat64T hysteresis);
+SaErrorT oh_watch_remove(SaHpiDomainIdT did,
+                         SaHpiSessionIdT sid,
+                         SaHpiResourceIdT rid,
+                         SaHpiSensorNumT num);
+void oh_watch_remove_session(SaHpiSessionIdT sid);
+
+void oh_watch_init(void);
+void oh_watch_finit(void);
+SaErrorT oh_watch_process(void);
+void oh_watch_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OH_WATCH_H */
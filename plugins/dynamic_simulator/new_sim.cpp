@@ -31,6 +31,7 @@
 
 #include "new_sim.h"
 #include "new_sim_utils.h"
+#include "new_sim_timer_queue.h"
 
 /// Definition of eventlog size
 #define NEWSIM_EVENTLOG_ENTRIES 256
@@ -4062,12 +4063,18 @@ static SaHpiTimeoutT GetTimeout( GHashTable *handler_config, const char *str,
 /**
  * Constructor
  **/
-NewSimulator::NewSimulator() : m_magic( dNewSimulatorMagic ), m_handler( 0 ) {}
+NewSimulator::NewSimulator() : m_magic( dNewSimulatorMagic ), m_handler( 0 ) {
+
+   NewSimulatorTimerQueue::Ref();
+}
 
 /**
  * Destructor
  **/
-NewSimulator::~NewSimulator() {}
+NewSimulator::~NewSimulator() {
+
+   NewSimulatorTimerQueue::Unref();
+}
 
 /**
  * Set handler pointer
@@ -34,6 +34,7 @@
 #include "new_sim_file_watchdog.h"
 #include "new_sim_file_fumi.h"
 #include "new_sim_file_dimi.h"
+#include "new_sim_file_topology.h"
 #include "new_sim_domain.h"
 #include "new_sim_entity.h"
 #include "new_sim_utils.h"
@@ -199,6 +200,7 @@ bool NewSimulatorFile::Open() {
    m_tokens.Add(new SimulatorToken( "FUMI_SOURCE_DATA",  FUMI_SOURCE_DATA_TOKEN_HANDLER ));
    m_tokens.Add(new SimulatorToken( "FUMI_TARGET_DATA",  FUMI_TARGET_DATA_TOKEN_HANDLER ));
    m_tokens.Add(new SimulatorToken( "FUMI_LOG_TARGET_DATA", FUMI_LOG_TARGET_DATA_TOKEN_HANDLER ));
+   m_tokens.Add(new SimulatorToken( "TOPOLOGY", TOPOLOGY_TOKEN_HANDLER ));
    
    stdlog << "DBG: NewSimulatorFile::Open()\n";
    stdlog << "DBG: Working with entity path: " << m_root_ep << "\n";
@@ -228,6 +230,7 @@ bool NewSimulatorFile::Open() {
                         break;
       case RPT_TOKEN_HANDLER:
       case RDR_TOKEN_HANDLER:
+      case TOPOLOGY_TOKEN_HANDLER:
                         err("Configuration settings are missing in the file - setting default values");
                         m_mode = INIT;
                         done = 1; 
@@ -277,6 +280,17 @@ bool NewSimulatorFile::Discover(NewSimulatorDomain *domain) {
          }   
          break;
 
+      case TOPOLOGY_TOKEN_HANDLER:
+         stdlog << "DBG: NewSimulatorFile::Discover: Generate topology\n";
+         success = process_topology_token(domain);
+         if (!success) {
+            done = 1;
+            err("Stop parsing due to the error before");
+         } else {
+            cur_token = g_scanner_peek_next_token (m_scanner);
+         }
+         break;
+
       default:
          cur_token = g_scanner_get_next_token(m_scanner);
          g_scanner_unexp_token(m_scanner, G_TOKEN_SYMBOL, NULL, 
@@ -536,6 +550,28 @@ bool NewSimulatorFile::process_rpt_token( NewSimulatorDomain *domain ) {
    return success;
 }
 
+/** 
+ * Read the TOPOLOGY section and generate its resources
+ *
+ * Startpoint is token \c TOPOLOGY_TOKEN_HANDLER. Endpoint is the last
+ * \c G_TOKEN_RIGHT_CURLY of the \c TOPOLOGY section. The parsing is done
+ * by NewSimulatorFileTopology::process_token(), the resources are added to
+ * the domain by NewSimulatorFileTopology::Generate().
+ * 
+ * @param domain Pointer to a NewSimulatorDomain object
+ * 
+ * @return success bool
+ **/
+bool NewSimulatorFile::process_topology_token( NewSimulatorDomain *domain ) {
+   NewSimulatorFileTopology topology( m_scanner, m_root_ep );
+
+   if ( !topology.process_token() )
+      return false;
+
+   return topology.Generate( domain );
+}
+
+
 /** 
  * Read one RDR section
  *
@@ -64,6 +64,7 @@ class NewSimulatorFile : public NewSimulatorFileUtil {
    bool process_rpt_token(NewSimulatorDomain *domain);
    bool process_rpt_info(SaHpiResourceInfoT *rptinfo);
    bool process_rdr_token( NewSimulatorResource *res );
+   bool process_topology_token( NewSimulatorDomain *domain );
    bool process_empty();
    
    public:
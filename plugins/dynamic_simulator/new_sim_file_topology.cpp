@@ -0,0 +1,300 @@
+/**
+ * @file    new_sim_file_topology.cpp
+ *
+ * The file includes the class for parsing the topology section and
+ * generating the described resources:\n
+ * NewSimulatorFileTopology
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+#include <SaHpi.h>
+
+#include "new_sim_file_topology.h"
+#include "new_sim_file_util.h"
+#include "new_sim_domain.h"
+#include "new_sim_resource.h"
+#include "new_sim_sensor_threshold.h"
+#include "new_sim_text_buffer.h"
+
+#include <oh_error.h>
+#include <oh_utils.h>
+
+
+/**
+ * Constructor
+ **/
+NewSimulatorFileTopology::NewSimulatorFileTopology( GScanner *scanner,
+                                                    NewSimulatorEntityPath root )
+                        : NewSimulatorFileUtil( scanner ),
+                          m_racks( 0 ),
+                          m_chassis( 0 ),
+                          m_blades( 0 ),
+                          m_sensors( 0 ) {
+
+   m_root_ep = root;
+}
+
+
+/**
+ * Destructor
+ **/
+NewSimulatorFileTopology::~NewSimulatorFileTopology() {
+}
+
+
+/**
+ * Read the \c TOPOLOGY section
+ *
+ * Startpoint is token \c TOPOLOGY_TOKEN_HANDLER. Endpoint is the last
+ * \c G_TOKEN_RIGHT_CURLY of the \c TOPOLOGY section.
+ *
+ * @return success
+ **/
+bool NewSimulatorFileTopology::process_token() {
+   int depth = 0;
+   bool success = true;
+   gchar *field;
+   guint cur_token = g_scanner_get_next_token(m_scanner);
+
+   if (g_scanner_get_next_token(m_scanner) != G_TOKEN_LEFT_CURLY) {
+      err("Processing parse topology: Expected left curly token.");
+      return false;
+   }
+   depth++;
+
+   while ( (depth > 0) && success ) {
+      cur_token = g_scanner_get_next_token(m_scanner);
+
+      switch (cur_token) {
+         case G_TOKEN_EOF:
+            err("Processing parse topology: File ends too early");
+            success = false;
+            break;
+
+         case G_TOKEN_RIGHT_CURLY:
+            depth--;
+            break;
+
+         case G_TOKEN_STRING:
+            field = g_strdup(m_scanner->value.v_string);
+
+            if (g_scanner_get_next_token(m_scanner) != G_TOKEN_EQUAL_SIGN) {
+               err("Processing parse topology: Missing equal sign");
+               success = false;
+
+            } else if (g_scanner_get_next_token(m_scanner) != G_TOKEN_INT) {
+               err("Processing parse topology: Wrong kind of value for %s", field);
+               success = false;
+
+            } else if (!strcmp(field, "Racks")) {
+               m_racks = m_scanner->value.v_int;
+
+            } else if (!strcmp(field, "Chassis")) {
+               m_chassis = m_scanner->value.v_int;
+
+            } else if (!strcmp(field, "Blades")) {
+               m_blades = m_scanner->value.v_int;
+
+            } else if (!strcmp(field, "Sensors")) {
+               m_sensors = m_scanner->value.v_int;
+
+            } else {
+               err("Processing parse topology: Unknown field %s", field);
+               success = false;
+            }
+            g_free(field);
+            break;
+
+         default:
+            err("Processing parse topology: Unknown token");
+            success = false;
+            break;
+      }
+   }
+
+   // Sensor numbers of a resource have to fit in the sensor number table
+   if ( m_sensors > 255 ) {
+      err("Processing parse topology: Too many sensors per blade %u", m_sensors);
+      success = false;
+   }
+
+   stdlog << "DBG: Topology " << m_racks << " racks, " << m_chassis << " chassis, "
+          << m_blades << " blades, " << m_sensors << " sensors\n";
+
+   return success;
+}
+
+
+/**
+ * Generate the resources of the topology and add them to the domain
+ *
+ * @param domain pointer on the domain
+ *
+ * @return success
+ **/
+bool NewSimulatorFileTopology::Generate( NewSimulatorDomain *domain ) {
+   SaHpiEntityPathT root = m_root_ep;
+   SaHpiEntityPathT ep;
+   char tag[SAHPI_MAX_TEXT_BUFFER_LENGTH];
+   unsigned int count = 0;
+
+   for ( unsigned int r = 1; r <= m_racks; r++ ) {
+      memset( &ep, 0, sizeof( SaHpiEntityPathT ));
+      ep.Entry[0].EntityType     = SAHPI_ENT_RACK;
+      ep.Entry[0].EntityLocation = r;
+      ep.Entry[1].EntityType     = SAHPI_ENT_ROOT;
+      oh_concat_ep( &ep, &root );
+      snprintf( tag, sizeof( tag ), "Rack %u", r );
+      if ( !create_resource( domain, ep, SAHPI_CAPABILITY_RESOURCE, tag ) )
+         return false;
+      count++;
+
+      for ( unsigned int c = 1; c <= m_chassis; c++ ) {
+         memset( &ep, 0, sizeof( SaHpiEntityPathT ));
+         ep.Entry[0].EntityType     = SAHPI_ENT_SYSTEM_CHASSIS;
+         ep.Entry[0].EntityLocation = c;
+         ep.Entry[1].EntityType     = SAHPI_ENT_RACK;
+         ep.Entry[1].EntityLocation = r;
+         ep.Entry[2].EntityType     = SAHPI_ENT_ROOT;
+         oh_concat_ep( &ep, &root );
+         snprintf( tag, sizeof( tag ), "Rack %u Chassis %u", r, c );
+         if ( !create_resource( domain, ep, SAHPI_CAPABILITY_RESOURCE, tag ) )
+            return false;
+         count++;
+
+         for ( unsigned int b = 1; b <= m_blades; b++ ) {
+            memset( &ep, 0, sizeof( SaHpiEntityPathT ));
+            ep.Entry[0].EntityType     = SAHPI_ENT_SYSTEM_BLADE;
+            ep.Entry[0].EntityLocation = b;
+            ep.Entry[1].EntityType     = SAHPI_ENT_SYSTEM_CHASSIS;
+            ep.Entry[1].EntityLocation = c;
+            ep.Entry[2].EntityType     = SAHPI_ENT_RACK;
+            ep.Entry[2].EntityLocation = r;
+            ep.Entry[3].EntityType     = SAHPI_ENT_ROOT;
+            oh_concat_ep( &ep, &root );
+            snprintf( tag, sizeof( tag ), "Rack %u Chassis %u Blade %u", r, c, b );
+            SaHpiCapabilitiesT caps = SAHPI_CAPABILITY_RESOURCE | SAHPI_CAPABILITY_FRU;
+            if ( m_sensors > 0 )
+               caps |= SAHPI_CAPABILITY_RDR | SAHPI_CAPABILITY_SENSOR;
+            if ( !create_resource( domain, ep, caps, tag ) )
+               return false;
+            count++;
+         }
+      }
+   }
+
+   stdlog << "DBG: Topology generated " << count << " resources\n";
+
+   return true;
+}
+
+
+/**
+ * Create one resource including its sensors, add it to the domain and
+ * populate it
+ *
+ * @return pointer on the new resource, 0 on error
+ **/
+NewSimulatorResource *NewSimulatorFileTopology::create_resource( NewSimulatorDomain *domain,
+                                                                 SaHpiEntityPathT &ep,
+                                                                 SaHpiCapabilitiesT caps,
+                                                                 const char *tag ) {
+   NewSimulatorResource *res = new NewSimulatorResource( domain );
+
+   res->EntityPath() = NewSimulatorEntityPath( ep );
+   res->ResourceCapabilities() = caps;
+   res->HotSwapCapabilities() = 0;
+   res->ResourceSeverity() = SAHPI_MAJOR;
+   res->ResourceFailed() = SAHPI_FALSE;
+   res->ResourceTag() = NewSimulatorTextBuffer( tag, SAHPI_TL_TYPE_TEXT );
+
+   domain->AddResource( res );
+
+   if ( caps & SAHPI_CAPABILITY_SENSOR ) {
+      for ( unsigned int i = 1; i <= m_sensors; i++ ) {
+         if ( !create_sensor( res, ep, i ) )
+            return 0;
+      }
+   }
+
+   if ( !res->Populate() ) {
+      err("Topology: Couldn't populate resource %s", tag);
+      return 0;
+   }
+
+   return res;
+}
+
+
+/**
+ * Create a temperature sensor with upper major and critical thresholds
+ *
+ * @return success
+ **/
+bool NewSimulatorFileTopology::create_sensor( NewSimulatorResource *res,
+                                              SaHpiEntityPathT &ep,
+                                              SaHpiSensorNumT num ) {
+   SaHpiRdrT rdr;
+   SaHpiSensorReadingT data;
+   SaHpiSensorThresholdsT thresholds;
+   char name[SAHPI_MAX_TEXT_BUFFER_LENGTH];
+
+   memset( &rdr, 0, sizeof( SaHpiRdrT ));
+   rdr.RdrType = SAHPI_SENSOR_RDR;
+   rdr.Entity  = ep;
+   rdr.IsFru   = SAHPI_FALSE;
+   snprintf( name, sizeof( name ), "Temperature %u", num );
+   rdr.IdString = NewSimulatorTextBuffer( name, SAHPI_TL_TYPE_TEXT );
+
+   SaHpiSensorRecT &rec = rdr.RdrTypeUnion.SensorRec;
+   rec.Num        = num;
+   rec.Type       = SAHPI_TEMPERATURE;
+   rec.Category   = SAHPI_EC_THRESHOLD;
+   rec.EnableCtrl = SAHPI_TRUE;
+   rec.EventCtrl  = SAHPI_SEC_PER_EVENT;
+   rec.Events     = SAHPI_ES_UPPER_MAJOR | SAHPI_ES_UPPER_CRIT;
+   rec.DataFormat.IsSupported = SAHPI_TRUE;
+   rec.DataFormat.ReadingType = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   rec.DataFormat.BaseUnits   = SAHPI_SU_DEGREES_C;
+   rec.DataFormat.ModifierUse = SAHPI_SMUU_NONE;
+   rec.DataFormat.Range.Flags = SAHPI_SRF_MIN | SAHPI_SRF_MAX;
+   rec.DataFormat.Range.Min.IsSupported = SAHPI_TRUE;
+   rec.DataFormat.Range.Min.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   rec.DataFormat.Range.Min.Value.SensorFloat64 = 0;
+   rec.DataFormat.Range.Max.IsSupported = SAHPI_TRUE;
+   rec.DataFormat.Range.Max.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   rec.DataFormat.Range.Max.Value.SensorFloat64 = 125;
+   rec.ThresholdDefn.IsAccessible = SAHPI_TRUE;
+   rec.ThresholdDefn.ReadThold    = SAHPI_STM_UP_MAJOR | SAHPI_STM_UP_CRIT;
+   rec.ThresholdDefn.WriteThold   = SAHPI_STM_UP_MAJOR | SAHPI_STM_UP_CRIT;
+
+   memset( &data, 0, sizeof( SaHpiSensorReadingT ));
+   data.IsSupported = SAHPI_TRUE;
+   data.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   data.Value.SensorFloat64 = 30 + ( num % 10 );
+
+   memset( &thresholds, 0, sizeof( SaHpiSensorThresholdsT ));
+   thresholds.UpMajor.IsSupported = SAHPI_TRUE;
+   thresholds.UpMajor.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   thresholds.UpMajor.Value.SensorFloat64 = 80;
+   thresholds.UpCritical.IsSupported = SAHPI_TRUE;
+   thresholds.UpCritical.Type = SAHPI_SENSOR_READING_TYPE_FLOAT64;
+   thresholds.UpCritical.Value.SensorFloat64 = 95;
+
+   NewSimulatorRdr *sensor = new NewSimulatorSensorThreshold( res, rdr, data, 0,
+                                                              rec.Events, rec.Events,
+                                                              thresholds,
+                                                              SAHPI_TRUE, SAHPI_TRUE );
+
+   return res->AddRdr( sensor );
+}
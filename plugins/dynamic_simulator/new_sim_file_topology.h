@@ -0,0 +1,75 @@
+/**
+ * @file    new_sim_file_topology.h
+ *
+ * The file includes the class for parsing the topology section and
+ * generating the described resources:\n
+ * NewSimulatorFileTopology
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __NEW_SIM_FILE_TOPOLOGY_H__
+#define __NEW_SIM_FILE_TOPOLOGY_H__
+
+#include <glib.h>
+
+extern "C" {
+#include "SaHpi.h"
+}
+
+#ifndef __NEW_SIM_FILE_UTIL_H__
+#include "new_sim_file_util.h"
+#endif
+
+#ifndef __NEW_SIM_RESOURCE_H__
+#include "new_sim_resource.h"
+#endif
+
+class NewSimulatorDomain;
+
+/**
+ * @class NewSimulatorFileTopology
+ *
+ * Parses the \c TOPOLOGY section of the simulation file and generates
+ * racks, chassis and blades with temperature sensors from it.\n
+ * So large simulated systems don't need a resource section per resource:
+ * @code
+ * TOPOLOGY {
+ *   "Racks" = 10
+ *   "Chassis" = 4
+ *   "Blades" = 16
+ *   "Sensors" = 8
+ * }
+ * @endcode
+ * The counts are per parent, i.e. the example gives 10 racks with 4 chassis
+ * each and 16 blades with 8 sensors in each chassis.
+ **/
+class NewSimulatorFileTopology : public NewSimulatorFileUtil {
+   private:
+   unsigned int m_racks;    //!< Number of racks
+   unsigned int m_chassis;  //!< Number of chassis per rack
+   unsigned int m_blades;   //!< Number of blades per chassis
+   unsigned int m_sensors;  //!< Number of sensors per blade
+
+   NewSimulatorResource *create_resource( NewSimulatorDomain *domain,
+                                          SaHpiEntityPathT &ep,
+                                          SaHpiCapabilitiesT caps,
+                                          const char *tag );
+   bool create_sensor( NewSimulatorResource *res, SaHpiEntityPathT &ep,
+                       SaHpiSensorNumT num );
+
+   public:
+   NewSimulatorFileTopology( GScanner *scanner, NewSimulatorEntityPath root );
+   ~NewSimulatorFileTopology();
+
+   bool process_token();
+   bool Generate( NewSimulatorDomain *domain );
+};
+
+#endif /*__NEW_SIM_FILE_TOPOLOGY_H__*/
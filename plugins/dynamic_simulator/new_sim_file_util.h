@@ -66,7 +66,8 @@ enum SimTokenType {
         FUMI_DATA_TOKEN_HANDLER,
         FUMI_SOURCE_DATA_TOKEN_HANDLER,
         FUMI_TARGET_DATA_TOKEN_HANDLER,
-        FUMI_LOG_TARGET_DATA_TOKEN_HANDLER
+        FUMI_LOG_TARGET_DATA_TOKEN_HANDLER,
+        TOPOLOGY_TOKEN_HANDLER
 };
 
 /** 
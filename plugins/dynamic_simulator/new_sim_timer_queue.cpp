@@ -0,0 +1,266 @@
+/**
+ * @file    new_sim_timer_queue.cpp
+ *
+ * The file includes the class serving all simulator timers in one thread:\n
+ * NewSimulatorTimerQueue
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <sys/time.h>
+
+#include <oh_error.h>
+
+#include "new_sim_utils.h"
+#include "new_sim_log.h"
+#include "new_sim_timer_queue.h"
+#include "new_sim_timer_thread.h"
+
+
+/// lock for the queue instance and the reference counter
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+/// the queue instance shared by all handlers
+static NewSimulatorTimerQueue *queue = 0;
+/// number of NewSimulator objects using the queue
+static int queue_refs = 0;
+
+
+/**
+ * Constructor
+ **/
+NewSimulatorTimerQueue::NewSimulatorTimerQueue()
+                      : m_current( 0 ),
+                        m_exit( false ),
+                        m_started( false ) {
+}
+
+
+/**
+ * Destructor
+ **/
+NewSimulatorTimerQueue::~NewSimulatorTimerQueue() {
+}
+
+
+/**
+ * Take a reference on the queue, the first one creates it
+ **/
+void NewSimulatorTimerQueue::Ref() {
+
+   pthread_mutex_lock( &queue_lock );
+   if ( queue_refs == 0 )
+      queue = new NewSimulatorTimerQueue();
+   queue_refs++;
+   pthread_mutex_unlock( &queue_lock );
+}
+
+
+/**
+ * Release a reference on the queue, the last one stops the thread
+ **/
+void NewSimulatorTimerQueue::Unref() {
+
+   pthread_mutex_lock( &queue_lock );
+   queue_refs--;
+   if ( queue_refs == 0 ) {
+      queue->Shutdown();
+      delete queue;
+      queue = 0;
+   }
+   pthread_mutex_unlock( &queue_lock );
+}
+
+
+/**
+ * Get the queue instance
+ *
+ * @return pointer on the queue, 0 if no handler is open
+ **/
+NewSimulatorTimerQueue *NewSimulatorTimerQueue::Get() {
+   return queue;
+}
+
+
+/**
+ * Current time in ms on the same clock as cTime::Now()
+ **/
+long long NewSimulatorTimerQueue::NowMsec() {
+   struct timeval tv;
+
+   gettimeofday( &tv, 0 );
+   return (long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+/**
+ * Start a timer with its current timeout value
+ *
+ * @param timer pointer on the timer
+ **/
+void NewSimulatorTimerQueue::Arm( NewSimulatorTimerThread *timer ) {
+
+   m_cond.Lock();
+   timer->m_start   = cTime::Now();
+   timer->m_running = true;
+   timer->m_reset   = true;
+   // A running action is rearmed by the thread afterwards
+   if ( m_current != timer )
+      Insert( timer, timer->Due() );
+
+   if ( !m_started ) {
+      m_started = Start();
+      if ( !m_started )
+         err( "Couldn't start the simulator timer thread" );
+   }
+   m_cond.Broadcast();
+   m_cond.Unlock();
+}
+
+
+/**
+ * Stop a timer
+ *
+ * If the action of the timer is running in the queue thread, the caller
+ * waits for it. The action itself may stop its timer.
+ *
+ * @param timer pointer on the timer
+ **/
+void NewSimulatorTimerQueue::Disarm( NewSimulatorTimerThread *timer ) {
+
+   m_cond.Lock();
+   timer->m_running = false;
+   Remove( timer );
+
+   if ( !m_started || !pthread_equal( pthread_self(), m_thread ) ) {
+      while ( m_current == timer )
+         m_cond.Wait();
+   }
+   m_cond.Unlock();
+}
+
+
+/**
+ * Set a new timeout value starting from now
+ *
+ * @param timer pointer on the timer
+ * @param timeout new timeout value in ms
+ **/
+void NewSimulatorTimerQueue::Reset( NewSimulatorTimerThread *timer, unsigned int timeout ) {
+
+   m_cond.Lock();
+   timer->m_timeout = timeout;
+   timer->m_start   = cTime::Now();
+   timer->m_reset   = true;
+   if ( timer->m_queued ) {
+      Insert( timer, timer->Due() );
+      m_cond.Broadcast();
+   }
+   m_cond.Unlock();
+}
+
+
+/**
+ * Put a timer in the queue, an already queued timer is moved
+ * The lock has to be held.
+ **/
+void NewSimulatorTimerQueue::Insert( NewSimulatorTimerThread *timer, long long due ) {
+
+   Remove( timer );
+   timer->m_pos    = m_timers.insert( TimerMap::value_type( due, timer ) );
+   timer->m_queued = true;
+}
+
+
+/**
+ * Take a timer out of the queue
+ * The lock has to be held.
+ **/
+void NewSimulatorTimerQueue::Remove( NewSimulatorTimerThread *timer ) {
+
+   if ( timer->m_queued ) {
+      m_timers.erase( timer->m_pos );
+      timer->m_queued = false;
+   }
+}
+
+
+/**
+ * Stop the thread, all timers have to be disarmed before
+ **/
+void NewSimulatorTimerQueue::Shutdown() {
+
+   m_cond.Lock();
+   m_exit = true;
+   m_cond.Broadcast();
+   m_cond.Unlock();
+
+   if ( m_started ) {
+      pthread_join( m_thread, 0 );
+      m_started = false;
+   }
+
+   if ( !m_timers.empty() )
+      err( "Simulator timer queue is shut down with armed timers" );
+}
+
+
+/**
+ * Main loop of the queue
+ *
+ * The first timer is taken from the queue when it expires and its
+ * TriggerAction() is called. The timer is queued again if the action
+ * has reset it or if it asked to be called again.
+ **/
+void *NewSimulatorTimerQueue::Run() {
+
+   stdlog << "DBG: Run shared TimerLoop\n";
+
+   m_cond.Lock();
+   while ( !m_exit ) {
+      if ( m_timers.empty() ) {
+         m_cond.Wait();
+         continue;
+      }
+
+      TimerMap::iterator first = m_timers.begin();
+      if ( first->first > NowMsec() ) {
+         struct timespec abstime;
+         abstime.tv_sec  = first->first / 1000;
+         abstime.tv_nsec = ( first->first % 1000 ) * 1000000;
+         m_cond.TimedWait( abstime );
+         continue;
+      }
+
+      NewSimulatorTimerThread *timer = first->second;
+      Remove( timer );
+      timer->m_reset = false;
+      m_current = timer;
+      m_cond.Unlock();
+
+      bool done = timer->TriggerAction();
+
+      m_cond.Lock();
+      m_current = 0;
+      if ( timer->m_running ) {
+         if ( timer->m_reset ) {
+            Insert( timer, timer->Due() );
+         } else if ( !done ) {
+            Insert( timer, NowMsec() + THREAD_SLEEPTIME / 1000 );
+         } else {
+            timer->m_running = false;
+         }
+      }
+      m_cond.Broadcast();
+   }
+   m_cond.Unlock();
+
+   stdlog << "DBG: Exit shared TimerLoop\n";
+
+   return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file    new_sim_timer_queue.h
+ *
+ * The file includes the class serving all simulator timers in one thread:\n
+ * NewSimulatorTimerQueue
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef __NEW_SIM_TIMER_QUEUE_H__
+#define __NEW_SIM_TIMER_QUEUE_H__
+
+#include <map>
+
+#ifndef __THREAD_H__
+#include "thread.h"
+#endif
+
+class NewSimulatorTimerThread;
+
+/**
+ * @class NewSimulatorTimerQueue
+ *
+ * One thread for the watchdog and hotswap timers of all handlers.\n
+ * The armed timers are sorted by their expiration time. The thread sleeps
+ * until the first one expires and calls NewSimulatorTimerThread::TriggerAction()
+ * without holding the queue lock.\n
+ * The queue is referenced by every NewSimulator object, the thread is started
+ * with the first armed timer and stopped with the last reference.
+ **/
+class NewSimulatorTimerQueue : public cThread {
+
+public:
+  /// expiration time in ms -> timer
+  typedef std::multimap<long long, NewSimulatorTimerThread *> TimerMap;
+
+private:
+  /// protects the queue and the timer states, wakes up the thread
+  cThreadCond               m_cond;
+  /// armed timers
+  TimerMap                  m_timers;
+  /// timer whose TriggerAction() is running
+  NewSimulatorTimerThread  *m_current;
+  /// signal thread to exit
+  bool                      m_exit;
+  /// flag if the thread was started
+  bool                      m_started;
+
+  NewSimulatorTimerQueue();
+  virtual ~NewSimulatorTimerQueue();
+
+  void Insert( NewSimulatorTimerThread *timer, long long due );
+  void Remove( NewSimulatorTimerThread *timer );
+  void Shutdown();
+
+protected:
+  virtual void *Run();
+
+public:
+  static void Ref();
+  static void Unref();
+  static NewSimulatorTimerQueue *Get();
+
+  void Arm( NewSimulatorTimerThread *timer );
+  void Disarm( NewSimulatorTimerThread *timer );
+  void Reset( NewSimulatorTimerThread *timer, unsigned int timeout );
+
+  static long long NowMsec();
+};
+
+
+#endif
@@ -1,7 +1,7 @@
 /** 
  * @file    new_sim_timer_thread.cpp
  *
- * The file includes a class Timer which runs in another thread:\n
+ * The file includes a timer class served by the shared timer queue:\n
  * NewSimulatorTimerThread
  * 
  * @author  Lars Wetzel <larswetzel@users.sourceforge.net>
@@ -19,21 +19,23 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <oh_error.h>
 #include "new_sim.h"
 #include "new_sim_utils.h"
 #include "new_sim_watchdog.h"
+#include "new_sim_timer_queue.h"
 
 
  
 /**
  * Constructor for Watchdogs
  **/
-// NewSimulatorTimerThread::NewSimulatorTimerThread( NewSimulatorWatchdog  *wdt, 
 NewSimulatorTimerThread::NewSimulatorTimerThread(
                                                   unsigned int ms_timeout )
                        : m_timeout( ms_timeout ),
-                         m_running( false ),
-                         m_exit( false ) {
+                         m_queued( false ),
+                         m_reset( false ),
+                         m_running( false ) {
 
 }
 
@@ -42,16 +44,45 @@ NewSimulatorTimerThread::NewSimulatorTimerThread(
  * Destructor
  **/
 NewSimulatorTimerThread::~NewSimulatorTimerThread() {
+
+   Stop();
 }
 
 
 /**
- * Set the exit flag and sleep THREAD_SLEEPTIME to be sure it is read
+ * Start the timer with the latest timeout value
+ *
+ * @return success
+ **/
+bool NewSimulatorTimerThread::Start() {
+   NewSimulatorTimerQueue *queue = NewSimulatorTimerQueue::Get();
+
+   if ( !queue ) {
+      err( "No timer queue available" );
+      return false;
+   }
+
+   stdlog << "DBG: Start timer - with timeout " << m_timeout << "\n";
+   queue->Arm( this );
+
+   return true;
+}
+
+
+/**
+ * Stop the timer
+ *
+ * If TriggerAction() is running in the queue thread, it is waited
+ * for its end.
  **/
 void NewSimulatorTimerThread::Stop() {
+   NewSimulatorTimerQueue *queue = NewSimulatorTimerQueue::Get();
 
-   m_exit = true;
-   usleep( THREAD_SLEEPTIME );
+   if ( queue ) {
+      queue->Disarm( this );
+   } else {
+      m_running = false;
+   }
 }
 
 
@@ -63,46 +94,25 @@ void NewSimulatorTimerThread::Stop() {
  * @return latest timeout value of the object
  **/
 unsigned int NewSimulatorTimerThread::Reset( unsigned int new_timeout ) {
-   
-   m_timeout = new_timeout;
-   m_start = cTime::Now();
-   stdlog << "DBG: Reset timeout value " << m_timeout << "\n";
+   NewSimulatorTimerQueue *queue = NewSimulatorTimerQueue::Get();
+
+   if ( queue ) {
+      queue->Reset( this, new_timeout );
+   } else {
+      m_timeout = new_timeout;
+      m_start = cTime::Now();
+   }
+   stdlog << "DBG: Reset timeout value " << new_timeout << "\n";
 
-   return m_timeout;
+   return new_timeout;
 }
 
 
 /** 
- * Main loop of the timer.
- *
- * If the timer expires the method TriggerAction() is called. 
+ * Expiration time of the timer in ms
  **/
-void * NewSimulatorTimerThread::Run() {
-   cTime now;
-   int delta;
-   m_start = cTime::Now();
-   m_running = true;
-   m_exit = false;
-   stdlog << "DBG: Run Timerloop - with timeout " << m_timeout << "\n";
-
-   while( !m_exit ) {
-      now = cTime::Now();
-      now -= m_start;
-      delta = m_timeout - now.GetMsec();
-      
-      if ( delta <= 0 ) {
-         m_exit = TriggerAction();	
-
-      } else if ( delta <= THREAD_SLEEPTIME / 1000 ) {
-         usleep( delta*1000 );
-
-      } else {
-      	 usleep( THREAD_SLEEPTIME );
-      }
-   }
-   m_running = false;
-   stdlog << "DBG: Exit TimerLoop\n";
-   
-   return 0;
-}
+long long NewSimulatorTimerThread::Due() {
 
+   return (long long)m_start.m_time.tv_sec * 1000 + m_start.m_time.tv_usec / 1000
+          + m_timeout;
+}
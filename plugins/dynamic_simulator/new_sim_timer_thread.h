@@ -1,7 +1,7 @@
 /** 
  * @file    new_sim_timer_thread.h
  *
- * The file includes a class for starting a timer in a thread:\n
+ * The file includes a class for a timer served by the shared timer queue:\n
  * NewSimulatorTimerThread
  * 
  * @author  Lars Wetzel <larswetzel@users.sourceforge.net>
@@ -24,8 +24,8 @@
 #include "new_sim_utils.h"
 #endif
 
-#ifndef __THREAD_H__
-#include "thread.h"
+#ifndef __NEW_SIM_TIMER_QUEUE_H__
+#include "new_sim_timer_queue.h"
 #endif
 
 class NewSimulatorWatchdog;
@@ -38,9 +38,14 @@ class NewSimulatorTimerThread;
 /**
  * @class NewSimulatorTimerThread
  * 
- * Starts a thread in which a timer will trigger a function after expiration.
+ * A timer which triggers a function after expiration.\n
+ * The name is kept from the time each timer had its own thread. The timers
+ * are served by the shared NewSimulatorTimerQueue now, so TriggerAction()
+ * is called in the queue thread.
  **/
-class NewSimulatorTimerThread : public cThread {
+class NewSimulatorTimerThread {
+
+friend class NewSimulatorTimerQueue;
 
 private:
 
@@ -48,21 +53,26 @@ private:
   unsigned int     m_timeout;
   /// Start time of timer
   cTime             m_start;
+  /// Flag if the timer is in the queue
+  bool             m_queued;
+  /// Position in the queue
+  NewSimulatorTimerQueue::TimerMap::iterator m_pos;
+  /// Flag if the timer was reset since its action was called
+  bool             m_reset;
+
+  long long Due();
 
 protected:
-  virtual void *Run();
-  /// Flag if a thread is already running
+  /// Flag if the timer is armed
   bool             m_running;
-  /// Abstract method which is called after the timre expires
+  /// Abstract method which is called after the timer expires, true => stop the timer
   virtual bool TriggerAction() = 0;
 
 public:
-  /// signal thread to exit
-  bool m_exit;
-
   NewSimulatorTimerThread( unsigned int ms_timeout );
   virtual ~NewSimulatorTimerThread();
   
+  bool Start();
   void Stop();
   unsigned int Reset( unsigned int new_timeout );
   
@@ -0,0 +1,115 @@
+/**
+ * @file    timer_queue_000.cpp
+ *
+ * Checks that the shared timer queue fires the timers in the order of
+ * their expiration and that stopped timers don't fire.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "thread.h"
+#include "new_sim_timer_queue.h"
+#include "new_sim_timer_thread.h"
+
+static int failed = 0;
+
+#define CHECK(expr) \
+   do { \
+      if ( !( expr ) ) { \
+         printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr ); \
+         failed = 1; \
+      } \
+   } while ( 0 )
+
+/// ids of the fired timers in firing order
+static int fired[16];
+static int num_fired = 0;
+static cThreadLock fired_lock;
+
+
+class cTestTimer : public NewSimulatorTimerThread {
+   int  m_id;
+   bool m_once;
+   int  m_calls;
+
+protected:
+   virtual bool TriggerAction() {
+      cThreadLockAuto al( fired_lock );
+      m_calls++;
+      if ( m_once && num_fired < 16 )
+         fired[num_fired++] = m_id;
+      return m_once;
+   }
+
+public:
+   cTestTimer( int id, unsigned int timeout, bool once = true )
+      : NewSimulatorTimerThread( timeout ),
+        m_id( id ), m_once( once ), m_calls( 0 ) {}
+
+   int Calls() {
+      cThreadLockAuto al( fired_lock );
+      return m_calls;
+   }
+};
+
+
+int main() {
+   NewSimulatorTimerQueue::Ref();
+   CHECK( NewSimulatorTimerQueue::Get() != 0 );
+
+   {
+      cTestTimer a( 1, 300 ), b( 2, 100 ), c( 3, 200 ), d( 4, 100 );
+
+      CHECK( a.Start() );
+      CHECK( b.Start() );
+      CHECK( c.Start() );
+      CHECK( d.Start() );
+
+      // Cancelled before it expires
+      c.Stop();
+      // Moved behind a
+      d.Reset( 400 );
+
+      usleep( 700000 );
+
+      CHECK( num_fired == 3 );
+      CHECK( fired[0] == 2 );
+      CHECK( fired[1] == 1 );
+      CHECK( fired[2] == 4 );
+      CHECK( c.Calls() == 0 );
+
+      // Fired timers are not called again
+      usleep( 100000 );
+      CHECK( a.Calls() == 1 );
+      CHECK( b.Calls() == 1 );
+      CHECK( d.Calls() == 1 );
+   }
+
+   {
+      // A timer asking to be called again until it is stopped
+      cTestTimer e( 5, 50, false );
+
+      CHECK( e.Start() );
+      usleep( 200000 );
+      e.Stop();
+
+      int calls = e.Calls();
+      CHECK( calls > 1 );
+      usleep( 100000 );
+      CHECK( e.Calls() == calls );
+   }
+
+   NewSimulatorTimerQueue::Unref();
+   CHECK( NewSimulatorTimerQueue::Get() == 0 );
+
+   return failed;
+}
@@ -0,0 +1,173 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <glib.h>
+#include <SaHpi.h>
+#include <oHpi.h>
+
+#define CONF     "./topology_000.conf"
+#define GOOD     "./topology_000_good.data"
+#define BAD      "./topology_000_bad.data"
+
+#define RACKS    2
+#define CHASSIS  2
+#define BLADES   3
+#define SENSORS  2
+
+static int write_topology(const char *name, int racks, int chassis,
+                          int blades, int sensors)
+{
+        FILE *f = fopen(name, "w");
+
+        if (!f)
+                return -1;
+        fprintf(f, "TOPOLOGY {\n");
+        fprintf(f, "  \"Racks\" = %d\n", racks);
+        fprintf(f, "  \"Chassis\" = %d\n", chassis);
+        fprintf(f, "  \"Blades\" = %d\n", blades);
+        fprintf(f, "  \"Sensors\" = %d\n", sensors);
+        fprintf(f, "}\n");
+        fclose(f);
+
+        return 0;
+}
+
+static int write_conf(void)
+{
+        FILE *f = fopen(CONF, "w");
+
+        if (!f)
+                return -1;
+        fprintf(f, "handler libdyn_simulator {\n");
+        fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,1}\"\n");
+        fprintf(f, "        file = \"%s\"\n", GOOD);
+        fprintf(f, "}\n");
+        fprintf(f, "handler libdyn_simulator {\n");
+        fprintf(f, "        entity_root = \"{SYSTEM_CHASSIS,2}\"\n");
+        fprintf(f, "        file = \"%s\"\n", BAD);
+        fprintf(f, "}\n");
+        fclose(f);
+
+        return chmod(CONF, S_IRUSR | S_IWUSR);
+}
+
+static int count_sensors(SaHpiSessionIdT sid, SaHpiResourceIdT rid)
+{
+        SaHpiEntryIdT id, next_id;
+        SaHpiRdrT rdr;
+        int n = 0;
+
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRdrGet(sid, rid, id, &next_id, &rdr))
+                        break;
+                if (rdr.RdrType == SAHPI_SENSOR_RDR)
+                        n++;
+        }
+
+        return n;
+}
+
+/* Waits until the handler is opened */
+static int wait_handler(SaHpiSessionIdT sid, oHpiHandlerIdT hid)
+{
+        GHashTable *config;
+        oHpiHandlerInfoT info;
+        int tries;
+
+        for (tries = 0; tries < 100; tries++) {
+                config = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                               g_free, g_free);
+                if (oHpiHandlerInfo(sid, hid, &info, config)) {
+                        g_hash_table_destroy(config);
+                        return -1;
+                }
+                g_hash_table_destroy(config);
+                if (info.load_failed != OHPI_HANDLER_OPENING)
+                        return info.load_failed;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+
+        return -1;
+}
+
+/* Counts the resources and the blades with the expected sensors */
+static int count_resources(SaHpiSessionIdT sid, int *blades)
+{
+        SaHpiEntryIdT id, next_id;
+        SaHpiRptEntryT rpte;
+        int n = 0;
+
+        *blades = 0;
+        for (id = SAHPI_FIRST_ENTRY; id != SAHPI_LAST_ENTRY; id = next_id) {
+                if (saHpiRptEntryGet(sid, id, &next_id, &rpte))
+                        break;
+                n++;
+                if (rpte.ResourceEntity.Entry[0].EntityType !=
+                    SAHPI_ENT_SYSTEM_BLADE)
+                        continue;
+                if (count_sensors(sid, rpte.ResourceId) == SENSORS)
+                        (*blades)++;
+        }
+
+        return n;
+}
+
+/**
+ * Load one dynamic simulator handler with a TOPOLOGY section and one
+ * with too many sensors per blade in its TOPOLOGY section.
+ * Pass if the first one generates all racks, chassis and blades with
+ * their sensors and the second one adds no resources, otherwise failed.
+ **/
+int main(int argc, char **argv)
+{
+        SaHpiSessionIdT sid;
+        int tries, n = 0, blades = 0;
+        const int total = RACKS + RACKS * CHASSIS + RACKS * CHASSIS * BLADES;
+
+        if (write_topology(GOOD, RACKS, CHASSIS, BLADES, SENSORS))
+                return -1;
+        if (write_topology(BAD, 1, 1, 1, 256))
+                return -1;
+        if (write_conf())
+                return -1;
+        setenv("OPENHPI_CONF", CONF, 1);
+
+        if (saHpiSessionOpen(SAHPI_UNSPECIFIED_DOMAIN_ID, &sid, NULL))
+                return -1;
+
+        /* The handlers are opened in the background */
+        if (wait_handler(sid, 1) != OHPI_HANDLER_LOADED)
+                return -1;
+        if (wait_handler(sid, 2) != OHPI_HANDLER_LOADED)
+                return -1;
+        for (tries = 0; tries < 50; tries++) {
+                saHpiDiscover(sid);
+                n = count_resources(sid, &blades);
+                if (n >= total)
+                        break;
+                g_usleep(G_USEC_PER_SEC / 10);
+        }
+
+        saHpiSessionClose(sid);
+        remove(CONF);
+        remove(GOOD);
+        remove(BAD);
+
+        if (n != total)
+                return -1;
+        if (blades != RACKS * CHASSIS * BLADES)
+                return -1;
+
+        return 0;
+}
@@ -422,6 +422,13 @@ cThreadCond::Signal()
   pthread_cond_signal( &m_cond );
 }
 
+/// Broadcast
+void
+cThreadCond::Broadcast()
+{
+  pthread_cond_broadcast( &m_cond );
+}
+
 /// Wait
 void
 cThreadCond::Wait()
@@ -429,3 +436,16 @@ cThreadCond::Wait()
   pthread_cond_wait( &m_cond, &m_lock );
 }
 
+/**
+ * Wait until signaled or the absolute time (gettimeofday based) is reached
+ *
+ * @param abstime wake up time
+ *
+ * @return false on timeout
+ **/
+bool
+cThreadCond::TimedWait( const struct timespec &abstime )
+{
+  return pthread_cond_timedwait( &m_cond, &m_lock, &abstime ) != ETIMEDOUT;
+}
+
@@ -173,8 +173,14 @@ public:
   // call Lock before Signal
   virtual void Signal();
 
+  // call Lock before Broadcast
+  virtual void Broadcast();
+
   // call Lock before Wait
   virtual void Wait();
+
+  // call Lock before TimedWait, false => timeout
+  virtual bool TimedWait( const struct timespec &abstime );
 };
 
 
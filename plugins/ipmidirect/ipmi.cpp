@@ -1869,6 +1869,15 @@ cIpmi::AllocConnection( GHashTable *handler_config )
   stdlog << "AllocConnection: Max Outstanding IPMI messages "
          << m_max_outstanding << ".\n";
 
+  // time between sensor sweeps in ms, 0 => no sweep
+  const char *sweep = (const char *)g_hash_table_lookup( handler_config, "SensorSweepInterval" );
+
+  if ( sweep )
+       m_sensor_sweep_interval = strtoul( sweep, 0, 0 );
+
+  stdlog << "AllocConnection: Sensor sweep interval "
+         << m_sensor_sweep_interval << " ms.\n";
+
   unsigned int poll_alive = GetIntNotNull( handler_config, "AtcaPollAliveMCs", 0 );
   if ( poll_alive == 1 )
      {
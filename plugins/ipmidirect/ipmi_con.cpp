@@ -165,6 +165,10 @@ cIpmiCon::HandleMsgError( cIpmiRequest *r, SaErrorT err )
 
   r->m_error = err;
   r->m_signal->Lock();
+
+  if ( r->m_pending )
+       (*r->m_pending)--;
+
   r->m_signal->Signal();
   r->m_signal->Unlock();
 }
@@ -504,6 +508,88 @@ cIpmiCon::ExecuteCmd( const cIpmiAddr &addr, const cIpmiMsg &msg,
 }
 
 
+// send a batch of ipmi commands and wait for all responses.
+// commands which do not fit into the outstanding window are
+// queued and sent by the reader thread as responses come in.
+SaErrorT
+cIpmiCon::ExecuteCmds( int num, const cIpmiAddr *addr, const cIpmiMsg *msg,
+                       cIpmiMsg *rsp_msg, SaErrorT *errs, int retries )
+{
+  assert( retries > 0 );
+  assert( IsRunning() );
+
+  if ( num <= 0 )
+       return SA_OK;
+
+  cThreadCond cond;
+  int pending = 0;
+  cIpmiAddr *rsp_addr = new cIpmiAddr[num];
+  cIpmiRequest **r = new cIpmiRequest *[num];
+
+  // lock queue
+  cond.Lock();
+  m_queue_lock.Lock();
+
+  for( int i = 0; i < num; i++ )
+     {
+       assert( msg[i].m_data_len <= dIpmiMaxMsgLength );
+
+       r[i] = new cIpmiRequest( addr[i], msg[i] );
+       r[i]->m_rsp_addr     = &rsp_addr[i];
+       r[i]->m_rsp          = &rsp_msg[i];
+       r[i]->m_signal       = &cond;
+       r[i]->m_pending      = &pending;
+       r[i]->m_error        = SA_ERR_HPI_INVALID_CMD;
+       r[i]->m_retries_left = retries;
+
+       if ( m_num_outstanding < m_max_outstanding )
+          {
+            SaErrorT rv = SendCmd( r[i] );
+
+            if ( rv != SA_OK )
+               {
+                 r[i]->m_error = rv;
+                 continue;
+               }
+          }
+       else
+            m_queue = g_list_append( m_queue, r[i] );
+
+       pending++;
+     }
+
+  m_queue_lock.Unlock();
+
+  // wait for all responses
+  while( pending > 0 )
+       cond.Wait();
+
+  cond.Unlock();
+
+  for( int i = 0; i < num; i++ )
+     {
+       errs[i] = r[i]->m_error;
+
+       delete r[i];
+
+       if ( errs[i] != SA_OK )
+            continue;
+
+       if (    ((tIpmiNetfn)(msg[i].m_netfn | 1) != rsp_msg[i].m_netfn)
+            || (msg[i].m_cmd != rsp_msg[i].m_cmd) )
+          {
+            stdlog << "Mismatch send netfn " << msg[i].m_netfn << " cmd " << msg[i].m_cmd << ", recv netfn " << rsp_msg[i].m_netfn << " cmd " << rsp_msg[i].m_cmd << "\n";
+            errs[i] = SA_ERR_HPI_INTERNAL_ERROR;
+          }
+     }
+
+  delete [] r;
+  delete [] rsp_addr;
+
+  return SA_OK;
+}
+
+
 void
 cIpmiCon::HandleResponse( int seq, const cIpmiAddr &addr, const cIpmiMsg &msg )
 {
@@ -554,6 +640,10 @@ cIpmiCon::HandleResponse( int seq, const cIpmiAddr &addr, const cIpmiMsg &msg )
   *r->m_rsp      = msg;
 
   r->m_signal->Lock();
+
+  if ( r->m_pending )
+       (*r->m_pending)--;
+
   r->m_signal->Signal();
   r->m_signal->Unlock();
 
@@ -72,12 +72,13 @@ public:
   cIpmiMsg      *m_rsp;
   SaErrorT       m_error;  // if != 0 => error
   cThreadCond   *m_signal; // the calling thread is waiting for this
+  int           *m_pending; // != 0 => request of a batch, decremented when done
   cTime          m_timeout;
   int            m_retries_left;
 
   cIpmiRequest( const cIpmiAddr &addr, const cIpmiMsg &msg )
     : m_addr( addr ), m_send_addr( addr ), m_msg( msg ), m_rsp_addr( 0 ), m_rsp( 0 ),
-    m_error( SA_OK ), m_signal( 0 ), m_retries_left( -1 )  {}
+    m_error( SA_OK ), m_signal( 0 ), m_pending( 0 ), m_retries_left( -1 )  {}
 
   virtual ~cIpmiRequest() {}
 };
@@ -205,6 +206,13 @@ public:
                        cIpmiMsg &rsp_msg,
                        int retries = dIpmiDefaultRetries );
 
+  // send num commands and wait for all responses.
+  // up to m_max_outstanding commands are on the bus at a time.
+  // the result of each command is returned in errs.
+  SaErrorT ExecuteCmds( int num, const cIpmiAddr *addr, const cIpmiMsg *msg,
+                        cIpmiMsg *rsp_msg, SaErrorT *errs,
+                        int retries = dIpmiDefaultRetries );
+
   int GetMaxOutstanding() { return m_max_outstanding; }
   bool SetMaxOutstanding( int max )
   {
@@ -53,7 +53,7 @@ cIpmiMcThread::cIpmiMcThread( cIpmiDomain *domain,
     m_mc( 0 ),
     m_properties( properties ),
     m_exit( false ), m_tasks( 0 ),
-    m_sel( 0 ), m_events( 0 )
+    m_sel( 0 ), m_sweep( false ), m_events( 0 )
 {
 }
 
@@ -410,6 +410,17 @@ cIpmiMcThread::Discover( cIpmiMsg *get_device_id_rsp )
                   m_domain->m_sel_rescan_interval,
                   m_sel );
      }
+
+  if ( m_domain->m_sensor_sweep_interval && !m_sweep )
+     {
+       stdlog << "addr " << m_addr << ": add sensor sweep. cIpmiMcThread::Discover\n";
+
+       m_sweep = true;
+
+       AddMcTask( &cIpmiMcThread::SweepSensors,
+                  m_domain->m_sensor_sweep_interval,
+                  this );
+     }
 }
 
 
@@ -754,3 +765,23 @@ cIpmiMcThread::ReadSel( void *userdata )
       && ( new_events ))
         m_domain->HandleEvents( new_events );
 }
+
+
+void
+cIpmiMcThread::SweepSensors( void *userdata )
+{
+  // mc is gone, Discover() adds the task again
+  if ( m_mc == 0 )
+     {
+       m_sweep = false;
+       return;
+     }
+
+  m_domain->ReadLock();
+  m_domain->SweepSensors( m_mc );
+  m_domain->ReadUnlock();
+
+  // add myself to task list
+  AddMcTask( &cIpmiMcThread::SweepSensors, m_domain->m_sensor_sweep_interval,
+             userdata );
+}
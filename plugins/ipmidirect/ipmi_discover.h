@@ -92,6 +92,12 @@ protected:
   // read SEL task
   void ReadSel( void *userdata );
 
+  // true => sensor sweep task is in the task list
+  bool m_sweep;
+
+  // sensor sweep task
+  void SweepSensors( void *userdata );
+
   GList *m_events;
   cThreadLock m_events_lock;
 
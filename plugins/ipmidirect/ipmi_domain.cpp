@@ -35,6 +35,7 @@ cIpmiDomain::cIpmiDomain()
     m_initial_discover( 0 ),
     m_mc_poll_interval( dIpmiMcPollInterval ),
     m_sel_rescan_interval( dIpmiSelQueryInterval ),
+    m_sensor_sweep_interval( dIpmiSensorSweepInterval ),
     m_bmc_discovered( false )
 {
   cIpmiMcVendorFactory::InitFactory();
@@ -617,6 +618,89 @@ cIpmiDomain::SendCommand( const cIpmiAddr &addr, const cIpmiMsg &msg,
 }
 
 
+SaErrorT
+cIpmiDomain::SendCommands( int num, const cIpmiAddr *addr, const cIpmiMsg *msg,
+                           cIpmiMsg *rsp_msg, SaErrorT *errs, int retries )
+{
+  if ( m_con == 0 )
+     {
+       return SA_ERR_HPI_NOT_PRESENT;
+     }
+
+  return m_con->ExecuteCmds( num, addr, msg, rsp_msg, errs, retries );
+}
+
+
+void
+cIpmiDomain::SweepSensors( cIpmiMc *mc )
+{
+  GList *list = 0;
+  int num = 0;
+
+  for( int i = 0; i < mc->NumResources(); i++ )
+     {
+       cIpmiResource *res = mc->GetResource( i );
+
+       for( int j = 0; j < res->NumRdr(); j++ )
+          {
+            cIpmiRdr *rdr = res->GetRdr( j );
+
+            if ( rdr->Type() != SAHPI_SENSOR_RDR )
+                 continue;
+
+            cIpmiSensor *sensor = (cIpmiSensor *)rdr;
+
+            if ( !sensor->CanSweep() )
+                 continue;
+
+            list = g_list_append( list, sensor );
+            num++;
+          }
+     }
+
+  if ( num == 0 )
+       return;
+
+  cIpmiSensor **sensors = new cIpmiSensor *[num];
+  cIpmiAddr    *addr    = new cIpmiAddr[num];
+  cIpmiMsg     *msg     = new cIpmiMsg[num];
+  cIpmiMsg     *rsp     = new cIpmiMsg[num];
+  SaErrorT     *errs    = new SaErrorT[num];
+  int i = 0;
+
+  for( GList *l = list; l; l = g_list_next( l ) )
+     {
+       sensors[i] = (cIpmiSensor *)l->data;
+       sensors[i]->GetSweepCmd( addr[i], msg[i] );
+       i++;
+     }
+
+  g_list_free( list );
+
+  // the read lock is held, so no sensor can go away meanwhile
+  SaErrorT rv = SendCommands( num, addr, msg, rsp, errs );
+
+  if ( rv == SA_OK )
+     {
+       m_sweep_lock.Lock();
+
+       for( i = 0; i < num; i++ )
+            if ( errs[i] == SA_OK )
+                 sensors[i]->SetSweepData( rsp[i] );
+
+       m_sweep_lock.Unlock();
+     }
+  else
+       stdlog << "IPMI error sweeping sensors: " << rv << " \n";
+
+  delete [] sensors;
+  delete [] addr;
+  delete [] msg;
+  delete [] rsp;
+  delete [] errs;
+}
+
+
 GList *
 cIpmiDomain::GetSdrSensors( cIpmiMc *mc )
 {
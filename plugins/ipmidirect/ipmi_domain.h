@@ -91,6 +91,9 @@ public:
 // Default poll interval for MCs
 #define dIpmiMcPollInterval 1000
 
+// Sweep the sensors of each MC every second by default.
+#define dIpmiSensorSweepInterval 1000
+
 
 class cIpmiDomain : public cIpmiFruInfoContainer
 {
@@ -193,6 +196,12 @@ public:
 
   // time between sel rescan in ms
   unsigned int m_sel_rescan_interval;
+
+  // time between sensor sweeps in ms, 0 => no sweep
+  unsigned int m_sensor_sweep_interval;
+
+  // lock sweep results of all sensors
+  cThreadLock m_sweep_lock;
   bool m_bmc_discovered;
 
   SaErrorT CheckTca();
@@ -212,6 +221,13 @@ public:
   //cIpmiMc *FindOrCreateMcBySlaveAddr( unsigned int slave_addr );
   SaErrorT SendCommand( const cIpmiAddr &addr, const cIpmiMsg &msg, cIpmiMsg &rsp_msg,
                         int retries = dIpmiDefaultRetries );
+  SaErrorT SendCommands( int num, const cIpmiAddr *addr, const cIpmiMsg *msg,
+                         cIpmiMsg *rsp_msg, SaErrorT *errs,
+                         int retries = dIpmiDefaultRetries );
+
+  // read all sensors of a mc with pipelined commands.
+  // called by the mc thread with the global read lock held.
+  void SweepSensors( cIpmiMc *mc );
   GList *GetSdrSensors( cIpmiMc *mc );
   void   SetSdrSensors( cIpmiMc *mc, GList *sensors );
   cIpmiMc *GetEventRcvr();
@@ -183,7 +183,8 @@ cIpmiSensor::cIpmiSensor( cIpmiMc *mc )
     m_rate_unit_string( 0 ),
     m_base_unit_string( 0 ),
     m_modifier_unit_string( 0 ),
-    m_sdr( 0 )
+    m_sdr( 0 ),
+    m_sweep_valid( false )
 {
 }
 
@@ -358,6 +359,38 @@ cIpmiSensor::CreateRdr( SaHpiRptEntryT &resource, SaHpiRdrT &rdr )
 }
 
 
+void
+cIpmiSensor::GetSweepCmd( cIpmiAddr &addr, cIpmiMsg &msg )
+{
+  unsigned char sa, chan = 0;
+  unsigned char n = m_num;
+  if (m_channel != 0) {  /* Get sensor reading for ME/NM has diff channel */
+     chan = m_channel;
+     sa = m_owner;
+  } else sa = dIpmiBmcSlaveAddr;
+  msg = cIpmiMsg( eIpmiNetfnSensorEvent, eIpmiCmdGetSensorReading, 1,&n, sa,chan);
+
+  // same address as cIpmiMc::SendCommand()
+  addr = Resource()->Mc()->Addr();
+  addr.m_lun = m_lun;
+
+  if ( msg.m_chan != 0 )
+     {
+       addr.m_channel    = msg.m_chan;
+       addr.m_slave_addr = msg.m_sa;
+     }
+}
+
+
+void
+cIpmiSensor::SetSweepData( const cIpmiMsg &rsp )
+{
+  m_sweep_rsp   = rsp;
+  m_sweep_time  = cTime::Now();
+  m_sweep_valid = true;
+}
+
+
 SaErrorT
 cIpmiSensor::GetSensorData( cIpmiMsg &rsp )
 {
@@ -377,13 +410,39 @@ cIpmiSensor::GetSensorData( cIpmiMsg &rsp )
        return SA_OK;
      }
 
-  SaErrorT rv = Resource()->SendCommandReadLock( this, msg, rsp, m_lun );
+  cIpmiDomain *domain = Domain();
+  unsigned int interval = domain->m_sensor_sweep_interval;
+  bool cached = false;
 
-  if ( rv != SA_OK )
+  // the mc thread sweeps every interval, so allow one missed sweep
+  if ( interval )
      {
-       stdlog << "IPMI error getting states: " << rv << " \n";
+       cTime limit = cTime::Now();
+       limit -= 2 * interval;
 
-       return rv;
+       domain->m_sweep_lock.Lock();
+
+       if ( m_sweep_valid && limit < m_sweep_time )
+          {
+            rsp = m_sweep_rsp;
+            cached = true;
+          }
+
+       domain->m_sweep_lock.Unlock();
+     }
+
+  SaErrorT rv;
+
+  if ( !cached )
+     {
+       rv = Resource()->SendCommandReadLock( this, msg, rsp, m_lun );
+
+       if ( rv != SA_OK )
+          {
+            stdlog << "IPMI error getting states: " << rv << " \n";
+
+            return rv;
+          }
      }
 
   if ( rsp.m_data[0] != 0 )
@@ -35,6 +35,14 @@ extern "C" {
 #include "ipmi_msg.h"
 #endif
 
+#ifndef dIpmiAddr_h
+#include "ipmi_addr.h"
+#endif
+
+#ifndef dIpmiUtils_h
+#include "ipmi_utils.h"
+#endif
+
 #ifndef dIpmiEvent_h
 #include "ipmi_event.h"
 #endif
@@ -205,6 +213,11 @@ protected:
 
   cIpmiSdr *m_sdr; // full sensor record or 0
 
+  // response of the last sensor sweep
+  cIpmiMsg m_sweep_rsp;
+  cTime    m_sweep_time;
+  bool     m_sweep_valid;
+
 public:
   cIpmiSensor( cIpmiMc *mc );
   virtual ~cIpmiSensor();
@@ -254,6 +267,16 @@ public:
   // read sensor. must be called with a global read lock held.
   SaErrorT GetSensorData( cIpmiMsg &rsp );
 
+  // true => sensor can be read by a sensor sweep
+  bool CanSweep() const { return m_sdr_type != eSdrTypeEventOnlySensorRecord; }
+
+  // get sensor reading command of a sensor sweep
+  void GetSweepCmd( cIpmiAddr &addr, cIpmiMsg &msg );
+
+  // store the result of a sensor sweep.
+  // called with cIpmiDomain::m_sweep_lock held.
+  void SetSweepData( const cIpmiMsg &rsp );
+
   // get sensor data. this function must called with the global read lock held
   virtual SaErrorT GetSensorReading( SaHpiSensorReadingT &data, SaHpiEventStateT &state ) = 0;
 
@@ -24,6 +24,7 @@
 
 
 #include "ipmi_sensor_factors.h"
+#include "thread.h"
 #include <math.h>
 
 
@@ -76,8 +77,34 @@ IpmiLinearizationToString( tIpmiLinearization val )
 }
 
 
+class cIpmiSensorFactorsTable
+{
+public:
+  cIpmiSensorFactorsTable *m_next;
+  int                      m_use_count;
+
+  // factor set
+  tIpmiAnalogeDataFormat m_analog_data_format;
+  tIpmiLinearization     m_linearization;
+  int                    m_m;
+  int                    m_b;
+  int                    m_r_exp;
+  int                    m_b_exp;
+
+  // interpreted value of each raw value
+  double m_value[256];
+  double m_hysteresis[256];
+};
+
+
+// all conversion tables in use
+static cThreadLock              table_lock;
+static cIpmiSensorFactorsTable *tables = 0;
+
+
 cIpmiSensorFactors::cIpmiSensorFactors()
-  : m_analog_data_format( eIpmiAnalogDataFormatUnsigned ),
+  : m_table( 0 ),
+    m_analog_data_format( eIpmiAnalogDataFormatUnsigned ),
     m_linearization( eIpmiLinearizationLinear ),
     m_is_non_linear( false ),
     m_m( 0 ),
@@ -91,8 +118,127 @@ cIpmiSensorFactors::cIpmiSensorFactors()
 }
 
 
+cIpmiSensorFactors::cIpmiSensorFactors( const cIpmiSensorFactors &sf )
+  : m_table( 0 )
+{
+  *this = sf;
+}
+
+
 cIpmiSensorFactors::~cIpmiSensorFactors()
 {
+  ReleaseTable();
+}
+
+
+cIpmiSensorFactors &
+cIpmiSensorFactors::operator=( const cIpmiSensorFactors &sf )
+{
+  if ( this == &sf )
+       return *this;
+
+  ReleaseTable();
+
+  m_analog_data_format = sf.m_analog_data_format;
+  m_linearization      = sf.m_linearization;
+  m_is_non_linear      = sf.m_is_non_linear;
+  m_m                  = sf.m_m;
+  m_tolerance          = sf.m_tolerance;
+  m_b                  = sf.m_b;
+  m_r_exp              = sf.m_r_exp;
+  m_accuracy_exp       = sf.m_accuracy_exp;
+  m_accuracy           = sf.m_accuracy;
+  m_b_exp              = sf.m_b_exp;
+  m_accuracy_factor    = sf.m_accuracy_factor;
+
+  if ( sf.m_table )
+     {
+       table_lock.Lock();
+       m_table = sf.m_table;
+       m_table->m_use_count++;
+       table_lock.Unlock();
+     }
+
+  return *this;
+}
+
+
+// find or create the conversion table of this factor set.
+// the factors must not be changed afterwards.
+void
+cIpmiSensorFactors::AttachTable()
+{
+  ReleaseTable();
+
+  double d;
+
+  // factor set cannot be converted
+  if ( !Convert( 0, d, false ) )
+       return;
+
+  table_lock.Lock();
+
+  cIpmiSensorFactorsTable *t;
+
+  for( t = tables; t; t = t->m_next )
+       if (    t->m_analog_data_format == m_analog_data_format
+            && t->m_linearization      == m_linearization
+            && t->m_m                  == m_m
+            && t->m_b                  == m_b
+            && t->m_r_exp              == m_r_exp
+            && t->m_b_exp              == m_b_exp )
+            break;
+
+  if ( t == 0 )
+     {
+       t = new cIpmiSensorFactorsTable;
+       t->m_use_count          = 0;
+       t->m_analog_data_format = m_analog_data_format;
+       t->m_linearization      = m_linearization;
+       t->m_m                  = m_m;
+       t->m_b                  = m_b;
+       t->m_r_exp              = m_r_exp;
+       t->m_b_exp              = m_b_exp;
+
+       for( unsigned int i = 0; i < 256; i++ )
+          {
+            Convert( i, t->m_value[i], false );
+            Convert( i, t->m_hysteresis[i], true );
+          }
+
+       t->m_next = tables;
+       tables = t;
+     }
+
+  t->m_use_count++;
+  m_table = t;
+
+  table_lock.Unlock();
+}
+
+
+void
+cIpmiSensorFactors::ReleaseTable()
+{
+  if ( m_table == 0 )
+       return;
+
+  table_lock.Lock();
+
+  if ( --m_table->m_use_count == 0 )
+     {
+       cIpmiSensorFactorsTable **p = &tables;
+
+       while( *p != m_table )
+            p = &(*p)->m_next;
+
+       *p = m_table->m_next;
+       delete m_table;
+     }
+
+  table_lock.Unlock();
+
+  m_table = 0;
 }
 
 
@@ -120,6 +266,8 @@ cIpmiSensorFactors::GetDataFromSdr( const cIpmiSdr *sdr )
   else
       m_is_non_linear = true;
 
+  AttachTable();
+
   return true;
 }
 
@@ -250,6 +398,25 @@ bool
 cIpmiSensorFactors::ConvertFromRaw( unsigned int val,
                                     double      &result,
                                     bool        is_hysteresis) const
+{
+  if ( m_table == 0 )
+       return Convert( val, result, is_hysteresis );
+
+  val &= 0xff;
+
+  if ( is_hysteresis )
+       result = m_table->m_hysteresis[val];
+  else
+       result = m_table->m_value[val];
+
+  return true;
+}
+
+
+bool
+cIpmiSensorFactors::Convert( unsigned int val,
+                             double      &result,
+                             bool        is_hysteresis) const
 {
   double m, b, b_exp, r_exp, fval;
   linearizer c_func;
@@ -358,6 +525,7 @@ cIpmiSensorFactors::ConvertToRaw( tIpmiRound    rounding,
 
   // We do a binary search for the right value.  Yuck, but I don't
   // have a better plan that will work with non-linear sensors.
+  // With a conversion table each step is a table lookup.
   do
      {
        raw = next_raw;
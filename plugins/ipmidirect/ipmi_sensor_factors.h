@@ -67,12 +67,27 @@ enum tIpmiLinearization
 const char *IpmiLinearizationToString( tIpmiLinearization val );
 
 
+// raw -> interpreted conversion table of one factor set.
+// tables are shared by all sensors with the same factors.
+class cIpmiSensorFactorsTable;
+
+
 class cIpmiSensorFactors
 {
+protected:
+  cIpmiSensorFactorsTable *m_table;
+
+  bool Convert( unsigned int val, double &result, bool is_hysteresis ) const;
+  void AttachTable();
+  void ReleaseTable();
+
 public:
   cIpmiSensorFactors();
+  cIpmiSensorFactors( const cIpmiSensorFactors &sf );
   virtual ~cIpmiSensorFactors();
 
+  cIpmiSensorFactors &operator=( const cIpmiSensorFactors &sf );
+
   virtual bool GetDataFromSdr( const cIpmiSdr *sdr );
   virtual bool Cmp( const cIpmiSensorFactors &sf ) const;
 
@@ -0,0 +1,118 @@
+/*
+ * Test that table based conversions match the direct computation
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+
+#include "test.h"
+#include "ipmi_sensor_factors.h"
+#include <string.h>
+
+
+static void
+InitSdr( cIpmiSdr &sdr, tIpmiAnalogeDataFormat fmt, tIpmiLinearization l,
+         int m, int b, int r_exp, int b_exp )
+{
+  memset( &sdr, 0, sizeof( cIpmiSdr ) );
+
+  sdr.m_type     = eSdrTypeFullSensorRecord;
+  sdr.m_length   = 60;
+  sdr.m_data[2]  = 0x51;
+  sdr.m_data[20] = fmt << 6;
+  sdr.m_data[23] = l;
+  sdr.m_data[24] = m & 0xff;
+  sdr.m_data[25] = (m >> 2) & 0xc0;
+  sdr.m_data[26] = b & 0xff;
+  sdr.m_data[27] = (b >> 2) & 0xc0;
+  sdr.m_data[29] = ((r_exp << 4) & 0xf0) | (b_exp & 0x0f);
+}
+
+
+// compare s (with table) against c (computed)
+static void
+Check( const cIpmiSensorFactors &s, const cIpmiSensorFactors &c )
+{
+  for( unsigned int i = 0; i < 256; i++ )
+     {
+       double d1, d2;
+       unsigned int r1, r2;
+
+       Test( s.ConvertFromRaw( i, d1, false ) );
+       Test( c.ConvertFromRaw( i, d2, false ) );
+       Test( d1 == d2 );
+
+       Test( s.ConvertFromRaw( i, d1, true ) );
+       Test( c.ConvertFromRaw( i, d2, true ) );
+       Test( d1 == d2 );
+
+       Test( s.ConvertToRaw( cIpmiSensorFactors::eRoundNormal, d2, r1, false, false ) );
+       Test( c.ConvertToRaw( cIpmiSensorFactors::eRoundNormal, d2, r2, false, false ) );
+       Test( r1 == r2 );
+     }
+}
+
+
+static void
+TestFactors( tIpmiAnalogeDataFormat fmt, tIpmiLinearization l,
+             int m, int b, int r_exp, int b_exp )
+{
+  cIpmiSdr sdr;
+  InitSdr( sdr, fmt, l, m, b, r_exp, b_exp );
+
+  cIpmiSensorFactors *s1 = new cIpmiSensorFactors;
+  cIpmiSensorFactors *s2 = new cIpmiSensorFactors;
+
+  Test( s1->GetDataFromSdr( &sdr ) );
+  Test( s2->GetDataFromSdr( &sdr ) );
+
+  // no table
+  cIpmiSensorFactors c;
+  c.m_analog_data_format = fmt;
+  c.m_linearization      = l;
+  c.m_m                  = m;
+  c.m_b                  = b;
+  c.m_r_exp              = r_exp;
+  c.m_b_exp              = b_exp;
+
+  Test( s1->Cmp( c ) );
+
+  Check( *s1, c );
+
+  // the table is shared and survives the first user
+  delete s1;
+  Check( *s2, c );
+
+  cIpmiSensorFactors s3( *s2 );
+  delete s2;
+  Check( s3, c );
+}
+
+
+int
+main( int /*argc*/, char * /*argv*/[] )
+{
+  TestFactors( eIpmiAnalogDataFormatUnsigned, eIpmiLinearizationLinear, 136, 0, -4, 0 );
+  TestFactors( eIpmiAnalogDataFormatUnsigned, eIpmiLinearizationLinear, 63, -100, -2, 1 );
+  TestFactors( eIpmiAnalogDataFormat1Compl, eIpmiLinearizationLinear, 1, 0, 0, 0 );
+  TestFactors( eIpmiAnalogDataFormat2Compl, eIpmiLinearizationLinear, -5, 12, -1, 2 );
+  TestFactors( eIpmiAnalogDataFormatUnsigned, eIpmiLinearizationSqr, 10, 5, -2, 0 );
+  TestFactors( eIpmiAnalogDataFormatUnsigned, eIpmiLinearizationExp2, 1, 0, -1, 0 );
+
+  // factor set that cannot be converted
+  cIpmiSdr sdr;
+  InitSdr( sdr, eIpmiAnalogDataFormatNotAnalog, eIpmiLinearizationLinear, 1, 0, 0, 0 );
+
+  cIpmiSensorFactors s;
+  double d;
+  Test( s.GetDataFromSdr( &sdr ) );
+  Test( !s.ConvertFromRaw( 0, d, false ) );
+
+  return TestResult();
+}
@@ -26,30 +26,13 @@
 # Script Description:
 #
 # This script takes raw event information contained in 
-# snmp_bc_event.map and generates code that populates the 
-# errlog2event_hash table. This can be done in two ways - 
-# with C code or with XML code. The C code way is simpler
-# but takes more memory. XML is more complex but takes less space.
-# 
-# The default way is to generate C code and header files to
-# populate the hash table. This generates the following files:
+# snmp_bc_event.map and generates a static, read-only table of
+# events indexed by a minimal perfect hash of the event message.
+# No hash table is built at runtime. This generates the following
+# file:
 #
-# el.h - Error log header file with common #defines
-# el2event.h - Header file definitions need by generated C file.
-# el2event.c - Generated C code that adds events to directly to
-#              the errlog2event_hash table.
-#
-# The second way is to translate events into XML data which is 
-# (in a later step and script) turned into source code that
-# populates the hash table. This generates the following files:
-#
-# el.h - Error log header file with common #defines
-# el2event.h - Header file definitions need by generated source.
-# event.xml - XML formatted events.
-#
-# If the XML method is used, another script, scripts/text2cstr.pl, 
-# needs to be invoked to turn the XML formatted events into source 
-# code that populates the hash table.
+# el2event.c - errlog2event_table[] and the hash displacement table
+#              errlog2event_disp[] used by errlog2event_lookup().
 #
 # Script Input:
 #
@@ -61,9 +44,6 @@
 #                          Default is snmp_bc_event.map.
 # --odir      (optional)   Directory for output file(s).
 #                          Default is current directory.
-# --xml       (optional)   Generate XML formatted events.
-#                          Default is to generate C formatted
-#                          events and code.
 #
 # Exit codes
 # - 1 successful
@@ -74,14 +54,8 @@ use strict;
 use Getopt::Long;
 
 sub check4dups($$);
-#sub print_h_file_header;
-#sub print_h_file_ending;
-sub print_c_file_header;
-sub print_c_file_ending;
-sub print_c_file_hash_member($);
-sub print_xml_file_header;
-sub print_xml_file_ending;
-sub print_xml_file_hash_member($);
+sub strhash($$);
+sub print_phash_file;
 #sub print_err_hfile_header;
 #sub print_err_hfile_ending;
 
@@ -90,7 +64,6 @@ GetOptions(
   "idir=s"        => \my $idir,
   "mapfile=s"     => \my $mapfile,
   "odir=s"        => \my $odir,
-  "xml"           => \my $xml,
 );
 
 ##########################
@@ -114,10 +87,6 @@ my $oevent_cfile = "el2event.c";
 #my $oerror_hfile = "el.h";
 #my $oevent_hfile = "el2event.h";
 
-if ($xml) {
-    $oevent_cfile = "event.xml";
-}
-
 my $file_c = $odir . "/$oevent_cfile";
 #my $file_err_h = $odir . "/$oerror_hfile";
 #my $file_h = $odir . "/$oevent_hfile";
@@ -192,29 +161,10 @@ while ( <FILE_MAP> ) {
 #}
 #if (&print_err_hfile_ending) { $err = 0; goto CLEANUP; }
 
-#################################################
-# Create "Error Log to event" mapping header file
-#################################################
-#if (&print_h_file_header) { $err = 0; goto CLEANUP; }
-#if (&print_h_file_ending) { $err = 0; goto CLEANUP; }
-
 ################################################
 # Create "Error Log 2 event" mapping source file
 ################################################
-if ($xml) {
-    if (&print_xml_file_header) { $err = 0; goto CLEANUP; }
-    foreach my $event_message (sort keys %eventmap) {
-	if (&print_xml_file_hash_member($event_message)) { $err = 0; goto CLEANUP; }
-    }
-    if (&print_xml_file_ending) { $err = 0; goto CLEANUP; }
-}
-else {
-    if (&print_c_file_header) { $err = 0; goto CLEANUP; }
-    foreach my $event_message (sort keys %eventmap) {
-	if (&print_c_file_hash_member($event_message)) { $err = 0; goto CLEANUP; }
-    }
-    if (&print_c_file_ending) { $err = 0; goto CLEANUP; }
-}
+if (&print_phash_file) { $err = 0; goto CLEANUP; }
 
 CLEANUP:
 close FILE_MAP;
@@ -270,12 +220,11 @@ sub check4dups($$) {
     return 0;
 }
 
-#######################################################
-# Print "Error Log to Event" header file's leading text 
-#######################################################
-#sub print_h_file_header {
-#
-#    print FILE_H <<EOF;
+############################################
+# Print error log header file's leading text
+############################################
+#sub print_err_hfile_header {
+#    print FILE_ERR_H <<EOF;
 #/*      -*- linux-c -*-
 # *
 # * (C) Copyright IBM Corp. 2004
@@ -290,59 +239,25 @@ sub check4dups($$) {
 #
 #/******************************************************************* 
 # * WARNING! This file is auto-magically generated by:
-# *          $0. 
+# *          $0.
 # *          Do not change this file manually. Update script instead.
 # *******************************************************************/
 #
-##ifndef __EL2EVENT_H
-##define __EL2EVENT_H
-#
-##define HPIDUP_STRING  "_HPIDUP"
-#
-##define NO_OVR     0x00000000  /* No overrides */
-##define OVR_SEV    0x00000001  /* Override Error Log's severity */
-##define OVR_RID    0x00000010  /* Override Error Log's source */
-##define OVR_EXP    0x00000100  /* Override Error Log's source for expansion cards */
-##define OVR_MMACT  0x00001000  /* Override Error Log's source for MM */
-##define OVR_MM1    0x00010000  /* Override Error Log's source for MM 1 */
-##define OVR_MM2    0x00100000  /* Override Error Log's source for MM 2 */
-#
-#typedef struct {
-#        gchar *event;
-#	SaHpiSeverityT event_sev;
-#	unsigned int   event_ovr;
-#        short          event_dup;
-#} ErrLog2EventInfoT;
-#
-#/* Global \"Error Log to Event\" mapping hash table and usage count */
-#extern GHashTable *errlog2event_hash;
-#extern unsigned int errlog2event_hash_use_count;
+##ifndef __EL_H
+##define __EL_H
 #
-#SaErrorT errlog2event_hash_init(struct snmp_bc_hnd *custom_handle);
-#SaErrorT errlog2event_hash_free(void);
 #EOF
 #
-#    if ($xml) {
-#	print FILE_H <<EOF;
-#
-#/* XML event code and mapping structures */
-#extern char *eventxml;
-#
-#struct errlog2event_hash_info {
-#	GHashTable *hashtable;
-#};
-#EOF
-#    }
+#return 0;
 #
-#    return 0;
 #}
 
-#######################################################
-# Print "Error Log to Event" header file's leading text 
-#######################################################
-#sub print_h_file_ending {
+#############################################
+# Print error log header file's trailing text
+#############################################
+#sub print_err_hfile_ending {
 #
-#    print FILE_H <<EOF;
+#    print FILE_ERR_H <<EOF;
 #
 ##endif
 #EOF
@@ -350,10 +265,94 @@ sub check4dups($$) {
 #    return 0;
 #}
 
-####################################
-# Print c file's static leading text 
-####################################
-sub print_c_file_header {
+##################################################################
+# Hash event message string. Seeded 32-bit FNV-1a.
+# Must match errlog2event_strhash() in snmp_bc_xml2event.c.
+# Multiplication is split so intermediate values stay exact.
+##################################################################
+sub strhash($$) {
+    my ($seed, $str) = @_;
+
+    my $h = (2166136261 ^ $seed) & 0xFFFFFFFF;
+    foreach my $c (unpack("C*", $str)) {
+	$h ^= $c;
+	# $h * 16777619 mod 2^32
+	$h = ((($h & 0xFF) << 24) + $h * 403) % 4294967296;
+    }
+
+    return $h;
+}
+
+##################################################################
+# Print perfect hash table file.
+#
+# Uses "hash and displace": messages are put into buckets by
+# strhash(0, msg). Buckets are placed largest first, each getting
+# the smallest displacement d so that strhash(d, msg) % N maps all
+# of its messages to free table slots. The table has exactly N
+# slots, one per message, so lookup is one bucket read plus one
+# string compare.
+##################################################################
+sub print_phash_file {
+
+    my @names = sort keys %eventmap;
+    my $n = scalar(@names);
+    my (@msgs, @lits, %index);
+
+    if ($n == 0) {
+	print "$0: Error! No events found.\n";
+	return 1;
+    }
+
+    foreach my $i (0 .. $n - 1) {
+	my ($event_count, $event_name, $event_hex, $event_severity,
+	    $override_flags, $event_msg, $rest) = split/\|/,$eventmap{$names[$i]};
+	chomp($event_msg);
+	$lits[$i] = $event_msg;
+	$event_msg =~ s/^\"//;
+	$event_msg =~ s/\"$//;
+	$msgs[$i] = $event_msg;
+	$index{$event_msg} = $i;
+    }
+
+    my $nbuckets = int(($n + 3) / 4);
+    my @buckets = ();
+    foreach my $i (0 .. $n - 1) {
+	push @{$buckets[strhash(0, $msgs[$i]) % $nbuckets]}, $i;
+    }
+
+    my @order = sort { scalar(@{$buckets[$b] || []}) <=> scalar(@{$buckets[$a] || []})
+			   || $a <=> $b } (0 .. $nbuckets - 1);
+    my @disp = (0) x $nbuckets;
+    my @used = ();
+    my @slot = ();
+
+    foreach my $b (@order) {
+	my @items = @{$buckets[$b] || []};
+	next if !@items;
+
+	my $d;
+	for ($d = 1; $d < 10000000; $d++) {
+	    my %taken = ();
+	    my $ok = 1;
+	    foreach my $i (@items) {
+		my $s = strhash($d, $msgs[$i]) % $n;
+		if ($used[$s] || $taken{$s}) { $ok = 0; last; }
+		$taken{$s} = 1;
+		$slot[$i] = $s;
+	    }
+	    last if $ok;
+	}
+	if ($d >= 10000000) {
+	    print "$0: Error! Cannot build perfect hash for bucket $b.\n";
+	    return 1;
+	}
+	$disp[$b] = $d;
+	$used[$slot[$_]] = 1 foreach @items;
+    }
+
+    my @byslot = ();
+    $byslot[$slot[$_]] = $_ foreach (0 .. $n - 1);
 
     print FILE_C <<EOF;
 /*      -*- linux-c -*-
@@ -368,252 +367,65 @@ sub print_c_file_header {
  * full licensing terms.
  */
 
-/******************************************************************* 
+/*******************************************************************
  * WARNING! This file is auto-magically generated by:
- *          $0. 
+ *          $0.
  *          Do not change this file manually. Update script instead.
  *******************************************************************/
 
 #include <glib.h>
-#include <string.h>
 #include <SaHpi.h>
 
-#include <openhpi.h>
 #include <snmp_bc_plugin.h>
 
-GHashTable *errlog2event_hash;
-
-static void free_hash_data(gpointer key, gpointer value, gpointer user_data);
-
-/************************************************************************
- * errlog2event_hash_init:
- * \@custom_handle: Plugin's data pointer.
- * 
- * Initializes the Error Log to event translation hash table.
- *
- * Returns:
- * SA_OK - Normal operation.
- * SA_ERR_HPI_OUT_OF_SPACE - No memory to allocate hash table structures.
- * SA_ERR_HPI_INVALID_PARAMS - \@custom_handle is NULL.
- ************************************************************************/
-SaErrorT errlog2event_hash_init(struct snmp_bc_hnd *custom_handle) {
-
-	gchar *key;
-/*       gchar *key_exists; */
-	ErrLog2EventInfoT *strinfo;
-
-	if (!custom_handle) {
-		dbg("Invalid parameter.");
-		return(SA_ERR_HPI_INVALID_PARAMS);
-	}
-
-	errlog2event_hash = g_hash_table_new(g_str_hash, g_str_equal);
-	if (errlog2event_hash == NULL) {
-		dbg("No memory.");
-		return(SA_ERR_HPI_OUT_OF_SPACE);
-	}
+const unsigned int errlog2event_table_size = $n;
+const unsigned int errlog2event_disp_size = $nbuckets;
 
+const unsigned int errlog2event_disp[] = {
 EOF
-    return 0;
-}
-
-#####################################
-# Print c file's static trailing text 
-#####################################
-sub print_c_file_ending {
-
-   print FILE_C <<EOF;
-
-	return(SA_OK);
-}
-
-/**********************************************************************
- * errlog2event_hash_free:
- *
- * Frees the Error Log to event translation hash table.
- *
- * Returns:
- * SA_OK - Normal operation.
- **********************************************************************/
-SaErrorT errlog2event_hash_free()
-{
-        g_hash_table_foreach(errlog2event_hash, free_hash_data, NULL);
-	g_hash_table_destroy(errlog2event_hash);
-
-	return(SA_OK);
-}
-
-static void free_hash_data(gpointer key, gpointer value, gpointer user_data)
-{
-/*        g_free(key);  keys are string constants - cannot free them */
-        g_free(value);
-}
-EOF
-
-    return 0;
-}
-
-#############################
-# Print c file's dynamic text 
-#############################
-sub print_c_file_hash_member($) {
-    my ($event_message) = @_;
-    
-    my ($event_count, $event_name, $event_hex,
-	$event_severity, $override_flags, $event_msg, $rest) = 
-	    split/\|/,$eventmap{$event_message};
 
-    chomp($event_msg);
-
-    my $event_hex_str = "\"$event_hex\"";
-    $event_hex_str =~ s/^\"0x/\"/;
-
-    my $tab = "";
-
-    # Format override flags
-    if ($override_flags ne "NO_OVR") { 
-	$override_flags =~ s/,/ | /g;
+    for (my $b = 0; $b < $nbuckets; $b += 8) {
+	my $last = ($b + 8 < $nbuckets) ? $b + 8 : $nbuckets;
+	print FILE_C "\t" . join(", ", @disp[$b .. $last - 1]) . ",\n";
     }
-    
-    print FILE_C <<EOF;
-$tab	key = $event_msg;
-$tab	strinfo = g_malloc0(sizeof(ErrLog2EventInfoT));
-$tab	if (!strinfo) {
-$tab		dbg("No memory. Key=%s.", key);
-$tab		errlog2event_hash_free();
-$tab		return(SA_ERR_HPI_OUT_OF_SPACE);
-$tab	}
-$tab	strinfo->event = $event_hex_str; /* $event_name */
-$tab	strinfo->event_sev = $event_severity;
-$tab	strinfo->event_ovr = $override_flags;
-$tab	strinfo->event_dup = $event_count;
-$tab	g_hash_table_insert(errlog2event_hash, key, strinfo);
-EOF
-#$tab
-#$tab	key_exists = g_hash_table_lookup(errlog2event_hash, key); 
-#$tab	if (!key_exists) {
-#$tab		strinfo->event = $event_hex_str; /* $event_name */
-#$tab		strinfo->event_sev = $event_severity;
-#$tab		strinfo->event_ovr = $override_flags;
-#$tab		strinfo->event_dup = $event_count;
-#$tab		g_hash_table_insert(errlog2event_hash, key, strinfo);
-#$tab	}
-#$tab	else {
-#$tab		dbg("Error!: Key %s defined twice", key);
-#$tab		errlog2event_hash_free();
-#$tab		return -1;
-#$tab	}
-#EOF
-
-    print FILE_C "\n";
-
-    return 0;
-}
-
-############################################
-# Print error log header file's leading text
-############################################
-#sub print_err_hfile_header {
-#    print FILE_ERR_H <<EOF;
-#/*      -*- linux-c -*-
-# *
-# * (C) Copyright IBM Corp. 2004
-# *
-# * This program is distributed in the hope that it will be useful,
-# * but WITHOUT ANY WARRANTY; without even the implied warranty of
-# * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. This
-# * file and program are licensed under a BSD style license. See
-# * the Copying file included with the OpenHPI distribution for
-# * full licensing terms.
-# */
-#
-#/******************************************************************* 
-# * WARNING! This file is auto-magically generated by:
-# *          $0.
-# *          Do not change this file manually. Update script instead.
-# *******************************************************************/
-#
-##ifndef __EL_H
-##define __EL_H
-#
-#EOF
-#
-#return 0;
-#
-#}
 
-#############################################
-# Print error log header file's trailing text
-#############################################
-#sub print_err_hfile_ending {
-#
-#    print FILE_ERR_H <<EOF;
-#
-##endif
-#EOF
-#
-#    return 0;
-#}
+    print FILE_C "};\n\nconst ErrLog2EventEntryT errlog2event_table[] = {\n";
 
-######################################
-# Print XML file's static leading text 
-######################################
-sub print_xml_file_header {
+    foreach my $s (0 .. $n - 1) {
+	my $i = $byslot[$s];
+	my ($event_count, $event_name, $event_hex, $event_severity,
+	    $override_flags, $event_msg, $rest) = split/\|/,$eventmap{$names[$i]};
 
-    print FILE_C <<EOF;
-<?xml version="1.0"?>
-<!--
- (C) Copyright IBM Corp. 2004
+	my $event_hex_str = "\"$event_hex\"";
+	$event_hex_str =~ s/^\"0x/\"/;
 
-/******************************************************************* 
- * WARNING! This file is auto-magically generated by:
- *          $0. 
- *          Do not change this file manually. Update script instead.
- *******************************************************************/
--->
-<events>
-EOF
-
-    return 0;
-}
+	# Flags are matched by name - unknown flags are ignored
+	my @ovr = grep { index($override_flags, $_) >= 0 }
+	    qw(OVR_SEV OVR_RID OVR_EXP OVR_VMM OVR_MM1 OVR_MM2 OVR_MM_STBY OVR_MM_PRIME);
+	$override_flags = @ovr ? join(" | ", @ovr) : "NO_OVR";
 
-#######################################
-# Print XML file's static trailing text 
-#######################################
-sub print_xml_file_ending {
-
-   print FILE_C <<EOF;
-</events>
-EOF
-
-    return 0;
-}
-
-###############################
-# Print XML file's dynamic text 
-###############################
-sub print_xml_file_hash_member($) {
-    my ($event_message) = @_;
-    
-    my ($event_count, $event_name, $event_hex,
-	$event_severity, $override_flags, $event_msg, $rest) =
-	    split/\|/,$eventmap{$event_message};
-    chomp($event_msg);
-    my $event_hex_str = "\"$event_hex\"";
-    $event_hex_str =~ s/^\"0x/\"/;
+	# Chain duplicate strings: msg -> msg_HPIDUPn -> ... -> msg_HPIDUP1
+	my $next = -1;
+	my $next_msg = "";
+	if ($msgs[$i] =~ /^(.*)_HPIDUP(\d+)$/) {
+	    $next_msg = $1 . "_HPIDUP" . ($2 - 1) if ($2 > 1);
+	}
+	elsif ($event_count > 0) {
+	    $next_msg = $msgs[$i] . "_HPIDUP" . $event_count;
+	}
+	if ($next_msg ne "") {
+	    if (!defined($index{$next_msg})) {
+		print "$0: Error! Duplicate string $next_msg not found.\n";
+		return 1;
+	    }
+	    $next = $slot[$index{$next_msg}];
+	}
 
-    # Format override flags
-    if ($override_flags ne "NO_OVR") {
-	$override_flags =~ s/,/ | /g;
+	print FILE_C "\t{ $lits[$i],\n\t  { $event_hex_str, $event_severity, " .
+	    "$override_flags, $event_count, $next } }, /* $event_name */\n";
     }
-    
-    print FILE_C <<EOF;
-<event name="$event_name" hex=$event_hex_str 
-       severity="$event_severity" override="$override_flags" dup="$event_count"
-       msg=$event_msg />
-EOF
 
-    print FILE_C "\n";
+    print FILE_C "};\n";
 
     return 0;
 }
@@ -283,6 +283,93 @@ SaErrorT snmp_bc_control_parm(void *hnd, SaHpiResourceIdT rid, SaHpiParmActionT
 		continue;                          \
 	}
 
+/**
+ * snmp_bc_not_readable:
+ * @value: SNMP value returned by the agent.
+ *
+ * BladeCenter agents answer some reads with a placeholder string
+ * instead of an SNMP error when the reading is not available.
+ *
+ * Return values:
+ * SAHPI_TRUE - @value is one of the "not readable" placeholders.
+ **/
+static SaHpiBoolT snmp_bc_not_readable(struct snmp_value *value)
+{
+	if (value->type != ASN_OCTET_STR) return(SAHPI_FALSE);
+
+	if ((g_ascii_strncasecmp(value->string,"Not Readable!", sizeof("Not Readable!")) == 0) ||
+	    (g_ascii_strncasecmp(value->string,"Not Readable", sizeof("Not Readable")) == 0) ||
+	    (g_ascii_strncasecmp(value->string,"(No temperature)", sizeof("(No temperature)")) == 0) ||
+	    (g_ascii_strncasecmp(value->string,"NO_TEMPERATURE", sizeof("NO_TEMPERATURE")) == 0)) {
+		return(SAHPI_TRUE);
+	}
+
+	return(SAHPI_FALSE);
+}
+
+/* Cached result of one OID from a multi-OID GET */
+struct snmp_bc_sweep_entry {
+	SaErrorT err;
+	struct snmp_value value;
+};
+
+/* Drop the whole sweep cache once it is older than SNMP_BC_SWEEP_TIMEOUT */
+static void snmp_bc_sweep_expire(struct snmp_bc_hnd *custom_handle)
+{
+	if (custom_handle->sweep_cache &&
+	    time(NULL) - custom_handle->sweep_time >= SNMP_BC_SWEEP_TIMEOUT) {
+		snmp_bc_sweep_flush(custom_handle);
+	}
+}
+
+/**
+ * snmp_bc_sweep_lookup:
+ * @custom_handle:  Plugin's data pointer.
+ * @objid: SNMP OID.
+ * @value: Location to store cached SNMP value.
+ * @err: Location to store cached return code.
+ *
+ * Looks up @objid in the sweep cache.
+ *
+ * Return values:
+ * SAHPI_TRUE - @objid was found; @value and @err are filled in.
+ **/
+static SaHpiBoolT snmp_bc_sweep_lookup(struct snmp_bc_hnd *custom_handle,
+				       const char *objid,
+				       struct snmp_value *value,
+				       SaErrorT *err)
+{
+	struct snmp_bc_sweep_entry *entry;
+
+	snmp_bc_sweep_expire(custom_handle);
+	if (custom_handle->sweep_cache == NULL) return(SAHPI_FALSE);
+
+	entry = (struct snmp_bc_sweep_entry *)g_hash_table_lookup(custom_handle->sweep_cache, objid);
+	if (entry == NULL) return(SAHPI_FALSE);
+
+	memcpy(value, &(entry->value), sizeof(struct snmp_value));
+	*err = entry->err;
+
+	return(SAHPI_TRUE);
+}
+
+/**
+ * snmp_bc_sweep_flush:
+ * @custom_handle:  Plugin's data pointer.
+ *
+ * Drops all readings cached by snmp_bc_sweep_prefetch().
+ *
+ * Return values:
+ * None
+ **/
+void snmp_bc_sweep_flush(struct snmp_bc_hnd *custom_handle)
+{
+	if (custom_handle->sweep_cache) {
+		g_hash_table_destroy(custom_handle->sweep_cache);
+		custom_handle->sweep_cache = NULL;
+	}
+}
+
 /**
  * snmp_bc_snmp_get:
  * @custom_handle:  Plugin's data pointer.
@@ -310,6 +397,9 @@ SaErrorT snmp_bc_snmp_get(struct snmp_bc_hnd *custom_handle,
         /* struct snmp_session *ss = custom_handle->ss; */
 	int l_retry;
 	
+	/* Answer from a previous multi-OID sweep, if any */
+	if (snmp_bc_sweep_lookup(custom_handle, objid, value, &err)) return(err);
+
 	if (retry) l_retry = 0;
 	else l_retry = 2;
 	
@@ -334,21 +424,11 @@ SaErrorT snmp_bc_snmp_get(struct snmp_bc_hnd *custom_handle,
 			}
         	} else {
                 	custom_handle->handler_retries = 0;
-			if ((err == SA_OK) && (value->type == ASN_OCTET_STR)) {
-				if ((g_ascii_strncasecmp(value->string,"Not Readable!", sizeof("Not Readable!")) == 0) ||
-				    (g_ascii_strncasecmp(value->string,"Not Readable", sizeof("Not Readable")) == 0) ||
-				    (g_ascii_strncasecmp(value->string,"(No temperature)", sizeof("(No temperature)")) == 0) ||
-				    (g_ascii_strncasecmp(value->string,"NO_TEMPERATURE", sizeof("NO_TEMPERATURE")) == 0) ||
-				    (!value->string) ) /*||
-				    (value->string[0] == '\0'))*/ {
-					custom_handle->handler_retries = 0;
-					dbg("Not readable reading from OID=%s.", objid);
-                        		err = SA_ERR_HPI_NO_RESPONSE;
-					break;
-				} else {
-					break;
-				} 
-			} else break;
+			if ((err == SA_OK) && snmp_bc_not_readable(value)) {
+				dbg("Not readable reading from OID=%s.", objid);
+				err = SA_ERR_HPI_NO_RESPONSE;
+			}
+			break;
 	        }               
 
 	} while(l_retry < 3);
@@ -399,6 +479,176 @@ SaErrorT snmp_bc_oid_snmp_get(struct snmp_bc_hnd *custom_handle,
 	return(rv);
 }
 
+/**
+ * snmp_bc_snmp_getn:
+ * @custom_handle:  Plugin's data pointer.
+ * @objids: Array of SNMP OIDs.
+ * @num: Number of OIDs in @objids; at most SNMP_GETN_MAX.
+ * @values: Array of @num locations to store returned SNMP values.
+ * @errs: Array of @num locations to store per OID return codes.
+ * @retry: retry is requested on snmp timeout
+ *
+ * Plugin wrapper for multi-OID SNMP get call. All OIDs are read with a
+ * single GET PDU. Timeouts are retried like snmp_bc_snmp_get(). On success,
+ * @errs holds the result of each OID, including SA_ERR_HPI_NO_RESPONSE
+ * for "not readable" values.
+ *
+ * Return values:
+ * SA_OK - Normal case.
+ **/
+SaErrorT snmp_bc_snmp_getn(struct snmp_bc_hnd *custom_handle,
+			   const char **objids,
+			   int num,
+			   struct snmp_value *values,
+			   SaErrorT *errs,
+			   SaHpiBoolT retry)
+{
+        SaErrorT err;
+	int i, l_retry;
+
+	if (retry) l_retry = 0;
+	else l_retry = 2;
+
+	do {
+		err = snmp_getn(custom_handle->sessp, objids, num, values, errs);
+	        if ((err == SA_ERR_HPI_TIMEOUT) || (err == SA_ERR_HPI_ERROR)) {
+                	if ( (err == SA_ERR_HPI_ERROR) || 
+				(custom_handle->handler_retries == SNMP_BC_MAX_SNMP_RETRY_ATTEMPTED)) {
+				err = snmp_bc_recover_snmp_session(custom_handle);
+				if (err) {
+                        		custom_handle->handler_retries = 0;
+                        		err = SA_ERR_HPI_NO_RESPONSE;
+					break;
+				} else {
+					if (retry) l_retry = 0;
+					else l_retry = 2;
+					custom_handle->handler_retries = 0;
+				}
+                	} else {
+				dbg("HPI_TIMEOUT %s (+%d)", objids[0], num - 1);
+				snmp_bc_internal_retry();  /* l_retry got incremented here */
+			}
+        	} else {
+                	custom_handle->handler_retries = 0;
+			break;
+	        }
+	} while(l_retry < 3);
+
+	if (err) return(err);
+
+	for (i = 0; i < num; i++) {
+		if ((errs[i] == SA_OK) && snmp_bc_not_readable(&values[i])) {
+			dbg("Not readable reading from OID=%s.", objids[i]);
+			errs[i] = SA_ERR_HPI_NO_RESPONSE;
+		}
+	}
+
+        return(SA_OK);
+}
+
+/**
+ * snmp_bc_sweep_add_oid:
+ * @oids: Array of OID strings to add to.
+ * @ep: Entity path of the resource
+ * @loc_offset: Offset to add to location in entity path
+ * @oidstr: raw SNMP OID.
+ *
+ * Derives @oidstr like snmp_bc_oid_snmp_get() does and appends it to
+ * @oids for a later snmp_bc_sweep_prefetch().
+ *
+ * Return values:
+ * None
+ **/
+void snmp_bc_sweep_add_oid(GPtrArray *oids,
+			   SaHpiEntityPathT *ep,
+			   SaHpiEntityLocationT loc_offset,
+			   const gchar *oidstr)
+{
+	gchar *oid;
+
+	oid = oh_derive_string(ep, loc_offset, 10, oidstr);
+	if (oid == NULL) {
+		err("Cannot derive %s.", oidstr);
+		return;
+	}
+	g_ptr_array_add(oids, oid);
+}
+
+/**
+ * snmp_bc_sweep_prefetch:
+ * @custom_handle:  Plugin's data pointer.
+ * @oids: Array of derived OID strings. Array and strings are freed.
+ *
+ * Reads all OIDs in @oids that are not already cached, packing up to
+ * SNMP_GETN_MAX of them into each GET PDU, and keeps the results in
+ * the handler's sweep cache. Later snmp_bc_snmp_get() calls for these
+ * OIDs are answered from the cache until SNMP_BC_SWEEP_TIMEOUT expires
+ * or an SNMP set is done.
+ *
+ * A batch the agent rejects as a whole (e.g. SNMPv1 noSuchName) is
+ * simply not cached; its OIDs are then read one by one as before.
+ *
+ * Return values:
+ * SA_OK - Normal case.
+ * SA_ERR_HPI_BUSY, SA_ERR_HPI_NO_RESPONSE - Agent does not respond.
+ **/
+SaErrorT snmp_bc_sweep_prefetch(struct snmp_bc_hnd *custom_handle,
+				GPtrArray *oids)
+{
+	SaErrorT err;
+	const char *objids[SNMP_GETN_MAX];
+	struct snmp_value values[SNMP_GETN_MAX];
+	SaErrorT errs[SNMP_GETN_MAX];
+	struct snmp_bc_sweep_entry *entry;
+	guint i;
+	int j, num;
+
+	if (!custom_handle || !oids) {
+		err("Invalid parameter.");
+		return(SA_ERR_HPI_INVALID_PARAMS);
+	}
+
+	snmp_bc_sweep_expire(custom_handle);
+	if (custom_handle->sweep_cache == NULL) {
+		custom_handle->sweep_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+								   g_free, g_free);
+		custom_handle->sweep_time = time(NULL);
+	}
+
+	err = SA_OK;
+	for (i = 0; i < oids->len; ) {
+
+		/* Gather next batch of uncached OIDs */
+		for (num = 0; i < oids->len && num < SNMP_GETN_MAX; i++) {
+			const char *oid = g_ptr_array_index(oids, i);
+			if (g_hash_table_lookup(custom_handle->sweep_cache, oid)) continue;
+			for (j = 0; j < num && strcmp(objids[j], oid); j++);
+			if (j == num) objids[num++] = oid;
+		}
+		if (num == 0) break;
+
+		err = snmp_bc_snmp_getn(custom_handle, objids, num, values, errs, SAHPI_TRUE);
+		if (err == SA_ERR_HPI_BUSY || err == SA_ERR_HPI_NO_RESPONSE) break;
+		if (err) {
+			dbg("Multi-OID get rejected. Error=%s", oh_lookup_error(err));
+			err = SA_OK;
+			continue;
+		}
+
+		for (j = 0; j < num; j++) {
+			entry = g_new(struct snmp_bc_sweep_entry, 1);
+			entry->err = errs[j];
+			memcpy(&(entry->value), &values[j], sizeof(struct snmp_value));
+			g_hash_table_insert(custom_handle->sweep_cache, g_strdup(objids[j]), entry);
+		}
+	}
+
+	for (i = 0; i < oids->len; i++) g_free(g_ptr_array_index(oids, i));
+	g_ptr_array_free(oids, TRUE);
+
+	return(err);
+}
+
 /**
  * snmp_bc_snmp_set:
  * @custom_handle:  Plugin's data pointer.
@@ -422,6 +672,9 @@ SaErrorT snmp_bc_snmp_set(struct snmp_bc_hnd *custom_handle,
         SaErrorT err;
 	/* struct snmp_session *ss = custom_handle->ss; */
 
+	/* Cached readings may depend on what is written */
+	snmp_bc_sweep_flush(custom_handle);
+
         err = snmp_set(custom_handle->sessp, objid, value);
         if (err == SA_ERR_HPI_TIMEOUT) {
                 if (custom_handle->handler_retries == SNMP_BC_MAX_SNMP_RETRY_ATTEMPTED) {
@@ -19,8 +19,10 @@
 
 #define SNMP_BC_MAX_SNMP_RETRY_ATTEMPTED  3
 #define SNMP_BC_MAX_RESOURCES_MASK        16 /* 15-char long plus NULL terminated */
+#define SNMP_BC_SWEEP_TIMEOUT             2  /* Seconds a sweep cache reading stays valid */
 
 #include <stdlib.h>
+#include <time.h>
 #include <glib.h>
 
 typedef struct {
@@ -74,6 +76,8 @@ struct snmp_bc_hnd {
 	gchar installed_smi_mask[SNMP_BC_MAX_RESOURCES_MASK];
         gulong installed_mt_mask;
 	gulong installed_filter_mask; 
+	GHashTable *sweep_cache;	/* OID string to reading, filled by multi-OID GETs */
+	time_t  sweep_time;		/* When sweep_cache was started */
 };
 
 SaErrorT snmp_bc_snmp_get(struct snmp_bc_hnd *custom_handle,
@@ -88,6 +92,23 @@ SaErrorT snmp_bc_oid_snmp_get(struct snmp_bc_hnd *custom_handle,
 			      struct snmp_value *value,
 			      SaHpiBoolT retry);
 
+SaErrorT snmp_bc_snmp_getn(struct snmp_bc_hnd *custom_handle,
+			   const char **objids,
+			   int num,
+			   struct snmp_value *values,
+			   SaErrorT *errs,
+			   SaHpiBoolT retry);
+
+void snmp_bc_sweep_add_oid(GPtrArray *oids,
+			   SaHpiEntityPathT *ep,
+			   SaHpiEntityLocationT loc_offset,
+			   const gchar *oidstr);
+
+SaErrorT snmp_bc_sweep_prefetch(struct snmp_bc_hnd *custom_handle,
+				GPtrArray *oids);
+
+void snmp_bc_sweep_flush(struct snmp_bc_hnd *custom_handle);
+
 SaErrorT snmp_bc_snmp_set(struct snmp_bc_hnd *custom_handle,
                           char *objid,
                           struct snmp_value value);
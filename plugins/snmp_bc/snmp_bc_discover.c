@@ -85,6 +85,9 @@ SaErrorT snmp_bc_discover_resources(void *hnd)
 	/*custom_handle->tmpqueue = NULL;                                  */
 	/* --------------------------------------------------------------- */
 
+	/* Start discovery with current readings */
+	snmp_bc_sweep_flush(custom_handle);
+
 	/* Individual platform discovery */
 	if (custom_handle->platform == SNMP_BC_PLATFORM_RSA) {
 		err = snmp_bc_discover_rsa(handle, &ep_root);
@@ -159,10 +162,24 @@ SaErrorT snmp_bc_discover_sensors(struct oh_handler_state *handle,
 	SaErrorT err;
 	SaHpiBoolT valid_sensor;
 	SaHpiRdrT *rdrptr;
+	GPtrArray *oids;
 	struct snmp_bc_hnd *custom_handle;
 	struct SensorInfo *sensor_info_ptr;
 	
 	custom_handle = (struct snmp_bc_hnd *)handle->data;
+
+	/* Read all sensor OIDs of the resource in a few GET PDUs */
+	oids = g_ptr_array_new();
+	for (i=0; sensor_array[i].index != 0; i++) {
+		if (sensor_array[i].sensor.DataFormat.IsSupported == SAHPI_TRUE &&
+		    sensor_array[i].sensor_info.mib.oid != NULL &&
+		    sensor_array[i].sensor_info.mib.write_only != SAHPI_TRUE) {
+			snmp_bc_sweep_add_oid(oids, &(res_oh_event->resource.ResourceEntity),
+					      sensor_array[i].sensor_info.mib.loc_offset,
+					      sensor_array[i].sensor_info.mib.oid);
+		}
+	}
+	snmp_bc_sweep_prefetch(custom_handle, oids);
 	
 	for (i=0; sensor_array[i].index != 0; i++) {
 		rdrptr = (SaHpiRdrT *)g_malloc0(sizeof(SaHpiRdrT));
@@ -249,10 +266,23 @@ SaErrorT snmp_bc_discover_controls(struct oh_handler_state *handle,
 	SaErrorT err;
 	SaHpiBoolT valid_control;
 	SaHpiRdrT *rdrptr;
+	GPtrArray *oids;
 	struct snmp_bc_hnd *custom_handle;
 	struct ControlInfo *control_info_ptr;
 	
 	custom_handle = (struct snmp_bc_hnd *)handle->data;
+
+	/* Read all control OIDs of the resource in a few GET PDUs */
+	oids = g_ptr_array_new();
+	for (i=0; control_array[i].index != 0; i++) {
+		if (control_array[i].control_info.mib.oid != NULL &&
+		    control_array[i].control_info.mib.write_only != SAHPI_TRUE) {
+			snmp_bc_sweep_add_oid(oids, &(res_oh_event->resource.ResourceEntity),
+					      control_array[i].control_info.mib.loc_offset,
+					      control_array[i].control_info.mib.oid);
+		}
+	}
+	snmp_bc_sweep_prefetch(custom_handle, oids);
 	
 	for (i=0; control_array[i].index != 0; i++) {
 		rdrptr = (SaHpiRdrT *)g_malloc0(sizeof(SaHpiRdrT));
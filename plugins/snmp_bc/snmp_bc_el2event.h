@@ -26,24 +26,25 @@
 #define OVR_MM_PRIME  0x0000000010000000  /* Override Error Log's source - set resource to primary MM */
 
 typedef struct {
-        gchar *event;
+        const gchar        *event;
 	SaHpiSeverityT      event_sev;
 	unsigned long long  event_ovr;
         short               event_dup;
+	int                 event_next_dup; /* Table index of next duplicate string; -1 if none */
 } ErrLog2EventInfoT;
 
-/* Global "Error Log to Event" mapping hash table and usage count */
-extern GHashTable *errlog2event_hash;
-extern unsigned int errlog2event_hash_use_count;
-
-SaErrorT errlog2event_hash_init(struct snmp_bc_hnd *custom_handle);
-SaErrorT errlog2event_hash_free(void);
-
-/* XML event code and mapping structures */
-extern char *eventxml;
-
-struct errlog2event_hash_info {
-	GHashTable *hashtable;
-};
+typedef struct {
+        const gchar        *msg;
+        ErrLog2EventInfoT   info;
+} ErrLog2EventEntryT;
+
+/* "Error Log to Event" perfect hash table - generated by eventmap2code.pl */
+extern const ErrLog2EventEntryT errlog2event_table[];
+extern const unsigned int errlog2event_table_size;
+extern const unsigned int errlog2event_disp[];
+extern const unsigned int errlog2event_disp_size;
+
+const ErrLog2EventInfoT *errlog2event_lookup(const gchar *msg);
+const ErrLog2EventInfoT *errlog2event_next_dup(const ErrLog2EventInfoT *info);
 
 #endif
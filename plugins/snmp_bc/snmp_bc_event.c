@@ -45,9 +45,9 @@ static SaErrorT snmp_bc_map2oem(SaHpiEventT *event,
 				sel_entry *sel_entry,
 				OEMReasonCodeT reason);
 
-static ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
-						     ErrLog2EventInfoT *dupstrhash_data,
-						     LogSource2ResourceT *logsrc2res);
+static const ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
+							   const ErrLog2EventInfoT *dupstrhash_data,
+							   LogSource2ResourceT *logsrc2res);
 /**
  * event2hpi_hash_init:
  * @handle: Pointer to handler's data.
@@ -371,7 +371,7 @@ SaErrorT snmp_bc_log2event(struct oh_handler_state *handle,
 	SaHpiSeverityT      event_severity;
 	SaHpiTextBufferT    thresh_read_value, thresh_trigger_value;
 	SaHpiTimeT          event_time;
-	ErrLog2EventInfoT   *strhash_data;
+	const ErrLog2EventInfoT *strhash_data;
         struct snmp_bc_hnd *custom_handle;
 	int dupovrovr;
 	struct oh_event *e;
@@ -505,9 +505,9 @@ SaErrorT snmp_bc_log2event(struct oh_handler_state *handle,
 	event_rid = logsrc2res.rid;
 
 	/***********************************************************
-	 * See if adjusted root string is in errlog2event_hash table
+	 * See if adjusted root string is in errlog2event table
          ***********************************************************/
-	strhash_data = (ErrLog2EventInfoT *)g_hash_table_lookup(errlog2event_hash, search_str);
+	strhash_data = errlog2event_lookup(search_str);
 	if (!strhash_data) {
 		if (snmp_bc_map2oem(&working, &log_entry, EVENT_NOT_ALERTABLE)) {
 			err("Cannot map to OEM Event %s.", log_entry.text);
@@ -804,11 +804,12 @@ RESUME_TO_EXIT:
  * information. A NULL is returned if the information cannot be found.
  * 
  * There are several identical Error Log messages strings that are shared by
- * multiple resources. The scripts that populate errlog2event_hash
+ * multiple resources. The scripts that generate errlog2event_table
  * create unique entries for these duplicate strings by tacking on
  * an unique string (HPIDUP_duplicate_number) to the error log message.
- * This is then stored in errlog2event_hash. So there is a unique mapping
- * for each resource with a duplicate string.
+ * This is then stored in errlog2event_table. So there is a unique mapping
+ * for each resource with a duplicate string. The entries are chained
+ * so errlog2event_next_dup() steps through them without string lookups.
  * 
  * This routine goes finds the unique mapping for all the duplicate strings.
  * Then searches through all the resource's events and all the resource's
@@ -820,12 +821,11 @@ RESUME_TO_EXIT:
  * SA_OK - Normal case.
  * SA_ERR_HPI_INVALID_PARAMS - Parameter pointer(s) are NULL.
  **/
-static ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
-						   ErrLog2EventInfoT *strhash_data,
-						   LogSource2ResourceT *logsrc2res)
+static const ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
+							 const ErrLog2EventInfoT *strhash_data,
+							 LogSource2ResourceT *logsrc2res)
 {	
-	gchar dupstr[SNMP_BC_MAX_SEL_ENTRY_LENGTH];
-	ErrLog2EventInfoT *dupstr_hash_data;
+	const ErrLog2EventInfoT *dupstr_hash_data;
 	short strnum;
 
 	if (!search_str || !strhash_data || !logsrc2res) {
@@ -833,7 +833,6 @@ static ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
 		return(NULL);
 	}
 
-	strncpy(dupstr, search_str, SNMP_BC_MAX_SEL_ENTRY_LENGTH);
 	dupstr_hash_data = strhash_data;
 	strnum = strhash_data->event_dup + 1; /* Original string plus dups */
        
@@ -869,17 +868,10 @@ static ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
 		/* Find next duplicate string */
 		strnum--;
 		if (strnum) {
-			gchar strnum_str[OH_MAX_LOCATION_DIGITS];
-			gchar *tmpstr;
-
-			snprintf(strnum_str, OH_MAX_LOCATION_DIGITS, "%d", strnum);
-			tmpstr = g_strconcat(search_str, HPIDUP_STRING, strnum_str, NULL);
-			strncpy(dupstr, tmpstr, SNMP_BC_MAX_SEL_ENTRY_LENGTH);
-			g_free(tmpstr);
-
-			dupstr_hash_data = (ErrLog2EventInfoT *)g_hash_table_lookup(errlog2event_hash, dupstr);
+			dupstr_hash_data = errlog2event_next_dup(dupstr_hash_data);
 			if (dupstr_hash_data == NULL) {
-				err("Cannot find duplicate string=%s.", dupstr);
+				err("Cannot find duplicate string=%s%s%d.",
+				    search_str, HPIDUP_STRING, strnum);
 			}
 		}
 	}
@@ -897,7 +889,7 @@ static ErrLog2EventInfoT *snmp_bc_findevent4dupstr(gchar *search_str,
  * Parses a Error Log threshold string into its root string, read, 
  * and trigger value strings.
  * 
- * Format is a root string (in the errlog2event_hash table) followed by a
+ * Format is a root string (in the errlog2event_table) followed by a
  * read threshold value string, followed by a trigger threshold value string.
  * Unfortunately cannot convert directly to sensor values yet because 
  * don't yet know if event is in the event2hpi_hash table or if it is, 
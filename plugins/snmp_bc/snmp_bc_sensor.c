@@ -15,6 +15,54 @@
 
 #include <snmp_bc_plugin.h>
 
+/**
+ * snmp_bc_sweep_sensors:
+ * @handle: Handler data pointer.
+ * @rid: Resource ID.
+ *
+ * Reads the raw SNMP OIDs of all the resource's normal readable sensors
+ * with multi-OID GETs into the sweep cache, so reading the resource's
+ * sensors one after another costs a single round trip. OIDs already in
+ * the cache are not read again.
+ *
+ * Return values:
+ * None
+ **/
+static void snmp_bc_sweep_sensors(struct oh_handler_state *handle,
+				  SaHpiResourceIdT rid)
+{
+	GPtrArray *oids;
+	SaHpiRdrT *rdr;
+	SaHpiEntityPathT valEntity;
+	SaHpiSensorNumT num;
+	struct SensorInfo *sinfo;
+
+	oids = g_ptr_array_new();
+	for (rdr = oh_get_rdr_by_type_first(handle->rptcache, rid, SAHPI_SENSOR_RDR);
+	     rdr != NULL;
+	     rdr = oh_get_rdr_by_type_next(handle->rptcache, rid, SAHPI_SENSOR_RDR,
+					   rdr->RdrTypeUnion.SensorRec.Num)) {
+
+		num = rdr->RdrTypeUnion.SensorRec.Num;
+		if (rdr->RdrTypeUnion.SensorRec.DataFormat.IsSupported != SAHPI_TRUE ||
+		    num == BLADECENTER_SENSOR_NUM_MGMNT_ACTIVE ||
+		    num == BLADECENTER_SENSOR_NUM_MGMNT_STANDBY ||
+		    num == BLADECENTER_SENSOR_NUM_SLOT_STATE ||
+		    num == BLADECENTER_SENSOR_NUM_MAX_POWER ||
+		    num == BLADECENTER_SENSOR_NUM_ASSIGNED_POWER ||
+		    num == BLADECENTER_SENSOR_NUM_MIN_POWER) continue;
+
+		sinfo = (struct SensorInfo *)oh_get_rdr_data(handle->rptcache, rid, rdr->RecordId);
+		if (sinfo == NULL || sinfo->sensor_enabled == SAHPI_FALSE ||
+		    sinfo->mib.oid == NULL || sinfo->mib.write_only == SAHPI_TRUE) continue;
+
+		snmp_bc_validate_ep(&(rdr->Entity), &valEntity);
+		snmp_bc_sweep_add_oid(oids, &valEntity, sinfo->mib.loc_offset, sinfo->mib.oid);
+	}
+
+	snmp_bc_sweep_prefetch((struct snmp_bc_hnd *)handle->data, oids);
+}
+
 /**
  * snmp_bc_get_sensor_reading:
  * @hnd: Handler data pointer.
@@ -124,6 +172,7 @@ SaErrorT snmp_bc_get_sensor_reading(void *hnd,
 		}
 		else                /* Normal sensors */
 		{ 
+			snmp_bc_sweep_sensors(handle, rid);
 			err = snmp_bc_get_sensor_oid_reading(hnd, rid, sid, sinfo->mib.oid, &working_reading);
 		}
 	
@@ -393,15 +393,6 @@ void *snmp_bc_open(GHashTable *handler_config,
 		}
 	}
 
-	/* Initialize "String to Event" mapping hash table */
-	if (errlog2event_hash_use_count == 0) {
-		if (errlog2event_hash_init(custom_handle)) {
-			err("Out of memory.");
-			return NULL;
-		}
-	}
-	errlog2event_hash_use_count++;
-	
 	/* Initialize "Event Number to HPI Event" mapping hash table */
 	if (event2hpi_hash_init(handle)) {
 		err("Out of memory.");
@@ -451,12 +442,8 @@ void snmp_bc_close(void *hnd)
 	/* Cleanup event2hpi hash table */
 	event2hpi_hash_free(handle);
 
-	/* Cleanup errlog2event_hash table */
-	errlog2event_hash_use_count--;
-	if (errlog2event_hash_use_count == 0) {
-		errlog2event_hash_free();
-	}
-	
+	snmp_bc_sweep_flush((struct snmp_bc_hnd *)handle->data);
+
         oh_flush_rpt(handle->rptcache);  
         g_free(handle->rptcache);
 	
@@ -22,7 +22,10 @@
 #include <snmp_utils.h>
 #include <sim_resources.h>
 
-int snmp_get(void *sessp, const char *objid, struct snmp_value *value) 
+/* Number of GET requests (PDUs) answered by the simulator */
+unsigned int sim_get_requests = 0;
+
+static int sim_get(const char *objid, struct snmp_value *value)
 {
 	SnmpMibInfoT *hash_data;
 	
@@ -53,6 +56,29 @@ int snmp_get(void *sessp, const char *objid, struct snmp_value *value)
 	return 0;
 }
 
+int snmp_get(void *sessp, const char *objid, struct snmp_value *value) 
+{
+	sim_get_requests++;
+	return(sim_get(objid, value));
+}
+
+int snmp_getn(void *sessp, const char **objids, int num,
+	      struct snmp_value *values, SaErrorT *errs)
+{
+	int i;
+
+	if (num <= 0 || num > SNMP_GETN_MAX) return SA_ERR_HPI_INVALID_PARAMS;
+
+	sim_get_requests++;
+	for (i = 0; i < num; i++) {
+		errs[i] = sim_get(objids[i], &values[i]);
+		/* Forced errors apply to the whole PDU */
+		if (errs[i] == -1 || errs[i] == SA_ERR_HPI_TIMEOUT) return errs[i];
+	}
+
+	return 0;
+}
+
 int snmp_set(void *sessp, char *objid, struct snmp_value value) 
 {
 	SnmpMibInfoT *hash_data;
@@ -0,0 +1,80 @@
+/* -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ */
+
+/************************************************************************
+ * Notes:
+ *
+ * Checks the generated "Error Log to Event" perfect hash table: every
+ * message must be found at its own slot, duplicate string chains must
+ * be complete and unknown messages must not be found.
+ ************************************************************************/
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <snmp_bc_plugin.h>
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+	const ErrLog2EventInfoT *info, *dup;
+
+	if (errlog2event_table_size == 0 || errlog2event_disp_size == 0) {
+		printf("  Error! Testcase failed. Line=%d\n", __LINE__);
+		printf("  Event table is empty\n");
+		return -1;
+	}
+
+	for (i = 0; i < errlog2event_table_size; i++) {
+		int ndups;
+
+		info = errlog2event_lookup(errlog2event_table[i].msg);
+		if (info != &errlog2event_table[i].info) {
+			printf("  Error! Testcase failed. Line=%d\n", __LINE__);
+			printf("  Cannot find event=%s\n", errlog2event_table[i].msg);
+			return -1;
+		}
+
+		/* Duplicate entries themselves have event_dup == 0 */
+		if (strstr(errlog2event_table[i].msg, HPIDUP_STRING)) continue;
+
+		ndups = 0;
+		for (dup = errlog2event_next_dup(info); dup; dup = errlog2event_next_dup(dup)) {
+			ndups++;
+		}
+		if (ndups != info->event_dup) {
+			printf("  Error! Testcase failed. Line=%d\n", __LINE__);
+			printf("  Event=%s has %d duplicates; expected %d\n",
+			       errlog2event_table[i].msg, ndups, info->event_dup);
+			return -1;
+		}
+	}
+
+	/* Test event from snmp_bc_event.map */
+	info = errlog2event_lookup("Bogus Test Event");
+	if (!info || strcmp(info->event, "FFFFFFFF") || info->event_sev != SAHPI_CRITICAL) {
+		printf("  Error! Testcase failed. Line=%d\n", __LINE__);
+		printf("  Bad test event mapping\n");
+		return -1;
+	}
+
+	/* Unknown strings and prefixes are not mapped */
+	if (errlog2event_lookup("Bogus Test Even") ||
+	    errlog2event_lookup("Bogus Test Event.") ||
+	    errlog2event_lookup("") ||
+	    errlog2event_lookup(NULL)) {
+		printf("  Error! Testcase failed. Line=%d\n", __LINE__);
+		printf("  Unknown event string mapped\n");
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,221 @@
+/* -*- linux-c -*-
+ *
+ * (C) Copyright IBM Corp. 2004, 2006
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <snmp_bc_plugin.h>
+#include <sahpimacros.h>
+#include <sim_resources.h>
+#include <tsetup.h>
+
+#define MAX_TEST_SENSORS 32
+
+int main(int argc, char **argv)
+{
+
+	/* ************************
+	 * Local variables
+	 * ***********************/
+	int testfail = 0;
+	SaErrorT          err;
+	SaErrorT expected_err;
+	SaHpiResourceIdT  id;
+        SaHpiRptEntryT rptentry;
+	SaHpiRdrT      rdr;
+	SaHpiEntryIdT  entryid, nextentryid;
+	SaHpiSensorNumT sids[MAX_TEST_SENSORS];
+	SaHpiEntryIdT recids[MAX_TEST_SENSORS];
+	SaHpiSensorReadingT readings[MAX_TEST_SENSORS];
+	SaHpiSensorReadingT reading;
+	SaHpiEventStateT state;
+	struct SensorInfo *sinfo;
+	unsigned int requests;
+	int i, nsids;
+
+	const char *objids[3];
+	struct snmp_value values[3];
+	struct snmp_value value;
+	SaErrorT errs[3];
+	GPtrArray *oids;
+	struct snmp_bc_hnd *custom_handle;
+
+        SaHpiSessionIdT sessionid;
+        SaHpiDomainIdT did;
+        struct oh_handler *h = NULL;
+        struct oh_domain *d = NULL;
+        unsigned int *hid = NULL;
+	struct oh_handler_state *handle;
+
+	/* ************************
+	 * Find a resource with Sensor type rdr
+	 * ***********************/
+	err = tsetup(&sessionid);
+	if (err != SA_OK) {
+		printf("Error! Can not open session for test environment\n");
+		printf("      File=%s, Line=%d\n", __FILE__, __LINE__);
+		return -1;
+	}
+	err = tfind_resource(&sessionid, SAHPI_CAPABILITY_SENSOR, SAHPI_FIRST_ENTRY, &rptentry, SAHPI_TRUE);
+	if (err != SA_OK) {
+		printf("Error! Can not find resources for test environment\n");
+		printf("      File=%s, Line=%d\n", __FILE__, __LINE__);
+		err = tcleanup(&sessionid);
+		return -1;
+	}
+
+	id = rptentry.ResourceId;
+	INIT_HANDLE(did, d, hid, h, handle);
+	custom_handle = (struct snmp_bc_hnd *)handle->data;
+
+	/* Keep event polling from adding SNMP requests while counting */
+	snmp_bc_lock_handler(custom_handle);
+
+	objids[0] = SNMP_BC_DATETIME_OID;
+	objids[1] = ".1.3.6.1.4.1.2.3.51.2.99.99.99.0";	/* Not in simulator */
+	objids[2] = SNMP_BC_MGMNT_ACTIVE;
+
+	/**************************
+	 * Test 1: Too many OIDs for one PDU
+	 **************************/
+	expected_err = SA_ERR_HPI_INVALID_PARAMS;
+	err = snmp_bc_snmp_getn(custom_handle, objids, SNMP_GETN_MAX + 1, values, errs, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+
+	/**************************
+	 * Test 2: Multi-OID get is one request; missing OID fails alone
+	 **************************/
+	requests = sim_get_requests;
+	expected_err = SA_OK;
+	err = snmp_bc_snmp_getn(custom_handle, objids, 3, values, errs, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+	checkstatus(errs[0], expected_err, testfail);
+	checkstatus(errs[2], expected_err, testfail);
+	checkstatus(errs[1], SA_ERR_HPI_NOT_PRESENT, testfail);
+	if (sim_get_requests != requests + 1) {
+		printf("Error! Multi-OID get used %d requests, Line=%d\n",
+		       sim_get_requests - requests, __LINE__);
+		testfail = -1;
+	}
+
+	err = snmp_bc_snmp_get(custom_handle, objids[0], &value, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+	if (value.type != values[0].type || strcmp(value.string, values[0].string)) {
+		printf("Error! Multi-OID get returned wrong value, Line=%d\n", __LINE__);
+		testfail = -1;
+	}
+
+	/**************************
+	 * Test 3: Prefetched OIDs are answered from the sweep cache
+	 **************************/
+	oids = g_ptr_array_new();
+	g_ptr_array_add(oids, g_strdup(objids[0]));
+	g_ptr_array_add(oids, g_strdup(objids[1]));
+	g_ptr_array_add(oids, g_strdup(objids[2]));
+	err = snmp_bc_sweep_prefetch(custom_handle, oids);
+	checkstatus(err, expected_err, testfail);
+
+	requests = sim_get_requests;
+	err = snmp_bc_snmp_get(custom_handle, objids[2], &value, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+	if (value.integer != values[2].integer) {
+		printf("Error! Cached value differs, Line=%d\n", __LINE__);
+		testfail = -1;
+	}
+	err = snmp_bc_snmp_get(custom_handle, objids[1], &value, SAHPI_TRUE);
+	checkstatus(err, SA_ERR_HPI_NOT_PRESENT, testfail);
+	if (sim_get_requests != requests) {
+		printf("Error! Cached OIDs were read again, Line=%d\n", __LINE__);
+		testfail = -1;
+	}
+
+	/**************************
+	 * Test 4: SNMP set drops the sweep cache
+	 **************************/
+	err = snmp_bc_snmp_get(custom_handle, objids[0], &value, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+	err = snmp_bc_snmp_set(custom_handle, (char *)objids[0], value);
+	checkstatus(err, expected_err, testfail);
+
+	requests = sim_get_requests;
+	err = snmp_bc_snmp_get(custom_handle, objids[2], &value, SAHPI_TRUE);
+	checkstatus(err, expected_err, testfail);
+	if (sim_get_requests != requests + 1) {
+		printf("Error! Sweep cache not flushed by set, Line=%d\n", __LINE__);
+		testfail = -1;
+	}
+
+	/**************************
+	 * Test 5: Reading one sensor sweeps the resource's sensors
+	 **************************/
+	nsids = 0;
+	entryid = SAHPI_FIRST_ENTRY;
+	do {
+		err = saHpiRdrGet(sessionid, id, entryid, &nextentryid, &rdr);
+		if (err == SA_OK) {
+			if ((rdr.RdrType == SAHPI_SENSOR_RDR) &&
+			    (rdr.RdrTypeUnion.SensorRec.DataFormat.IsSupported == SAHPI_TRUE) &&
+			    (rdr.RdrTypeUnion.SensorRec.Num < BLADECENTER_SENSOR_NUM_MGMNT_ACTIVE) &&
+			    (nsids < MAX_TEST_SENSORS)) {
+				recids[nsids] = rdr.RecordId;
+				sids[nsids++] = rdr.RdrTypeUnion.SensorRec.Num;
+			}
+			entryid = nextentryid;
+		}
+	} while ((err == SA_OK) && (entryid != SAHPI_LAST_ENTRY));
+
+	if (nsids > 1) {
+		snmp_bc_sweep_flush(custom_handle);
+		err = snmp_bc_get_sensor_reading(handle, id, sids[0], &readings[0], &state);
+		checkstatus(err, expected_err, testfail);
+
+		requests = sim_get_requests;
+		for (i = 1; i < nsids; i++) {
+			sinfo = (struct SensorInfo *)oh_get_rdr_data(handle->rptcache, id, recids[i]);
+			if (sinfo == NULL || sinfo->mib.oid == NULL || sinfo->mib.write_only ||
+			    sinfo->sensor_enabled == SAHPI_FALSE) {
+				sids[i] = 0;
+				continue;
+			}
+			err = snmp_bc_get_sensor_oid_reading(handle, id, sids[i], sinfo->mib.oid, &readings[i]);
+			if (err) sids[i] = 0;
+		}
+		if (sim_get_requests != requests) {
+			printf("Error! Sensor sweep missed %d OIDs, Line=%d\n",
+			       sim_get_requests - requests, __LINE__);
+			testfail = -1;
+		}
+
+		/* Swept readings must match unbatched ones */
+		for (i = 1; i < nsids; i++) {
+			if (sids[i] == 0) continue;
+			sinfo = (struct SensorInfo *)oh_get_rdr_data(handle->rptcache, id, recids[i]);
+			snmp_bc_sweep_flush(custom_handle);
+			err = snmp_bc_get_sensor_oid_reading(handle, id, sids[i], sinfo->mib.oid, &reading);
+			checkstatus(err, expected_err, testfail);
+			if (reading.Type != readings[i].Type ||
+			    oh_compare_sensorreading(reading.Type, &reading, &readings[i])) {
+				printf("Error! Sensor %d swept reading differs, Line=%d\n", sids[i], __LINE__);
+				testfail = -1;
+			}
+		}
+	}
+
+	snmp_bc_unlock_handler(custom_handle);
+
+	/***************************
+	 * Cleanup after all tests
+	 ***************************/
+	 err = tcleanup(&sessionid);
+	 return testfail;
+
+}
+
+#include <tsetup.c>
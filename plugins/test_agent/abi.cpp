@@ -14,6 +14,7 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <glib.h>
 
@@ -32,6 +33,7 @@
 #include "fumi.h"
 #include "handler.h"
 #include "inventory.h"
+#include "load.h"
 #include "log.h"
 #include "resource.h"
 #include "sensor.h"
@@ -47,9 +49,20 @@ namespace TA {
  *  Helpers
  *************************************************************/
 
+static void ParseUint32( GHashTable * config,
+                         const char * name,
+                         SaHpiUint32T& x )
+{
+    const char * param = (const char*)g_hash_table_lookup( config, name );
+    if ( param ) {
+        x = strtoul( param, 0, 0 );
+    }
+}
+
 static bool ParseConfig(
     GHashTable * config,
-    uint16_t& port )
+    uint16_t& port,
+    LoadParams& load )
 {
     const char * param;
 
@@ -61,6 +74,21 @@ static bool ParseConfig(
 
     port = atoi( param );
 
+    ParseUint32( config, "load_resources", load.resources );
+    ParseUint32( config, "load_sensors", load.sensors );
+    ParseUint32( config, "load_sensor_rate", load.sensor_rate );
+    ParseUint32( config, "load_hotswap_rate", load.hotswap_rate );
+    ParseUint32( config, "load_failure_rate", load.failure_rate );
+
+    param = (const char*)g_hash_table_lookup( config, "load_parent" );
+    if ( param ) {
+        SaErrorT rv = oh_encode_entitypath( param, &load.parent );
+        if ( rv != SA_OK ) {
+            CRIT( "invalid load_parent entity path: %s", param );
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -274,7 +302,8 @@ oh_open(
     bool rc;
 
     uint16_t port;
-    rc = TA::ParseConfig( handler_config, port );
+    TA::LoadParams load;
+    rc = TA::ParseConfig( handler_config, port, load );
     if ( !rc ) {
         CRIT( "Error while parsing config." );
         return 0;
@@ -288,6 +317,8 @@ oh_open(
         return 0;
     }
 
+    handler->StartLoad( load );
+
     return handler;
 }
 
@@ -24,8 +24,10 @@
 
 #include "codec.h"
 #include "handler.h"
+#include "load.h"
 #include "resource.h"
 #include "timers.h"
+#include "utils.h"
 #include "vars.h"
 
 #include "sahpi_wrappers.h"
@@ -50,13 +52,17 @@ cHandler::cHandler( unsigned int id,
       cConsole( *this, port, *this ),
       m_id( id ),
       m_eventq( eventq ),
-      m_ai_timeout( SAHPI_TIMEOUT_IMMEDIATE )
+      m_ai_timeout( SAHPI_TIMEOUT_IMMEDIATE ),
+      m_load( *this )
 {
     wrap_g_static_mutex_init( &m_lock );
 }
 
 cHandler::~cHandler()
 {
+    // Load generator thread uses resources
+    m_load.Shutdown();
+
     Resources::const_iterator iter = m_resources.begin();
     Resources::const_iterator end  = m_resources.end();
     for ( ; iter != end; ++iter ) {
@@ -86,6 +92,12 @@ bool cHandler::Init()
     return true;
 }
 
+void cHandler::StartLoad( const LoadParams& params )
+{
+    cLocker<cHandler> al( this );
+    m_load.Configure( params );
+}
+
 void cHandler::Lock()
 {
     wrap_g_static_mutex_lock( &m_lock );
@@ -108,6 +120,33 @@ cResource * cHandler::GetResource( SaHpiResourceIdT rid ) const
     return 0;
 }
 
+cResource * cHandler::CreateResource( const SaHpiEntityPathT& ep )
+{
+    SaHpiEntityPathT ep2 = ep;
+    SaHpiResourceIdT rid = oh_uid_from_entity_path( &ep2 );
+    if ( GetResource( rid ) ) {
+        return 0;
+    }
+
+    cResource * r = new cResource( *this, ep );
+    m_resources[r->GetResourceId()] = r;
+
+    return r;
+}
+
+bool cHandler::RemoveResource( SaHpiResourceIdT rid )
+{
+    cResource * r = GetResource( rid );
+    if ( !r ) {
+        return false;
+    }
+
+    m_resources.erase( rid );
+    delete r;
+
+    return true;
+}
+
 SaErrorT cHandler::RemoveFailedResource( SaHpiResourceIdT rid )
 {
     cResource * r = GetResource( rid );
@@ -199,10 +238,9 @@ bool cHandler::CreateChild( const std::string& name )
         return false;
     }
 
-    cResource * r = new cResource( *this, ep );
-    m_resources[r->GetResourceId()] = r;
+    cResource * r = CreateResource( ep );
 
-    return true;
+    return ( r != 0 );
 }
 
 bool cHandler::RemoveChild( const std::string& name )
@@ -215,19 +253,13 @@ bool cHandler::RemoveChild( const std::string& name )
     }
 
     cObject * obj = cObject::GetChild( name );
-    if ( !obj ) {
+    if ( ( !obj ) || ( obj == &m_load ) ) {
         return false;
     }
 
     cResource * r = static_cast<cResource *>(obj);
-    size_t n = m_resources.erase( r->GetResourceId() );
-    if ( n == 0 ) {
-        return false;
-    }
 
-    delete r;
-
-    return true;
+    return RemoveResource( r->GetResourceId() );
 }
 
 
@@ -235,6 +267,8 @@ void cHandler::GetChildren( Children& children ) const
 {
     cObject::GetChildren( children );
 
+    children.push_back( const_cast<cLoad *>(&m_load) );
+
     Resources::const_iterator iter = m_resources.begin();
     Resources::const_iterator end  = m_resources.end();
     for ( ; iter != end; ++iter ) {
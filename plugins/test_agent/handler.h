@@ -28,6 +28,7 @@
 
 #include "console.h"
 #include "instrument.h"
+#include "load.h"
 #include "object.h"
 #include "timers.h"
 
@@ -51,12 +52,15 @@ public:
     ~cHandler();
 
     bool Init();
+    void StartLoad( const LoadParams& params );
     void Lock();
     void Unlock();
 
 public:
 
     cResource * GetResource( SaHpiResourceIdT rid ) const;
+    cResource * CreateResource( const SaHpiEntityPathT& ep );
+    bool RemoveResource( SaHpiResourceIdT rid );
 
 public:  // HPI interface
 
@@ -95,6 +99,7 @@ private: // data
     GStaticMutex  m_lock;
     Resources     m_resources;
     SaHpiTimeoutT m_ai_timeout;
+    cLoad         m_load;
 };
 
 
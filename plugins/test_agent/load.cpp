@@ -0,0 +1,611 @@
+/*      -*- c++ -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+
+#include <oh_error.h>
+#include <oh_utils.h>
+
+#include "codec.h"
+#include "handler.h"
+#include "load.h"
+#include "resource.h"
+#include "sensor.h"
+#include "utils.h"
+#include "vars.h"
+
+#include "sahpi_wrappers.h"
+
+
+namespace TA {
+
+
+/**************************************************************
+ * Helper data
+ *************************************************************/
+// Longest sleep of the generator thread, usec.
+// Bounds the delay of Stop and of rate changes.
+static const gint64 MaxSleep = 100000LL;
+
+// Longest lag after which missed events are dropped, usec
+static const gint64 MaxLag = 1000000LL;
+
+// Max events of one stream posted under one handler lock
+static const SaHpiUint32T MaxBurst = 64;
+
+
+/**************************************************************
+ * Helper functions
+ *************************************************************/
+static gint64 Now()
+{
+#if GLIB_CHECK_VERSION (2, 32, 0)
+    return g_get_monotonic_time();
+#else
+    GTimeVal now;
+    g_get_current_time( &now );
+    return ( (gint64)now.tv_sec ) * 1000000LL + now.tv_usec;
+#endif
+}
+
+/***
+ * Changes a var the same way the console "set" command does,
+ * so the object posts exactly the events a user would get.
+ **/
+template <typename T>
+static bool SetVar( cObject& obj,
+                    const std::string& name,
+                    eDataType type,
+                    const T& value )
+{
+    Var var;
+    bool rc = obj.GetVar( name, var );
+    if ( ( !rc ) || ( var.type != type ) || ( !var.wdata ) ) {
+        return false;
+    }
+
+    obj.BeforeVarSet( name );
+    Ref<T>( var.wdata ) = value;
+    obj.AfterVarSet( name );
+
+    return true;
+}
+
+static bool GetFloat( const SaHpiSensorReadingT& r, SaHpiFloat64T& x )
+{
+    if ( r.IsSupported == SAHPI_FALSE ) {
+        return false;
+    }
+    if ( r.Type != SAHPI_SENSOR_READING_TYPE_FLOAT64 ) {
+        return false;
+    }
+    x = r.Value.SensorFloat64;
+
+    return true;
+}
+
+
+/**************************************************************
+ * struct LoadParams
+ *************************************************************/
+LoadParams::LoadParams()
+    : resources( 0 ),
+      sensors( 4 ),
+      sensor_rate( 0 ),
+      hotswap_rate( 0 ),
+      failure_rate( 0 )
+{
+    oh_init_ep( &parent );
+    parent.Entry[0].EntityType     = SAHPI_ENT_SYSTEM_CHASSIS;
+    parent.Entry[0].EntityLocation = 1;
+    parent.Entry[1].EntityType     = SAHPI_ENT_ROOT;
+    parent.Entry[1].EntityLocation = 0;
+}
+
+
+/**************************************************************
+ * class cLoad
+ *************************************************************/
+const std::string cLoad::classname( "load" );
+
+cLoad::cLoad( cHandler& handler )
+    : cObject( classname ),
+      m_handler( handler ),
+      m_populated( SAHPI_FALSE ),
+      m_new_populated( SAHPI_FALSE ),
+      m_running( SAHPI_FALSE ),
+      m_new_running( SAHPI_FALSE ),
+      m_late( 0 ),
+      m_max_lag( 0 ),
+      m_mutex( wrap_g_mutex_new_init() ),
+      m_cond( wrap_g_cond_new_init() ),
+      m_thread_running( false ),
+      m_stop( false ),
+      m_reset( false )
+{
+    LoadParams params;
+    m_resources = params.resources;
+    m_sensors   = params.sensors;
+    m_parent    = params.parent;
+
+    for ( size_t i = 0; i < StreamCount; ++i ) {
+        m_rates[i] = 0;
+        m_next[i]  = 0;
+        m_count[i] = 0;
+    }
+}
+
+cLoad::~cLoad()
+{
+    Shutdown();
+    wrap_g_cond_free( m_cond );
+    wrap_g_mutex_free_clear( m_mutex );
+}
+
+void cLoad::Configure( const LoadParams& params )
+{
+    m_resources                = params.resources;
+    m_sensors                  = params.sensors;
+    m_parent                   = params.parent;
+    m_rates[SensorStream]      = params.sensor_rate;
+    m_rates[HotSwapStream]     = params.hotswap_rate;
+    m_rates[FailureStream]     = params.failure_rate;
+
+    if ( m_resources == 0 ) {
+        return;
+    }
+    if ( !Populate() ) {
+        return;
+    }
+    for ( size_t i = 0; i < StreamCount; ++i ) {
+        if ( m_rates[i] != 0 ) {
+            Start();
+            break;
+        }
+    }
+}
+
+bool cLoad::Populate()
+{
+    if ( m_populated != SAHPI_FALSE ) {
+        return true;
+    }
+
+    m_rids.clear();
+    m_rids.reserve( m_resources );
+
+    for ( SaHpiUint32T i = 0; i < m_resources; ++i ) {
+        SaHpiEntityPathT ep;
+        oh_init_ep( &ep );
+        ep.Entry[0].EntityType     = SAHPI_ENT_SYSTEM_BLADE;
+        ep.Entry[0].EntityLocation = i + 1;
+        ep.Entry[1].EntityType     = SAHPI_ENT_ROOT;
+        ep.Entry[1].EntityLocation = 0;
+        oh_concat_ep( &ep, &m_parent );
+
+        cResource * r = m_handler.CreateResource( ep );
+        if ( !r ) {
+            // Already exists, leave it to the user
+            continue;
+        }
+
+        cObject& robj = *r;
+        for ( SaHpiUint32T j = 0; j < m_sensors; ++j ) {
+            SaHpiSensorNumT num = j + 1;
+            robj.CreateChild( AssembleNumberedObjectName( cSensor::classname, num ) );
+            cSensor * s = r->GetSensor( num );
+            if ( s ) {
+                s->SetVisible( true );
+            }
+        }
+
+        r->SetVisible( true );
+        m_rids.push_back( r->GetResourceId() );
+    }
+
+    m_populated     = SAHPI_TRUE;
+    m_new_populated = SAHPI_TRUE;
+    for ( size_t i = 0; i < StreamCount; ++i ) {
+        m_next[i] = 0;
+    }
+
+    return true;
+}
+
+void cLoad::Depopulate()
+{
+    Stop();
+
+    Rids::const_iterator iter = m_rids.begin();
+    Rids::const_iterator end  = m_rids.end();
+    for ( ; iter != end; ++iter ) {
+        m_handler.RemoveResource( *iter );
+    }
+    m_rids.clear();
+
+    m_populated     = SAHPI_FALSE;
+    m_new_populated = SAHPI_FALSE;
+}
+
+bool cLoad::Start()
+{
+    for ( size_t i = 0; i < StreamCount; ++i ) {
+        m_count[i] = 0;
+    }
+    m_late    = 0;
+    m_max_lag = 0;
+
+    wrap_g_mutex_lock( m_mutex );
+    m_stop  = false;
+    m_reset = true;
+    if ( !m_thread_running ) {
+        GThread * thread = wrap_g_thread_create_new( "cLoad",
+                                                     ThreadFuncAdapter,
+                                                     this,
+                                                     FALSE,
+                                                     0 );
+        m_thread_running = ( thread != 0 );
+    }
+    bool rc = m_thread_running;
+    wrap_g_mutex_unlock( m_mutex );
+
+    if ( !rc ) {
+        CRIT( "cannot start load generator thread" );
+    }
+
+    m_running     = rc ? SAHPI_TRUE : SAHPI_FALSE;
+    m_new_running = m_running;
+
+    return rc;
+}
+
+void cLoad::Stop()
+{
+    // The thread is holding or waiting for the handler lock,
+    // so do not wait for it here. It exits on its next step.
+    wrap_g_mutex_lock( m_mutex );
+    m_stop = true;
+    wrap_g_mutex_unlock( m_mutex );
+
+    m_running     = SAHPI_FALSE;
+    m_new_running = SAHPI_FALSE;
+}
+
+void cLoad::Shutdown()
+{
+    wrap_g_mutex_lock( m_mutex );
+    m_stop = true;
+    while ( m_thread_running ) {
+        g_cond_wait( m_cond, m_mutex );
+    }
+    wrap_g_mutex_unlock( m_mutex );
+}
+
+
+// cObject virtual functions
+void cLoad::GetNB( std::string& nb ) const
+{
+    cObject::GetNB( nb );
+    nb += "- Set Populated = TRUE to create Template.Resources resources\n";
+    nb += "    with Template.Sensors threshold sensors each.\n";
+    nb += "    Resources are placed under Template.ParentEntity.\n";
+    nb += "- Set Running = TRUE to post events at the Rate.* values\n";
+    nb += "    (events per second, 0 disables the stream).\n";
+    nb += "- Rates can be changed while running.\n";
+    nb += "- Set Populated = FALSE to stop and remove generated resources.\n";
+}
+
+void cLoad::GetVars( cVars& vars )
+{
+    cObject::GetVars( vars );
+
+    bool populated = ( m_populated != SAHPI_FALSE );
+
+    vars << "Template.Resources"
+         << dtSaHpiUint32T
+         << DATA( m_resources )
+         << READONLY_IF( populated )
+         << VAR_END();
+    vars << "Template.Sensors"
+         << dtSaHpiUint32T
+         << DATA( m_sensors )
+         << READONLY_IF( populated )
+         << VAR_END();
+    vars << "Template.ParentEntity"
+         << dtSaHpiEntityPathT
+         << DATA( m_parent )
+         << READONLY_IF( populated )
+         << VAR_END();
+    vars << "Populated"
+         << dtSaHpiBoolT
+         << DATA( m_populated, m_new_populated )
+         << VAR_END();
+    vars << "Rate.SensorEvents"
+         << dtSaHpiUint32T
+         << DATA( m_rates[SensorStream] )
+         << VAR_END();
+    vars << "Rate.HotSwapEvents"
+         << dtSaHpiUint32T
+         << DATA( m_rates[HotSwapStream] )
+         << VAR_END();
+    vars << "Rate.FailureEvents"
+         << dtSaHpiUint32T
+         << DATA( m_rates[FailureStream] )
+         << VAR_END();
+    vars << "Running"
+         << dtSaHpiBoolT
+         << DATA( m_running, m_new_running )
+         << VAR_END();
+    vars << "Stats.SensorEvents"
+         << dtSaHpiUint64T
+         << DATA( m_count[SensorStream] )
+         << READONLY()
+         << VAR_END();
+    vars << "Stats.HotSwapEvents"
+         << dtSaHpiUint64T
+         << DATA( m_count[HotSwapStream] )
+         << READONLY()
+         << VAR_END();
+    vars << "Stats.FailureEvents"
+         << dtSaHpiUint64T
+         << DATA( m_count[FailureStream] )
+         << READONLY()
+         << VAR_END();
+    vars << "Stats.Resyncs"
+         << dtSaHpiUint64T
+         << DATA( m_late )
+         << READONLY()
+         << VAR_END();
+    vars << "Stats.MaxLagUsec"
+         << dtSaHpiUint64T
+         << DATA( m_max_lag )
+         << READONLY()
+         << VAR_END();
+}
+
+void cLoad::BeforeVarSet( const std::string& var_name )
+{
+    cObject::BeforeVarSet( var_name );
+
+    m_new_populated = m_populated;
+    m_new_running   = m_running;
+}
+
+void cLoad::AfterVarSet( const std::string& var_name )
+{
+    cObject::AfterVarSet( var_name );
+
+    if ( m_populated != m_new_populated ) {
+        if ( m_new_populated != SAHPI_FALSE ) {
+            Populate();
+        } else {
+            Depopulate();
+        }
+    }
+    if ( m_running != m_new_running ) {
+        if ( m_new_running != SAHPI_FALSE ) {
+            Start();
+        } else {
+            Stop();
+        }
+    }
+}
+
+
+// Generator thread
+gpointer cLoad::ThreadFuncAdapter( gpointer data )
+{
+    cLoad * me = reinterpret_cast<cLoad *>(data);
+    me->ThreadFunc();
+
+    return 0;
+}
+
+/***
+ * Each stream has its own schedule: event k is due at
+ * start + k / rate. Deadlines are absolute, so sleep jitter
+ * does not accumulate and the average rate stays exact.
+ * Events that are late are posted in bursts to catch up.
+ * If a stream lags more than MaxLag, its schedule restarts.
+ **/
+void cLoad::ThreadFunc()
+{
+    gint64       start[StreamCount];
+    SaHpiUint64T k[StreamCount];
+    SaHpiUint32T rates[StreamCount];
+
+    for ( size_t i = 0; i < StreamCount; ++i ) {
+        start[i] = 0;
+        k[i]     = 0;
+        rates[i] = 0;
+    }
+
+    while ( true ) {
+        gint64 wakeup;
+        {
+            cLocker<cHandler> al( &m_handler );
+
+            wrap_g_mutex_lock( m_mutex );
+            if ( m_stop ) {
+                m_thread_running = false;
+                g_cond_broadcast( m_cond );
+                wrap_g_mutex_unlock( m_mutex );
+                return;
+            }
+            bool reset = m_reset;
+            m_reset = false;
+            wrap_g_mutex_unlock( m_mutex );
+
+            gint64 now = Now();
+            wakeup = now + MaxSleep;
+
+            for ( size_t i = 0; i < StreamCount; ++i ) {
+                if ( reset || ( rates[i] != m_rates[i] ) ) {
+                    rates[i] = m_rates[i];
+                    start[i] = now;
+                    k[i]     = 0;
+                }
+                if ( rates[i] == 0 ) {
+                    continue;
+                }
+
+                gint64 due = start[i] + (gint64)( k[i] * 1000000ULL / rates[i] );
+                for ( SaHpiUint32T n = 0; ( due <= now ) && ( n < MaxBurst ); ++n ) {
+                    SaHpiUint64T lag = now - due;
+                    if ( lag > (SaHpiUint64T)MaxLag ) {
+                        ++m_late;
+                        start[i] = now;
+                        k[i]     = 0;
+                        lag      = 0;
+                    }
+                    if ( lag > m_max_lag ) {
+                        m_max_lag = lag;
+                    }
+                    if ( Fire( static_cast<eStream>(i) ) ) {
+                        ++m_count[i];
+                    }
+                    ++k[i];
+                    due = start[i] + (gint64)( k[i] * 1000000ULL / rates[i] );
+                }
+                if ( due < wakeup ) {
+                    wakeup = due;
+                }
+            }
+        }
+
+        gint64 now = Now();
+        if ( wakeup > now ) {
+            g_usleep( wakeup - now );
+        }
+    }
+}
+
+bool cLoad::Fire( eStream stream )
+{
+    if ( m_rids.empty() ) {
+        return false;
+    }
+
+    switch ( stream ) {
+        case SensorStream:
+            return FireSensor();
+        case HotSwapStream:
+            return FireHotSwap();
+        case FailureStream:
+            return FireFailure();
+        default:
+            return false;
+    }
+}
+
+/***
+ * Moves the reading of the next sensor across the upper minor
+ * threshold and back, so every call asserts or deasserts
+ * one threshold event state.
+ **/
+bool cLoad::FireSensor()
+{
+    if ( m_sensors == 0 ) {
+        return false;
+    }
+
+    size_t pos = m_next[SensorStream]++ % ( m_rids.size() * m_sensors );
+    cResource * r = m_handler.GetResource( m_rids[pos / m_sensors] );
+    if ( !r ) {
+        return false;
+    }
+    cSensor * s = r->GetSensor( ( pos % m_sensors ) + 1 );
+    if ( !s ) {
+        return false;
+    }
+
+    SaErrorT rv;
+    SaHpiSensorReadingT reading;
+    SaHpiEventStateT states;
+    SaHpiSensorThresholdsT ths;
+    rv = s->GetReading( reading, states );
+    if ( rv != SA_OK ) {
+        return false;
+    }
+    rv = s->GetThresholds( ths );
+    if ( rv != SA_OK ) {
+        return false;
+    }
+
+    SaHpiFloat64T low_minor, up_minor, up_major;
+    if ( !GetFloat( ths.LowMinor, low_minor ) ||
+         !GetFloat( ths.UpMinor, up_minor ) ||
+         !GetFloat( ths.UpMajor, up_major ) )
+    {
+        return false;
+    }
+
+    SaHpiFloat64T x;
+    if ( ( states & SAHPI_ES_UPPER_MINOR ) != 0 ) {
+        x = ( low_minor + up_minor ) / 2;
+    } else {
+        x = ( up_minor + up_major ) / 2;
+    }
+
+    return SetVar( *s, "Reading.Value", dtSaHpiFloat64T, x );
+}
+
+/***
+ * Walks the next resource through insertion or extraction.
+ **/
+bool cLoad::FireHotSwap()
+{
+    size_t pos = m_next[HotSwapStream]++ % m_rids.size();
+    cResource * r = m_handler.GetResource( m_rids[pos] );
+    if ( !r ) {
+        return false;
+    }
+
+    SaHpiHsStateT state;
+    SaErrorT rv = r->GetHsState( state );
+    if ( rv != SA_OK ) {
+        return false;
+    }
+    if ( state == SAHPI_HS_STATE_INACTIVE ) {
+        rv = r->RequestHsAction( SAHPI_HS_ACTION_INSERTION );
+    } else if ( state == SAHPI_HS_STATE_ACTIVE ) {
+        rv = r->RequestHsAction( SAHPI_HS_ACTION_EXTRACTION );
+    } else {
+        // Waiting for auto insertion/extraction timeout
+        return false;
+    }
+
+    return ( rv == SA_OK );
+}
+
+/***
+ * Fails the next resource, or restores it if it has failed.
+ **/
+bool cLoad::FireFailure()
+{
+    size_t pos = m_next[FailureStream]++ % m_rids.size();
+    cResource * r = m_handler.GetResource( m_rids[pos] );
+    if ( !r ) {
+        return false;
+    }
+
+    SaHpiBoolT failed = r->IsFailed() ? SAHPI_FALSE : SAHPI_TRUE;
+
+    return SetVar( *r, "ResourceFailed", dtSaHpiBoolT, failed );
+}
+
+
+}; // namespace TA
+
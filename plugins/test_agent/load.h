@@ -0,0 +1,145 @@
+/*      -*- c++ -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#ifndef LOAD_H_FB2B5DD5_4E7D_49F5_9397_C2FEC21B4010
+#define LOAD_H_FB2B5DD5_4E7D_49F5_9397_C2FEC21B4010
+
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+
+#include "object.h"
+
+
+namespace TA {
+
+
+/**************************************************************
+ * struct LoadParams
+ *************************************************************/
+struct LoadParams
+{
+    explicit LoadParams();
+
+    SaHpiUint32T     resources;
+    SaHpiUint32T     sensors;
+    SaHpiEntityPathT parent;
+    SaHpiUint32T     sensor_rate;   // events per second
+    SaHpiUint32T     hotswap_rate;  // events per second
+    SaHpiUint32T     failure_rate;  // events per second
+};
+
+
+/**************************************************************
+ * class cLoad
+ *
+ * Synthetic load generator.
+ * Creates Resources x Sensors objects from a template
+ * and changes their state at the configured rates.
+ *
+ * Every change goes through the same code as a console "set",
+ * so generated events are the ones a user would get.
+ *************************************************************/
+class cHandler;
+
+class cLoad : public cObject
+{
+public:
+
+    static const std::string classname;
+
+    explicit cLoad( cHandler& handler );
+    virtual ~cLoad();
+
+    // Called with handler lock held
+    void Configure( const LoadParams& params );
+    bool Populate();
+    void Depopulate();
+    bool Start();
+    void Stop();
+
+    // Called without handler lock
+    void Shutdown();
+
+protected: // cObject virtual functions
+
+    virtual void GetNB( std::string& nb ) const;
+    virtual void GetVars( cVars& vars );
+    virtual void BeforeVarSet( const std::string& var_name );
+    virtual void AfterVarSet( const std::string& var_name );
+
+private:
+
+    cLoad( const cLoad& );
+    cLoad& operator =( const cLoad& );
+
+private:
+
+    enum eStream
+    {
+        SensorStream = 0,
+        HotSwapStream,
+        FailureStream,
+        StreamCount,
+    };
+
+    static gpointer ThreadFuncAdapter( gpointer data );
+    void ThreadFunc();
+    bool Fire( eStream stream );
+    bool FireSensor();
+    bool FireHotSwap();
+    bool FireFailure();
+
+private: // data
+
+    typedef std::vector<SaHpiResourceIdT> Rids;
+
+    cHandler&        m_handler;
+    Rids             m_rids;
+
+    // Template
+    SaHpiUint32T     m_resources;
+    SaHpiUint32T     m_sensors;
+    SaHpiEntityPathT m_parent;
+
+    // Rates, events per second
+    SaHpiUint32T     m_rates[StreamCount];
+
+    SaHpiBoolT       m_populated;
+    SaHpiBoolT       m_new_populated;
+    SaHpiBoolT       m_running;
+    SaHpiBoolT       m_new_running;
+
+    // Round-robin positions
+    size_t           m_next[StreamCount];
+
+    // Statistics
+    SaHpiUint64T     m_count[StreamCount];
+    SaHpiUint64T     m_late;
+    SaHpiUint64T     m_max_lag;
+
+    // Generator thread state, protected by m_mutex
+    GMutex *         m_mutex;
+    GCond *          m_cond;
+    bool             m_thread_running;
+    bool             m_stop;
+    bool             m_reset;
+};
+
+
+}; // namespace TA
+
+
+#endif // LOAD_H_FB2B5DD5_4E7D_49F5_9397_C2FEC21B4010
+
@@ -21,6 +21,36 @@
 #include <oh_error.h>
 #include <snmp_utils.h>
 
+/*
+ * Copy a single response varbind into @value.
+ * Returns SA_ERR_HPI_NOT_PRESENT for SNMP exception varbinds.
+ */
+static SaErrorT snmp_var2value(struct variable_list *vars,
+			       struct snmp_value *value)
+{
+	value->type = vars->type;
+
+	if ( !(CHECK_END(vars->type)) ) {
+		/* This is one of the exception condition */
+		return(SA_ERR_HPI_NOT_PRESENT);
+
+	} else if ( (vars->type == ASN_INTEGER) || 
+		    (vars->type == ASN_COUNTER) || 
+		    (vars->type == ASN_UNSIGNED) ) {
+		value->integer = *(vars->val.integer);
+
+	} else { 
+		value->str_len = vars->val_len;
+		if (value->str_len >= MAX_ASN_STR_LEN)
+			value->str_len = MAX_ASN_STR_LEN;
+		if (value->str_len > 0)
+			memcpy(value->string, vars->val.string, value->str_len);
+		value->string[value->str_len] = '\0'; /* guarantee NULL terminated string */
+	}
+
+	return(SA_OK);
+}
+
 /**
  * snmp_get
  * @ss: a handle to the snmp session needed to make an
@@ -66,30 +96,14 @@ SaErrorT snmp_get( void *sessp,
         if (status == STAT_SUCCESS) {
 		if(response->errstat == SNMP_ERR_NOERROR) {
                	 	vars = response->variables;
-                	value->type = vars->type;
                 	if (vars->next_variable != NULL) {
                 		/* There are more values, set return type to null. */
                         	value->type = ASN_NULL;
-			} else if ( !(CHECK_END(vars->type)) ) {
-				/* This is one of the exception condition */
-				returncode = SA_ERR_HPI_NOT_PRESENT;
-				DBG("Warning: OID=%s gets snmp exception %d \n",objid, vars->type);
-
-                    	} else if ( (vars->type == ASN_INTEGER) || 
-				    (vars->type == ASN_COUNTER) || 
-			    	    (vars->type == ASN_UNSIGNED) ) {
-                        	value->integer = *(vars->val.integer);
-
-                	} else { 
-                        	value->str_len = vars->val_len;
-                        	if (value->str_len >= MAX_ASN_STR_LEN)
-                                		value->str_len = MAX_ASN_STR_LEN;
-				if (value->str_len > 0)
-                        	    memcpy(value->string, vars->val.string, value->str_len);						
-						
-                        	value->string[value->str_len] = '\0'; /* guarantee NULL terminated string */
-				
-                	}
+			} else {
+				returncode = snmp_var2value(vars, value);
+				if (returncode)
+					DBG("Warning: OID=%s gets snmp exception %d \n",objid, vars->type);
+			}
 
 		} else {
                         DBG("Error in packet %s\nReason: %s\n",
@@ -111,6 +125,96 @@ SaErrorT snmp_get( void *sessp,
         return (returncode);
 }
 
+/**
+ * snmp_getn
+ * @sessp: a handle to the snmp session needed to make an
+ * snmp transaction.
+ * @objids: array of strings containing the OID entries.
+ * @num: number of entries in @objids, at most SNMP_GETN_MAX.
+ * @values: array of @num locations for the values received from snmp.
+ * @errs: array of @num locations for the per OID return codes.
+ *
+ * Gets several values indicated by the objectids with a single GET PDU.
+ * An OID the agent doesn't know only fails its own entry, which gets
+ * SA_ERR_HPI_NOT_PRESENT in @errs. SNMPv1 agents reject the whole PDU
+ * instead; this is returned as an error and callers should fall back to
+ * snmp_get() for the individual OIDs.
+ *
+ * Returns: 0 if the PDU was answered, <0 if there was an error.
+ **/
+SaErrorT snmp_getn(void *sessp,
+		   const char **objids,
+		   int num,
+		   struct snmp_value *values,
+		   SaErrorT *errs)
+{
+        struct snmp_pdu *pdu;
+        struct snmp_pdu *response = NULL;
+	struct snmp_session *session;
+
+        oid anOID[MAX_OID_LEN];
+        size_t anOID_len;
+        struct variable_list *vars;
+	SaErrorT returncode = SA_OK;
+        int i, status;
+
+	if (num <= 0 || num > SNMP_GETN_MAX || !objids || !values || !errs)
+		return(SA_ERR_HPI_INVALID_PARAMS);
+
+        /*
+         * Create the PDU for the data for our request.
+         */
+        pdu = snmp_pdu_create(SNMP_MSG_GET);
+	for (i = 0; i < num; i++) {
+		anOID_len = MAX_OID_LEN;
+		if (!read_objid(objids[i], anOID, &anOID_len)) {
+			DBG("Cannot parse OID=%s\n", objids[i]);
+			snmp_free_pdu(pdu);
+			return(SA_ERR_HPI_INVALID_PARAMS);
+		}
+		snmp_add_null_var(pdu, anOID, anOID_len);
+		errs[i] = SA_ERR_HPI_NOT_PRESENT;
+		values[i].type = ASN_NULL;
+	}
+
+        /*
+         * Send the Request out.
+         */
+        status = snmp_sess_synch_response(sessp, pdu, &response);
+
+        /*
+         * Process the response. Varbinds come back in request order.
+         */
+        if (status == STAT_SUCCESS) {
+		if (response->errstat == SNMP_ERR_NOERROR) {
+			for (i = 0, vars = response->variables;
+			     i < num && vars != NULL;
+			     i++, vars = vars->next_variable) {
+				errs[i] = snmp_var2value(vars, &values[i]);
+				if (errs[i])
+					DBG("Warning: OID=%s gets snmp exception %d \n",
+					    objids[i], vars->type);
+			}
+		} else {
+                        DBG("Error in packet %s\nReason: %s\n",
+                            objids[response->errindex > 0 ? response->errindex - 1 : 0],
+			    snmp_errstring(response->errstat));
+			returncode = errstat2hpi(response->errstat);
+		}
+
+        } else {
+		session = snmp_sess_session(sessp);
+                snmp_sess_perror("snmpget", session);
+                DBG("OID %s (+%d), error status: %d\n", objids[0], num - 1, status);
+		returncode = snmpstat2hpi(status);
+        }
+
+        /* Clean up: free the response */
+        if (response) snmp_free_pdu(response);
+
+        return (returncode);
+}
+
 /**
  * snmp_set
  * @ss: a handle to the snmp session needed to make an snmp transaction.
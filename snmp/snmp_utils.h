@@ -61,6 +61,7 @@
 #define SNMP_BC_MM_BULK_MAX 45
 #define SNMP_BC_BULK_DEFAULT 32
 #define SNMP_BC_BULK_MIN 16
+#define SNMP_GETN_MAX 32	/* Max varbinds packed into one GET PDU by snmp_getn() */
 
 #define SA_ERR_SNMP_BASE - 10000
 #define SA_ERR_SNMP_NOSUCHOBJECT	(SaErrorT)(SA_ERR_SNMP_BASE - SNMP_NOSUCHOBJECT)
@@ -90,6 +91,13 @@ SaErrorT snmp_get(
         const char *objid,
         struct snmp_value *value);
 
+SaErrorT snmp_getn(
+        void *sessp,
+        const char **objids,
+        int num,
+        struct snmp_value *values,
+        SaErrorT *errs);
+
 SaErrorT snmp_set(
         void *sessp,
         char *objid,
@@ -32,7 +32,9 @@
 #include <netinet/tcp.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
 #endif
 
@@ -120,11 +122,115 @@ static void SelectAddresses( int ipvflags,
 }
 
 
+/***************************************************************
+ * Payload compression
+ *
+ * RPT entries, RDRs and events are fixed size structs, mostly
+ * zero padding and unused text buffers. A run-length encoding
+ * takes care of that at next to no CPU cost:
+ * - control byte 0x00-0x7F: control + 1 literal bytes follow
+ * - control byte 0x80-0xFF: (control & 0x7F) + 3 copies of the
+ *   byte that follows
+ **************************************************************/
+const size_t dMinRun     = 3;
+const size_t dMaxRun     = 0x7F + dMinRun;
+const size_t dMaxLiteral = 0x80;
+
+static bool PackLiteral( const uint8_t * src, size_t n,
+                         uint8_t * dst, size_t cap, size_t& pos )
+{
+    if ( n == 0 ) {
+        return true;
+    }
+    if ( pos + 1 + n > cap ) {
+        return false;
+    }
+    dst[pos++] = (uint8_t)( n - 1 );
+    memcpy( &dst[pos], src, n );
+    pos += n;
+
+    return true;
+}
+
+// Returns encoded length, 0 if it would take more than cap bytes
+static size_t PackPayload( const uint8_t * src, size_t len,
+                           uint8_t * dst, size_t cap )
+{
+    size_t pos = 0;
+    size_t lit = 0;
+    size_t i = 0;
+
+    while ( i < len ) {
+        size_t run = 1;
+        while ( ( i + run < len ) && ( run < dMaxRun ) && ( src[i + run] == src[i] ) ) {
+            ++run;
+        }
+        if ( run >= dMinRun ) {
+            if ( !PackLiteral( &src[lit], i - lit, dst, cap, pos ) ) {
+                return 0;
+            }
+            if ( pos + 2 > cap ) {
+                return 0;
+            }
+            dst[pos++] = (uint8_t)( 0x80 | ( run - dMinRun ) );
+            dst[pos++] = src[i];
+            i += run;
+            lit = i;
+        } else {
+            ++i;
+            if ( i - lit == dMaxLiteral ) {
+                if ( !PackLiteral( &src[lit], i - lit, dst, cap, pos ) ) {
+                    return 0;
+                }
+                lit = i;
+            }
+        }
+    }
+    if ( !PackLiteral( &src[lit], i - lit, dst, cap, pos ) ) {
+        return 0;
+    }
+
+    return pos;
+}
+
+static bool UnpackPayload( const uint8_t * src, size_t len,
+                           uint8_t * dst, size_t cap, size_t& out )
+{
+    size_t pos = 0;
+    size_t i = 0;
+
+    while ( i < len ) {
+        uint8_t ctl = src[i++];
+        if ( ( ctl & 0x80 ) != 0 ) {
+            size_t run = ( ctl & 0x7F ) + dMinRun;
+            if ( ( i >= len ) || ( pos + run > cap ) ) {
+                return false;
+            }
+            memset( &dst[pos], src[i++], run );
+            pos += run;
+        } else {
+            size_t n = ctl + 1;
+            if ( ( i + n > len ) || ( pos + n > cap ) ) {
+                return false;
+            }
+            memcpy( &dst[pos], &src[i], n );
+            i += n;
+            pos += n;
+        }
+    }
+    out = pos;
+
+    return true;
+}
+
+
 /***************************************************************
  * Base Stream Socket class
  **************************************************************/
 cStreamSock::cStreamSock( SockFdT sockfd )
-    : m_sockfd( sockfd )
+    : m_sockfd( sockfd ),
+      m_compress_threshold( 0 ),
+      m_peer_compress( false )
 {
     // empty
 }
@@ -143,6 +249,27 @@ bool cStreamSock::GetPeerAddress( SockAddrStorageT& storage ) const
     return ( cc == 0 );
 }
 
+#ifndef _WIN32
+bool cStreamSock::GetPeerCredentials( uid_t& uid, gid_t& gid, pid_t& pid ) const
+{
+#ifdef SO_PEERCRED
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    int cc = getsockopt( m_sockfd, SOL_SOCKET, SO_PEERCRED, &cred, &len );
+    if ( cc != 0 ) {
+        return false;
+    }
+    uid = cred.uid;
+    gid = cred.gid;
+    pid = cred.pid;
+
+    return true;
+#else
+    return false;
+#endif /* SO_PEERCRED */
+}
+#endif /* _WIN32 */
+
 bool cStreamSock::Close()
 {
     if ( m_sockfd == InvalidSockFd ) {
@@ -168,11 +295,27 @@ bool cStreamSock::Close()
     return true;
 }
 
+bool cStreamSock::Shutdown()
+{
+    if ( m_sockfd == InvalidSockFd ) {
+        return true;
+    }
+
+#ifdef _WIN32
+    int cc = shutdown( m_sockfd, SD_BOTH );
+#else
+    int cc = shutdown( m_sockfd, SHUT_RDWR );
+#endif
+
+    return ( cc == 0 );
+}
+
 bool cStreamSock::ReadMsg( uint8_t& type,
                            uint32_t& id,
                            void * payload,
                            uint32_t& payload_len,
-                           int& payload_byte_order )
+                           int& payload_byte_order,
+                           int * tag )
 {
     // Windows recv() takes char * so we need the workaround below.
     union {
@@ -183,14 +326,18 @@ bool cStreamSock::ReadMsg( uint8_t& type,
     char * dst = rawhdr;
     size_t got  = 0;
     size_t need = dMhSize;
+    // compressed payload is read here and then unpacked into payload
+    uint8_t * packed = 0;
     while ( got < need ) {
         ssize_t len = recv( m_sockfd, dst + got, need - got, 0 );
         if ( len < 0 ) {
             CRIT( "error while reading message in thread %p.", 
             g_thread_self() );
+            g_free( packed );
             return false;
         } else if ( len == 0 ) {
             //CRIT( "peer closed connection." );
+            g_free( packed );
             return false;
         }
         got += len;
@@ -209,14 +356,45 @@ bool cStreamSock::ReadMsg( uint8_t& type,
                                  G_LITTLE_ENDIAN : G_BIG_ENDIAN;
             id = DecodeUint32( &hdr[dMhOffId], payload_byte_order );
             payload_len = DecodeUint32( &hdr[dMhOffLen], payload_byte_order );
+            if ( tag ) {
+                if ( ( hdr[dMhOffFlags] & dMhTagBit ) != 0 ) {
+                    *tag = ( hdr[dMhOffReserved1] << 8 ) | hdr[dMhOffReserved2];
+                } else {
+                    *tag = -1;
+                }
+            }
+            if ( ( hdr[dMhOffFlags] & dMhCompressOkBit ) != 0 ) {
+                m_peer_compress = true;
+            }
 
             // now prepare to get payload
             dst  = reinterpret_cast<char *>(payload);
             got  = 0;
             need = payload_len;
+            if ( ( hdr[dMhOffFlags] & dMhCompressBit ) != 0 ) {
+                if ( payload_len > dMaxPayloadLength ) {
+                    CRIT( "compressed payload too large." );
+                    return false;
+                }
+                packed = reinterpret_cast<uint8_t *>( g_malloc( need ) );
+                dst = reinterpret_cast<char *>( packed );
+            }
         }
     }
 
+    if ( packed ) {
+        size_t out = 0;
+        bool rc = UnpackPayload( packed, got,
+                                 reinterpret_cast<uint8_t *>(payload),
+                                 dMaxPayloadLength, out );
+        g_free( packed );
+        if ( !rc ) {
+            CRIT( "invalid compressed payload." );
+            return false;
+        }
+        got = out;
+    }
+
     payload_len = got;
 
 /*
@@ -248,7 +426,8 @@ bool cStreamSock::ReadMsg( uint8_t& type,
 bool cStreamSock::WriteMsg( uint8_t type,
                             uint32_t id,
                             const void * payload,
-                            uint32_t payload_len )
+                            uint32_t payload_len,
+                            int tag )
 {
     if ( ( payload_len > 0 ) && ( payload == 0 ) ) {
         return false;
@@ -271,13 +450,36 @@ bool cStreamSock::WriteMsg( uint8_t type,
     }
     hdr[dMhOffReserved1] = 0;
     hdr[dMhOffReserved2] = 0;
+    if ( tag >= 0 ) {
+        hdr[dMhOffFlags] |= dMhTagBit;
+        hdr[dMhOffReserved1] = ( tag >> 8 ) & 0xFF;
+        hdr[dMhOffReserved2] = tag & 0xFF;
+    }
+
+    uint32_t wire_len = payload_len;
+    bool packed = false;
+    if ( m_compress_threshold != 0 ) {
+        hdr[dMhOffFlags] |= dMhCompressOkBit;
+        if ( payload && m_peer_compress && ( payload_len >= m_compress_threshold ) ) {
+            // only worth it if it saves something
+            size_t n = PackPayload( reinterpret_cast<const uint8_t *>(payload),
+                                    payload_len,
+                                    reinterpret_cast<uint8_t *>(&msg[dMhSize]),
+                                    payload_len - 1 );
+            if ( n != 0 ) {
+                hdr[dMhOffFlags] |= dMhCompressBit;
+                wire_len = n;
+                packed = true;
+            }
+        }
+    }
     EncodeUint32( &hdr[dMhOffId], id, G_BYTE_ORDER );
-    EncodeUint32( &hdr[dMhOffLen], payload_len, G_BYTE_ORDER );
+    EncodeUint32( &hdr[dMhOffLen], wire_len, G_BYTE_ORDER );
 
-    if ( payload ) {
+    if ( payload && !packed ) {
         memcpy( &msg[dMhSize], payload, payload_len );
     }
-    size_t msg_len = dMhSize + payload_len;
+    size_t msg_len = dMhSize + wire_len;
 
 /*
     printf("Transport: sending message of %d bytes:\n", msg_len );
@@ -301,6 +503,39 @@ bool cStreamSock::WriteMsg( uint8_t type,
     return true;
 }
 
+void cStreamSock::EnableCompression( uint32_t threshold )
+{
+    m_compress_threshold = threshold;
+}
+
+bool cStreamSock::ReadRaw( void * data, size_t& len )
+{
+    // Windows recv() takes char *
+    ssize_t cc = recv( m_sockfd, reinterpret_cast<char *>(data), len, 0 );
+    if ( cc <= 0 ) {
+        return false;
+    }
+    len = cc;
+
+    return true;
+}
+
+bool cStreamSock::WriteRaw( const void * data, size_t len )
+{
+    const char * src = reinterpret_cast<const char *>(data);
+    while ( len > 0 ) {
+        ssize_t cc = send( m_sockfd, src, len, 0 );
+        if ( cc <= 0 ) {
+            CRIT( "error while sending data." );
+            return false;
+        }
+        src += cc;
+        len -= cc;
+    }
+
+    return true;
+}
+
 cStreamSock::eWaitCc cStreamSock::Wait()
 {
     fd_set fds;
@@ -329,6 +564,35 @@ cStreamSock::eWaitCc cStreamSock::Wait()
     return eWaitSuccess;
 }
 
+bool cStreamSock::SetTimeouts( unsigned int ms )
+{
+    int cc;
+
+#ifdef _WIN32
+    DWORD tv = ms;
+    cc = setsockopt( m_sockfd, SOL_SOCKET, SO_SNDTIMEO,
+                     (const char *)&tv, sizeof(tv) );
+    if ( cc == 0 ) {
+        cc = setsockopt( m_sockfd, SOL_SOCKET, SO_RCVTIMEO,
+                         (const char *)&tv, sizeof(tv) );
+    }
+#else
+    struct timeval tv;
+    tv.tv_sec  = ms / 1000;
+    tv.tv_usec = ( ms % 1000 ) * 1000;
+    cc = setsockopt( m_sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv) );
+    if ( cc == 0 ) {
+        cc = setsockopt( m_sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) );
+    }
+#endif
+    if ( cc != 0 ) {
+        CRIT( "failed to set socket timeouts." );
+        return false;
+    }
+
+    return true;
+}
+
 bool cStreamSock::CreateAttempt( const struct addrinfo * info, bool last_attempt )
 {
     bool rc = Close();
@@ -370,6 +634,31 @@ bool cStreamSock::CreateAttempt( const struct addrinfo * info, bool last_attempt
     return true;
 }
 
+#ifndef _WIN32
+bool cStreamSock::MakeLocalAddress( const char * path,
+                                    struct sockaddr_un& sun,
+                                    struct addrinfo& info )
+{
+    if ( strlen( path ) >= sizeof(sun.sun_path) ) {
+        CRIT( "local socket path %s is too long.", path );
+        return false;
+    }
+
+    memset( &sun, 0, sizeof(sun) );
+    sun.sun_family = AF_UNIX;
+    strcpy( sun.sun_path, path );
+
+    memset( &info, 0, sizeof(info) );
+    info.ai_family   = AF_UNIX;
+    info.ai_socktype = SOCK_STREAM;
+    info.ai_protocol = 0;
+    info.ai_addr     = reinterpret_cast<struct sockaddr *>( &sun );
+    info.ai_addrlen  = sizeof(sun);
+
+    return true;
+}
+#endif /* _WIN32 */
+
 
 /***************************************************************
  * Client Stream Socket class
@@ -405,6 +694,20 @@ bool cClientStreamSock::Create( const char * host, uint16_t port )
     return connected;
 }
 
+#ifndef _WIN32
+bool cClientStreamSock::CreateLocal( const char * path )
+{
+    struct sockaddr_un sun;
+    struct addrinfo info;
+
+    if ( !MakeLocalAddress( path, sun, info ) ) {
+        return false;
+    }
+
+    return CreateAttempt( &info, true );
+}
+#endif /* _WIN32 */
+
 bool cClientStreamSock::EnableKeepAliveProbes( int keepalive_time,
                                                int keepalive_intvl,
                                                int keepalive_probes )
@@ -503,6 +806,51 @@ bool cServerStreamSock::Create( int ipvflags, const char * bindaddr, uint16_t po
     return bound;
 }
 
+#ifndef _WIN32
+bool cServerStreamSock::CreateLocal( const char * path )
+{
+    struct sockaddr_un sun;
+    struct addrinfo info;
+
+    if ( !MakeLocalAddress( path, sun, info ) ) {
+        return false;
+    }
+
+    // Only a socket left behind by a server that is gone is replaced
+    struct stat st;
+    if ( lstat( path, &st ) == 0 ) {
+        if ( !S_ISSOCK( st.st_mode ) ) {
+            CRIT( "%s exists and is not a socket.", path );
+            return false;
+        }
+        int fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+        if ( fd < 0 ) {
+            CRIT( "cannot create socket." );
+            return false;
+        }
+        int cc = connect( fd, info.ai_addr, info.ai_addrlen );
+        int err = errno;
+        close( fd );
+        if ( cc == 0 ) {
+            CRIT( "%s is in use by another server.", path );
+            return false;
+        }
+        if ( err != ECONNREFUSED ) {
+            CRIT( "cannot check %s: %s.", path, strerror( err ) );
+            return false;
+        }
+        unlink( path );
+    }
+
+    // bind() creates the socket file, it must never be world accessible
+    mode_t prev_umask = umask( S_IXUSR | S_IXGRP | S_IRWXO );
+    bool rc = CreateAttempt( &info, true );
+    umask( prev_umask );
+
+    return rc;
+}
+#endif /* _WIN32 */
+
 bool cServerStreamSock::CreateAttempt( const struct addrinfo * info, bool last_attempt )
 {
     bool rc = cStreamSock::CreateAttempt( info, last_attempt );
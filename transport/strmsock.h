@@ -30,6 +30,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #endif
 
 
@@ -61,8 +62,17 @@ const uint8_t eMhError = 2;
 // message flags
 // bits 0-3 : flags, bit 4-7 : OpenHPI RPC version
 // if endian bit is set the byte order is Little Endian
-const uint8_t dMhEndianBit  = 1;
-const uint8_t dMhRpcVersion = 1;
+// if tag bit is set the reserved bytes hold a request tag:
+// several requests can be in flight on one connection and
+// the reply carries the tag of its request
+// if compress bit is set the payload is run-length encoded and
+// the length field holds the encoded length
+// if compress ok bit is set the sender takes compressed payloads
+const uint8_t dMhEndianBit     = 1;
+const uint8_t dMhTagBit        = 2;
+const uint8_t dMhCompressBit   = 4;
+const uint8_t dMhCompressOkBit = 8;
+const uint8_t dMhRpcVersion    = 1;
 
 
 const size_t dMaxMessageLength = 0xFFFF;
@@ -93,18 +103,35 @@ public:
 
     bool Close();
 
+    // Wakes up a thread blocked in ReadMsg, the socket stays open
+    bool Shutdown();
+
     bool GetPeerAddress( SockAddrStorageT& storage ) const;
 
+#ifndef _WIN32
+    // Credentials of the peer process, local sockets only
+    bool GetPeerCredentials( uid_t& uid, gid_t& gid, pid_t& pid ) const;
+#endif
+
+    // tag gets -1 for a message without request tag
     bool ReadMsg( uint8_t& type,
                   uint32_t& id,
                   void * payload,
                   uint32_t& payload_len,
-                  int& payload_byte_order );
+                  int& payload_byte_order,
+                  int * tag = 0 );
 
+    // tag -1 - message without request tag
     bool WriteMsg( uint8_t type,
                    uint32_t id,
                    const void * payload,
-                   uint32_t payload_len );
+                   uint32_t payload_len,
+                   int tag = -1 );
+
+    // Raw data without message framing, for non-RPC protocols.
+    // ReadRaw gets whatever one recv() returns, at most len bytes.
+    bool ReadRaw( void * data, size_t& len );
+    bool WriteRaw( const void * data, size_t len );
 
     enum eWaitCc
     {
@@ -115,6 +142,13 @@ public:
 
     eWaitCc Wait();
 
+    // Blocking send and recv calls give up after ms milliseconds
+    bool SetTimeouts( unsigned int ms );
+
+    // Payloads of at least threshold bytes are sent compressed once
+    // the peer has shown that it takes them. 0 disables compression.
+    void EnableCompression( uint32_t threshold );
+
 protected:
 
     SockFdT SockFd() const
@@ -124,6 +158,12 @@ protected:
 
     bool CreateAttempt( const struct addrinfo * ainfo, bool last_attempt );
 
+#ifndef _WIN32
+    static bool MakeLocalAddress( const char * path,
+                                  struct sockaddr_un& sun,
+                                  struct addrinfo& info );
+#endif
+
 private:
 
     cStreamSock( const cStreamSock& );
@@ -132,6 +172,8 @@ private:
 private:
 
     SockFdT m_sockfd;
+    uint32_t m_compress_threshold;
+    volatile bool m_peer_compress;
 };
 
 
@@ -147,6 +189,11 @@ public:
 
     bool Create( const char * host, uint16_t port );
 
+#ifndef _WIN32
+    // Unix domain socket for clients on the same host
+    bool CreateLocal( const char * path );
+#endif
+
     /***********************
      * TCP Keep-Alive
      *
@@ -181,6 +228,12 @@ public:
 
     bool Create( int ipvflags, const char * bindaddr, uint16_t port );
 
+#ifndef _WIN32
+    // Unix domain socket, accessible to the owner and the group.
+    // A stale socket file at path is removed.
+    bool CreateLocal( const char * path );
+#endif
+
     cStreamSock * Accept();
 
 private:
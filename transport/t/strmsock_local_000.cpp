@@ -0,0 +1,100 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "strmsock.h"
+
+#define SOCK_PATH "strmsock_local_000.sock"
+
+static int failed = 0;
+
+#define CHECK( expr ) \
+    if ( !( expr ) ) { \
+        printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr ); \
+        failed = 1; \
+    }
+
+/**
+ * Local listener: a path that is not a socket or a socket with a
+ * live server behind it is left alone, a stale socket is replaced,
+ * the socket file is never world accessible, and the server sees
+ * the credentials of the connecting process.
+ * Passes if all of these hold, otherwise fails.
+ **/
+int main( int argc, char **argv )
+{
+    struct stat st;
+    FILE * fp;
+
+    unlink( SOCK_PATH );
+
+    // a regular file is not replaced
+    fp = fopen( SOCK_PATH, "w" );
+    if ( !fp ) {
+        return 1;
+    }
+    fclose( fp );
+    {
+        cServerStreamSock ssock;
+        CHECK( !ssock.CreateLocal( SOCK_PATH ) );
+    }
+    CHECK( ( lstat( SOCK_PATH, &st ) == 0 ) && S_ISREG( st.st_mode ) );
+    unlink( SOCK_PATH );
+
+    // a fresh socket is not world accessible, whatever the umask
+    umask( 0 );
+    cServerStreamSock * ssock = new cServerStreamSock;
+    CHECK( ssock->CreateLocal( SOCK_PATH ) );
+    CHECK( lstat( SOCK_PATH, &st ) == 0 );
+    CHECK( S_ISSOCK( st.st_mode ) );
+    CHECK( ( st.st_mode & 0777 ) == 0660 );
+
+    // a socket with a live server is not replaced
+    {
+        cServerStreamSock ssock2;
+        CHECK( !ssock2.CreateLocal( SOCK_PATH ) );
+    }
+
+    // the first server still works and sees who connects
+    cClientStreamSock csock;
+    CHECK( csock.CreateLocal( SOCK_PATH ) );
+    CHECK( ssock->Wait() == cStreamSock::eWaitSuccess );
+    cStreamSock * sock = ssock->Accept();
+    CHECK( sock != 0 );
+#ifdef SO_PEERCRED
+    if ( sock ) {
+        uid_t uid;
+        gid_t gid;
+        pid_t pid;
+        CHECK( sock->GetPeerCredentials( uid, gid, pid ) );
+        CHECK( uid == geteuid() );
+        CHECK( gid == getegid() );
+        CHECK( pid == getpid() );
+    }
+#endif
+    delete sock;
+    csock.Close();
+
+    // a stale socket of a server that is gone is replaced
+    delete ssock;
+    CHECK( ( lstat( SOCK_PATH, &st ) == 0 ) && S_ISSOCK( st.st_mode ) );
+    ssock = new cServerStreamSock;
+    CHECK( ssock->CreateLocal( SOCK_PATH ) );
+    delete ssock;
+
+    unlink( SOCK_PATH );
+
+    return failed;
+}
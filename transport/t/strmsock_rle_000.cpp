@@ -0,0 +1,120 @@
+/*      -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+// The payload codec is static, so it is tested with its source included
+#include "strmsock.cpp"
+
+#define BUF_SIZE 1024
+
+static int failed = 0;
+
+#define CHECK( expr ) \
+    if ( !( expr ) ) { \
+        printf( "FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr ); \
+        failed = 1; \
+    }
+
+// Packs src, checks the encoded length and that it unpacks to src again
+static void RoundTrip( const uint8_t * src, size_t len, size_t packed_len )
+{
+    uint8_t packed[BUF_SIZE];
+    uint8_t unpacked[BUF_SIZE];
+    size_t n, out = 0;
+
+    n = PackPayload( src, len, packed, sizeof(packed) );
+    CHECK( n == packed_len );
+    CHECK( UnpackPayload( packed, n, unpacked, sizeof(unpacked), out ) );
+    CHECK( out == len );
+    CHECK( memcmp( unpacked, src, len ) == 0 );
+}
+
+// Payload of a literal byte, a run of len bytes and another literal byte
+static size_t Run( uint8_t * buf, size_t len )
+{
+    buf[0] = 1;
+    memset( &buf[1], 2, len );
+    buf[len + 1] = 3;
+
+    return len + 2;
+}
+
+/**
+ * Run-length payload codec: literals up to and beyond the longest
+ * literal chunk, runs around the shortest and the longest encoded run,
+ * the raw fallback for input that does not shrink and rejection of
+ * truncated or overlong encoded input.
+ * Passes if every case packs to the expected length and unpacks to
+ * its input, and bad input is rejected, otherwise fails.
+ **/
+int main( int argc, char **argv )
+{
+    uint8_t src[BUF_SIZE];
+    uint8_t packed[BUF_SIZE];
+    uint8_t unpacked[BUF_SIZE];
+    size_t i, len, out;
+
+    // empty input packs to nothing and unpacks to nothing
+    CHECK( PackPayload( src, 0, packed, sizeof(packed) ) == 0 );
+    out = 1;
+    CHECK( UnpackPayload( packed, 0, unpacked, sizeof(unpacked), out ) );
+    CHECK( out == 0 );
+
+    // literals: one chunk of 128 bytes, then a second chunk
+    for ( i = 0; i < sizeof(src); ++i ) {
+        src[i] = (uint8_t)( i & 1 ? i : ~i );
+    }
+    RoundTrip( src, 128, 1 + 128 );
+    RoundTrip( src, 129, 1 + 128 + 1 + 1 );
+
+    // a run of 2 stays literal, runs of 3 to 130 take two bytes,
+    // the rest of a longer run is encoded on its own
+    len = Run( src, 2 );
+    RoundTrip( src, len, 1 + 4 );
+    len = Run( src, 3 );
+    RoundTrip( src, len, 2 + 2 + 2 );
+    len = Run( src, 129 );
+    RoundTrip( src, len, 2 + 2 + 2 );
+    len = Run( src, 130 );
+    RoundTrip( src, len, 2 + 2 + 2 );
+    len = Run( src, 131 );
+    RoundTrip( src, len, 2 + 2 + 3 );
+    len = Run( src, 132 );
+    RoundTrip( src, len, 2 + 2 + 4 );
+
+    // input that does not shrink is sent raw
+    for ( i = 0; i < 64; ++i ) {
+        src[i] = (uint8_t)i;
+    }
+    CHECK( PackPayload( src, 64, packed, 64 - 1 ) == 0 );
+    memset( src, 0, 64 );
+    CHECK( PackPayload( src, 64, packed, 64 - 1 ) == 2 );
+
+    // a run without its byte
+    packed[0] = 0x80;
+    CHECK( !UnpackPayload( packed, 1, unpacked, sizeof(unpacked), out ) );
+
+    // a literal with fewer bytes than announced
+    packed[0] = 0x04;
+    memset( &packed[1], 7, 4 );
+    CHECK( !UnpackPayload( packed, 5, unpacked, sizeof(unpacked), out ) );
+    CHECK( UnpackPayload( packed, 6, unpacked, sizeof(unpacked), out ) );
+
+    // output beyond the payload buffer
+    packed[0] = 0xFF;
+    packed[1] = 9;
+    CHECK( !UnpackPayload( packed, 2, unpacked, 129, out ) );
+    CHECK( UnpackPayload( packed, 2, unpacked, 130, out ) );
+    CHECK( out == 130 );
+    packed[0] = 0x04;
+    CHECK( !UnpackPayload( packed, 6, unpacked, 4, out ) );
+
+    return failed;
+}
@@ -20,6 +20,8 @@
  *     Anton Pak <anton.pak@pigeonpoint.com>
  */
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <SaHpi.h>
@@ -27,46 +29,251 @@
 #include <oh_utils.h>
 
 
+#include <sahpi_wrappers.h>
+
+
+/*
+ * Pool for the event copies queued to the sessions.
+ *
+ * Every thread caches up to 2 * OH_POOL_BATCH free objects of each
+ * kind. A thread with a full cache hands a batch over to the shared
+ * depot, a thread with an empty cache takes a batch from there. So
+ * objects flow from the threads that free events (HPI callers) to the
+ * threads that duplicate them (event processing) with one lock round
+ * trip per batch. The depot keeps at most OH_POOL_DEPOT batches, more
+ * are given back to the heap after an event storm.
+ */
+#define OH_POOL_BATCH 64
+#define OH_POOL_DEPOT 64
+
+enum {
+        OH_POOL_EVENT = 0,
+        OH_POOL_RDR,
+        OH_POOL_NODE,
+        OH_POOL_KINDS
+};
+
+/* A free object; the first one of a depot batch links the next batch */
+struct oh_pool_obj {
+        struct oh_pool_obj *next;
+        struct oh_pool_obj *next_batch;
+};
+
+struct oh_pool_cache {
+        struct oh_pool_obj *free[OH_POOL_KINDS];
+        guint len[OH_POOL_KINDS];
+};
+
+static const gsize pool_sizes[OH_POOL_KINDS] = {
+        sizeof(struct oh_event),
+        sizeof(SaHpiRdrT),
+        sizeof(GSList) > sizeof(struct oh_pool_obj) ?
+                sizeof(GSList) : sizeof(struct oh_pool_obj)
+};
+
+static struct oh_pool_obj *pool_depot[OH_POOL_KINDS];
+static guint pool_depot_len[OH_POOL_KINDS];
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GMutex pool_lock;
+#else
+static GStaticMutex pool_lock = G_STATIC_MUTEX_INIT;
+#endif
+static gint pool_heap_allocs = 0;
+static gint pool_heap_frees = 0;
+
+static void pool_free_chain(struct oh_pool_obj *obj)
+{
+        struct oh_pool_obj *next = NULL;
+
+        for (; obj; obj = next) {
+                next = obj->next;
+                g_free(obj);
+                g_atomic_int_inc(&pool_heap_frees);
+        }
+}
+
+/* Gives a chain of free objects to the depot or, if full, to the heap */
+static void pool_put_batch(guint kind, struct oh_pool_obj *batch)
+{
+        wrap_g_static_mutex_lock(&pool_lock);
+        if (pool_depot_len[kind] < OH_POOL_DEPOT) {
+                batch->next_batch = pool_depot[kind];
+                pool_depot[kind] = batch;
+                pool_depot_len[kind]++;
+                batch = NULL;
+        }
+        wrap_g_static_mutex_unlock(&pool_lock);
+
+        pool_free_chain(batch);
+}
+
+static struct oh_pool_obj *pool_get_batch(guint kind)
+{
+        struct oh_pool_obj *batch = NULL;
+
+        wrap_g_static_mutex_lock(&pool_lock);
+        batch = pool_depot[kind];
+        if (batch) {
+                pool_depot[kind] = batch->next_batch;
+                pool_depot_len[kind]--;
+        }
+        wrap_g_static_mutex_unlock(&pool_lock);
+
+        return batch;
+}
+
+static void release_pool_cache(gpointer data)
+{
+        struct oh_pool_cache *cache = data;
+        guint kind;
+
+        for (kind = 0; kind < OH_POOL_KINDS; kind++) {
+                if (cache->free[kind])
+                        pool_put_batch(kind, cache->free[kind]);
+        }
+        g_free(cache);
+}
+
+#if GLIB_CHECK_VERSION (2, 32, 0)
+static GPrivate pool_cache_key = G_PRIVATE_INIT(release_pool_cache);
+#else
+static GStaticPrivate pool_cache_key = G_STATIC_PRIVATE_INIT;
+#endif
+
+static struct oh_pool_cache *get_pool_cache(void)
+{
+        struct oh_pool_cache *cache = NULL;
+
+        cache = wrap_g_static_private_get(&pool_cache_key);
+        if (cache)
+                return cache;
+
+        cache = g_new0(struct oh_pool_cache, 1);
+#if GLIB_CHECK_VERSION (2, 32, 0)
+        wrap_g_static_private_set(&pool_cache_key, cache);
+#else
+        wrap_g_static_private_set(&pool_cache_key, cache, release_pool_cache);
+#endif
+
+        return cache;
+}
+
+static gpointer pool_alloc(guint kind)
+{
+        struct oh_pool_cache *cache = get_pool_cache();
+        struct oh_pool_obj *obj = NULL;
+        guint len = 0;
+
+        if (!cache->free[kind]) {
+                obj = pool_get_batch(kind);
+                for (cache->free[kind] = obj; obj; obj = obj->next)
+                        len++;
+                cache->len[kind] = len;
+        }
+
+        obj = cache->free[kind];
+        if (!obj) {
+                g_atomic_int_inc(&pool_heap_allocs);
+                return g_malloc(pool_sizes[kind]);
+        }
+        cache->free[kind] = obj->next;
+        cache->len[kind]--;
+
+        return obj;
+}
+
+static void pool_free(guint kind, gpointer data)
+{
+        struct oh_pool_cache *cache = get_pool_cache();
+        struct oh_pool_obj *obj = data, *batch = NULL;
+        guint i;
+
+        obj->next = cache->free[kind];
+        cache->free[kind] = obj;
+        cache->len[kind]++;
+
+        if (cache->len[kind] < 2 * OH_POOL_BATCH)
+                return;
+
+        /* Keep one batch, hand the other over */
+        for (i = 1; i < OH_POOL_BATCH; i++)
+                obj = obj->next;
+        batch = obj->next;
+        obj->next = NULL;
+        cache->len[kind] = OH_POOL_BATCH;
+        pool_put_batch(kind, batch);
+}
+
+static void free_rdr_list(GSList *list, SaHpiBoolT pooled)
+{
+        GSList *node = NULL, *next = NULL;
+
+        if (!pooled) {
+                for (node = list; node; node = node->next) {
+                        g_free(node->data);
+                }
+                g_slist_free(list);
+                return;
+        }
+
+        for (node = list; node; node = next) {
+                next = node->next;
+                pool_free(OH_POOL_RDR, node->data);
+                pool_free(OH_POOL_NODE, node);
+        }
+}
+
+static GSList *dup_rdr_list(GSList *list)
+{
+        GSList *head = NULL, *tail = NULL, *node = NULL, *copy = NULL;
+
+        for (node = list; node; node = node->next) {
+                copy = pool_alloc(OH_POOL_NODE);
+                copy->data = pool_alloc(OH_POOL_RDR);
+                memcpy(copy->data, node->data, sizeof(SaHpiRdrT));
+                copy->next = NULL;
+                if (tail) {
+                        tail->next = copy;
+                } else {
+                        head = copy;
+                }
+                tail = copy;
+        }
+
+        return head;
+}
+
 void oh_event_free(struct oh_event *e, int only_rdrs)
 {
 	if (e) {
 		if (e->rdrs) {
-			GSList *node = NULL;
-			for (node = e->rdrs; node; node = node->next) {
-				g_free(node->data);
-			}
-			g_slist_free(e->rdrs);
+			free_rdr_list(e->rdrs, e->pooled);
+			e->rdrs = NULL;
 		}
 		if (e->rdrs_to_remove) {
-			GSList *node = NULL;
-			for (node = e->rdrs_to_remove; node; node = node->next) {
-				g_free(node->data);
-			}
-			g_slist_free(e->rdrs_to_remove);
+			free_rdr_list(e->rdrs_to_remove, e->pooled);
+			e->rdrs_to_remove = NULL;
+		}
+		if (only_rdrs) return;
+		if (e->pooled) {
+			pool_free(OH_POOL_EVENT, e);
+		} else {
+			g_free(e);
 		}
-		if (!only_rdrs) g_free(e);
 	}
 }
 
 struct oh_event *oh_dup_event(struct oh_event *old_event)
 {
-	GSList *node = NULL;
 	struct oh_event *e = NULL;
 
 	if (!old_event) return NULL;
 
-	e = g_new0(struct oh_event, 1);
+	e = pool_alloc(OH_POOL_EVENT);
 	*e = *old_event;
-	e->rdrs = NULL;
-	for (node = old_event->rdrs; node; node = node->next) {
-		e->rdrs = g_slist_append(e->rdrs, g_memdup(node->data,
-							   sizeof(SaHpiRdrT)));
-	}
-    e->rdrs_to_remove = NULL;
-	for (node = old_event->rdrs_to_remove; node; node = node->next) {
-		e->rdrs_to_remove = g_slist_append(e->rdrs_to_remove, g_memdup(node->data,
-							   sizeof(SaHpiRdrT)));
-	}
+	e->pooled = SAHPI_TRUE;
+	e->rdrs = dup_rdr_list(old_event->rdrs);
+	e->rdrs_to_remove = dup_rdr_list(old_event->rdrs_to_remove);
 
 	return e;
 }
@@ -76,3 +283,23 @@ void oh_evt_queue_push(oh_evt_queue *equeue, gpointer data)
         g_async_queue_push(equeue, data);
 }
 
+/**
+ * oh_event_pool_get_stats
+ * @stats: place for the pool counters
+ *
+ * Objects cached by the threads are in neither counter.
+ **/
+void oh_event_pool_get_stats(struct oh_event_pool_stats *stats)
+{
+        guint kind;
+
+        if (!stats) return;
+
+        stats->heap_allocs = g_atomic_int_get(&pool_heap_allocs);
+        stats->heap_frees = g_atomic_int_get(&pool_heap_frees);
+        stats->depot = 0;
+        wrap_g_static_mutex_lock(&pool_lock);
+        for (kind = 0; kind < OH_POOL_KINDS; kind++)
+                stats->depot += pool_depot_len[kind];
+        wrap_g_static_mutex_unlock(&pool_lock);
+}
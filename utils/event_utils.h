@@ -101,14 +101,25 @@ struct oh_event {
         SaHpiRptEntryT resource;
         GSList *rdrs;
         GSList *rdrs_to_remove;
+        /* Set by oh_dup_event(): the event, its RDRs and list nodes
+           come from the event pool. Plugins leave it 0. */
+        SaHpiBoolT pooled;
 };
 
 typedef GAsyncQueue oh_evt_queue;
 
+/* Event pool counters, see oh_event_pool_get_stats() */
+struct oh_event_pool_stats {
+        SaHpiUint32T heap_allocs; /* Objects taken from the heap */
+        SaHpiUint32T heap_frees;  /* Objects given back to the heap */
+        SaHpiUint32T depot;       /* Batches kept in the shared depot */
+};
+
 #define oh_new_event() g_new0(struct oh_event, 1)
 void oh_event_free(struct oh_event *e, int only_rdrs);
 struct oh_event *oh_dup_event(struct oh_event *old_event);
 void oh_evt_queue_push(oh_evt_queue *equeue, gpointer data);
+void oh_event_pool_get_stats(struct oh_event_pool_stats *stats);
 
 #ifdef __cplusplus
 }
@@ -18,8 +18,23 @@
 #include <oh_utils.h>
 #include <oh_error.h>
 
+/*
+ * Node of the entity path trie. The root node stands for {ROOT,0},
+ * each level below it adds one entity path element.
+ */
+typedef struct _EPNode {
+        SaHpiEntityT entity;
+        GSList *rptentries; /* RPTEntrys with exactly this entity path */
+        struct _EPNode *parent;
+        struct _EPNode *children; /* First child, for sequence lookups */
+        struct _EPNode *prev; /* Siblings */
+        struct _EPNode *next;
+        GHashTable *childtable; /* Contains child EPNodes for fast entity lookups */
+} EPNode;
+
 typedef struct {
         SaHpiRptEntryT rpt_entry;
+        EPNode *epnode; /* Where this entry is in the entity path trie */
         int owndata;
         void *data; /* private data for the owner of the RPTable */
         SaHpiUint32T update_count; /* RDR Update counter */
@@ -27,12 +42,68 @@ typedef struct {
         GHashTable *rdrtable; /* Contains RDRecords for fast RecordId lookups */
 } RPTEntry;
 
+/*
+ * Part common to both kinds of RDR records. @rdr points into the record
+ * for ordinary tables. Compact records only get it while the RDR is
+ * handed out, see get_rdr().
+ */
 typedef struct {
-       SaHpiRdrT rdr;
+       SaHpiEntryIdT RecordId; /* Key for the rdrtable */
+       SaHpiRdrTypeT RdrType;
        int owndata;
        void *data; /* private data for the owner of the rpt entry. */
+       SaHpiRdrT *rdr;
 } RDRecord;
 
+typedef struct {
+       RDRecord head;
+       SaHpiRdrT rdr;
+} FullRDRecord;
+
+/*
+ * Compact RDR storage, see oh_init_rpt_compact().
+ *
+ * Records are sized to their RDR type and carved out of big arena
+ * chunks. Freed records go to a free list per RDR type and are reused
+ * for the next RDR of that type. Entity paths, IdStrings and the big
+ * type records are interned: RDRs of a resource mostly share the entity
+ * path, and instruments of the same kind differ in little more than
+ * their number, which is kept in the record.
+ */
+#define RDR_ARENA_CHUNK 65536
+/* Bigger type records are interned instead of kept in the record */
+#define RDR_INLINE_MAX 32
+/* Free list for RDR types newer than this code */
+#define RDR_TYPE_OTHER (SAHPI_RDR_TYPE_MAX_VALID + 1)
+
+typedef struct {
+        guint refs;
+        guint hash;
+        gsize len;
+        gconstpointer bytes; /* Follows the atom, or the caller's for lookups */
+} RdrAtom;
+
+typedef struct {
+        RDRecord head;
+        SaHpiBoolT IsFru;
+        SaHpiInstrumentIdT num; /* Taken out of an interned type record */
+        RdrAtom *entity;
+        RdrAtom *idstring;
+        RdrAtom *typerec; /* Interned type record */
+        SaHpiRdrTypeUnionT rec; /* Inline type record, cut to its size */
+} CompactRDRecord;
+
+typedef struct _RdrArena {
+        GSList *chunks;
+        guchar *top; /* Unused part of the newest chunk */
+        gsize left;
+        gpointer freelist[RDR_TYPE_OTHER + 1];
+        GHashTable *atoms;
+        GSList *views; /* CompactRDRecords with a materialized rdr */
+        SaHpiUint32T rdrs;
+        SaHpiUint64T atom_bytes;
+} RdrArena;
+
 
 static RPTEntry *get_rptentry_by_rid(RPTable *table, SaHpiResourceIdT rid)
 {
@@ -126,6 +197,291 @@ static GSList *get_rdrnode_by_id(RPTEntry *rptentry, SaHpiEntryIdT id)
         return rdrnode;
 }
 
+static gsize rdr_type_rec_size(SaHpiRdrTypeT type)
+{
+        switch (type) {
+                case SAHPI_NO_RECORD:
+                        return 0;
+                case SAHPI_CTRL_RDR:
+                        return sizeof(SaHpiCtrlRecT);
+                case SAHPI_SENSOR_RDR:
+                        return sizeof(SaHpiSensorRecT);
+                case SAHPI_INVENTORY_RDR:
+                        return sizeof(SaHpiInventoryRecT);
+                case SAHPI_WATCHDOG_RDR:
+                        return sizeof(SaHpiWatchdogRecT);
+                case SAHPI_ANNUNCIATOR_RDR:
+                        return sizeof(SaHpiAnnunciatorRecT);
+                case SAHPI_DIMI_RDR:
+                        return sizeof(SaHpiDimiRecT);
+                case SAHPI_FUMI_RDR:
+                        return sizeof(SaHpiFumiRecT);
+                default:
+                        return sizeof(SaHpiRdrTypeUnionT);
+        }
+}
+
+/* Where the instrument number is in an interned type record */
+static SaHpiInstrumentIdT *rdr_type_rec_num(SaHpiRdrTypeT type,
+                                            SaHpiRdrTypeUnionT *rec)
+{
+        switch (type) {
+                case SAHPI_CTRL_RDR:
+                        return &rec->CtrlRec.Num;
+                case SAHPI_SENSOR_RDR:
+                        return &rec->SensorRec.Num;
+                default:
+                        return NULL;
+        }
+}
+
+static guint rdr_type_slot(SaHpiRdrTypeT type)
+{
+        return (type <= SAHPI_RDR_TYPE_MAX_VALID) ? (guint)type : RDR_TYPE_OTHER;
+}
+
+static gsize compact_rdr_size(SaHpiRdrTypeT type)
+{
+        gsize size = G_STRUCT_OFFSET(CompactRDRecord, rec);
+
+        if (rdr_type_rec_size(type) <= RDR_INLINE_MAX) {
+                size += rdr_type_rec_size(type);
+        }
+
+        /* Keep the next record aligned for the 64 bit reading values */
+        return (size + 7) & ~(gsize)7;
+}
+
+static guint atom_hash(gconstpointer key)
+{
+        return ((const RdrAtom *)key)->hash;
+}
+
+static gboolean atom_equal(gconstpointer a, gconstpointer b)
+{
+        const RdrAtom *a1 = (const RdrAtom *)a;
+        const RdrAtom *a2 = (const RdrAtom *)b;
+
+        return (a1->len == a2->len && !memcmp(a1->bytes, a2->bytes, a1->len));
+}
+
+static RdrArena *get_rdrarena(RPTable *table)
+{
+        if (!table->rdrarena) {
+                table->rdrarena = g_new0(RdrArena, 1);
+                table->rdrarena->atoms = g_hash_table_new(atom_hash, atom_equal);
+        }
+
+        return table->rdrarena;
+}
+
+/* Only called once the table is empty, so nothing refers to the arena */
+static void free_rdrarena(RPTable *table)
+{
+        RdrArena *arena = table->rdrarena;
+        GSList *node;
+
+        if (!arena) {
+                return;
+        }
+        for (node = arena->chunks; node; node = node->next) {
+                g_free(node->data);
+        }
+        g_slist_free(arena->chunks);
+        g_slist_free(arena->views);
+        g_hash_table_destroy(arena->atoms);
+        g_free(arena);
+        table->rdrarena = NULL;
+}
+
+static CompactRDRecord *arena_alloc(RdrArena *arena, SaHpiRdrTypeT type)
+{
+        guint slot = rdr_type_slot(type);
+        gsize size = compact_rdr_size(type);
+        gpointer p = arena->freelist[slot];
+
+        if (p) {
+                arena->freelist[slot] = *(gpointer *)p;
+        } else {
+                if (arena->left < size) {
+                        arena->top = g_malloc(RDR_ARENA_CHUNK);
+                        arena->left = RDR_ARENA_CHUNK;
+                        arena->chunks = g_slist_prepend(arena->chunks, arena->top);
+                }
+                p = arena->top;
+                arena->top += size;
+                arena->left -= size;
+        }
+        memset(p, 0, size);
+        arena->rdrs++;
+
+        return (CompactRDRecord *)p;
+}
+
+static void arena_free(RdrArena *arena, CompactRDRecord *crec)
+{
+        guint slot = rdr_type_slot(crec->head.RdrType);
+
+        *(gpointer *)crec = arena->freelist[slot];
+        arena->freelist[slot] = crec;
+        arena->rdrs--;
+}
+
+static RdrAtom *atom_ref(RdrArena *arena, gconstpointer bytes, gsize len)
+{
+        const guchar *p = (const guchar *)bytes;
+        RdrAtom key, *atom;
+        gsize i;
+
+        key.hash = 5381;
+        for (i = 0; i < len; i++) {
+                key.hash = (key.hash << 5) + key.hash + p[i];
+        }
+        key.len = len;
+        key.bytes = bytes;
+
+        atom = (RdrAtom *)g_hash_table_lookup(arena->atoms, &key);
+        if (!atom) {
+                atom = (RdrAtom *)g_malloc(sizeof(RdrAtom) + len);
+                *atom = key;
+                atom->refs = 0;
+                atom->bytes = atom + 1;
+                memcpy(atom + 1, bytes, len);
+                g_hash_table_insert(arena->atoms, atom, atom);
+                arena->atom_bytes += sizeof(RdrAtom) + len;
+        }
+        atom->refs++;
+
+        return atom;
+}
+
+static void atom_unref(RdrArena *arena, RdrAtom *atom)
+{
+        if (!atom || --atom->refs > 0) {
+                return;
+        }
+        g_hash_table_remove(arena->atoms, atom);
+        arena->atom_bytes -= sizeof(RdrAtom) + atom->len;
+        g_free(atom);
+}
+
+/* @crec must have room for the type record of @rdr */
+static void pack_rdr(RdrArena *arena, CompactRDRecord *crec, const SaHpiRdrT *rdr)
+{
+        gsize size = rdr_type_rec_size(rdr->RdrType);
+        RdrAtom *entity, *idstring, *typerec = NULL;
+
+        /* Ref before unref, an update mostly keeps the same atoms */
+        entity = atom_ref(arena, &rdr->Entity, sizeof(SaHpiEntityPathT));
+        idstring = atom_ref(arena, &rdr->IdString, sizeof(SaHpiTextBufferT));
+        if (size > RDR_INLINE_MAX) {
+                SaHpiRdrTypeUnionT rec;
+                SaHpiInstrumentIdT *num;
+
+                memcpy(&rec, &rdr->RdrTypeUnion, size);
+                num = rdr_type_rec_num(rdr->RdrType, &rec);
+                if (num) {
+                        crec->num = *num;
+                        *num = 0;
+                }
+                typerec = atom_ref(arena, &rec, size);
+        } else {
+                memcpy(&crec->rec, &rdr->RdrTypeUnion, size);
+        }
+        atom_unref(arena, crec->entity);
+        atom_unref(arena, crec->idstring);
+        atom_unref(arena, crec->typerec);
+        crec->entity = entity;
+        crec->idstring = idstring;
+        crec->typerec = typerec;
+        crec->IsFru = rdr->IsFru;
+}
+
+static void unpack_rdr(const CompactRDRecord *crec, SaHpiRdrT *rdr)
+{
+        memset(rdr, 0, sizeof(SaHpiRdrT));
+        rdr->RecordId = crec->head.RecordId;
+        rdr->RdrType = crec->head.RdrType;
+        memcpy(&rdr->Entity, crec->entity->bytes, crec->entity->len);
+        rdr->IsFru = crec->IsFru;
+        if (crec->typerec) {
+                SaHpiInstrumentIdT *num;
+
+                memcpy(&rdr->RdrTypeUnion, crec->typerec->bytes, crec->typerec->len);
+                num = rdr_type_rec_num(rdr->RdrType, &rdr->RdrTypeUnion);
+                if (num) {
+                        *num = crec->num;
+                }
+        } else {
+                memcpy(&rdr->RdrTypeUnion, &crec->rec,
+                       rdr_type_rec_size(crec->head.RdrType));
+        }
+        memcpy(&rdr->IdString, crec->idstring->bytes, crec->idstring->len);
+}
+
+/* Returns the RDR of @rdrecord, a compact one gets a view first */
+static SaHpiRdrT *get_rdr(RPTable *table, RDRecord *rdrecord)
+{
+        if (!rdrecord) {
+                return NULL;
+        }
+
+        if (!rdrecord->rdr) {
+                rdrecord->rdr = g_new(SaHpiRdrT, 1);
+                unpack_rdr((CompactRDRecord *)rdrecord, rdrecord->rdr);
+                table->rdrarena->views = g_slist_prepend(table->rdrarena->views,
+                                                         rdrecord);
+        }
+
+        return rdrecord->rdr;
+}
+
+static RDRecord *new_rdrecord(RPTable *table, SaHpiRdrTypeT type)
+{
+        FullRDRecord *full;
+
+        if (table->compact) {
+                return &arena_alloc(get_rdrarena(table), type)->head;
+        }
+
+        full = g_new0(FullRDRecord, 1);
+        full->head.rdr = &full->rdr;
+
+        return &full->head;
+}
+
+static void free_rdrecord(RPTable *table, RDRecord *rdrecord)
+{
+        RdrArena *arena = table->rdrarena;
+        CompactRDRecord *crec = (CompactRDRecord *)rdrecord;
+
+        if (!table->compact) {
+                g_free(rdrecord);
+                return;
+        }
+
+        if (rdrecord->rdr) {
+                arena->views = g_slist_remove(arena->views, rdrecord);
+                g_free(rdrecord->rdr);
+        }
+        atom_unref(arena, crec->entity);
+        atom_unref(arena, crec->idstring);
+        atom_unref(arena, crec->typerec);
+        arena_free(arena, crec);
+}
+
+/* Takes @rdrecord out of the repository, its data is left alone */
+static void unlink_rdrecord(RPTable *table, RPTEntry *rptentry, RDRecord *rdrecord)
+{
+        rptentry->rdrlist = g_slist_remove(rptentry->rdrlist, (gpointer)rdrecord);
+        g_hash_table_remove(rptentry->rdrtable, &(rdrecord->RecordId));
+        free_rdrecord(table, rdrecord);
+        if (!rptentry->rdrlist) {
+                g_hash_table_destroy(rptentry->rdrtable);
+                rptentry->rdrtable = NULL;
+        }
+}
+
 static int check_instrument_id(SaHpiRptEntryT *rptentry, SaHpiRdrT *rdr)
 {
         int result = 0;
@@ -154,6 +510,147 @@ static int check_instrument_id(SaHpiRptEntryT *rptentry, SaHpiRdrT *rdr)
         return result;
 }
 
+static guint ep_entity_hash(gconstpointer key)
+{
+        const SaHpiEntityT *e = (const SaHpiEntityT *)key;
+
+        return ((guint)e->EntityType * 31) + (guint)e->EntityLocation;
+}
+
+static gboolean ep_entity_equal(gconstpointer a, gconstpointer b)
+{
+        const SaHpiEntityT *e1 = (const SaHpiEntityT *)a;
+        const SaHpiEntityT *e2 = (const SaHpiEntityT *)b;
+
+        return (e1->EntityType == e2->EntityType &&
+                e1->EntityLocation == e2->EntityLocation);
+}
+
+static EPNode *get_epnode_child(EPNode *node, const SaHpiEntityT *e)
+{
+        if (!node->childtable) {
+                return NULL;
+        }
+
+        return (EPNode *)g_hash_table_lookup(node->childtable, e);
+}
+
+/* Finds trie node for @ep. Creates missing nodes if @create is set. */
+static EPNode *get_epnode_by_ep(RPTable *table, const SaHpiEntityPathT *ep,
+                                int create)
+{
+        EPNode *node, *child;
+        int i;
+
+        if (!table->eptree) {
+                if (!create) {
+                        return NULL;
+                }
+                table->eptree = g_new0(EPNode, 1);
+                table->eptree->entity.EntityType = SAHPI_ENT_ROOT;
+        }
+
+        node = table->eptree;
+        /* Entity paths are stored leaf first, walk them from the root */
+        for (i = (int)oh_ep_len(ep) - 1; i >= 0; i--) {
+                child = get_epnode_child(node, &ep->Entry[i]);
+                if (!child) {
+                        if (!create) {
+                                return NULL;
+                        }
+                        child = g_new0(EPNode, 1);
+                        child->entity = ep->Entry[i];
+                        child->parent = node;
+                        /* Append to sibling list to keep insertion order */
+                        if (!node->children) {
+                                node->children = child;
+                        } else {
+                                EPNode *last = node->children->prev;
+                                last->next = child;
+                                child->prev = last;
+                        }
+                        /* First child's prev points to the last sibling */
+                        node->children->prev = child;
+                        if (!node->childtable) {
+                                node->childtable = g_hash_table_new(ep_entity_hash,
+                                                                    ep_entity_equal);
+                        }
+                        g_hash_table_insert(node->childtable, &child->entity, child);
+                }
+                node = child;
+        }
+
+        return node;
+}
+
+static void add_to_eptree(RPTable *table, RPTEntry *rptentry)
+{
+        EPNode *node;
+
+        node = get_epnode_by_ep(table, &rptentry->rpt_entry.ResourceEntity, 1);
+        node->rptentries = g_slist_append(node->rptentries, rptentry);
+        rptentry->epnode = node;
+}
+
+static void remove_from_eptree(RPTable *table, RPTEntry *rptentry)
+{
+        EPNode *node = rptentry->epnode;
+        EPNode *parent;
+
+        if (!node) {
+                return;
+        }
+        rptentry->epnode = NULL;
+        node->rptentries = g_slist_remove(node->rptentries, rptentry);
+
+        /* Prune nodes that no longer lead to any resource */
+        while (node->parent && !node->rptentries && !node->children) {
+                parent = node->parent;
+                g_hash_table_remove(parent->childtable, &node->entity);
+                if (parent->children == node) {
+                        parent->children = node->next;
+                        if (node->next) {
+                                node->next->prev = node->prev;
+                        }
+                } else {
+                        node->prev->next = node->next;
+                        if (node->next) {
+                                node->next->prev = node->prev;
+                        } else {
+                                parent->children->prev = node->prev;
+                        }
+                }
+                if (node->childtable) {
+                        g_hash_table_destroy(node->childtable);
+                }
+                g_free(node);
+                node = parent;
+        }
+
+        if (node == table->eptree && !node->rptentries && !node->children) {
+                if (node->childtable) {
+                        g_hash_table_destroy(node->childtable);
+                }
+                g_free(node);
+                table->eptree = NULL;
+        }
+}
+
+/* Appends all RPT entries at and below @node to @res_list (in reverse) */
+static void collect_eptree(EPNode *node, GSList **res_list)
+{
+        GSList *tmp;
+        EPNode *child;
+
+        for (tmp = node->rptentries; tmp; tmp = tmp->next) {
+                *res_list = g_slist_prepend(*res_list,
+                                            &((RPTEntry *)tmp->data)->rpt_entry);
+        }
+        for (child = node->children; child; child = child->next) {
+                collect_eptree(child, res_list);
+        }
+}
+
 static void update_rptable(RPTable *table) {
         if (!table) {
                 return;
@@ -248,6 +745,97 @@ SaErrorT oh_init_rpt(RPTable *table)
         table->update_count = 0;
         table->rptlist = NULL;
         table->rptable = NULL;
+        table->eptree = NULL;
+        table->compact = 0;
+        table->rdrarena = NULL;
+
+        return SA_OK;
+}
+
+/**
+ * oh_init_rpt_compact
+ * @table: Pointer to RPTable structure to be initialized.
+ *
+ * Like oh_init_rpt(), but RDRs are stored in compact records that take
+ * a fraction of a full SaHpiRdrT. The RDR lookup calls hand out copies
+ * of them instead of references into the table. The copies stay valid
+ * until the RDR is removed or oh_release_rdr_views() is called on the
+ * table, and changes made to them are not stored. The owner of the
+ * table has to call oh_release_rdr_views() once it has no more RDR
+ * references, e.g. when it unlocks the table.
+ *
+ * Returns: SA_OK on success Or minus SA_OK on error.
+ **/
+SaErrorT oh_init_rpt_compact(RPTable *table)
+{
+        SaErrorT rv = oh_init_rpt(table);
+
+        if (rv == SA_OK) {
+                table->compact = 1;
+        }
+
+        return rv;
+}
+
+/**
+ * oh_release_rdr_views
+ * @table: Pointer to the RPT.
+ *
+ * Frees the RDR copies handed out by a table set up with
+ * oh_init_rpt_compact(). Nothing happens for other tables.
+ **/
+void oh_release_rdr_views(RPTable *table)
+{
+        GSList *node;
+
+        if (!table || !table->rdrarena) {
+                return;
+        }
+
+        for (node = table->rdrarena->views; node; node = node->next) {
+                RDRecord *rdrecord = (RDRecord *)node->data;
+                g_free(rdrecord->rdr);
+                rdrecord->rdr = NULL;
+        }
+        g_slist_free(table->rdrarena->views);
+        table->rdrarena->views = NULL;
+}
+
+/**
+ * oh_get_rdr_mem_stats
+ * @table: Pointer to the RPT.
+ * @stats: Place for the numbers.
+ *
+ * Reports the memory held for the RDRs of the table, not counting
+ * the list and hash table nodes used to look them up.
+ *
+ * Returns: SA_OK on success Or minus SA_OK on error.
+ **/
+SaErrorT oh_get_rdr_mem_stats(RPTable *table, struct oh_rdr_mem_stats *stats)
+{
+        RdrArena *arena;
+        GSList *node;
+
+        if (!table || !stats) {
+                return SA_ERR_HPI_INVALID_PARAMS;
+        }
+
+        memset(stats, 0, sizeof(struct oh_rdr_mem_stats));
+        arena = table->rdrarena;
+        if (!table->compact) {
+                for (node = table->rptlist; node; node = node->next) {
+                        RPTEntry *rptentry = (RPTEntry *)node->data;
+                        stats->rdrs += g_slist_length(rptentry->rdrlist);
+                }
+                stats->bytes = (SaHpiUint64T)stats->rdrs * sizeof(FullRDRecord);
+        } else if (arena) {
+                stats->rdrs = arena->rdrs;
+                stats->atoms = g_hash_table_size(arena->atoms);
+                stats->views = g_slist_length(arena->views);
+                stats->bytes = (SaHpiUint64T)g_slist_length(arena->chunks) *
+                               RDR_ARENA_CHUNK + arena->atom_bytes +
+                               (SaHpiUint64T)stats->views * sizeof(SaHpiRdrT);
+        }
 
         return SA_OK;
 }
@@ -405,6 +993,7 @@ SaErrorT oh_add_resource(RPTable *table, SaHpiRptEntryT *entry, void *data, int
 {
         RPTEntry *rptentry;
         int update_info = 0;
+        int update_eptree = 0;
 
         if (!table) {
                 return SA_ERR_HPI_INVALID_PARAMS;
@@ -428,6 +1017,7 @@ SaErrorT oh_add_resource(RPTable *table, SaHpiRptEntryT *entry, void *data, int
                         return SA_ERR_HPI_OUT_OF_MEMORY;
                 }
                 update_info = 1; /* Have a new changed entry */
+                update_eptree = 1;
                 /* Put new RPTEntry in RPTable */
                 table->rptlist = g_slist_append(table->rptlist, (gpointer)rptentry);
 
@@ -447,9 +1037,17 @@ SaErrorT oh_add_resource(RPTable *table, SaHpiRptEntryT *entry, void *data, int
         rptentry->owndata = owndata;
         /* Check if we really have a new/changed entry */
         if (update_info || memcmp(entry, &(rptentry->rpt_entry), sizeof(SaHpiRptEntryT))) {
+                if (!update_eptree &&
+                    !oh_cmp_ep(&(entry->ResourceEntity),
+                               &(rptentry->rpt_entry.ResourceEntity))) {
+                        /* Entity path changed, move entry in the trie */
+                        remove_from_eptree(table, rptentry);
+                        update_eptree = 1;
+                }
                 update_info = 1;
                 rptentry->rpt_entry = *entry;
         }
+        if (update_eptree) add_to_eptree(table, rptentry);
 
         if (update_info) update_rptable(table);
 
@@ -476,19 +1074,20 @@ SaErrorT oh_remove_resource(RPTable *table, SaHpiResourceIdT rid)
         if (!rptentry) {
                 return SA_ERR_HPI_NOT_PRESENT;
         } else {
-                SaHpiRdrT *tmp_rdr;
                 /* Remove all RDRs for the resource first */
-                while ((tmp_rdr = oh_get_rdr_by_id(table, rid, SAHPI_FIRST_ENTRY)) != NULL) {
+                while (rptentry->rdrlist) {
                         oh_remove_rdr(table, rid, SAHPI_FIRST_ENTRY);
                 }
                 /* then remove the resource itself. */
                 table->rptlist = g_slist_remove(table->rptlist, (gpointer)rptentry);
+                remove_from_eptree(table, rptentry);
                 if (!rptentry->owndata) g_free(rptentry->data);
                 g_hash_table_remove(table->rptable, &(rptentry->rpt_entry.EntryId));
                 g_free((gpointer)rptentry);
                 if (!table->rptlist) {
                         g_hash_table_destroy(table->rptable);
                         table->rptable = NULL;
+                        free_rdrarena(table);
                 }
         }
 
@@ -553,6 +1152,8 @@ SaHpiRptEntryT *oh_get_resource_by_id(RPTable *table, SaHpiResourceIdT rid)
  * @ep: Entity path of the RPT entry to be looked up.
  *
  * Get a RPT entry from the RPT by using the entity path.
+ * The lookup walks the entity path trie, so it costs time
+ * proportional to the entity path length.
  *
  * Returns:
  * Pointer to the RPT entry found or NULL if an RPT entry by that
@@ -560,36 +1161,19 @@ SaHpiRptEntryT *oh_get_resource_by_id(RPTable *table, SaHpiResourceIdT rid)
  **/
 SaHpiRptEntryT *oh_get_resource_by_ep(RPTable *table, SaHpiEntityPathT *ep)
 {
-        RPTEntry *rptentry = NULL;
-        GSList *node = NULL;
-        SaHpiResourceIdT rid = 0;
+        EPNode *node;
 
-        if (!table) {
+        if (!table || !ep) {
                 return NULL;
         }
-        /* Check the uid database first */
-        rid = oh_uid_is_initialized() ? oh_uid_lookup(ep) : 0;
-        if (rid > 0) {
-                /* Found it in uid database */
-                return oh_get_resource_by_id(table, rid);
-        } else {
-                DBG("Didn't find the EP in the Uid table so "
-                    "looking manually in the RPTable");
-        }
-
-        for (node = table->rptlist; node != NULL; node = node->next) {
-                rptentry = (RPTEntry *) node->data;
-                if (oh_cmp_ep(&(rptentry->rpt_entry.ResourceEntity), ep))
-                        break;
-                else rptentry = NULL;
-        }
 
-        if (!rptentry) {
+        node = get_epnode_by_ep(table, ep, 0);
+        if (!node || !node->rptentries) {
                 /*DBG("Warning: RPT entry not found. Returning NULL.");*/
                 return NULL;
         }
 
-        return &(rptentry->rpt_entry);
+        return &(((RPTEntry *)node->rptentries->data)->rpt_entry);
 }
 
 /**
@@ -622,6 +1206,130 @@ SaHpiRptEntryT *oh_get_resource_next(RPTable *table, SaHpiResourceIdT rid_prev)
         return rptentry ? &(rptentry->rpt_entry) : NULL;
 }
 
+/**
+ * oh_get_resource_child
+ * @table: Pointer to the RPT for looking up the RPT entry.
+ * @parent: Entity path of the parent. {ROOT,0} stands for the top level.
+ * @rid: Resource id of the child RPT entry to be looked up.
+ *
+ * Get the RPT entry of a direct child of @parent, that is a resource whose
+ * entity path is @parent with one more element added.
+ * If @rid is %SAHPI_FIRST_ENTRY, the first child RPT entry is returned.
+ *
+ * Returns:
+ * Pointer to the RPT entry found or NULL if there is no such resource,
+ * the resource is not a direct child of @parent or the table was a NULL pointer.
+ **/
+SaHpiRptEntryT *oh_get_resource_child(RPTable *table, SaHpiEntityPathT *parent,
+                                      SaHpiResourceIdT rid)
+{
+        RPTEntry *rptentry;
+        EPNode *node, *child;
+
+        if (!table || !parent) {
+                return NULL;
+        }
+
+        node = get_epnode_by_ep(table, parent, 0);
+        if (!node) {
+                return NULL;
+        }
+
+        if (rid != SAHPI_FIRST_ENTRY) {
+                rptentry = get_rptentry_by_rid(table, rid);
+                if (!rptentry || !rptentry->epnode ||
+                    rptentry->epnode->parent != node) {
+                        return NULL;
+                }
+                return &(rptentry->rpt_entry);
+        }
+
+        for (child = node->children; child; child = child->next) {
+                if (child->rptentries) {
+                        rptentry = (RPTEntry *)child->rptentries->data;
+                        return &(rptentry->rpt_entry);
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * oh_get_resource_child_next
+ * @table: Pointer to the RPT for looking up the RPT entry.
+ * @parent: Entity path of the parent. {ROOT,0} stands for the top level.
+ * @rid_prev: Resource id of the child RPT entry previous to the one being looked up.
+ *
+ * Get the direct child of @parent next to the specified child.
+ * If @rid_prev is %SAHPI_FIRST_ENTRY, the first child RPT entry is returned.
+ *
+ * Returns:
+ * Pointer to the RPT entry found or NULL if there are no more children,
+ * @rid_prev is not a direct child of @parent or the table was a NULL pointer.
+ **/
+SaHpiRptEntryT *oh_get_resource_child_next(RPTable *table, SaHpiEntityPathT *parent,
+                                           SaHpiResourceIdT rid_prev)
+{
+        RPTEntry *rptentry;
+        GSList *node;
+        EPNode *child;
+
+        if (rid_prev == SAHPI_FIRST_ENTRY) {
+                return oh_get_resource_child(table, parent, SAHPI_FIRST_ENTRY);
+        }
+
+        if (!oh_get_resource_child(table, parent, rid_prev)) {
+                return NULL;
+        }
+        rptentry = get_rptentry_by_rid(table, rid_prev);
+
+        /* Other resources with the same entity path come first */
+        node = g_slist_find(rptentry->epnode->rptentries, rptentry);
+        if (node && node->next) {
+                return &(((RPTEntry *)node->next->data)->rpt_entry);
+        }
+
+        for (child = rptentry->epnode->next; child; child = child->next) {
+                if (child->rptentries) {
+                        rptentry = (RPTEntry *)child->rptentries->data;
+                        return &(rptentry->rpt_entry);
+                }
+        }
+
+        return NULL;
+}
+
+/**
+ * oh_get_resource_subtree
+ * @table: Pointer to the RPT for looking up the RPT entries.
+ * @ep: Entity path of the subtree root. {ROOT,0} stands for the whole RPT.
+ * @res_list: OUT. List of RPT entries found.
+ *
+ * Collects the RPT entry for @ep, if any, and all RPT entries whose entity
+ * paths start with @ep. The entries are appended to @res_list, parents before
+ * their children. The caller owns the list but not the entries in it.
+ *
+ * Returns: SA_ERR_HPI_INVALID_PARAMS if any argument is NULL, otherwise SA_OK.
+ **/
+SaErrorT oh_get_resource_subtree(RPTable *table, SaHpiEntityPathT *ep,
+                                 GSList **res_list)
+{
+        EPNode *node;
+        GSList *found = NULL;
+
+        if (!table || !ep || !res_list) {
+                return SA_ERR_HPI_INVALID_PARAMS;
+        }
+
+        node = get_epnode_by_ep(table, ep, 0);
+        if (node) {
+                collect_eptree(node, &found);
+                *res_list = g_slist_concat(*res_list, g_slist_reverse(found));
+        }
+
+        return SA_OK;
+}
+
 /**
  * oh_get_rdr_update_count
  * @table: Pointer to the RPT for looking up the RPT entry.
@@ -704,9 +1412,16 @@ SaErrorT oh_add_rdr(RPTable *table, SaHpiResourceIdT rid, SaHpiRdrT *rdr, void *
         rdr->RecordId = oh_get_rdr_uid(rdr->RdrType, instr_id);
         /* Check if record exists */
         rdrecord = get_rdrecord_by_id(rptentry, rdr->RecordId);
+        /* A compact record has no room for the type record of another type */
+        if (rdrecord && table->compact && rdrecord->RdrType != rdr->RdrType) {
+                if (rdrecord->data && rdrecord->data != data && !rdrecord->owndata)
+                        g_free(rdrecord->data);
+                unlink_rdrecord(table, rptentry, rdrecord);
+                rdrecord = NULL;
+        }
         /* If not, create new rdr */
         if (!rdrecord) {
-                rdrecord = g_new0(RDRecord, 1);
+                rdrecord = new_rdrecord(table, rdr->RdrType);
                 if (!rdrecord) {
                         return SA_ERR_HPI_OUT_OF_MEMORY;
                 }
@@ -716,9 +1431,9 @@ SaErrorT oh_add_rdr(RPTable *table, SaHpiResourceIdT rid, SaHpiRdrT *rdr, void *
                 if (!rptentry->rdrtable)
                         rptentry->rdrtable = g_hash_table_new(g_int_hash, g_int_equal);
 
-                rdrecord->rdr.RecordId = rdr->RecordId;
+                rdrecord->RecordId = rdr->RecordId;
                 g_hash_table_insert(rptentry->rdrtable,
-                                    &(rdrecord->rdr.RecordId),
+                                    &(rdrecord->RecordId),
                                     g_slist_last(rptentry->rdrlist));
         }
         /* Else, modify existing rdrecord */
@@ -726,7 +1441,15 @@ SaErrorT oh_add_rdr(RPTable *table, SaHpiResourceIdT rid, SaHpiRdrT *rdr, void *
                 g_free(rdrecord->data);
         rdrecord->data = data;
         rdrecord->owndata = owndata;
-        rdrecord->rdr = *rdr;
+        rdrecord->RdrType = rdr->RdrType;
+        if (table->compact) {
+                pack_rdr(table->rdrarena, (CompactRDRecord *)rdrecord, rdr);
+                /* Keep a copy that is handed out up to date */
+                if (rdrecord->rdr && rdrecord->rdr != rdr)
+                        *(rdrecord->rdr) = *rdr;
+        } else {
+                *(rdrecord->rdr) = *rdr;
+        }
 
         ++rptentry->update_count;
 
@@ -765,14 +1488,8 @@ SaErrorT oh_remove_rdr(RPTable *table, SaHpiResourceIdT rid, SaHpiEntryIdT rdrid
         if (!rdrecord) {
                 return SA_ERR_HPI_NOT_PRESENT;
         } else {
-                rptentry->rdrlist = g_slist_remove(rptentry->rdrlist, (gpointer)rdrecord);
                 if (!rdrecord->owndata) g_free(rdrecord->data);
-                g_hash_table_remove(rptentry->rdrtable, &(rdrecord->rdr.RecordId));
-                g_free((gpointer)rdrecord);
-                if (!rptentry->rdrlist) {
-                        g_hash_table_destroy(rptentry->rdrtable);
-                        rptentry->rdrtable = NULL;
-                }
+                unlink_rdrecord(table, rptentry, rdrecord);
                 ++rptentry->update_count;
         }
 
@@ -845,7 +1562,7 @@ SaHpiRdrT *oh_get_rdr_by_id(RPTable *table, SaHpiResourceIdT rid, SaHpiEntryIdT
                 return NULL;
         }
 
-        return &(rdrecord->rdr);
+        return get_rdr(table, rdrecord);
 }
 
 /**
@@ -883,7 +1600,7 @@ SaHpiRdrT *oh_get_rdr_by_type(RPTable *table, SaHpiResourceIdT rid,
                 return NULL;
         }
 
-        return &(rdrecord->rdr);        
+        return get_rdr(table, rdrecord);
 }
 
 /**
@@ -924,7 +1641,7 @@ SaHpiRdrT *oh_get_rdr_next(RPTable *table, SaHpiResourceIdT rid, SaHpiEntryIdT r
                 }
         }
 
-        return rdrecord ? &(rdrecord->rdr) : NULL;
+        return get_rdr(table, rdrecord);
 }
 
 SaHpiRdrT *oh_get_rdr_by_type_first(RPTable *table, SaHpiResourceIdT rid,
@@ -942,14 +1659,14 @@ SaHpiRdrT *oh_get_rdr_by_type_first(RPTable *table, SaHpiResourceIdT rid,
         /* Get first RDR matching the type */
         for (node = rptentry->rdrlist; node; node = node->next) {
                 RDRecord *temp = (RDRecord *)node->data;
-                if (temp->rdr.RdrType == type) {
+                if (temp->RdrType == type) {
                         rdrecord = temp;
                         break;
                 }
         }                
         if (!rdrecord) return NULL;
 
-        return &(rdrecord->rdr);
+        return get_rdr(table, rdrecord);
 }
 
 SaHpiRdrT *oh_get_rdr_by_type_next(RPTable *table, SaHpiResourceIdT rid,
@@ -970,12 +1687,12 @@ SaHpiRdrT *oh_get_rdr_by_type_next(RPTable *table, SaHpiResourceIdT rid,
         
         for (node = node->next; node; node = node->next) {
                 RDRecord *temp = (RDRecord *)node->data;
-                if (temp->rdr.RdrType == type) {
+                if (temp->RdrType == type) {
                         rdrecord = temp;
                         break;
                 }
         }
         if (!rdrecord) return NULL;
 
-        return &(rdrecord->rdr);
+        return get_rdr(table, rdrecord);
 }
@@ -38,12 +38,25 @@ typedef struct {
         /* No one should touch this. */
         GSList *rptlist; /* Contains RPTEntrys for sequence lookups */
         GHashTable *rptable; /* Contains RPTEntrys for fast EntryId lookups */
+        struct _EPNode *eptree; /* Entity path trie for parent/child lookups */
+        int compact; /* RDRs are stored compact, see oh_init_rpt_compact() */
+        struct _RdrArena *rdrarena; /* Storage for compact RDRs */
 } RPTable;
 
+struct oh_rdr_mem_stats {
+        SaHpiUint32T rdrs;  /* RDRs in the table */
+        SaHpiUint32T atoms; /* Interned entity paths and IdStrings */
+        SaHpiUint32T views; /* RDR copies handed out by a compact table */
+        SaHpiUint64T bytes; /* Memory held for all of the above */
+};
+
 
 /* General RPT calls */
 SaErrorT oh_init_rpt(RPTable *table);
+SaErrorT oh_init_rpt_compact(RPTable *table);
 SaErrorT oh_flush_rpt(RPTable *table);
+void oh_release_rdr_views(RPTable *table);
+SaErrorT oh_get_rdr_mem_stats(RPTable *table, struct oh_rdr_mem_stats *stats);
 SaErrorT rpt_diff(RPTable *cur_rpt, RPTable *new_rpt,
                   GSList **res_new, GSList **rdr_new,
                   GSList **res_gone, GSList **rdr_gone);
@@ -61,6 +74,12 @@ void *oh_get_resource_data(RPTable *table, SaHpiResourceIdT rid);
 SaHpiRptEntryT *oh_get_resource_by_id(RPTable *table, SaHpiResourceIdT rid);
 SaHpiRptEntryT *oh_get_resource_by_ep(RPTable *table, SaHpiEntityPathT *ep);
 SaHpiRptEntryT *oh_get_resource_next(RPTable *table, SaHpiResourceIdT rid_prev);
+SaHpiRptEntryT *oh_get_resource_child(RPTable *table, SaHpiEntityPathT *parent,
+                                      SaHpiResourceIdT rid);
+SaHpiRptEntryT *oh_get_resource_child_next(RPTable *table, SaHpiEntityPathT *parent,
+                                           SaHpiResourceIdT rid_prev);
+SaErrorT oh_get_resource_subtree(RPTable *table, SaHpiEntityPathT *ep,
+                                 GSList **res_list);
 
 SaErrorT oh_get_rdr_update_count(RPTable *table,
                                  SaHpiResourceIdT rid,
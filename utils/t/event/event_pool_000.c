@@ -0,0 +1,94 @@
+/* -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+static SaHpiRdrT *make_rdr(SaHpiEntryIdT id)
+{
+        SaHpiRdrT *rdr = g_new0(SaHpiRdrT, 1);
+
+        rdr->RecordId = id;
+        rdr->RdrType = SAHPI_SENSOR_RDR;
+        rdr->RdrTypeUnion.SensorRec.Num = id;
+
+        return rdr;
+}
+
+static int same_rdrs(GSList *a, GSList *b)
+{
+        for (; a && b; a = a->next, b = b->next) {
+                if (a->data == b->data)
+                        return 0;
+                if (memcmp(a->data, b->data, sizeof(SaHpiRdrT)))
+                        return 0;
+        }
+
+        return !a && !b;
+}
+
+/**
+ * main: Duplicate a plugin event with RDRs, duplicate the copy again
+ * and free everything. Passes if the copies are deep and equal to the
+ * original, otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        struct oh_event *e, *copy, *copy2, onstack;
+        SaHpiEntryIdT i;
+
+        e = oh_new_event();
+        e->hid = 1;
+        e->event.Source = 10;
+        e->event.EventType = SAHPI_ET_SENSOR;
+        for (i = 1; i <= 3; i++)
+                e->rdrs = g_slist_append(e->rdrs, make_rdr(i));
+        e->rdrs_to_remove = g_slist_append(e->rdrs_to_remove, make_rdr(4));
+
+        copy = oh_dup_event(e);
+        if (!copy || copy == e)
+                return 1;
+        if (copy->hid != 1 || copy->event.Source != 10)
+                return 1;
+        if (!copy->pooled || e->pooled)
+                return 1;
+        if (!same_rdrs(e->rdrs, copy->rdrs))
+                return 1;
+        if (!same_rdrs(e->rdrs_to_remove, copy->rdrs_to_remove))
+                return 1;
+
+        /* Plugin event is freed the old way */
+        oh_event_free(e, FALSE);
+
+        copy2 = oh_dup_event(copy);
+        if (!same_rdrs(copy->rdrs, copy2->rdrs))
+                return 1;
+        oh_event_free(copy, FALSE);
+
+        /* As saHpiEventGet() does: take over the RDRs, free them later */
+        onstack = *copy2;
+        copy2->rdrs = NULL;
+        copy2->rdrs_to_remove = NULL;
+        oh_event_free(copy2, FALSE);
+        if (g_slist_length(onstack.rdrs) != 3)
+                return 1;
+        oh_event_free(&onstack, TRUE);
+        if (onstack.rdrs || onstack.rdrs_to_remove)
+                return 1;
+
+        return 0;
+}
@@ -0,0 +1,67 @@
+/* -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+#define EVENTS_PER_ROUND 1000
+#define ROUNDS           1000
+
+/**
+ * main: Allocation count benchmark. Queues EVENTS_PER_ROUND copies of
+ * an event with two RDRs and frees them again, ROUNDS times.
+ * Passes if only the first round takes objects from the heap,
+ * otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        struct oh_event *e, *copies[EVENTS_PER_ROUND];
+        struct oh_event_pool_stats first, last;
+        gint64 start;
+        int round, i;
+
+        e = oh_new_event();
+        e->event.EventType = SAHPI_ET_SENSOR;
+        e->rdrs = g_slist_append(e->rdrs, g_new0(SaHpiRdrT, 1));
+        e->rdrs = g_slist_append(e->rdrs, g_new0(SaHpiRdrT, 1));
+
+        start = g_get_monotonic_time();
+        for (round = 0; round < ROUNDS; round++) {
+                for (i = 0; i < EVENTS_PER_ROUND; i++)
+                        copies[i] = oh_dup_event(e);
+                for (i = 0; i < EVENTS_PER_ROUND; i++)
+                        oh_event_free(copies[i], FALSE);
+                if (round == 0)
+                        oh_event_pool_get_stats(&first);
+        }
+        oh_event_pool_get_stats(&last);
+
+        printf("%d events, %u heap allocations (%u after the first round), "
+               "%u heap frees, %lld usec\n",
+               EVENTS_PER_ROUND * ROUNDS, last.heap_allocs,
+               last.heap_allocs - first.heap_allocs, last.heap_frees,
+               (long long)(g_get_monotonic_time() - start));
+
+        oh_event_free(e, FALSE);
+
+        if (first.heap_allocs != EVENTS_PER_ROUND * 5)
+                return 1;
+        if (last.heap_allocs != first.heap_allocs)
+                return 1;
+
+        return 0;
+}
@@ -0,0 +1,117 @@
+/* -*- linux-c -*-
+ *
+ * (C) Copyright IBM Corp. 2004
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+#include <rpt_resources.h>
+
+static int count_children(RPTable *rptable, SaHpiEntityPathT *parent)
+{
+        SaHpiRptEntryT *tmpentry;
+        int n = 0;
+
+        for (tmpentry = oh_get_resource_child(rptable, parent, SAHPI_FIRST_ENTRY);
+             tmpentry;
+             tmpentry = oh_get_resource_child_next(rptable, parent,
+                                                   tmpentry->ResourceId)) {
+                if (tmpentry->ResourceEntity.Entry[1].EntityType !=
+                    parent->Entry[0].EntityType)
+                        return -1;
+                n++;
+        }
+
+        return n;
+}
+
+/**
+ * main: Starts with an RPTable of 10 resources. Walks the children
+ * of a subchassis and of the chassis, collects the chassis subtree,
+ * looks resources up by entity path and repeats after removing
+ * a resource. A wrong count or lookup means the test failed,
+ * otherwise the test passed.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        RPTable *rptable = (RPTable *)g_malloc0(sizeof(RPTable));
+        SaHpiEntityPathT subchassis, chassis, root;
+        GSList *subtree = NULL;
+        guint i = 0;
+
+        oh_init_rpt(rptable);
+
+        for (i = 0; rptentries[i].ResourceId != 0; i++) {
+                if (oh_add_resource(rptable, rptentries + i, NULL, 0))
+                        return 1;
+        }
+
+        /* {SUB_CHASSIS,1}{SYSTEM_CHASSIS,1} */
+        oh_init_ep(&subchassis);
+        subchassis.Entry[0] = rptentries[0].ResourceEntity.Entry[1];
+        subchassis.Entry[1] = rptentries[0].ResourceEntity.Entry[2];
+        oh_init_ep(&chassis);
+        chassis.Entry[0] = rptentries[0].ResourceEntity.Entry[2];
+        oh_init_ep(&root);
+
+        if (count_children(rptable, &subchassis) != 5)
+                return 1;
+
+        /* Subchassis are not resources, so the chassis has no children */
+        if (count_children(rptable, &chassis) != 0)
+                return 1;
+
+        if (oh_get_resource_child(rptable, &root, SAHPI_FIRST_ENTRY)
+            != oh_get_resource_by_ep(rptable, &chassis))
+                return 1;
+
+        /* Resource 4 sits in the other subchassis */
+        if (oh_get_resource_child(rptable, &subchassis, 4))
+                return 1;
+
+        if (oh_get_resource_subtree(rptable, &chassis, &subtree))
+                return 1;
+        if (g_slist_length(subtree) != i)
+                return 1;
+        /* Parents come before their children */
+        if (((SaHpiRptEntryT *)subtree->data)->ResourceId != 10)
+                return 1;
+        g_slist_free(subtree);
+
+        for (i = 0; rptentries[i].ResourceId != 0; i++) {
+                SaHpiRptEntryT *tmpentry =
+                        oh_get_resource_by_ep(rptable, &rptentries[i].ResourceEntity);
+                if (!tmpentry || tmpentry->ResourceId != rptentries[i].ResourceId)
+                        return 1;
+        }
+
+        if (oh_remove_resource(rptable, 2))
+                return 1;
+
+        if (count_children(rptable, &subchassis) != 4)
+                return 1;
+
+        if (oh_get_resource_by_ep(rptable, &rptentries[1].ResourceEntity))
+                return 1;
+
+        oh_flush_rpt(rptable);
+
+        if (oh_get_resource_child(rptable, &root, SAHPI_FIRST_ENTRY))
+                return 1;
+
+        return 0;
+}
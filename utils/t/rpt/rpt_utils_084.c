@@ -0,0 +1,180 @@
+/* -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+#include <rpt_resources.h>
+
+#define COPIES 200
+
+static int add_rdrs(RPTable *rptable, SaHpiResourceIdT rid, SaHpiRdrT *rdrs)
+{
+        int i;
+
+        for (i = 0; rdrs[i].RdrType != SAHPI_NO_RECORD; i++) {
+                if (oh_add_rdr(rptable, rid, rdrs + i, NULL, 0))
+                        return -1;
+        }
+
+        return 0;
+}
+
+static int fill(RPTable *rptable)
+{
+        SaHpiResourceIdT rid = rptentries[0].ResourceId;
+        int i;
+
+        for (i = 0; rptentries[i].ResourceId != 0; i++) {
+                if (oh_add_resource(rptable, rptentries + i, NULL, 0))
+                        return -1;
+        }
+
+        if (add_rdrs(rptable, rid, sensors) ||
+            add_rdrs(rptable, rid, controls) ||
+            add_rdrs(rptable, rid, inventories) ||
+            add_rdrs(rptable, rid, watchdogs) ||
+            add_rdrs(rptable, rid, annunciators))
+                return -1;
+
+        return 0;
+}
+
+/**
+ * main: Fills an ordinary and a compact RPTable with the same
+ * resources and RDRs. Walks the RDRs of both and compares them, keeps
+ * two RDRs of the compact table at a time like saHpiRdrGet does,
+ * updates and removes an RDR and releases the handed out copies.
+ * Then adds COPIES sensors with the same name per resource to both
+ * tables. Passes if the RDRs are the same in both tables and the
+ * compact table needs less than a fourth of the memory for the
+ * sensors, otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        RPTable *full = (RPTable *)g_malloc0(sizeof(RPTable));
+        RPTable *compact = (RPTable *)g_malloc0(sizeof(RPTable));
+        SaHpiResourceIdT rid = rptentries[0].ResourceId;
+        struct oh_rdr_mem_stats full_stats, compact_stats;
+        SaHpiRdrT *rdr, *tmprdr, *next, update;
+        int i, n;
+
+        oh_init_rpt(full);
+        oh_init_rpt_compact(compact);
+
+        if (fill(full) || fill(compact))
+                return 1;
+
+        n = 0;
+        for (rdr = oh_get_rdr_next(full, rid, SAHPI_FIRST_ENTRY);
+             rdr;
+             rdr = oh_get_rdr_next(full, rid, rdr->RecordId)) {
+                tmprdr = oh_get_rdr_by_id(compact, rid, rdr->RecordId);
+                if (!tmprdr || memcmp(rdr, tmprdr, sizeof(SaHpiRdrT)))
+                        return 1;
+                tmprdr = oh_get_rdr_by_type(compact, rid, rdr->RdrType,
+                                            oh_get_rdr_num(rdr->RecordId));
+                if (!tmprdr || memcmp(rdr, tmprdr, sizeof(SaHpiRdrT)))
+                        return 1;
+                n++;
+        }
+
+        if (oh_get_rdr_mem_stats(compact, &compact_stats))
+                return 1;
+        if (n == 0 || compact_stats.rdrs != n || compact_stats.views != n)
+                return 1;
+
+        /* Handed out copies stay valid while others are handed out */
+        rdr = oh_get_rdr_by_type_first(compact, rid, SAHPI_SENSOR_RDR);
+        if (!rdr)
+                return 1;
+        next = oh_get_rdr_by_type_next(compact, rid, SAHPI_SENSOR_RDR,
+                                       rdr->RdrTypeUnion.SensorRec.Num);
+        if (!next || rdr == next)
+                return 1;
+        if (rdr->RdrType != SAHPI_SENSOR_RDR ||
+            next->RdrTypeUnion.SensorRec.Num != sensors[1].RdrTypeUnion.SensorRec.Num)
+                return 1;
+
+        /* Updating an RDR updates its handed out copy */
+        update = *rdr;
+        oh_init_textbuffer(&update.IdString);
+        oh_append_textbuffer(&update.IdString, "Updated sensor");
+        update.RdrTypeUnion.SensorRec.Oem = 42;
+        if (oh_add_rdr(compact, rid, &update, NULL, 0))
+                return 1;
+        if (memcmp(rdr, &update, sizeof(SaHpiRdrT)))
+                return 1;
+
+        oh_release_rdr_views(compact);
+        oh_get_rdr_mem_stats(compact, &compact_stats);
+        if (compact_stats.views != 0 || compact_stats.rdrs != n)
+                return 1;
+
+        rdr = oh_get_rdr_by_id(compact, rid, update.RecordId);
+        if (!rdr || memcmp(rdr, &update, sizeof(SaHpiRdrT)))
+                return 1;
+
+        if (oh_remove_rdr(compact, rid, update.RecordId))
+                return 1;
+        if (oh_get_rdr_by_id(compact, rid, update.RecordId))
+                return 1;
+        oh_get_rdr_mem_stats(compact, &compact_stats);
+        if (compact_stats.rdrs != n - 1)
+                return 1;
+
+        oh_flush_rpt(full);
+        oh_flush_rpt(compact);
+        oh_get_rdr_mem_stats(compact, &compact_stats);
+        if (compact_stats.rdrs != 0 || compact_stats.bytes != 0)
+                return 1;
+
+        /* Many sensors that only differ in their number */
+        for (i = 0; rptentries[i].ResourceId != 0; i++) {
+                if (oh_add_resource(full, rptentries + i, NULL, 0) ||
+                    oh_add_resource(compact, rptentries + i, NULL, 0))
+                        return 1;
+                for (n = 1; n <= COPIES; n++) {
+                        update = sensors[0];
+                        update.RdrTypeUnion.SensorRec.Num = n;
+                        if (oh_add_rdr(full, rptentries[i].ResourceId,
+                                       &update, NULL, 0) ||
+                            oh_add_rdr(compact, rptentries[i].ResourceId,
+                                       &update, NULL, 0))
+                                return 1;
+                }
+        }
+
+        oh_get_rdr_mem_stats(full, &full_stats);
+        oh_get_rdr_mem_stats(compact, &compact_stats);
+        if (full_stats.rdrs != compact_stats.rdrs)
+                return 1;
+        if (compact_stats.bytes * 4 > full_stats.bytes)
+                return 1;
+
+        rdr = oh_get_rdr_by_type(compact, rptentries[1].ResourceId,
+                                 SAHPI_SENSOR_RDR, COPIES);
+        tmprdr = oh_get_rdr_by_type(full, rptentries[1].ResourceId,
+                                    SAHPI_SENSOR_RDR, COPIES);
+        if (!rdr || !tmprdr || memcmp(rdr, tmprdr, sizeof(SaHpiRdrT)))
+                return 1;
+
+        oh_flush_rpt(full);
+        oh_flush_rpt(compact);
+        g_free(full);
+        g_free(compact);
+
+        return 0;
+}
@@ -0,0 +1,133 @@
+/* -*- linux-c -*-
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+#include <rpt_resources.h>
+
+#define RDRS_PER_RESOURCE 16
+
+static int compact;
+
+static void report(const char *op, guint size, guint n, gdouble t)
+{
+        printf("{\"bench\":\"rpt\",\"op\":\"%s\",\"compact\":%d,\"resources\":%u,"
+               "\"rdrs_per_resource\":%u,\"n\":%u,\"ns_per_op\":%.1f}\n",
+               op, compact, size, RDRS_PER_RESOURCE, n, t * 1e9 / n);
+}
+
+static void report_mem(RPTable *rptable, guint size)
+{
+        struct oh_rdr_mem_stats stats;
+
+        oh_get_rdr_mem_stats(rptable, &stats);
+        printf("{\"bench\":\"rpt\",\"op\":\"memory\",\"compact\":%d,\"resources\":%u,"
+               "\"rdrs_per_resource\":%u,\"n\":%u,\"bytes\":%llu,"
+               "\"bytes_per_rdr\":%.1f}\n",
+               compact, size, RDRS_PER_RESOURCE, stats.rdrs,
+               (unsigned long long)stats.bytes,
+               stats.rdrs ? (gdouble)stats.bytes / stats.rdrs : 0.0);
+}
+
+static void bench(guint size)
+{
+        RPTable *rptable = (RPTable *)g_malloc0(sizeof(RPTable));
+        GTimer *timer = g_timer_new();
+        SaHpiRptEntryT *res;
+        SaHpiRdrT *rdr;
+        guint i, j, n;
+
+        if (compact)
+                oh_init_rpt_compact(rptable);
+        else
+                oh_init_rpt(rptable);
+
+        g_timer_start(timer);
+        for (i = 1; i <= size; i++) {
+                rptentries[0].ResourceId = i;
+                rptentries[0].ResourceEntity.Entry[0].EntityLocation = i;
+                oh_add_resource(rptable, rptentries, NULL, 0);
+                for (j = 0; j < RDRS_PER_RESOURCE; j++) {
+                        sensors[0].RdrTypeUnion.SensorRec.Num = j;
+                        oh_add_rdr(rptable, i, sensors, NULL, 0);
+                }
+        }
+        report("add", size, size * (RDRS_PER_RESOURCE + 1),
+               g_timer_elapsed(timer, NULL));
+        report_mem(rptable, size);
+
+        /* Walk like saHpiRptEntryGet/saHpiRdrGet loops do */
+        n = 0;
+        g_timer_start(timer);
+        for (res = oh_get_resource_next(rptable, SAHPI_FIRST_ENTRY);
+             res; res = oh_get_resource_next(rptable, res->ResourceId))
+                n++;
+        report("resource_walk", size, n, g_timer_elapsed(timer, NULL));
+
+        n = 0;
+        g_timer_start(timer);
+        for (res = oh_get_resource_next(rptable, SAHPI_FIRST_ENTRY);
+             res; res = oh_get_resource_next(rptable, res->ResourceId)) {
+                for (rdr = oh_get_rdr_next(rptable, res->ResourceId, SAHPI_FIRST_ENTRY);
+                     rdr; rdr = oh_get_rdr_next(rptable, res->ResourceId, rdr->RecordId))
+                        n++;
+        }
+        report("rdr_walk", size, n, g_timer_elapsed(timer, NULL));
+        oh_release_rdr_views(rptable);
+
+        g_timer_start(timer);
+        for (i = 1; i <= size; i++)
+                oh_get_resource_by_id(rptable, i);
+        report("lookup_by_id", size, size, g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        for (i = 1; i <= size; i++) {
+                rptentries[0].ResourceEntity.Entry[0].EntityLocation = i;
+                oh_get_resource_by_ep(rptable, &rptentries[0].ResourceEntity);
+        }
+        report("lookup_by_ep", size, size, g_timer_elapsed(timer, NULL));
+
+        g_timer_start(timer);
+        oh_flush_rpt(rptable);
+        report("flush", size, size, g_timer_elapsed(timer, NULL));
+
+        g_timer_destroy(timer);
+        g_free(rptable);
+}
+
+/**
+ * main: Times RPTable add, walk, lookup and flush and reports the
+ * memory held for RDRs for growing numbers of resources, with ordinary
+ * and with compact RDR storage. Prints one JSON object per line.
+ *
+ * Usage: rpt_utils_bench [max resources]
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        guint max = 10000, size;
+
+        if (argc > 1)
+                max = strtoul(argv[1], NULL, 0);
+        if (max == 0)
+                return 1;
+
+        for (compact = 0; compact <= 1; compact++) {
+                for (size = 10; size <= max; size *= 10)
+                        bench(size);
+        }
+
+        return 0;
+}
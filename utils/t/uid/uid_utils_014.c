@@ -0,0 +1,87 @@
+/* -*- linux-c -*-
+ *
+ * (C) Copyright IBM Corp. 2004
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+/**
+ * main: Get 10 new unique ids and flush the uid map journal.
+ * Passes if the map file grew by one record per new id and
+ * its resource id header is past the highest id,
+ * otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+	SaHpiEntityPathT ep;
+	guint id[10], i, added = 0;
+        SaHpiResourceIdT next_id;
+        const char *map_file;
+        struct stat st1, st2;
+        FILE *fp;
+
+        map_file = getenv("OPENHPI_UID_MAP");
+        if (!map_file)
+                return 1;
+
+	if (oh_uid_initialize())
+		return 1;
+
+        if (stat(map_file, &st1))
+                return 1;
+
+	oh_init_ep(&ep);
+        ep.Entry[0].EntityType = SAHPI_ENT_SYSTEM_CHASSIS;
+
+        for (i = 0; i < 10; i++) {
+                ep.Entry[0].EntityLocation = 1400 + i;
+                if (!oh_uid_lookup(&ep))
+                        added++;
+                id[i] = oh_uid_from_entity_path(&ep);
+                if (!id[i])
+                        return 1;
+        }
+
+        if (oh_uid_map_flush())
+                return 1;
+
+        if (stat(map_file, &st2))
+                return 1;
+
+        if (st2.st_size - st1.st_size !=
+            added * (sizeof(SaHpiResourceIdT) + sizeof(SaHpiEntityPathT)))
+                return 1;
+
+        fp = fopen(map_file, "rb");
+        if (!fp)
+                return 1;
+        if (fread(&next_id, sizeof(next_id), 1, fp) != 1) {
+                fclose(fp);
+                return 1;
+        }
+        fclose(fp);
+
+        for (i = 0; i < 10; i++) {
+                if (id[i] >= next_id)
+                        return 1;
+        }
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/* -*- linux-c -*-
+ *
+ * (C) Copyright IBM Corp. 2004
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+#define MAP_FILE "uid_map_015"
+
+struct xref {
+        SaHpiResourceIdT resource_id;
+        SaHpiEntityPathT entity_path;
+};
+
+/**
+ * main: Replay a uid map file with a torn record at the end
+ * and a record that repeats an earlier one.
+ * Passes if both complete records come back with their ids,
+ * the torn and repeated records are dropped from the file
+ * and a new id is handed out past the old ones,
+ * otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        struct xref rec[2];
+        SaHpiResourceIdT header = 3;
+        SaHpiEntityPathT ep;
+        guint id;
+        struct stat st;
+        FILE *fp;
+        int i;
+
+        remove(MAP_FILE);
+        setenv("OPENHPI_UID_MAP", MAP_FILE, 1);
+
+        for (i = 0; i < 2; i++) {
+                memset(&rec[i], 0, sizeof(rec[i]));
+                oh_init_ep(&rec[i].entity_path);
+                rec[i].resource_id = i + 1;
+                rec[i].entity_path.Entry[0].EntityType = SAHPI_ENT_SYSTEM_CHASSIS;
+                rec[i].entity_path.Entry[0].EntityLocation = 1500 + i;
+        }
+
+        fp = fopen(MAP_FILE, "wb");
+        if (!fp)
+                return 1;
+        if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+            fwrite(rec, sizeof(rec[0]), 2, fp) != 2 ||
+            fwrite(&rec[1], sizeof(rec[1]), 1, fp) != 1 ||
+            fwrite(&rec[0], sizeof(rec[0]) / 2, 1, fp) != 1) {
+                fclose(fp);
+                return 1;
+        }
+        fclose(fp);
+
+        if (oh_uid_initialize())
+                return 1;
+
+        for (i = 0; i < 2; i++) {
+                if (oh_uid_lookup(&rec[i].entity_path) != rec[i].resource_id)
+                        return 1;
+        }
+
+        if (stat(MAP_FILE, &st))
+                return 1;
+        if (st.st_size != sizeof(header) + 2 * sizeof(rec[0]))
+                return 1;
+
+        oh_init_ep(&ep);
+        ep.Entry[0].EntityType = SAHPI_ENT_SYSTEM_CHASSIS;
+        ep.Entry[0].EntityLocation = 1510;
+        id = oh_uid_from_entity_path(&ep);
+        if (id != header)
+                return 1;
+
+        if (oh_uid_map_flush())
+                return 1;
+        if (stat(MAP_FILE, &st))
+                return 1;
+        if (st.st_size != sizeof(header) + 3 * sizeof(rec[0]))
+                return 1;
+
+        return 0;
+}
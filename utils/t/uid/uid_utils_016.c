@@ -0,0 +1,92 @@
+/* -*- linux-c -*-
+ *
+ * (C) Copyright IBM Corp. 2004
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  This
+ * file and program are licensed under a BSD style license.  See
+ * the Copying file included with the OpenHPI distribution for
+ * full licensing terms.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <SaHpi.h>
+#include <oh_utils.h>
+
+#define MAP_FILE "uid_map_016"
+
+struct xref {
+        SaHpiResourceIdT resource_id;
+        SaHpiEntityPathT entity_path;
+};
+
+/**
+ * main: Replay a uid map file whose resource id header is
+ * older than its records, as left by a crash between the
+ * record write and the header write of a journal flush.
+ * Passes if the next id handed out is past the highest
+ * record and the repaired header says so,
+ * otherwise fails.
+ *
+ * Return value: 0 on success, 1 on failure
+ **/
+int main(int argc, char **argv)
+{
+        struct xref rec[3];
+        SaHpiResourceIdT header = 2;
+        SaHpiEntityPathT ep;
+        guint id;
+        FILE *fp;
+        int i;
+
+        remove(MAP_FILE);
+        setenv("OPENHPI_UID_MAP", MAP_FILE, 1);
+
+        for (i = 0; i < 3; i++) {
+                memset(&rec[i], 0, sizeof(rec[i]));
+                oh_init_ep(&rec[i].entity_path);
+                rec[i].resource_id = i + 1;
+                rec[i].entity_path.Entry[0].EntityType = SAHPI_ENT_SYSTEM_CHASSIS;
+                rec[i].entity_path.Entry[0].EntityLocation = 1600 + i;
+        }
+
+        fp = fopen(MAP_FILE, "wb");
+        if (!fp)
+                return 1;
+        if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+            fwrite(rec, sizeof(rec[0]), 3, fp) != 3) {
+                fclose(fp);
+                return 1;
+        }
+        fclose(fp);
+
+        if (oh_uid_initialize())
+                return 1;
+
+        fp = fopen(MAP_FILE, "rb");
+        if (!fp)
+                return 1;
+        if (fread(&header, sizeof(header), 1, fp) != 1) {
+                fclose(fp);
+                return 1;
+        }
+        fclose(fp);
+        if (header != 4)
+                return 1;
+
+        oh_init_ep(&ep);
+        ep.Entry[0].EntityType = SAHPI_ENT_SYSTEM_CHASSIS;
+        ep.Entry[0].EntityLocation = 1610;
+        id = oh_uid_from_entity_path(&ep);
+        if (id != 4)
+                return 1;
+
+        return 0;
+}
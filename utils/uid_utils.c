@@ -21,6 +21,12 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
 
 #include <glib.h>
 #include <config.h>
@@ -67,16 +73,32 @@ typedef struct {
 	static GStaticMutex oh_uid_lock = G_STATIC_MUTEX_INIT;
 #endif
 
+/*
+ * Newly assigned uid/entity path pairs are not written to the map file
+ * one by one. They are kept in the journal and appended in one batch by
+ * oh_uid_map_flush() (end of each discovery pass), or as soon as
+ * OH_UID_JOURNAL_MAX records are pending.
+ */
+#define OH_UID_JOURNAL_MAX 256
+
 static GHashTable *oh_ep_table;
 static GHashTable *oh_resource_id_table;
+static GArray     *oh_uid_journal;
 static guint       resource_id;
+static long        oh_uid_map_size;   /* committed length of the map file */
 static char * oh_uid_map_file = 0;
 static int initialized = FALSE;
 
 
 /* use to build memory resident map table from file */
 static int uid_map_from_file(void);
-static int build_uid_map_data(FILE *fp);
+static int build_uid_map_data(const char *data, gsize len, int *dirty);
+
+/* used by oh_uid_map_to_file() and oh_uid_map_flush() */
+static SaErrorT uid_map_write_file(void);
+static SaErrorT uid_journal_flush(void);
+static int uid_sync_file(FILE *fp);
+static int uid_truncate_file(long size);
 
 /* used by oh_uid_remove() */
 static void write_ep_xref(gpointer key, gpointer value, gpointer file);
@@ -148,6 +170,7 @@ SaErrorT oh_uid_initialize(void)
                 /* initialize hash tables */
                 oh_ep_table = g_hash_table_new(oh_entity_path_hash, oh_entity_path_equal);
                 oh_resource_id_table = g_hash_table_new(g_int_hash, g_int_equal);
+                oh_uid_journal = g_array_new(FALSE, FALSE, sizeof(EP_XREF));
                 initialized = TRUE;
                 resource_id = 1;
 
@@ -193,8 +216,8 @@ SaHpiBoolT oh_uid_is_initialized()
  * This function returns an unique value to be used as
  * an uid/resourceID base upon a unique entity path specified
  * by @ep.  If the entity path already exists, the already assigned
- * resource id is returned.  Before returning, this call updates the
- * uid map file saved on disk.
+ * resource id is returned.  A newly assigned pair is queued in the
+ * uid map journal and reaches the disk with the next oh_uid_map_flush().
  *
  * Returns: positive unsigned int, failure is 0.
  **/
@@ -250,23 +273,13 @@ SaHpiUint32T oh_uid_from_entity_path(SaHpiEntityPathT *ep)
         key = (gpointer)&ep_xref->resource_id;
         g_hash_table_insert(oh_resource_id_table, key, value);
 
-        /* save newly created ep xref (iud/resource_id) to map file */
+        /* queue newly created ep xref (uid/resource_id) for the map file */
         if (oh_uid_map_file) {
-                FILE * fp;
-                fp = fopen(oh_uid_map_file, "r+b");
-                if (fp) {
-                        fseek(fp, 0, SEEK_END);
-                        if (fwrite(ep_xref, sizeof(EP_XREF), 1, fp) == 1) {
-                                fseek(fp, 0, SEEK_SET);
-                                if (fwrite(&resource_id, sizeof(resource_id), 1, fp) != 1) {
-                			CRIT("write resource_id failed");
-                                        ruid = 0;
-                		}
-        		} else {
-        			CRIT("write ep_xref failed");
+                g_array_append_val(oh_uid_journal, *ep_xref);
+                if (oh_uid_journal->len >= OH_UID_JOURNAL_MAX) {
+                        if (uid_journal_flush() != SA_OK) {
                                 ruid = 0;
                         }
-                        fclose(fp);
                 }
         }
 
@@ -393,24 +406,183 @@ SaErrorT oh_entity_path_lookup(SaHpiUint32T id, SaHpiEntityPathT *ep)
 /**
  * oh_uid_map_to_file: saves current uid and entity path mappings
  * to file, first element in file is 4 bytes for resource id,
- * then repeat EP_XREF structures holding uid and entity path pairings
+ * then repeat EP_XREF structures holding uid and entity path pairings.
+ * The map is written to a temporary file which then replaces the
+ * old one, so a crash never leaves a half written map behind.
  *
  * Return value: success 0, failed -1.
  **/
 SaErrorT oh_uid_map_to_file(void)
 {
-        FILE *fp;
+        SaErrorT rv;
 
         if (!oh_uid_map_file) {
                 return SA_OK;
         }
 
         uid_lock(&oh_uid_lock);
+        rv = uid_map_write_file();
+        uid_unlock(&oh_uid_lock);
+
+        return rv;
+}
+
+/**
+ * oh_uid_map_flush: appends all uid and entity path mappings
+ * queued by oh_uid_from_entity_path() to the map file.
+ * The records are written with a single write and synced before
+ * the resource id header is updated, so the file on disk is
+ * always usable by uid_map_from_file().
+ *
+ * Return value: success 0, failed -1.
+ **/
+SaErrorT oh_uid_map_flush(void)
+{
+        SaErrorT rv;
+
+        if (!oh_uid_map_file) {
+                return SA_OK;
+        }
+
+        uid_lock(&oh_uid_lock);
+        rv = uid_journal_flush();
+        uid_unlock(&oh_uid_lock);
+
+        return rv;
+}
+
+/*
+ * uid_sync_file: flushes stdio buffers of @fp and forces
+ * the file data to the disk.
+ *
+ * Return value: success 0, error -1.
+ */
+static int uid_sync_file(FILE *fp)
+{
+        if (fflush(fp) != 0) {
+                return -1;
+        }
+#ifdef _WIN32
+        if (_commit(_fileno(fp)) != 0) {
+                return -1;
+        }
+#else
+        if (fsync(fileno(fp)) != 0) {
+                return -1;
+        }
+#endif
+        return 0;
+}
+
+/*
+ * uid_journal_flush: called with oh_uid_lock held.
+ * See oh_uid_map_flush() for details.
+ *
+ * Return value: success 0, failed -1.
+ */
+static SaErrorT uid_journal_flush(void)
+{
+        FILE *fp;
+        guint len;
+
+        len = oh_uid_journal->len;
+        if (len == 0) {
+                return SA_OK;
+        }
+
+        fp = fopen(oh_uid_map_file, "r+b");
+        if (!fp) {
+                CRIT("uid map file '%s' could not be opened", oh_uid_map_file);
+                return SA_ERR_HPI_ERROR;
+        }
+
+        /*
+         * All queued records go in one write at the committed end of
+         * the file, then reach the disk. Anything a failed attempt
+         * left past that offset is overwritten by the retry.
+         */
+        if (fseek(fp, oh_uid_map_size, SEEK_SET) != 0 ||
+            fwrite(oh_uid_journal->data, sizeof(EP_XREF), len, fp) != len ||
+            uid_sync_file(fp) != 0) {
+                CRIT("write ep_xref failed");
+                goto rollback;
+        }
+
+        /*
+         * Header goes last. If we crash before it is updated,
+         * uid_map_from_file() recovers resource id from the records.
+         */
+        if (fseek(fp, 0, SEEK_SET) != 0 ||
+            fwrite(&resource_id, sizeof(resource_id), 1, fp) != 1 ||
+            uid_sync_file(fp) != 0) {
+                CRIT("write resource_id failed");
+                goto rollback;
+        }
+
+        if (fclose(fp) != 0) {
+                CRIT("Couldn't close uid map file '%s'", oh_uid_map_file);
+                uid_truncate_file(oh_uid_map_size);
+                return SA_ERR_HPI_ERROR;
+        }
+        oh_uid_map_size += len * sizeof(EP_XREF);
+        g_array_set_size(oh_uid_journal, 0);
+
+        return SA_OK;
+
+rollback:
+        /*
+         * The journal is kept for a retry, so drop whatever part of
+         * it made it to the file. Otherwise the retry appends the
+         * same records a second time.
+         */
+        fclose(fp);
+        if (uid_truncate_file(oh_uid_map_size) != 0) {
+                CRIT("Couldn't truncate uid map file '%s'", oh_uid_map_file);
+        }
 
-        fp = fopen(oh_uid_map_file, "wb");
+        return SA_ERR_HPI_ERROR;
+}
+
+/*
+ * uid_truncate_file: cuts the map file back to @size bytes.
+ *
+ * Return value: success 0, failed -1.
+ */
+static int uid_truncate_file(long size)
+{
+#ifndef _WIN32
+        return truncate(oh_uid_map_file, size);
+#else
+        int fd, rval;
+
+        fd = _open(oh_uid_map_file, _O_WRONLY | _O_BINARY);
+        if (fd < 0) {
+                return -1;
+        }
+        rval = _chsize(fd, size);
+        _close(fd);
+
+        return rval;
+#endif
+}
+
+/*
+ * uid_map_write_file: called with oh_uid_lock held.
+ * See oh_uid_map_to_file() for details.
+ *
+ * Return value: success 0, failed -1.
+ */
+static SaErrorT uid_map_write_file(void)
+{
+        FILE *fp;
+        gchar *tmp_file;
+        int rval;
+
+        tmp_file = g_strconcat(oh_uid_map_file, ".tmp", NULL);
+        fp = fopen(tmp_file, "wb");
         if(!fp) {
-                CRIT("Configuration file '%s' could not be opened", oh_uid_map_file);
-                uid_unlock(&oh_uid_lock);
+                CRIT("Configuration file '%s' could not be opened", tmp_file);
+                g_free(tmp_file);
                 return SA_ERR_HPI_ERROR;
         }
 
@@ -418,16 +590,38 @@ SaErrorT oh_uid_map_to_file(void)
         if (fwrite((void *)&resource_id, sizeof(resource_id), 1, fp) != 1) {
 		CRIT("write resource_id failed");
 		fclose(fp);
-                uid_unlock(&oh_uid_lock);
+                remove(tmp_file);
+                g_free(tmp_file);
 		return SA_ERR_HPI_ERROR;
 	}
 
         /* write all EP_XREF data records */
         g_hash_table_foreach(oh_resource_id_table, write_ep_xref, fp);
 
-        fclose(fp);
+        rval = uid_sync_file(fp);
+        if (fclose(fp) != 0 || rval != 0) {
+                CRIT("Couldn't write file '%s'", tmp_file);
+                remove(tmp_file);
+                g_free(tmp_file);
+                return SA_ERR_HPI_ERROR;
+        }
 
-        uid_unlock(&oh_uid_lock);
+#ifdef _WIN32
+        /* rename() does not replace an existing file on Windows */
+        remove(oh_uid_map_file);
+#endif
+        if (rename(tmp_file, oh_uid_map_file) != 0) {
+                CRIT("Couldn't replace uid map file '%s'", oh_uid_map_file);
+                remove(tmp_file);
+                g_free(tmp_file);
+                return SA_ERR_HPI_ERROR;
+        }
+        g_free(tmp_file);
+
+        /* whole table is on disk now, including queued records */
+        oh_uid_map_size = sizeof(resource_id) +
+                          g_hash_table_size(oh_resource_id_table) * sizeof(EP_XREF);
+        g_array_set_size(oh_uid_journal, 0);
 
         return SA_OK;
 }
@@ -451,6 +645,7 @@ static void write_ep_xref(gpointer key, gpointer value, gpointer fp)
  * uid_map_from_file: called from oh_uid_initialize() during intialization
  * This function, if a uid map file exists, reads the current value for
  * uid and intializes the memory resident uid map file from file.
+ * The file is mapped into memory and parsed in place.
  *
  * Return value: success 0, error -1.
  */
@@ -458,15 +653,24 @@ static gint uid_map_from_file()
 {
         FILE *fp;
         int rval;
+        int dirty = FALSE;
+        gchar *data;
+        gsize len;
 #ifndef _WIN32
+        int fd;
+        struct stat st;
 	mode_t prev_umask;
 #endif
 
         if (!oh_uid_map_file) {
                 return 0;
         }
-        fp = fopen(oh_uid_map_file, "rb");
-        if(!fp) {
+#ifndef _WIN32
+        fd = open(oh_uid_map_file, O_RDONLY);
+        if (fd < 0) {
+#else
+        if (!g_file_test(oh_uid_map_file, G_FILE_TEST_EXISTS)) {
+#endif
                  /* create map file with resource id initial value */
                  WARN("uid_map file '%s' could not be opened, initializing", oh_uid_map_file);
 #ifndef _WIN32
@@ -495,50 +699,116 @@ static gint uid_map_from_file()
                          CRIT("Couldn't close file '%s'.during uid map file initialization", oh_uid_map_file);
                          return -1;
                  }
+                 oh_uid_map_size = sizeof(resource_id);
                  /* return from successful initialization, from newly created uid map file */
                  return 0;
          }
 
-         /* read uid/resouce_id highest count from uid map file */
-         if (fread(&resource_id, sizeof(resource_id), 1, fp) != 1) {
+#ifndef _WIN32
+         if (fstat(fd, &st) != 0) {
+                 CRIT("Couldn't stat uid map file '%s'", oh_uid_map_file);
+                 close(fd);
+                 return -1;
+         }
+         len = st.st_size;
+         if (len < sizeof(resource_id)) {
+                 CRIT("error setting uid from existing uid map file");
+                 close(fd);
+                 return -1;
+         }
+         data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+         close(fd);
+         if (data == MAP_FAILED) {
+                 CRIT("Couldn't map uid map file '%s'", oh_uid_map_file);
+                 return -1;
+         }
+#else
+         if (!g_file_get_contents(oh_uid_map_file, &data, &len, NULL)) {
+                 CRIT("Couldn't read uid map file '%s'", oh_uid_map_file);
+                 return -1;
+         }
+         if (len < sizeof(resource_id)) {
                  CRIT("error setting uid from existing uid map file");
-                fclose(fp);
+                 g_free(data);
                  return -1;
          }
+#endif
+
+         /* read uid/resouce_id highest count from uid map file */
+         memcpy(&resource_id, data, sizeof(resource_id));
 
-         rval = build_uid_map_data(fp);
-         fclose(fp);
+         rval = build_uid_map_data(data + sizeof(resource_id),
+                                   len - sizeof(resource_id),
+                                   &dirty);
+#ifndef _WIN32
+         munmap(data, len);
+#else
+         g_free(data);
+#endif
 
          if (rval < 0)
                 return -1;
+         oh_uid_map_size = len;
+
+         /* rewrite the file if it was left inconsistent by a crash */
+         if (dirty) {
+                 WARN("uid map file '%s' was not closed cleanly, repairing", oh_uid_map_file);
+                 if (uid_map_write_file() != SA_OK)
+                        return -1;
+         }
 
          /* return from successful initialization from existing uid map file */
          return 0;
 }
 
 /*
- * build_uid_map_data: used by uid_map_from_file(),  recursively
- * reads map file and builds two hash tables and EP_XREF data
- * structures
+ * build_uid_map_data: used by uid_map_from_file(), walks the
+ * EP_XREF records in @data and builds two hash tables and
+ * EP_XREF data structures.
+ * A torn record at the end of @data, a resource id header
+ * older than the records (crash during oh_uid_map_flush())
+ * or a record that repeats an earlier one is fixed up in
+ * memory and reported through @dirty.
  *
- * @file: key into a GHashTable
+ * @data: map file contents following the resource id header
+ * @len: length of @data
+ * @dirty: set to TRUE if the map file has to be rewritten
  *
  * Return value: success 0, error -1.
  */
-static gint build_uid_map_data(FILE *fp)
+static gint build_uid_map_data(const char *data, gsize len, int *dirty)
 {
         EP_XREF *ep_xref;
-        EP_XREF ep_xref1;
         gpointer value;
         gpointer key;
+        gsize i, n;
+
+        n = len / sizeof(EP_XREF);
+        if ((len % sizeof(EP_XREF)) != 0) {
+                WARN("Ignoring incomplete record at the end of uid map file");
+                *dirty = TRUE;
+        }
 
-        while (fread(&ep_xref1, sizeof(EP_XREF), 1, fp) == 1) {
+        for (i = 0; i < n; ++i) {
 
-                /* copy read record from ep_xref1 to malloc'd ep_xref */
+                /* copy record from mapped file to malloc'd ep_xref */
                 ep_xref = g_new0(EP_XREF, 1);
                 if (!ep_xref)
                         return -1;
-                memcpy(ep_xref, &ep_xref1, sizeof(EP_XREF));
+                memcpy(ep_xref, data + i * sizeof(EP_XREF), sizeof(EP_XREF));
+
+                /* replaying the same records again must not change the map */
+                if (g_hash_table_lookup(oh_ep_table, &ep_xref->entity_path) ||
+                    g_hash_table_lookup(oh_resource_id_table, &ep_xref->resource_id)) {
+                        g_free(ep_xref);
+                        *dirty = TRUE;
+                        continue;
+                }
+
+                if (ep_xref->resource_id >= resource_id) {
+                        resource_id = ep_xref->resource_id + 1;
+                        *dirty = TRUE;
+                }
 
                 value = (gpointer)ep_xref;
 
@@ -551,9 +821,5 @@ static gint build_uid_map_data(FILE *fp)
                 g_hash_table_insert(oh_resource_id_table, key, value);
         }
 
-        if ((feof(fp) == 0) || (ferror(fp) != 0)) {
-                CRIT("error building ep xref from map file");
-                return -1;
-        }
         return 0;
 }
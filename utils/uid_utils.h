@@ -36,6 +36,7 @@ SaErrorT oh_uid_remove(SaHpiUint32T uid);
 SaHpiUint32T oh_uid_lookup(SaHpiEntityPathT *ep);
 SaErrorT oh_entity_path_lookup(SaHpiUint32T id, SaHpiEntityPathT *ep);
 SaErrorT oh_uid_map_to_file(void);
+SaErrorT oh_uid_map_flush(void);
 #ifdef __cplusplus
 }
 #endif